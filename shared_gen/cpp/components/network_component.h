@@ -12,20 +12,26 @@ public:
 
 	std::optional<uint8_t> ownerId{};
 	Halley::DataInterpolatorSet dataInterpolatorSet{};
+	float importance{ 1 };
 
 	NetworkComponent() {
 	}
 
+	NetworkComponent(float importance)
+		: importance(std::move(importance))
+	{
+	}
+
 	Halley::ConfigNode serialize(const Halley::EntitySerializationContext& context) const {
 		using namespace Halley::EntitySerialization;
 		Halley::ConfigNode node = Halley::ConfigNode::MapType();
-		
+		Halley::EntityConfigNodeSerializer<decltype(importance)>::serialize(importance, float{ 1 }, context, node, componentName, "importance", makeMask(Type::Prefab));
 		return node;
 	}
 
 	void deserialize(const Halley::EntitySerializationContext& context, const Halley::ConfigNode& node) {
 		using namespace Halley::EntitySerialization;
-		
+		Halley::EntityConfigNodeSerializer<decltype(importance)>::deserialize(importance, float{ 1 }, context, node, componentName, "importance", makeMask(Type::Prefab));
 	}
 
 };
@@ -21,6 +21,7 @@ namespace Halley
 		virtual size_t getLength() const = 0; // in samples
 		virtual size_t getLoopPoint() const { return 0; } // in samples
 		virtual bool isLoaded() const { return true; }
+		virtual bool canReadConcurrently() const { return true; }
 	};
 
 	class AudioClip final : public AsyncResource, public IAudioClip
@@ -39,6 +40,7 @@ namespace Halley
 		size_t getLength() const override; // in samples
 		size_t getLoopPoint() const override; // in samples
 		bool isLoaded() const override;
+		bool canReadConcurrently() const override;
 
 		ResourceMemoryUsage getMemoryUsage() const override;
 
@@ -1,10 +1,31 @@
 #pragma once
 #include <gsl/span>
 #include "halley/core/api/audio_api.h"
+#include "halley/text/enum_names.h"
 #include "audio_buffer.h"
 
 namespace Halley
 {
+	enum class AudioMixerInstructionSet
+	{
+		Scalar,
+		SSE2,
+		AVX2,
+		NEON
+	};
+
+	template <>
+	struct EnumNames<AudioMixerInstructionSet> {
+		constexpr std::array<const char*, 4> operator()() const {
+			return{{
+				"scalar",
+				"sse2",
+				"avx2",
+				"neon"
+			}};
+		}
+	};
+
 	class AudioMixer
 	{
 	public:
@@ -22,5 +43,10 @@ namespace Halley
 		static void copy(AudioMultiChannelSamples dst, AudioMultiChannelSamples src, size_t nChannels = 8);
 		static void copy(AudioSamples dst, AudioSamples src);
 		static void copy(AudioSamples dst, AudioSamples src, float gainStart, float gainEnd);
+
+		// The best instruction set supported by the CPU is picked on first use. All of them give bit-identical results.
+		static bool isInstructionSetSupported(AudioMixerInstructionSet set);
+		static AudioMixerInstructionSet getInstructionSet();
+		static void setInstructionSet(AudioMixerInstructionSet set);
 	};
 }
@@ -15,5 +15,8 @@ namespace Halley
 		virtual bool isReady() const { return true; }
 		virtual bool getAudioData(size_t numSamples, AudioMultiChannelSamples dst) = 0;
 		virtual void restart() = 0;
+
+		// Sources that share state with other voices (e.g. a streaming clip's decoder) must return false, so they're all mixed on the same thread
+		virtual bool canMixConcurrently() const { return true; }
 	};
 }
@@ -154,6 +154,12 @@ bool AudioClip::isLoaded() const
 	return AsyncResource::isLoaded();
 }
 
+bool AudioClip::canReadConcurrently() const
+{
+	// Streaming clips decode into a shared buffer
+	return !streaming;
+}
+
 ResourceMemoryUsage AudioClip::getMemoryUsage() const
 {
 	ResourceMemoryUsage result;
@@ -13,9 +13,12 @@
 #include "halley/support/profiler.h"
 #include "halley/time/stopwatch.h"
 #include "halley/utils/algorithm.h"
+#include "halley/concurrency/concurrent.h"
 
 using namespace Halley;
 
+thread_local AudioEngine::MixGroup* AudioEngine::currentMixGroup = nullptr;
+
 AudioEngine::AudioEngine()
 	: pool(std::make_unique<AudioBufferPool>())
 	, audioOutputBuffer(4096 * 8)
@@ -191,6 +194,8 @@ void AudioEngine::generateBuffer()
 	mixVoices(samplesToRead, numChannels, channelBuffers);
 	removeFinishedVoices();
 
+	ProfilerEvent postProcessEvent(ProfilerEventType::AudioPostProcess);
+
 	// Interleave
 	auto bufferRef = pool->getBuffer(samplesToRead * numChannels);
 	auto buffer = bufferRef.getSpan().subspan(0, samplesToRead * numChannels);
@@ -284,6 +289,7 @@ size_t AudioEngine::output(gsl::span<std::byte> dst, bool fill)
 	if (!remaining.empty() && fill) {
 		// :(
 		Logger::logWarning("Insufficient audio data, padding with zeroes.");
+		ProfilerCapture::get().addCounter(ProfilerCounterType::AudioUnderruns, 1);
 		memset(remaining.data(), 0, size_t(remaining.size_bytes()));
 		written = size_t(dst.size());
 	}
@@ -298,12 +304,12 @@ bool AudioEngine::needsMoreAudio()
 
 Random& AudioEngine::getRNG()
 {
-	return rng;
+	return currentMixGroup ? currentMixGroup->rng : rng;
 }
 
 AudioBufferPool& AudioEngine::getPool() const
 {
-	return *pool;
+	return currentMixGroup ? *currentMixGroup->pool : *pool;
 }
 
 void AudioEngine::setMasterGain(float gain)
@@ -313,6 +319,8 @@ void AudioEngine::setMasterGain(float gain)
 
 void AudioEngine::mixVoices(size_t numSamples, size_t nChannels, gsl::span<AudioBuffer*> buffers)
 {
+	ProfilerEvent event(ProfilerEventType::AudioMixVoices);
+
 	// Ensure propagation of bus gains
 	updateBusGains();
 
@@ -321,7 +329,8 @@ void AudioEngine::mixVoices(size_t numSamples, size_t nChannels, gsl::span<Audio
 		AudioMixer::zero(buffers[i]->samples);
 	}
 
-	// Mix every emitter
+	// Update every emitter's voices here, as that touches engine and emitter state
+	voicesToMix.clear();
 	for (auto& e: emitters) {
 		for (auto& v: e.second->getVoices()) {
 			// Start playing if necessary
@@ -329,13 +338,103 @@ void AudioEngine::mixVoices(size_t numSamples, size_t nChannels, gsl::span<Audio
 				v->start();
 			}
 
-			// Mix it in!
 			if (v->isPlaying()) {
 				v->update(channels, e.second->getPosition(), listener, masterGain * getCompositeBusGain(v->getBus()));
-				v->mixTo(numSamples, buffers, *pool);
+				voicesToMix.push_back(v.get());
+			}
+		}
+	}
+
+	auto& profiler = ProfilerCapture::get();
+	profiler.addCounter(ProfilerCounterType::AudioVoicesMixed, int64_t(voicesToMix.size()));
+
+	// Mix it in!
+	const size_t nGroups = assignMixGroups();
+	profiler.addCounter(ProfilerCounterType::AudioVoiceGroups, int64_t(nGroups));
+	if (nGroups == 1) {
+		for (auto* v: voicesToMix) {
+			v->mixTo(numSamples, buffers, *pool);
+		}
+		return;
+	}
+
+	// Each group mixes into its own buffers, which are then summed in group order, so the output doesn't depend on which thread ran what
+	const auto groups = gsl::span<MixGroup>(mixGroups).subspan(0, nGroups);
+	for (auto& group: groups) {
+		group.buffers = pool->getBuffers(nChannels, numSamples);
+	}
+
+	Concurrent::parallelFor(Executors::getCPU(), groups.begin(), groups.end(), [&] (MixGroup& group)
+	{
+		mixGroup(group, numSamples);
+	}, 1);
+
+	for (auto& group: groups) {
+		const auto src = group.buffers.getBuffers();
+		for (size_t i = 0; i < nChannels; ++i) {
+			AudioMixer::mixAudio(AudioSamples(src[i]->samples).subspan(0, numSamples), AudioSamples(buffers[i]->samples).subspan(0, numSamples), 1.0f, 1.0f);
+		}
+		group.buffers.clear();
+	}
+}
+
+size_t AudioEngine::assignMixGroups()
+{
+	const size_t nGroups = clamp(voicesToMix.size() / minVoicesPerMixGroup, size_t(1), maxMixGroups);
+	if (nGroups == 1) {
+		return 1;
+	}
+
+	if (mixGroups.size() < nGroups) {
+		mixGroups.resize(nGroups);
+		for (auto& group: mixGroups) {
+			if (!group.pool) {
+				group.pool = std::make_unique<AudioBufferPool>();
 			}
 		}
 	}
+
+	// Voices are split into contiguous runs, so the grouping only depends on the voice order
+	// Voices that can't be mixed concurrently all go to the first group, in their original order
+	size_t nConcurrent = 0;
+	for (auto* v: voicesToMix) {
+		if (v->canMixConcurrently()) {
+			++nConcurrent;
+		}
+	}
+
+	for (size_t i = 0; i < nGroups; ++i) {
+		mixGroups[i].voices.clear();
+		mixGroups[i].rng.setSeed(rng.getRawInt());
+	}
+
+	size_t concurrentIdx = 0;
+	for (auto* v: voicesToMix) {
+		if (v->canMixConcurrently()) {
+			mixGroups[concurrentIdx * nGroups / nConcurrent].voices.push_back(v);
+			++concurrentIdx;
+		} else {
+			mixGroups[0].voices.push_back(v);
+		}
+	}
+
+	return nGroups;
+}
+
+void AudioEngine::mixGroup(MixGroup& group, size_t numSamples)
+{
+	ProfilerEvent event(ProfilerEventType::AudioMixVoiceGroup);
+
+	const auto buffers = group.buffers.getBuffers();
+	for (auto* buffer: buffers) {
+		AudioMixer::zero(buffer->samples);
+	}
+
+	currentMixGroup = &group;
+	for (auto* v: group.voices) {
+		v->mixTo(numSamples, buffers, *group.pool);
+	}
+	currentMixGroup = nullptr;
 }
 
 void AudioEngine::removeFinishedVoices()
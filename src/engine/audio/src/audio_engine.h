@@ -70,6 +70,19 @@ namespace Halley {
 			OptionalLite<uint8_t> parent;
 		};
 
+		// A set of voices mixed together on one thread, into its own scratch buffers
+		// Each group owns a buffer pool and RNG, which getPool() and getRNG() return while it's being mixed
+		struct MixGroup {
+			std::unique_ptr<AudioBufferPool> pool;
+			Random rng;
+			Vector<AudioVoice*> voices;
+			AudioBuffersRef buffers;
+		};
+
+		constexpr static size_t minVoicesPerMixGroup = 16;
+		constexpr static size_t maxMixGroups = 8;
+		static thread_local MixGroup* currentMixGroup;
+
 		AudioSpec spec;
 		AudioOutputAPI* out = nullptr;
 		const AudioProperties* audioProperties = nullptr;
@@ -95,7 +108,12 @@ namespace Halley {
 
     	Vector<uint32_t> finishedSounds;
 
+		Vector<AudioVoice*> voicesToMix;
+		Vector<MixGroup> mixGroups;
+
 		void mixVoices(size_t numSamples, size_t channels, gsl::span<AudioBuffer*> buffers);
+		size_t assignMixGroups();
+		void mixGroup(MixGroup& group, size_t numSamples);
 	    void removeFinishedVoices();
 		void queueAudioFloat(gsl::span<const float> data);
 		void queueAudioBytes(gsl::span<const gsl::byte> data);
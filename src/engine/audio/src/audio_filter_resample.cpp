@@ -1,10 +1,11 @@
 #include "audio_filter_resample.h"
 #include "halley/support/debug.h"
+#include "audio_engine.h"
 
 using namespace Halley;
 
-AudioFilterResample::AudioFilterResample(std::shared_ptr<AudioSource> source, int fromHz, int toHz, AudioBufferPool& pool)
-	: pool(pool)
+AudioFilterResample::AudioFilterResample(std::shared_ptr<AudioSource> source, int fromHz, int toHz, AudioEngine& engine)
+	: engine(engine)
 	, source(std::move(source))
 	, fromHz(fromHz)
 	, toHz(toHz)
@@ -36,12 +37,12 @@ bool AudioFilterResample::getAudioData(size_t numSamples, AudioMultiChannelSampl
 	}
 
 	// Read upstream data
-	auto srcBuffers = pool.getBuffers(nChannels, numSamplesSrc);
+	auto srcBuffers = engine.getPool().getBuffers(nChannels, numSamplesSrc);
 	auto srcs = srcBuffers.getSampleSpans();
 	bool playing = source->getAudioData(numSamplesSrc, srcs);
 
 	// Prepare temporary destination data
-	auto tmpBuffer = pool.getBuffer(numSamples + 32); // Is this +32 needed?
+	auto tmpBuffer = engine.getPool().getBuffer(numSamples + 32); // Is this +32 needed?
 	auto tmp = tmpBuffer.getSpan();
 	
 	// Resample
@@ -81,6 +82,11 @@ void AudioFilterResample::restart()
 	resamplers.clear();
 }
 
+bool AudioFilterResample::canMixConcurrently() const
+{
+	return source->canMixConcurrently();
+}
+
 void AudioFilterResample::setFromHz(int fromHz)
 {
 	for (auto& r: resamplers) {
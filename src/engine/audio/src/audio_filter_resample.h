@@ -5,21 +5,24 @@
 
 namespace Halley
 {
+	class AudioEngine;
+
 	class AudioFilterResample final : public AudioSource
 	{
 	public:
-		AudioFilterResample(std::shared_ptr<AudioSource> source, int fromHz, int toHz, AudioBufferPool& pool);
+		AudioFilterResample(std::shared_ptr<AudioSource> source, int fromHz, int toHz, AudioEngine& engine);
 
 		uint8_t getNumberOfChannels() const override;
 		bool isReady() const override;
 		bool getAudioData(size_t numSamples, AudioMultiChannelSamples dst) override;
 		size_t getSamplesLeft() const override;
 		void restart() override;
+		bool canMixConcurrently() const override;
 
 		void setFromHz(int fromHz);
 
 	private:
-		AudioBufferPool& pool;
+		AudioEngine& engine;
 		std::shared_ptr<AudioSource> source;
 		Vector<std::unique_ptr<AudioResampler>> resamplers;
 		int fromHz;
@@ -1,61 +1,421 @@
 #include "audio_mixer.h"
+#include "audio_mixer_kernels.h"
 #include "halley/utils/utils.h"
+#include "halley/support/exception.h"
+#include "halley/text/string_converter.h"
+#include <atomic>
 
 using namespace Halley;
 
 
-#if defined(_M_X64) || defined(__x86_64__)
-#define HAS_SSE
-#if !defined(__linux__)
-#define HAS_AVX
-#endif
-#endif
-
-#if defined(_M_IX86) || defined(__i386)
-// Might not be available, but do we really care about such old processors?
-#define HAS_SSE
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HAS_SSE2
+#include <emmintrin.h>
 #endif
 
-#ifdef HAS_AVX
-#include <xmmintrin.h>
-#ifdef __clang__
-#include <immintrin.h>
-#endif
+#if defined(_M_X64) || defined(__x86_64__) || defined(_M_IX86) || defined(__i386)
+#define HAS_AVX2
 #ifdef _MSC_VER
 #include <intrin.h>
 #endif
 #endif
 
-#ifdef HAS_SSE
-#include <xmmintrin.h>
-#ifdef _MSC_VER
-#include <intrin.h>
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define HAS_NEON
+#include <arm_neon.h>
 #endif
+
+
+namespace {
+	void mixScalar(const float* src, float* dst, size_t n)
+	{
+		for (size_t i = 0; i < n; ++i) {
+			dst[i] += src[i];
+		}
+	}
+
+	void mixGainScalar(const float* src, float* dst, size_t n, float gain)
+	{
+		for (size_t i = 0; i < n; ++i) {
+			dst[i] += src[i] * gain;
+		}
+	}
+
+	void mixRampScalar(const float* src, float* dst, size_t n, float gain0, float gain1)
+	{
+		const float scale = 1.0f / n;
+		for (size_t i = 0; i < n; ++i) {
+			dst[i] += src[i] * lerp(gain0, gain1, i * scale);
+		}
+	}
+
+	void copyGainScalar(const float* src, float* dst, size_t n, float gain)
+	{
+		for (size_t i = 0; i < n; ++i) {
+			dst[i] = src[i] * gain;
+		}
+	}
+
+	void copyRampScalar(const float* src, float* dst, size_t n, float gain0, float gain1)
+	{
+		const float scale = 1.0f / n;
+		for (size_t i = 0; i < n; ++i) {
+			dst[i] = src[i] * lerp(gain0, gain1, i * scale);
+		}
+	}
+
+	void clampScalar(float* buffer, size_t n, float limit)
+	{
+		for (size_t i = 0; i < n; ++i) {
+			float& sample = buffer[i];
+			sample = std::max(-limit, std::min(sample, limit));
+		}
+	}
+
+	void interleaveStereoScalar(const float* left, const float* right, float* dst, size_t n)
+	{
+		for (size_t i = 0; i < n; ++i) {
+			dst[2 * i] = left[i];
+			dst[2 * i + 1] = right[i];
+		}
+	}
+}
+
+const AudioMixerKernels& Halley::getAudioMixerKernelsScalar()
+{
+	static const AudioMixerKernels kernels = { mixScalar, mixGainScalar, mixRampScalar, copyGainScalar, copyRampScalar, clampScalar, interleaveStereoScalar };
+	return kernels;
+}
+
+
+#ifdef HAS_SSE2
+namespace {
+	void mixSSE2(const float* src, float* dst, size_t n)
+	{
+		size_t i = 0;
+		for (; i + 4 <= n; i += 4) {
+			_mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), _mm_loadu_ps(src + i)));
+		}
+		mixScalar(src + i, dst + i, n - i);
+	}
+
+	void mixGainSSE2(const float* src, float* dst, size_t n, float gain)
+	{
+		const __m128 g = _mm_set1_ps(gain);
+		size_t i = 0;
+		for (; i + 4 <= n; i += 4) {
+			_mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), _mm_mul_ps(_mm_loadu_ps(src + i), g)));
+		}
+		mixGainScalar(src + i, dst + i, n - i, gain);
+	}
+
+	// lerp(gain0, gain1, i * scale) for four consecutive values of i, with the same operations as the scalar version
+	__m128 rampGainSSE2(__m128i idx, __m128 g0, __m128 g1, __m128 scale)
+	{
+		const __m128 t = _mm_mul_ps(_mm_cvtepi32_ps(idx), scale);
+		return _mm_add_ps(_mm_mul_ps(g0, _mm_sub_ps(_mm_set1_ps(1.0f), t)), _mm_mul_ps(g1, t));
+	}
+
+	void mixRampSSE2(const float* src, float* dst, size_t n, float gain0, float gain1)
+	{
+		const float scale = 1.0f / n;
+		const __m128 g0 = _mm_set1_ps(gain0);
+		const __m128 g1 = _mm_set1_ps(gain1);
+		const __m128 sc = _mm_set1_ps(scale);
+		__m128i idx = _mm_setr_epi32(0, 1, 2, 3);
+
+		size_t i = 0;
+		for (; i + 4 <= n; i += 4) {
+			const __m128 gain = rampGainSSE2(idx, g0, g1, sc);
+			_mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), _mm_mul_ps(_mm_loadu_ps(src + i), gain)));
+			idx = _mm_add_epi32(idx, _mm_set1_epi32(4));
+		}
+		for (; i < n; ++i) {
+			dst[i] += src[i] * lerp(gain0, gain1, i * scale);
+		}
+	}
+
+	void copyGainSSE2(const float* src, float* dst, size_t n, float gain)
+	{
+		const __m128 g = _mm_set1_ps(gain);
+		size_t i = 0;
+		for (; i + 4 <= n; i += 4) {
+			_mm_storeu_ps(dst + i, _mm_mul_ps(_mm_loadu_ps(src + i), g));
+		}
+		copyGainScalar(src + i, dst + i, n - i, gain);
+	}
+
+	void copyRampSSE2(const float* src, float* dst, size_t n, float gain0, float gain1)
+	{
+		const float scale = 1.0f / n;
+		const __m128 g0 = _mm_set1_ps(gain0);
+		const __m128 g1 = _mm_set1_ps(gain1);
+		const __m128 sc = _mm_set1_ps(scale);
+		__m128i idx = _mm_setr_epi32(0, 1, 2, 3);
+
+		size_t i = 0;
+		for (; i + 4 <= n; i += 4) {
+			_mm_storeu_ps(dst + i, _mm_mul_ps(_mm_loadu_ps(src + i), rampGainSSE2(idx, g0, g1, sc)));
+			idx = _mm_add_epi32(idx, _mm_set1_epi32(4));
+		}
+		for (; i < n; ++i) {
+			dst[i] = src[i] * lerp(gain0, gain1, i * scale);
+		}
+	}
+
+	void clampSSE2(float* buffer, size_t n, float limit)
+	{
+		// Operand order matches std::min/std::max, so NaNs come out the same as the scalar version
+		const __m128 maxVal = _mm_set1_ps(limit);
+		const __m128 minVal = _mm_set1_ps(-limit);
+		size_t i = 0;
+		for (; i + 4 <= n; i += 4) {
+			const __m128 v = _mm_min_ps(maxVal, _mm_loadu_ps(buffer + i));
+			_mm_storeu_ps(buffer + i, _mm_max_ps(v, minVal));
+		}
+		clampScalar(buffer + i, n - i, limit);
+	}
+
+	void interleaveStereoSSE2(const float* left, const float* right, float* dst, size_t n)
+	{
+		size_t i = 0;
+		for (; i + 4 <= n; i += 4) {
+			const __m128 l = _mm_loadu_ps(left + i);
+			const __m128 r = _mm_loadu_ps(right + i);
+			_mm_storeu_ps(dst + 2 * i, _mm_unpacklo_ps(l, r));
+			_mm_storeu_ps(dst + 2 * i + 4, _mm_unpackhi_ps(l, r));
+		}
+		interleaveStereoScalar(left + i, right + i, dst + 2 * i, n - i);
+	}
+}
+
+const AudioMixerKernels* Halley::getAudioMixerKernelsSSE2()
+{
+	static const AudioMixerKernels kernels = { mixSSE2, mixGainSSE2, mixRampSSE2, copyGainSSE2, copyRampSSE2, clampSSE2, interleaveStereoSSE2 };
+	return &kernels;
+}
+#else
+const AudioMixerKernels* Halley::getAudioMixerKernelsSSE2()
+{
+	return nullptr;
+}
 #endif
 
 
+#ifdef HAS_NEON
+namespace {
+	void mixNEON(const float* src, float* dst, size_t n)
+	{
+		size_t i = 0;
+		for (; i + 4 <= n; i += 4) {
+			vst1q_f32(dst + i, vaddq_f32(vld1q_f32(dst + i), vld1q_f32(src + i)));
+		}
+		mixScalar(src + i, dst + i, n - i);
+	}
+
+	void mixGainNEON(const float* src, float* dst, size_t n, float gain)
+	{
+		const float32x4_t g = vdupq_n_f32(gain);
+		size_t i = 0;
+		for (; i + 4 <= n; i += 4) {
+			// Separate multiply and add, rather than vmlaq, so the rounding matches the scalar version
+			vst1q_f32(dst + i, vaddq_f32(vld1q_f32(dst + i), vmulq_f32(vld1q_f32(src + i), g)));
+		}
+		mixGainScalar(src + i, dst + i, n - i, gain);
+	}
+
+	float32x4_t rampGainNEON(uint32x4_t idx, float32x4_t g0, float32x4_t g1, float32x4_t scale)
+	{
+		const float32x4_t t = vmulq_f32(vcvtq_f32_u32(idx), scale);
+		return vaddq_f32(vmulq_f32(g0, vsubq_f32(vdupq_n_f32(1.0f), t)), vmulq_f32(g1, t));
+	}
+
+	void mixRampNEON(const float* src, float* dst, size_t n, float gain0, float gain1)
+	{
+		const float scale = 1.0f / n;
+		const float32x4_t g0 = vdupq_n_f32(gain0);
+		const float32x4_t g1 = vdupq_n_f32(gain1);
+		const float32x4_t sc = vdupq_n_f32(scale);
+		const uint32_t startIdx[4] = { 0, 1, 2, 3 };
+		uint32x4_t idx = vld1q_u32(startIdx);
+
+		size_t i = 0;
+		for (; i + 4 <= n; i += 4) {
+			const float32x4_t gain = rampGainNEON(idx, g0, g1, sc);
+			vst1q_f32(dst + i, vaddq_f32(vld1q_f32(dst + i), vmulq_f32(vld1q_f32(src + i), gain)));
+			idx = vaddq_u32(idx, vdupq_n_u32(4));
+		}
+		for (; i < n; ++i) {
+			dst[i] += src[i] * lerp(gain0, gain1, i * scale);
+		}
+	}
+
+	void copyGainNEON(const float* src, float* dst, size_t n, float gain)
+	{
+		const float32x4_t g = vdupq_n_f32(gain);
+		size_t i = 0;
+		for (; i + 4 <= n; i += 4) {
+			vst1q_f32(dst + i, vmulq_f32(vld1q_f32(src + i), g));
+		}
+		copyGainScalar(src + i, dst + i, n - i, gain);
+	}
+
+	void copyRampNEON(const float* src, float* dst, size_t n, float gain0, float gain1)
+	{
+		const float scale = 1.0f / n;
+		const float32x4_t g0 = vdupq_n_f32(gain0);
+		const float32x4_t g1 = vdupq_n_f32(gain1);
+		const float32x4_t sc = vdupq_n_f32(scale);
+		const uint32_t startIdx[4] = { 0, 1, 2, 3 };
+		uint32x4_t idx = vld1q_u32(startIdx);
+
+		size_t i = 0;
+		for (; i + 4 <= n; i += 4) {
+			vst1q_f32(dst + i, vmulq_f32(vld1q_f32(src + i), rampGainNEON(idx, g0, g1, sc)));
+			idx = vaddq_u32(idx, vdupq_n_u32(4));
+		}
+		for (; i < n; ++i) {
+			dst[i] = src[i] * lerp(gain0, gain1, i * scale);
+		}
+	}
+
+	void clampNEON(float* buffer, size_t n, float limit)
+	{
+		// Compare and select instead of vminq/vmaxq, which propagate NaNs differently from std::min/std::max
+		const float32x4_t maxVal = vdupq_n_f32(limit);
+		const float32x4_t minVal = vdupq_n_f32(-limit);
+		size_t i = 0;
+		for (; i + 4 <= n; i += 4) {
+			float32x4_t v = vld1q_f32(buffer + i);
+			v = vbslq_f32(vcltq_f32(maxVal, v), maxVal, v);
+			v = vbslq_f32(vcltq_f32(minVal, v), v, minVal);
+			vst1q_f32(buffer + i, v);
+		}
+		clampScalar(buffer + i, n - i, limit);
+	}
+
+	void interleaveStereoNEON(const float* left, const float* right, float* dst, size_t n)
+	{
+		size_t i = 0;
+		for (; i + 4 <= n; i += 4) {
+			float32x4x2_t lr;
+			lr.val[0] = vld1q_f32(left + i);
+			lr.val[1] = vld1q_f32(right + i);
+			vst2q_f32(dst + 2 * i, lr);
+		}
+		interleaveStereoScalar(left + i, right + i, dst + 2 * i, n - i);
+	}
+}
+
+const AudioMixerKernels* Halley::getAudioMixerKernelsNEON()
+{
+	static const AudioMixerKernels kernels = { mixNEON, mixGainNEON, mixRampNEON, copyGainNEON, copyRampNEON, clampNEON, interleaveStereoNEON };
+	return &kernels;
+}
+#else
+const AudioMixerKernels* Halley::getAudioMixerKernelsNEON()
+{
+	return nullptr;
+}
+#endif
+
+
+namespace {
+	bool cpuHasAVX2()
+	{
+#if defined(HAS_AVX2) && defined(_MSC_VER)
+		int regs[4];
+		__cpuid(regs, 1);
+		const bool osUsesXSAVE_XRSTORE = (regs[2] & (1 << 27)) != 0;
+		const bool cpuAVXSupport = (regs[2] & (1 << 28)) != 0;
+		if (!osUsesXSAVE_XRSTORE || !cpuAVXSupport || (_xgetbv(_XCR_XFEATURE_ENABLED_MASK) & 0x6) != 0x6) {
+			return false;
+		}
+		__cpuidex(regs, 7, 0);
+		return (regs[1] & (1 << 5)) != 0;
+#elif defined(HAS_AVX2)
+		// Also checks that the OS saves the AVX registers
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx2");
+#else
+		return false;
+#endif
+	}
+
+	const AudioMixerKernels* getKernelsFor(AudioMixerInstructionSet set)
+	{
+		switch (set) {
+		case AudioMixerInstructionSet::Scalar:
+			return &getAudioMixerKernelsScalar();
+		case AudioMixerInstructionSet::SSE2:
+			return getAudioMixerKernelsSSE2();
+		case AudioMixerInstructionSet::AVX2:
+			return cpuHasAVX2() ? getAudioMixerKernelsAVX2() : nullptr;
+		case AudioMixerInstructionSet::NEON:
+			return getAudioMixerKernelsNEON();
+		}
+		return nullptr;
+	}
+
+	std::atomic<const AudioMixerKernels*> currentKernels { nullptr };
+	std::atomic<AudioMixerInstructionSet> currentInstructionSet { AudioMixerInstructionSet::Scalar };
+
+	const AudioMixerKernels& getKernels()
+	{
+		const auto* kernels = currentKernels.load(std::memory_order_acquire);
+		if (!kernels) {
+			for (const auto set: { AudioMixerInstructionSet::AVX2, AudioMixerInstructionSet::NEON, AudioMixerInstructionSet::SSE2, AudioMixerInstructionSet::Scalar }) {
+				if (AudioMixer::isInstructionSetSupported(set)) {
+					AudioMixer::setInstructionSet(set);
+					break;
+				}
+			}
+			kernels = currentKernels.load(std::memory_order_acquire);
+		}
+		return *kernels;
+	}
+}
+
+bool AudioMixer::isInstructionSetSupported(AudioMixerInstructionSet set)
+{
+	return getKernelsFor(set) != nullptr;
+}
+
+AudioMixerInstructionSet AudioMixer::getInstructionSet()
+{
+	getKernels();
+	return currentInstructionSet.load();
+}
+
+void AudioMixer::setInstructionSet(AudioMixerInstructionSet set)
+{
+	const auto* kernels = getKernelsFor(set);
+	if (!kernels) {
+		throw Exception("Audio mixer instruction set \"" + toString(set) + "\" is not supported on this CPU.", HalleyExceptions::AudioEngine);
+	}
+	currentInstructionSet = set;
+	currentKernels.store(kernels, std::memory_order_release);
+}
+
+
 void AudioMixer::mixAudio(AudioSamplesConst src, AudioSamples dst, float gain0, float gain1)
 {
 	const auto nSamples = std::min(src.size(), dst.size());
+	if (nSamples == 0) {
+		return;
+	}
 
 	if (std::abs(gain0 - gain1) < 0.0001f) {
 		// If the gain doesn't change, the code is faster
 		if (std::abs(gain0 - 1.0f) < 0.0001f) {
 			// No need to even multiply
-			for (size_t i = 0; i < nSamples; ++i) {
-				dst[i] += src[i];
-			}
+			getKernels().mix(src.data(), dst.data(), nSamples);
 		} else if (std::abs(gain0) > 0.0001f) {
-			for (size_t i = 0; i < nSamples; ++i) {
-				dst[i] += src[i] * gain0;
-			}
+			getKernels().mixGain(src.data(), dst.data(), nSamples, gain0);
 		}
 	} else {
 		// Interpolate the gain
-		const float scale = 1.0f / nSamples;
-		for (size_t i = 0; i < nSamples; ++i) {
-			dst[i] += src[i] * lerp(gain0, gain1, i * scale);
-		}
+		getKernels().mixRamp(src.data(), dst.data(), nSamples, gain0, gain1);
 	}
 }
 
@@ -79,6 +439,11 @@ void AudioMixer::interleaveChannels(AudioSamples dstBuffer, gsl::span<AudioBuffe
 {
 	const size_t nChannels = srcs.size();	
 	const size_t nSamples = dstBuffer.size() / nChannels;
+	if (nChannels == 2) {
+		getKernels().interleaveStereo(srcs[0]->samples.data(), srcs[1]->samples.data(), dstBuffer.data(), nSamples);
+		return;
+	}
+
 	for (size_t i = 0; i < nSamples; ++i) {
 		for (size_t j = 0; j < nChannels; ++j) {
 			dstBuffer[i * nChannels + j] = srcs[j]->samples[i];
@@ -98,10 +463,7 @@ void AudioMixer::concatenateChannels(AudioSamples dst, gsl::span<AudioBuffer*> s
 
 void AudioMixer::compressRange(AudioSamples buffer)
 {
-	for (size_t i = 0; i < buffer.size(); ++i) {
-		float& sample = buffer[i];
-		sample = std::max(-0.99995f, std::min(sample, 0.99995f));
-	}
+	getKernels().clamp(buffer.data(), buffer.size(), 0.99995f);
 }
 
 void AudioMixer::zero(AudioSamples dst)
@@ -142,175 +504,18 @@ void AudioMixer::copy(AudioSamples dst, AudioSamples src, float gainStart, float
 {
 	const auto nSamples = std::min(src.size(), dst.size());
 
+	if (nSamples == 0) {
+		return;
+	}
+
 	if (std::abs(gainStart - gainEnd) < 0.0001f) {
 		if (std::abs(gainStart - 1.0f) < 0.0001f) {
 			copy(dst, src);
 		} else {
-			for (size_t i = 0; i < nSamples; ++i) {
-				dst[i] = src[i] * gainStart;
-			}
+			getKernels().copyGain(src.data(), dst.data(), nSamples, gainStart);
 		}
 	} else {
 		// Interpolate the gain
-		const float scale = 1.0f / nSamples;
-		for (size_t i = 0; i < nSamples; ++i) {
-			dst[i] = src[i] * lerp(gainStart, gainEnd, i * scale);
-		}
-	}
-}
-
-#ifdef HAS_SSE
-
-#ifdef _MSC_VER
-
-#include <intrin.h>
-
-#else
-
-#include <cpuid.h>
-static inline unsigned long long _xgetbv(unsigned int index){
-	unsigned int eax, edx;
-	__asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(index));
-	return ((unsigned long long)edx << 32) | eax;
-}
-#define _XCR_XFEATURE_ENABLED_MASK 0
-
-#endif
-
-#endif
-
-#ifdef HAS_AVX
-static bool hasAVX()
-{
-#ifndef _MSC_VER
-    // It's crashing on Linux :(
-    return false;
-#endif
-
-#ifdef HAS_SSE
-	int regs[4];
-	int i = 1;
-
-#ifdef _WIN32
-	__cpuid(regs, i);
-#else
-	asm volatile
-	("cpuid" : "=a" (regs[0]), "=b" (regs[1]), "=c" (regs[2]), "=d" (regs[3])
-	: "a" (i), "c" (0));
-	// ECX is set to zero for CPUID function 4
-#endif
-
-	bool osUsesXSAVE_XRSTORE = regs[2] & (1 << 27) || false;
-	bool cpuAVXSuport = regs[2] & (1 << 28) || false;
-
-	if (osUsesXSAVE_XRSTORE && cpuAVXSuport) {
-		unsigned long long xcrFeatureMask = _xgetbv(_XCR_XFEATURE_ENABLED_MASK);
-		return (xcrFeatureMask & 0x6) == 0x6;
-	} else {
-		return false;
-	}
-#else
-	return false;
-#endif
-}
-#endif
-
-
-/*
-#ifdef HAS_AVX
-void AudioMixerAVX::mixAudio(AudioSamplesConst srcRaw, AudioSamples dstRaw, float gain0, float gain1)
-{
-	gsl::span<const __m256> src(reinterpret_cast<const __m256*>(srcRaw.data()), srcRaw.size() * 2);
-	gsl::span<__m256> dst(reinterpret_cast<__m256*>(dstRaw.data()), dstRaw.size() * 2);
-	const size_t nSamples = size_t(src.size());
-
-	if (gain0 == gain1) {
-		__m256 gain = _mm256_broadcast_ss(&gain0);
-		for (size_t i = 0; i < nSamples; i += 2) {
-			dst[i] = _mm256_add_ps(dst[i], _mm256_mul_ps(src[i], gain));
-			dst[i + 1] = _mm256_add_ps(dst[i + 1], _mm256_mul_ps(src[i + 1], gain));
-		}
-	} else {
-		const float sc = 1.0f / (dst.size() * 16);
-		const float gainDiff = gain1 - gain0;
-		const float eight = 8.0f;
-
-		__m256 gain0p = _mm256_broadcast_ss(&gain0);
-		__m256 gain1p = _mm256_broadcast_ss(&gainDiff);
-		__m256 scale = _mm256_broadcast_ss(&sc);
-		__m256 inc = _mm256_broadcast_ss(&eight);
-		__m256 offset = { 0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f };
-		for (size_t i = 0; i < nSamples; ++i) {
-			__m256 t = _mm256_mul_ps(offset, scale);
-			__m256 gain = _mm256_add_ps(gain0p, _mm256_mul_ps(gain1p, t));
-			offset = _mm256_add_ps(offset, inc);
-			dst[i] = _mm256_add_ps(dst[i], _mm256_mul_ps(src[i], gain));
-		}
+		getKernels().copyRamp(src.data(), dst.data(), nSamples, gainStart, gainEnd);
 	}
 }
-
-void AudioMixerAVX::compressRange(AudioSamples buffer)
-{
-	gsl::span<__m256> dst(reinterpret_cast<__m256*>(buffer.data()), buffer.size() * 2);
-	const size_t nSamples = size_t(dst.size());
-
-	float val = 0.99995f;
-	__m256 minVal = { -val, -val, -val, -val, -val, -val, -val, -val };
-	__m256 maxVal = { val, val, val, val, val, val, val, val };
-
-	for (size_t i = 0; i < nSamples; ++i) {
-		dst[i] = _mm256_max_ps(minVal, _mm256_min_ps(dst[i], maxVal));
-	}
-}
-
-#endif
-
-#ifdef HAS_SSE
-
-void AudioMixerSSE::mixAudio(AudioSamplesConst srcRaw, AudioSamples dstRaw, float gain0, float gain1)
-{
-	gsl::span<const __m128> src(reinterpret_cast<const __m128*>(srcRaw.data()), srcRaw.size() * 4);
-	gsl::span<__m128> dst(reinterpret_cast<__m128*>(dstRaw.data()), dstRaw.size() * 4);
-	const size_t nSamples = size_t(src.size());
-
-	if (gain0 == gain1) {
-		__m128 gain = { gain0, gain0, gain0, gain0 };
-		for (size_t i = 0; i < nSamples; i += 4) {
-			dst[i] = _mm_add_ps(dst[i], _mm_mul_ps(src[i], gain));
-			dst[i + 1] = _mm_add_ps(dst[i + 1], _mm_mul_ps(src[i + 1], gain));
-			dst[i + 2] = _mm_add_ps(dst[i + 2], _mm_mul_ps(src[i + 2], gain));
-			dst[i + 3] = _mm_add_ps(dst[i + 3], _mm_mul_ps(src[i + 3], gain));
-		}
-	} else {
-		const float sc = 1.0f / (dst.size() * 16);
-		const float gainDiff = gain1 - gain0;
-
-		__m128 gain0p = { gain0, gain0, gain0, gain0 };
-		__m128 gain1p = { gainDiff, gainDiff, gainDiff, gainDiff };
-		__m128 scale = { sc, sc, sc, sc };
-		__m128 offset = { 0.0f, 1.0f, 2.0f, 3.0f };
-		__m128 inc = { 4.0f, 4.0f, 4.0f, 4.0f };
-		for (size_t i = 0; i < nSamples; ++i) {
-			__m128 t = _mm_mul_ps(offset, scale);
-			__m128 gain = _mm_add_ps(_mm_mul_ps(gain1p, t), gain0p);
-			offset = _mm_add_ps(offset, inc);
-			dst[i] = _mm_add_ps(dst[i], _mm_mul_ps(src[i], gain));
-		}
-	}
-}
-
-void AudioMixerSSE::compressRange(AudioSamples buffer)
-{
-	gsl::span<__m128> dst(reinterpret_cast<__m128*>(buffer.data()), buffer.size() * 4);
-	const size_t nSamples = size_t(dst.size());
-
-	float val = 0.99995f;
-	__m128 minVal = {-val, -val, -val, -val};
-	__m128 maxVal = {val, val, val, val};
-
-	for (size_t i = 0; i < nSamples; ++i) {
-		dst[i] = _mm_max_ps(minVal, _mm_min_ps(dst[i], maxVal));
-	}
-}
-#endif
-*/
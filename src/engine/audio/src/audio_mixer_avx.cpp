@@ -0,0 +1,147 @@
+#include "audio_mixer_kernels.h"
+
+// This file is built with AVX2 enabled, and only used after checking the CPU at runtime.
+// Keep it free of inline functions from other headers, as the linker could pick up their AVX2 versions for the rest of the program.
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(_M_IX86) || defined(__i386)
+
+#include <immintrin.h>
+
+using namespace Halley;
+
+namespace {
+	// Scalar tails, written out here rather than shared, for the reason above
+	float rampGain(float gain0, float gain1, size_t i, float scale)
+	{
+		const float t = i * scale;
+		return gain0 * (1 - t) + gain1 * t;
+	}
+
+	void mixAVX2(const float* src, float* dst, size_t n)
+	{
+		size_t i = 0;
+		for (; i + 8 <= n; i += 8) {
+			_mm256_storeu_ps(dst + i, _mm256_add_ps(_mm256_loadu_ps(dst + i), _mm256_loadu_ps(src + i)));
+		}
+		for (; i < n; ++i) {
+			dst[i] += src[i];
+		}
+	}
+
+	void mixGainAVX2(const float* src, float* dst, size_t n, float gain)
+	{
+		const __m256 g = _mm256_set1_ps(gain);
+		size_t i = 0;
+		for (; i + 8 <= n; i += 8) {
+			_mm256_storeu_ps(dst + i, _mm256_add_ps(_mm256_loadu_ps(dst + i), _mm256_mul_ps(_mm256_loadu_ps(src + i), g)));
+		}
+		for (; i < n; ++i) {
+			dst[i] += src[i] * gain;
+		}
+	}
+
+	__m256 rampGainAVX2(__m256i idx, __m256 g0, __m256 g1, __m256 scale)
+	{
+		const __m256 t = _mm256_mul_ps(_mm256_cvtepi32_ps(idx), scale);
+		return _mm256_add_ps(_mm256_mul_ps(g0, _mm256_sub_ps(_mm256_set1_ps(1.0f), t)), _mm256_mul_ps(g1, t));
+	}
+
+	void mixRampAVX2(const float* src, float* dst, size_t n, float gain0, float gain1)
+	{
+		const float scale = 1.0f / n;
+		const __m256 g0 = _mm256_set1_ps(gain0);
+		const __m256 g1 = _mm256_set1_ps(gain1);
+		const __m256 sc = _mm256_set1_ps(scale);
+		__m256i idx = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+		size_t i = 0;
+		for (; i + 8 <= n; i += 8) {
+			const __m256 gain = rampGainAVX2(idx, g0, g1, sc);
+			_mm256_storeu_ps(dst + i, _mm256_add_ps(_mm256_loadu_ps(dst + i), _mm256_mul_ps(_mm256_loadu_ps(src + i), gain)));
+			idx = _mm256_add_epi32(idx, _mm256_set1_epi32(8));
+		}
+		for (; i < n; ++i) {
+			dst[i] += src[i] * rampGain(gain0, gain1, i, scale);
+		}
+	}
+
+	void copyGainAVX2(const float* src, float* dst, size_t n, float gain)
+	{
+		const __m256 g = _mm256_set1_ps(gain);
+		size_t i = 0;
+		for (; i + 8 <= n; i += 8) {
+			_mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_loadu_ps(src + i), g));
+		}
+		for (; i < n; ++i) {
+			dst[i] = src[i] * gain;
+		}
+	}
+
+	void copyRampAVX2(const float* src, float* dst, size_t n, float gain0, float gain1)
+	{
+		const float scale = 1.0f / n;
+		const __m256 g0 = _mm256_set1_ps(gain0);
+		const __m256 g1 = _mm256_set1_ps(gain1);
+		const __m256 sc = _mm256_set1_ps(scale);
+		__m256i idx = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+		size_t i = 0;
+		for (; i + 8 <= n; i += 8) {
+			_mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_loadu_ps(src + i), rampGainAVX2(idx, g0, g1, sc)));
+			idx = _mm256_add_epi32(idx, _mm256_set1_epi32(8));
+		}
+		for (; i < n; ++i) {
+			dst[i] = src[i] * rampGain(gain0, gain1, i, scale);
+		}
+	}
+
+	void clampAVX2(float* buffer, size_t n, float limit)
+	{
+		// Operand order matches std::min/std::max, so NaNs come out the same as the scalar version
+		const __m256 maxVal = _mm256_set1_ps(limit);
+		const __m256 minVal = _mm256_set1_ps(-limit);
+		size_t i = 0;
+		for (; i + 8 <= n; i += 8) {
+			const __m256 v = _mm256_min_ps(maxVal, _mm256_loadu_ps(buffer + i));
+			_mm256_storeu_ps(buffer + i, _mm256_max_ps(v, minVal));
+		}
+		for (; i < n; ++i) {
+			float v = buffer[i];
+			v = limit < v ? limit : v;
+			buffer[i] = -limit < v ? v : -limit;
+		}
+	}
+
+	void interleaveStereoAVX2(const float* left, const float* right, float* dst, size_t n)
+	{
+		size_t i = 0;
+		for (; i + 8 <= n; i += 8) {
+			const __m256 l = _mm256_loadu_ps(left + i);
+			const __m256 r = _mm256_loadu_ps(right + i);
+			// Unpacking works within each 128-bit lane, so the halves need swapping afterwards
+			const __m256 lo = _mm256_unpacklo_ps(l, r);
+			const __m256 hi = _mm256_unpackhi_ps(l, r);
+			_mm256_storeu_ps(dst + 2 * i, _mm256_permute2f128_ps(lo, hi, 0x20));
+			_mm256_storeu_ps(dst + 2 * i + 8, _mm256_permute2f128_ps(lo, hi, 0x31));
+		}
+		for (; i < n; ++i) {
+			dst[2 * i] = left[i];
+			dst[2 * i + 1] = right[i];
+		}
+	}
+}
+
+const AudioMixerKernels* Halley::getAudioMixerKernelsAVX2()
+{
+	static const AudioMixerKernels kernels = { mixAVX2, mixGainAVX2, mixRampAVX2, copyGainAVX2, copyRampAVX2, clampAVX2, interleaveStereoAVX2 };
+	return &kernels;
+}
+
+#else
+
+const Halley::AudioMixerKernels* Halley::getAudioMixerKernelsAVX2()
+{
+	return nullptr;
+}
+
+#endif
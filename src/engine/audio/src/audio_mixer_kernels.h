@@ -0,0 +1,25 @@
+#pragma once
+#include <cstddef>
+
+namespace Halley
+{
+	// The inner loops behind AudioMixer, one set per instruction set.
+	// Every set must give bit-identical results to the scalar one, so they must not use FMA.
+	// Gain ramps use lerp(gain0, gain1, i * (1.0f / n)) for sample i.
+	struct AudioMixerKernels
+	{
+		void (*mix)(const float* src, float* dst, size_t n);
+		void (*mixGain)(const float* src, float* dst, size_t n, float gain);
+		void (*mixRamp)(const float* src, float* dst, size_t n, float gain0, float gain1);
+		void (*copyGain)(const float* src, float* dst, size_t n, float gain);
+		void (*copyRamp)(const float* src, float* dst, size_t n, float gain0, float gain1);
+		void (*clamp)(float* buffer, size_t n, float limit);
+		void (*interleaveStereo)(const float* left, const float* right, float* dst, size_t n);
+	};
+
+	// These return null if the set wasn't built for this architecture
+	const AudioMixerKernels& getAudioMixerKernelsScalar();
+	const AudioMixerKernels* getAudioMixerKernelsSSE2();
+	const AudioMixerKernels* getAudioMixerKernelsAVX2();
+	const AudioMixerKernels* getAudioMixerKernelsNEON();
+}
@@ -1,7 +1,7 @@
 #include "audio_source_clip.h"
 #include <utility>
 #include "audio_clip.h"
-#include "../audio_mixer.h"
+#include "audio_mixer.h"
 #include "../audio_engine.h"
 
 using namespace Halley;
@@ -42,6 +42,11 @@ void AudioSourceClip::restart()
 	initialised = false;
 }
 
+bool AudioSourceClip::canMixConcurrently() const
+{
+	return clip->canReadConcurrently();
+}
+
 bool AudioSourceClip::getAudioData(size_t samplesRequested, AudioMultiChannelSamples dstChannels)
 {
 	Expects(isReady());
@@ -14,6 +14,7 @@ namespace Halley
 		bool isReady() const override;
 		size_t getSamplesLeft() const override;
 		void restart() override;
+		bool canMixConcurrently() const override;
 
 	private:
 		AudioEngine& engine;
@@ -1,5 +1,5 @@
 #include "audio_source_delay.h"
-#include "../audio_mixer.h"
+#include "audio_mixer.h"
 using namespace Halley;
 
 AudioSourceDelay::AudioSourceDelay(std::unique_ptr<AudioSource> src, size_t delay)
@@ -51,6 +51,11 @@ void AudioSourceDelay::restart()
 	src->restart();
 }
 
+bool AudioSourceDelay::canMixConcurrently() const
+{
+	return src->canMixConcurrently();
+}
+
 void AudioSourceDelay::setInitialDelay(size_t delay)
 {
 	initialDelay = delay;
@@ -13,6 +13,7 @@ namespace Halley
 		bool isReady() const override;
 		size_t getSamplesLeft() const override;
         void restart() override;
+		bool canMixConcurrently() const override;
 		void setInitialDelay(size_t delay);
 
 	private:
@@ -6,7 +6,7 @@
 #include "audio_object.h"
 #include "audio_source_clip.h"
 #include "audio_source_delay.h"
-#include "../audio_mixer.h"
+#include "audio_mixer.h"
 #include "sub_objects/audio_sub_object_layers.h"
 
 using namespace Halley;
@@ -85,6 +85,11 @@ void AudioSourceLayers::restart()
 	}
 }
 
+bool AudioSourceLayers::canMixConcurrently() const
+{
+	return std::all_of(layers.begin(), layers.end(), [] (const Layer& layer) { return layer.source->canMixConcurrently(); });
+}
+
 AudioSourceLayers::Layer::Layer(std::unique_ptr<AudioSource> source, size_t idx)
 	: source(std::move(source))
 	, idx(idx)
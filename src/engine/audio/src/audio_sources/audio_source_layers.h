@@ -18,6 +18,7 @@ namespace Halley
 		bool isReady() const override;
 		size_t getSamplesLeft() const override;
 		void restart() override;
+		bool canMixConcurrently() const override;
 
 	private:
 		class Layer {
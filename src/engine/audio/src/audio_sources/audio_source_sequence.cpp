@@ -1,7 +1,7 @@
 #include "audio_source_sequence.h"
 
 #include "../audio_engine.h"
-#include "../audio_mixer.h"
+#include "audio_mixer.h"
 #include "halley/utils/algorithm.h"
 using namespace Halley;
 
@@ -137,6 +137,12 @@ void AudioSourceSequence::restart()
 	initialize();
 }
 
+bool AudioSourceSequence::canMixConcurrently() const
+{
+	// Tracks are loaded as the sequence plays, and are usually streamed music, so keep these together
+	return false;
+}
+
 size_t AudioSourceSequence::PlayingTrack::getSamplesBeforeNextEvent(size_t fadeLen) const
 {
 	const auto left = source->getSamplesLeft();
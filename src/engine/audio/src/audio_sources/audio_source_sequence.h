@@ -15,6 +15,7 @@ namespace Halley
 		bool isReady() const override;
 		size_t getSamplesLeft() const override;
 		void restart() override;
+		bool canMixConcurrently() const override;
 
 	private:
 		enum class TrackState {
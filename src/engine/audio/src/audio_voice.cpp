@@ -148,12 +148,17 @@ void AudioVoice::setPitch(float pitch)
 		if (resample) {
 			resample->setFromHz(freq);
 		} else {
-			resample = std::make_shared<AudioFilterResample>(source, freq, AudioConfig::sampleRate, engine.getPool());
+			resample = std::make_shared<AudioFilterResample>(source, freq, AudioConfig::sampleRate, engine);
 			source = resample;
 		}
 	}
 }
 
+bool AudioVoice::canMixConcurrently() const
+{
+	return source->canMixConcurrently();
+}
+
 size_t AudioVoice::getNumberOfChannels() const
 {
 	return nChannels;
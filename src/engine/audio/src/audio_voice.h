@@ -36,6 +36,7 @@ namespace Halley {
 		void setPitch(float pitch);
 
 		size_t getNumberOfChannels() const;
+		bool canMixConcurrently() const;
 
 		void update(gsl::span<const AudioChannelData> channels, const AudioPosition& sourcePos, const AudioListenerData& listener, float busGain);
 		void mixTo(size_t numSamples, gsl::span<AudioBuffer*> dst, AudioBufferPool& pool);
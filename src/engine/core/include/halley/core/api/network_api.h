@@ -11,10 +11,16 @@ namespace Halley
 		UDP
 	};
 
+	struct NetworkServiceOptions
+	{
+		// Services the socket on a thread of its own, instead of during NetworkService::update (UDP only)
+		bool threadedIO = false;
+	};
+
 	class NetworkAPI
 	{
 	public:
 		virtual ~NetworkAPI() {}
-		virtual std::unique_ptr<NetworkService> createService(NetworkProtocol protocol, int port = 0) = 0;
+		virtual std::unique_ptr<NetworkService> createService(NetworkProtocol protocol, int port = 0, NetworkServiceOptions options = {}) = 0;
 	};
 }
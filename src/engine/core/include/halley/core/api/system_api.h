@@ -6,6 +6,7 @@
 #include "halley/concurrency/concurrent.h"
 #include "halley/data_structures/maybe.h"
 #include "halley/core/input/input_keys.h"
+#include "halley/support/profiler.h"
 
 namespace Halley
 {
@@ -51,6 +52,7 @@ namespace Halley
 		{
 			return std::thread([=] () {
 				setThreadName(name);
+				ProfilerCapture::setThreadName(name);
 				runnable();
 			});
 		}
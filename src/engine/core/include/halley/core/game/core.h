@@ -60,6 +60,7 @@ namespace Halley
 		Vector<Plugin*> getPlugins(PluginType type) override;
 
 		void log(LoggerLevel level, const String& msg) override;
+		void flush() override;
 
 		void addProfilerCallback(IProfileCallback* callback) override;
 		void removeProfilerCallback(IProfileCallback* callback) override;
@@ -35,6 +35,7 @@ namespace Halley
 		virtual String getDataPath() const = 0;
 		virtual bool isDevMode() const = 0;
 		virtual bool shouldCreateSeparateConsole() const;
+		virtual bool shouldLogAsynchronously() const;
 		virtual ConsoleInfo getConsoleInfo() const;
 
 		virtual std::unique_ptr<Stage> startGame() = 0;
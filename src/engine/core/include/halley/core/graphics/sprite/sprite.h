@@ -70,6 +70,7 @@ namespace Halley
 			return *material;
 		}
 		bool hasMaterial() const { return material != nullptr; }
+		const std::shared_ptr<Material>& getMaterialPtr() const { return material; }
 		bool hasCompatibleMaterial(const Material& other) const;
 
 		Sprite& setImage(Resources& resources, const String& imageName, String materialName = "");
@@ -164,6 +165,10 @@ namespace Halley
 			return getAABB().overlaps(rect) && visible;
 		}
 
+		// True if drawing this sprite is just copying its vertex data, so it can share a drawSprites() call with others using the same material
+		bool canBatch() const { return material && !sliced && !hasClip; }
+		const SpriteVertexAttrib& getVertexAttrib() const { return vertexAttrib; }
+
 		Vector4s getOuterBorder() const { return outerBorder; }
 		Sprite& setOuterBorder(Vector4s border);
 
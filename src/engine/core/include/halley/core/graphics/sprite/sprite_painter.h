@@ -15,6 +15,7 @@ namespace Halley
 	class Sprite;
 	class Painter;
 	class Material;
+	struct SpriteVertexAttrib;
 
 	class MaterialRecycler {
 	public:
@@ -57,6 +58,8 @@ namespace Halley
 		uint32_t getIndex() const;
 		uint32_t getCount() const;
 		int getMask() const;
+		int getLayer() const;
+		float getTieBreaker() const;
 		const std::optional<Rect4f>& getClip() const;
 
 	private:
@@ -74,6 +77,23 @@ namespace Halley
 	class SpritePainter
 	{
 	public:
+		struct DrawListEntry {
+			int layer;
+			float tieBreaker;
+			uint32_t entryIdx; // Entries are indexed in insertion order, so this also breaks ties
+
+			bool operator<(const DrawListEntry& o) const
+			{
+				if (layer != o.layer) {
+					return layer < o.layer;
+				} else if (tieBreaker != o.tieBreaker) {
+					return tieBreaker < o.tieBreaker;
+				} else {
+					return entryIdx < o.entryIdx;
+				}
+			}
+		};
+
 		void start(bool forceCopy = false);
 		
 		void add(const Sprite& sprite, int mask, int layer, float tieBreaker, std::optional<Rect4f> clip = {});
@@ -88,6 +108,10 @@ namespace Halley
 		
 		void draw(int mask, Painter& painter);
 
+		// Returns the entries matching mask and view, in draw order. Rebuilt only if the painter, mask or view changed since the last call.
+		const Vector<DrawListEntry>& getDrawList(int mask, Rect4f view);
+		const SpritePainterEntry& getEntry(size_t idx) const;
+
 	private:
 		Vector<SpritePainterEntry> sprites;
 		Vector<Sprite> cachedSprites;
@@ -96,9 +120,24 @@ namespace Halley
 		bool dirty = false;
 		bool forceCopy = false;
 
+		Vector<DrawListEntry> drawList;
+		Vector<DrawListEntry> drawListScratch;
+		Vector<uint32_t> layerBuckets;
+		int drawListMask = 0;
+		Rect4f drawListView;
+
+		Vector<SpriteVertexAttrib> batchVertices;
+		std::shared_ptr<Material> batchMaterial;
+
 		MaterialRecycler materialRecycler;
 
-		void draw(gsl::span<const Sprite> sprite, Painter& painter, Rect4f view, const std::optional<Rect4f>& clip) const;
+		bool isEntryInView(const SpritePainterEntry& entry, Rect4f view) const;
+		void sortDrawList();
+
+		void batch(const Sprite& sprite, Painter& painter);
+		void flushBatch(Painter& painter);
+
+		void draw(gsl::span<const Sprite> sprite, Painter& painter, Rect4f view, const std::optional<Rect4f>& clip);
 		void draw(gsl::span<const TextRenderer> text, Painter& painter, Rect4f view, const std::optional<Rect4f>& clip) const;
 		void draw(const SpritePainterEntry::Callback& callback, Painter& painter, const std::optional<Rect4f>& clip) const;
 	};
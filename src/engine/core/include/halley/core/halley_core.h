@@ -69,6 +69,7 @@ namespace Halley {} // Get GitHub to realise this is C++ :3
 #include "resources/asset_pack.h"
 #include "resources/resources.h"
 #include "resources/resource_locator.h"
+#include "resources/resource_prefetcher.h"
 #include "resources/resource_reference.h"
 
 #include "stage/stage.h"
@@ -57,6 +57,8 @@ namespace Halley {
 		std::mutex readerMutex;
 		size_t dataOffset = 0;
 		Bytes data;
+		std::shared_ptr<const char> mappedData; // Start of the data section, if the reader is memory-mapped
+		size_t mappedDataSize = 0;
 		std::array<char, 16> iv;
     };
 
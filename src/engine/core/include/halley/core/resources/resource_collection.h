@@ -5,6 +5,7 @@
 #include <functional>
 #include <shared_mutex>
 #include <halley/concurrency/shared_recursive_mutex.h>
+#include <halley/concurrency/future.h>
 #include <halley/text/halleystring.h>
 #include <halley/resources/resource_data.h>
 #include <halley/data_structures/hash_map.h>
@@ -31,7 +32,23 @@ namespace Halley
 			int depth;
 		};
 
+		// A load that's in progress on some thread; anyone else asking for the same asset waits on it
+		class PendingLoad
+		{
+		public:
+			Promise<void> promise;
+			std::shared_ptr<Resource> result;
+			std::exception_ptr error;
+			std::thread::id loadingThread;
+		};
+
 	public:
+		struct UnreferencedResource {
+			String assetId;
+			float age;
+			size_t bytes;
+		};
+
 		using ResourceLoaderFunc = std::function<std::shared_ptr<Resource>(const String&, ResourceLoadPriority)>;
 		using ResourceEnumeratorFunc = std::function<Vector<String>()>;
 
@@ -46,6 +63,7 @@ namespace Halley
 		void unload(const String& assetId);
 		void unloadAll(int minDepth = 0);
 		bool exists(const String& assetId) const;
+		bool isLoaded(const String& assetId) const;
 		void setFallback(const String& assetId);
 
 		void reload(const String& assetId);
@@ -53,6 +71,9 @@ namespace Halley
 
 		std::shared_ptr<Resource> getUntyped(const String& name, ResourceLoadPriority priority = ResourceLoadPriority::Normal);
 
+		// Loads on the disk IO executor, higher priorities first. Yields nullptr (after logging) if the asset fails to load.
+		Future<std::shared_ptr<Resource>> getUntypedAsync(const String& name, ResourceLoadPriority priority = ResourceLoadPriority::Normal);
+
 		Vector<String> enumerate() const;
 
 		AssetType getAssetType() const;
@@ -64,15 +85,21 @@ namespace Halley
 		/// <returns>How much memory was freed</returns>
 		ResourceMemoryUsage clearOldResources(float maxAge);
 
+		void getUnreferencedResources(Vector<UnreferencedResource>& dst) const;
+		bool unloadIfUnreferenced(const String& assetId);
+
 	protected:
 		virtual std::shared_ptr<Resource> loadResource(ResourceLoader& loader) = 0;
 
 		std::shared_ptr<Resource> doGet(const String& name, ResourceLoadPriority priority, bool allowFallback);
+		void doGetAsync(const String& name, ResourceLoadPriority priority, std::function<void(std::shared_ptr<Resource>)> callback);
 		std::pair<std::shared_ptr<Resource>, bool> loadAsset(const String& assetId, ResourceLoadPriority priority, bool allowFallback);
+		std::shared_ptr<Resource> storeLoadedAsset(const String& assetId, std::pair<std::shared_ptr<Resource>, bool> loadResult, bool finishPendingLoad);
 
 	private:
 		Resources& parent;
 		HashMap<String, Wrapper> resources;
+		HashMap<String, std::shared_ptr<PendingLoad>> pendingLoads;
 		String fallback;
 		AssetType type;
 		ResourceLoaderFunc resourceLoader;
@@ -95,6 +122,17 @@ namespace Halley
 			return std::static_pointer_cast<T>(doGet(assetId, priority, true));
 		}
 
+		Future<std::shared_ptr<const T>> getAsync(const String& assetId, ResourceLoadPriority priority = ResourceLoadPriority::Normal)
+		{
+			Promise<std::shared_ptr<const T>> promise;
+			auto future = promise.getFuture();
+			doGetAsync(assetId, priority, [promise] (std::shared_ptr<Resource> res) mutable
+			{
+				promise.setValue(std::static_pointer_cast<T>(std::move(res)));
+			});
+			return future;
+		}
+
 	protected:
 		std::shared_ptr<Resource> loadResource(ResourceLoader& loader) override {
 			return T::loadResource(loader);
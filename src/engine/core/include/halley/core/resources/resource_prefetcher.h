@@ -0,0 +1,78 @@
+#pragma once
+
+#include <mutex>
+#include "resources.h"
+#include "halley/time/halleytime.h"
+
+namespace Halley {
+	// Loads resources ahead of time from hints (e.g. everything a scene being loaded will use), and keeps
+	// the total memory used by resources under a budget by unloading the least recently used ones nobody holds on to.
+	class ResourcePrefetcher {
+	public:
+		struct Stats {
+			uint64_t hits = 0; // Was already loaded when requested
+			uint64_t misses = 0; // Wasn't loaded or hinted, so had to load on the spot
+			uint64_t stalls = 0; // Was hinted, but still loading when requested
+			Time stallTime = 0;
+			uint64_t prefetches = 0;
+			uint64_t evictions = 0;
+			size_t evictedBytes = 0;
+			size_t residentBytes = 0;
+		};
+
+		ResourcePrefetcher(Resources& resources, size_t budgetBytes);
+		~ResourcePrefetcher();
+
+		ResourcePrefetcher(const ResourcePrefetcher& other) = delete;
+		ResourcePrefetcher& operator=(const ResourcePrefetcher& other) = delete;
+
+		void setBudget(size_t bytes);
+		size_t getBudget() const;
+
+		// How long a prefetched resource is kept alive if it's never requested
+		void setHintLifetime(Time time);
+
+		void prefetch(AssetType type, const String& assetId, ResourceLoadPriority priority = ResourceLoadPriority::Low);
+		void prefetch(const String& typedAssetId, ResourceLoadPriority priority = ResourceLoadPriority::Low); // "type:name" format
+
+		template <typename T>
+		void prefetch(const String& assetId, ResourceLoadPriority priority = ResourceLoadPriority::Low)
+		{
+			prefetch(T::getAssetType(), assetId, priority);
+		}
+
+		template <typename T>
+		std::shared_ptr<const T> get(const String& assetId, ResourceLoadPriority priority = ResourceLoadPriority::Normal)
+		{
+			return std::static_pointer_cast<const T>(getUntyped(T::getAssetType(), assetId, priority));
+		}
+
+		std::shared_ptr<Resource> getUntyped(AssetType type, const String& assetId, ResourceLoadPriority priority = ResourceLoadPriority::Normal);
+
+		// Drops any prefetched resources that haven't been requested yet, so they become eligible for eviction
+		void clearHints();
+
+		// Ages resources and evicts down to the budget; call this once per frame
+		void update(Time t);
+
+		Stats getStats() const;
+		void resetStats();
+
+	private:
+		struct Hint {
+			std::shared_ptr<Resource> resource; // Keeps it loaded until it's requested or the hint expires
+			Future<std::shared_ptr<Resource>> future;
+			Time timeLeft = 0;
+		};
+
+		Resources& resources;
+		size_t budget;
+		Time hintLifetime = 30.0;
+
+		mutable std::mutex mutex;
+		HashMap<String, Hint> hints; // Keyed by "type:name"
+		Stats stats;
+
+		void evict(size_t totalBytes);
+	};
+}
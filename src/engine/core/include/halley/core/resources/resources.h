@@ -23,6 +23,9 @@
 
 #include <ctime>
 #include <algorithm>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
 #include <halley/support/exception.h>
 #include "halley/resources/resource.h"
 #include "resource_collection.h"
@@ -66,6 +69,12 @@ namespace Halley {
 			return of<T>().get(name, priority);
 		}
 
+		template <typename T>
+		Future<std::shared_ptr<const T>> getAsync(const String& name, ResourceLoadPriority priority = ResourceLoadPriority::Normal) const
+		{
+			return of<T>().getAsync(name, priority);
+		}
+
 		template <typename T>
 		void preload(const String& name) const
 		{
@@ -110,6 +119,8 @@ namespace Halley {
 			return of<T>().enumerate();
 		}
 
+		Vector<ResourceCollectionBase*> getCollections() const;
+
 		ResourceLocator& getLocator()
 		{
 			return *locator;
@@ -123,9 +134,32 @@ namespace Halley {
 		void generateMemoryReport();
 
 	private:
+		class AsyncLoadQueue {
+		public:
+			// If the queue gets closed before the load runs, cancel runs instead
+			void enqueue(ResourceLoadPriority priority, std::function<void()> load, std::function<void()> cancel);
+			void runNext();
+			void close();
+
+		private:
+			struct AsyncLoad {
+				std::function<void()> load;
+				std::function<void()> cancel;
+			};
+
+			std::mutex mutex;
+			std::condition_variable idle;
+			std::array<std::deque<AsyncLoad>, 3> loads; // Indexed by ResourceLoadPriority
+			size_t nRunning = 0;
+			bool closed = false;
+		};
+
 		const std::unique_ptr<ResourceLocator> locator;
+		std::shared_ptr<AsyncLoadQueue> asyncLoads;
 		Vector<std::unique_ptr<ResourceCollectionBase>> resources;
 		const HalleyAPI* const api;
 		ResourceOptions options;
+
+		void enqueueAsyncLoad(ResourceLoadPriority priority, std::function<void()> load, std::function<void()> cancel);
 	};
 }
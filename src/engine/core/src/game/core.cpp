@@ -136,6 +136,7 @@ void Core::onReloaded()
 	if (api->system) {
 		api->system->setThreadName("main");
 	}
+	ProfilerCapture::setThreadName("main");
 
 	if (api->systemInternal) {
 		api->systemInternal->onResume();
@@ -157,6 +158,8 @@ void Core::onReloaded()
 
 void Core::onTerminatedInError(const std::string& error)
 {
+	Logger::flush();
+
 	if (!error.empty()) {
 		std::cout << ConsoleColour(Console::RED) << "\n\nUnhandled exception: " << ConsoleColour(Console::DARK_RED) << error << ConsoleColour() << std::endl;
 	} else {
@@ -180,6 +183,11 @@ void Core::init()
 {
 	Expects(!initialized);
 	initialized = true;
+
+	// Have log messages written by a background thread, so whoever logs doesn't wait on console I/O
+	if (game->shouldLogAsynchronously()) {
+		Logger::setAsync(true);
+	}
 	
 	// Initialize API
 	api->init();
@@ -188,6 +196,7 @@ void Core::init()
 	if (api->system) {
 		api->system->setThreadName("main");
 	}
+	ProfilerCapture::setThreadName("main");
 
 	// Resources
 	initResources();
@@ -218,6 +227,7 @@ DevConClient* Core::getDevConClient() const
 
 void Core::deInit()
 {
+	Logger::setAsync(false);
 	std::cout << "Game shutting down." << std::endl;
 	Expects(initialized);
 	initialized = false;
@@ -653,7 +663,17 @@ void Core::log(LoggerLevel level, const String& msg)
 	std::cout << std::put_time(&buffer, "%T")  << '.' << std::setfill('0') << std::setw(3) << ms.count() << " ";
 	*/
 
-	std::cout << msg << ConsoleColour() << std::endl;
+	std::cout << msg << ConsoleColour() << '\n';
+
+	// When async, this gets flushed once per batch instead
+	if (!Logger::isAsync()) {
+		std::cout.flush();
+	}
+}
+
+void Core::flush()
+{
+	std::cout.flush();
 }
 
 void IHalleyEntryPoint::initSharedStatics(const HalleyStatics& parent)
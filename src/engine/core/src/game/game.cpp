@@ -20,6 +20,11 @@ bool Game::shouldCreateSeparateConsole() const
 	return isDevMode();
 }
 
+bool Game::shouldLogAsynchronously() const
+{
+	return false;
+}
+
 Game::ConsoleInfo Game::getConsoleInfo() const
 {
 	return ConsoleInfo{ getName() + " [Console]", {}, Vector2f(0.5f, 0.5f) };
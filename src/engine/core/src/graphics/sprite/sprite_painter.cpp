@@ -4,6 +4,7 @@
 #include <gsl/gsl>
 
 #include "graphics/material/material.h"
+#include "graphics/material/material_definition.h"
 #include "graphics/text/text_renderer.h"
 #include "halley/utils/algorithm.h"
 
@@ -128,6 +129,16 @@ int SpritePainterEntry::getMask() const
 	return mask;
 }
 
+int SpritePainterEntry::getLayer() const
+{
+	return layer;
+}
+
+float SpritePainterEntry::getTieBreaker() const
+{
+	return tieBreaker;
+}
+
 const std::optional<Rect4f>& SpritePainterEntry::getClip() const
 {
 	return clip;
@@ -139,7 +150,12 @@ void SpritePainter::start(bool forceCopy)
 	sprites.clear();
 	cachedSprites.clear();
 	cachedText.clear();
+	callbacks.clear();
 	materialRecycler.startFrame();
+
+	// The draw list points into what was just cleared, so it must be rebuilt even if nothing gets added this frame
+	drawList.clear();
+	dirty = true;
 }
 
 void SpritePainter::add(const Sprite& sprite, int mask, int layer, float tieBreaker, std::optional<Rect4f> clip)
@@ -232,29 +248,22 @@ void SpritePainter::add(SpritePainterEntry::Callback callback, int mask, int lay
 
 void SpritePainter::draw(int mask, Painter& painter)
 {
-	if (dirty) {
-		// TODO: implement hierarchical bucketing.
-		// - one bucket per layer
-		// - for each layer, one bucket per vertical band of the screen (32px or so)
-		// - sort each leaf bucket
-		std::sort(sprites.begin(), sprites.end()); // lol
-		dirty = false;
-	}
-
 	// View
 	const auto& cam = painter.getCurrentCamera();
 	Rect4f view = cam.getClippingRectangle();
 
 	// Draw!
-	for (auto& s : sprites) {
-		if ((s.getMask() & mask) != 0) {
-			const auto type = s.getType();
-			
-			if (type == SpritePainterEntryType::SpriteRef) {
-				draw(s.getSprites(), painter, view, s.getClip());
-			} else if (type == SpritePainterEntryType::SpriteCached) {
-				draw(gsl::span<const Sprite>(cachedSprites.data() + s.getIndex(), s.getCount()), painter, view, s.getClip());
-			} else if (type == SpritePainterEntryType::TextRef) {
+	for (const auto& e: getDrawList(mask, view)) {
+		const auto& s = sprites[e.entryIdx];
+		const auto type = s.getType();
+
+		if (type == SpritePainterEntryType::SpriteRef) {
+			draw(s.getSprites(), painter, view, s.getClip());
+		} else if (type == SpritePainterEntryType::SpriteCached) {
+			draw(gsl::span<const Sprite>(cachedSprites.data() + s.getIndex(), s.getCount()), painter, view, s.getClip());
+		} else {
+			flushBatch(painter);
+			if (type == SpritePainterEntryType::TextRef) {
 				draw(s.getTexts(), painter, view, s.getClip());
 			} else if (type == SpritePainterEntryType::TextCached) {
 				draw(gsl::span<const TextRenderer>(cachedText.data() + s.getIndex(), s.getCount()), painter, view, s.getClip());
@@ -263,14 +272,131 @@ void SpritePainter::draw(int mask, Painter& painter)
 			}
 		}
 	}
+	flushBatch(painter);
 	painter.flush();
 }
 
-void SpritePainter::draw(gsl::span<const Sprite> sprites, Painter& painter, Rect4f view, const std::optional<Rect4f>& clip) const
+const Vector<SpritePainter::DrawListEntry>& SpritePainter::getDrawList(int mask, Rect4f view)
+{
+	if (dirty || mask != drawListMask || view != drawListView) {
+		// Cull first, so only what's actually going to be drawn gets sorted
+		drawList.clear();
+		for (size_t i = 0; i < sprites.size(); ++i) {
+			const auto& s = sprites[i];
+			if ((s.getMask() & mask) != 0 && isEntryInView(s, view)) {
+				drawList.push_back(DrawListEntry{ s.getLayer(), s.getTieBreaker(), uint32_t(i) });
+			}
+		}
+		sortDrawList();
+
+		dirty = false;
+		drawListMask = mask;
+		drawListView = view;
+	}
+	return drawList;
+}
+
+const SpritePainterEntry& SpritePainter::getEntry(size_t idx) const
+{
+	return sprites.at(idx);
+}
+
+bool SpritePainter::isEntryInView(const SpritePainterEntry& entry, Rect4f view) const
+{
+	// Spans of several sprites are culled one by one as they're drawn
+	if (entry.getCount() == 1) {
+		const auto type = entry.getType();
+		if (type == SpritePainterEntryType::SpriteRef) {
+			return entry.getSprites()[0].isInView(view);
+		} else if (type == SpritePainterEntryType::SpriteCached) {
+			return cachedSprites[entry.getIndex()].isInView(view);
+		}
+	}
+	return true;
+}
+
+void SpritePainter::sortDrawList()
+{
+	// Entries are usually submitted mostly in order, so check for that first
+	if (drawList.empty() || std::is_sorted(drawList.begin(), drawList.end())) {
+		return;
+	}
+
+	int minLayer = drawList[0].layer;
+	int maxLayer = minLayer;
+	for (const auto& e: drawList) {
+		minLayer = std::min(minLayer, e.layer);
+		maxLayer = std::max(maxLayer, e.layer);
+	}
+
+	// Layers are normally a small dense range, so bucket them with a counting sort. Otherwise, fall back to a plain sort.
+	const auto layerRange = int64_t(maxLayer) - int64_t(minLayer) + 1;
+	if (layerRange > int64_t(std::max(drawList.size(), size_t(1024)))) {
+		std::sort(drawList.begin(), drawList.end());
+		return;
+	}
+
+	layerBuckets.clear();
+	layerBuckets.resize(size_t(layerRange) + 1, 0);
+	for (const auto& e: drawList) {
+		++layerBuckets[e.layer - minLayer + 1];
+	}
+	for (size_t i = 1; i < layerBuckets.size(); ++i) {
+		layerBuckets[i] += layerBuckets[i - 1];
+	}
+
+	// Stable scatter, so each bucket stays in insertion order
+	drawListScratch.resize(drawList.size());
+	for (const auto& e: drawList) {
+		drawListScratch[layerBuckets[e.layer - minLayer]++] = e;
+	}
+	std::swap(drawList, drawListScratch);
+
+	// After the scatter, each bucket's offset points to its end. Each bucket now only needs ordering by tie breaker, and often already is.
+	uint32_t bucketStart = 0;
+	for (size_t i = 0; i + 1 < layerBuckets.size(); ++i) {
+		const auto bucketEnd = layerBuckets[i];
+		const auto begin = drawList.begin() + bucketStart;
+		const auto end = drawList.begin() + bucketEnd;
+		if (end - begin > 1 && !std::is_sorted(begin, end)) {
+			std::sort(begin, end, [] (const DrawListEntry& a, const DrawListEntry& b)
+			{
+				return a.tieBreaker != b.tieBreaker ? a.tieBreaker < b.tieBreaker : a.entryIdx < b.entryIdx;
+			});
+		}
+		bucketStart = bucketEnd;
+	}
+}
+
+void SpritePainter::batch(const Sprite& sprite, Painter& painter)
+{
+	if (sprite.getMaterialPtr() != batchMaterial) {
+		flushBatch(painter);
+		batchMaterial = sprite.getMaterialPtr();
+	}
+	batchVertices.push_back(sprite.getVertexAttrib());
+}
+
+void SpritePainter::flushBatch(Painter& painter)
+{
+	if (!batchVertices.empty()) {
+		Expects(batchMaterial->getDefinition().getVertexStride() == sizeof(SpriteVertexAttrib));
+		painter.drawSprites(batchMaterial, batchVertices.size(), batchVertices.data());
+		batchVertices.clear();
+	}
+	batchMaterial.reset();
+}
+
+void SpritePainter::draw(gsl::span<const Sprite> sprites, Painter& painter, Rect4f view, const std::optional<Rect4f>& clip)
 {
 	for (const auto& sprite: sprites) {
-		if (sprite.isInView(view)) {
-			sprite.draw(painter, clip);
+		if (sprites.size() == 1 || sprite.isInView(view)) {
+			if (sprite.canBatch() && !clip) {
+				batch(sprite, painter);
+			} else {
+				flushBatch(painter);
+				sprite.draw(painter, clip);
+			}
 		}
 	}
 }
@@ -64,6 +64,12 @@ AssetPack::AssetPack(std::unique_ptr<ResourceDataReader> _reader, const String&
 	memset(ivEmpty.data(), 0, ivEmpty.size());
 	const bool hasCrypt = memcmp(iv.data(), ivEmpty.data(), iv.size()) != 0 && !encryptionKey.isEmpty();
 
+	if (auto mapped = reader->getMappedData(); mapped && !hasCrypt) {
+		// Assets can be served straight out of the mapping, without any locking or copying
+		mappedDataSize = totalSize - std::min(totalSize, dataOffset);
+		mappedData = std::shared_ptr<const char>(mapped, mapped.get() + dataOffset);
+	}
+
 	if (preLoad || hasCrypt) {
 		readToMemory();
 	}
@@ -85,6 +91,8 @@ AssetPack& AssetPack::operator=(AssetPack&& other) noexcept
 	dataOffset = other.dataOffset;
 	reader = std::move(other.reader);
 	data = std::move(other.data);
+	mappedData = std::move(other.mappedData);
+	mappedDataSize = other.mappedDataSize;
 	hasReader = !!reader;
 
 	other.hasReader = false;
@@ -139,7 +147,14 @@ std::unique_ptr<ResourceData> AssetPack::getData(const String& asset, AssetType
 			return std::make_unique<PackDataReader>(*this, pos, size);
 		});
 	} else {
-		if (hasReader) {
+		if (mappedData) {
+			if (pos + size > mappedDataSize) {
+				throw Exception("Asset \"" + asset + "\" is out of pack bounds.", HalleyExceptions::Resources);
+			}
+
+			// Aliases the mapping, so the data stays valid even if the pack is purged
+			return std::make_unique<ResourceDataStatic>(std::shared_ptr<const char>(mappedData, mappedData.get() + pos), size, path);
+		} else if (hasReader) {
 			auto result = new char[size];
 			try {
 				readData(pos, gsl::as_writable_bytes(gsl::span<char>(result, size)));
@@ -162,8 +177,13 @@ std::unique_ptr<ResourceData> AssetPack::getData(const String& asset, AssetType
 void AssetPack::readToMemory()
 {
 	std::unique_lock<std::mutex> lock(readerMutex);
-	reader->seek(dataOffset, SEEK_SET);
-	data = reader->readAll();
+	if (mappedData) {
+		data = Bytes(reinterpret_cast<const Byte*>(mappedData.get()), reinterpret_cast<const Byte*>(mappedData.get()) + mappedDataSize);
+		mappedData.reset();
+	} else {
+		reader->seek(dataOffset, SEEK_SET);
+		data = reader->readAll();
+	}
 	hasReader = false;
 	reader.reset();
 }
@@ -188,6 +208,14 @@ void AssetPack::decrypt(const String& key)
 
 void AssetPack::readData(size_t pos, gsl::span<gsl::byte> dst)
 {
+	if (mappedData) {
+		if (pos + size_t(dst.size()) > mappedDataSize) {
+			throw Exception("Asset data is out of pack bounds.", HalleyExceptions::Resources);
+		}
+		memcpy(dst.data(), mappedData.get() + pos, dst.size());
+		return;
+	}
+
 	if (hasReader) {
 		std::unique_lock<std::mutex> lock(readerMutex);
 		if (reader) {
@@ -208,6 +236,7 @@ std::unique_ptr<ResourceDataReader> AssetPack::extractReader()
 {
 	std::unique_lock<std::mutex> lock(readerMutex);
 	hasReader = false;
+	mappedData.reset();
 	return std::move(reader);
 }
 
@@ -71,6 +71,17 @@ std::shared_ptr<Resource> ResourceCollectionBase::getUntyped(const String& name,
 	return doGet(name, priority, true);
 }
 
+Future<std::shared_ptr<Resource>> ResourceCollectionBase::getUntypedAsync(const String& name, ResourceLoadPriority priority)
+{
+	Promise<std::shared_ptr<Resource>> promise;
+	auto future = promise.getFuture();
+	doGetAsync(name, priority, [promise] (std::shared_ptr<Resource> res) mutable
+	{
+		promise.setValue(std::move(res));
+	});
+	return future;
+}
+
 Vector<String> ResourceCollectionBase::enumerate() const
 {
 	if (resourceEnumerator) {
@@ -143,6 +154,39 @@ ResourceMemoryUsage ResourceCollectionBase::clearOldResources(float maxAge)
 	return usage;
 }
 
+void ResourceCollectionBase::getUnreferencedResources(Vector<UnreferencedResource>& dst) const
+{
+	std::shared_lock lock(mutex);
+
+	// Unlike ageing, this only counts resources that nothing but this collection holds on to, so unloading them really frees them
+	for (auto& r: resources) {
+		auto& resourcePtr = r.second.res;
+		if (resourcePtr.use_count() == 1) {
+			const auto usage = resourcePtr->getMemoryUsage();
+			dst.push_back(UnreferencedResource{ r.first, resourcePtr->getAge(), usage.ramUsage + usage.vramUsage });
+		}
+	}
+}
+
+bool ResourceCollectionBase::unloadIfUnreferenced(const String& assetId)
+{
+	std::shared_ptr<Resource> toDelete;
+
+	{
+		std::unique_lock lock(mutex);
+		const auto iter = resources.find(assetId);
+		if (iter == resources.end() || iter->second.res.use_count() != 1) {
+			return false;
+		}
+		toDelete = std::move(iter->second.res);
+		resources.erase(iter);
+	}
+
+	// Delete out of the lock, as with clearOldResources
+	toDelete.reset();
+	return true;
+}
+
 ResourceMemoryUsage ResourceCollectionBase::getMemoryUsageAndAge(float time)
 {
 	ResourceMemoryUsage usage;
@@ -202,26 +246,125 @@ std::shared_ptr<Resource> ResourceCollectionBase::doGet(const String& assetId, R
 	}
 
 	// Lock mutex, and make sure it's still not there (someone else might have gone through this by now)
-	std::unique_lock lockWrite(mutex);
-	const auto res = resources.find(assetId);
-	if (res != resources.end()) {
-		return res->second.res;
+	// If someone else is already loading it, wait for them instead, otherwise register our own load
+	std::shared_ptr<PendingLoad> pending;
+	bool isLoader = false;
+	{
+		std::unique_lock lockWrite(mutex);
+		const auto res = resources.find(assetId);
+		if (res != resources.end()) {
+			return res->second.res;
+		}
+
+		const auto iter = pendingLoads.find(assetId);
+		if (iter != pendingLoads.end()) {
+			pending = iter->second;
+		} else {
+			pending = std::make_shared<PendingLoad>();
+			pending->loadingThread = std::this_thread::get_id();
+			pendingLoads[assetId] = pending;
+			isLoader = true;
+		}
+	}
+
+	if (!isLoader) {
+		if (pending->loadingThread == std::this_thread::get_id()) {
+			// We're already loading this further up the stack (e.g. a worker helping with other tasks while it waits), so waiting would never finish
+			// Load it here instead, and cache it, so that the load further up finds it when it's done
+			return storeLoadedAsset(assetId, loadAsset(assetId, priority, allowFallback), false);
+		}
+
+		pending->promise.getFuture().wait();
+		if (pending->error) {
+			std::rethrow_exception(pending->error);
+		}
+		return pending->result;
+	}
+
+	// Load resource from disk, without holding the lock
+	try {
+		pending->result = storeLoadedAsset(assetId, loadAsset(assetId, priority, allowFallback), true);
+	} catch (...) {
+		pending->error = std::current_exception();
+		{
+			std::unique_lock lockWrite(mutex);
+			pendingLoads.erase(assetId);
+		}
+		pending->promise.set();
+		throw;
 	}
-	
-	// Load resource from disk
-	const auto [newRes, loaded] = loadAsset(assetId, priority, allowFallback);
 
-	// Store in cache
+	pending->promise.set();
+	return pending->result;
+}
+
+std::shared_ptr<Resource> ResourceCollectionBase::storeLoadedAsset(const String& assetId, std::pair<std::shared_ptr<Resource>, bool> loadResult, bool finishPendingLoad)
+{
+	auto [newRes, loaded] = std::move(loadResult);
+	{
+		std::unique_lock lockWrite(mutex);
+		if (loaded) {
+			const auto res = resources.find(assetId);
+			if (res != resources.end()) {
+				// Loaded further down the stack while this was loading
+				newRes = res->second.res;
+				loaded = false;
+			} else {
+				newRes->setAssetId(assetId);
+				resources.emplace(assetId, Wrapper(newRes, 0));
+			}
+		}
+		if (finishPendingLoad) {
+			pendingLoads.erase(assetId);
+		}
+	}
 	if (loaded) {
-		newRes->setAssetId(assetId);
-		resources.emplace(assetId, Wrapper(newRes, 0));
-		lockWrite.unlock();
 		newRes->onLoaded(parent);
 	}
-
 	return newRes;
 }
 
+void ResourceCollectionBase::doGetAsync(const String& assetId, ResourceLoadPriority priority, std::function<void(std::shared_ptr<Resource>)> callback)
+{
+	// Cache hits complete immediately, once the lock is released
+	std::shared_ptr<Resource> cached;
+	{
+		std::shared_lock lock(mutex);
+		const auto res = resources.find(assetId);
+		if (res != resources.end()) {
+			cached = res->second.res;
+		}
+	}
+	if (cached) {
+		callback(std::move(cached));
+		return;
+	}
+
+	// Loads cancelled because Resources is going away complete with nothing
+	auto cancel = [callback] ()
+	{
+		callback({});
+	};
+	parent.enqueueAsyncLoad(priority, [this, assetId, priority, callback = std::move(callback)] ()
+	{
+		std::shared_ptr<Resource> result;
+		try {
+			result = doGet(assetId, priority, true);
+		} catch (std::exception& e) {
+			Logger::logError("Error while loading " + toString(type) + ":" + assetId + ": " + e.what());
+		} catch (...) {
+			Logger::logError("Unknown error while loading " + toString(type) + ":" + assetId);
+		}
+		callback(std::move(result));
+	}, std::move(cancel));
+}
+
+bool ResourceCollectionBase::isLoaded(const String& assetId) const
+{
+	std::shared_lock lock(mutex);
+	return resources.find(assetId) != resources.end();
+}
+
 bool ResourceCollectionBase::exists(const String& assetId) const
 {
 	// Look in cache
@@ -2,6 +2,7 @@
 #include <utility>
 #include "resources/asset_pack.h"
 #include "api/system_api.h"
+#include "halley/file/memory_mapped_file.h"
 using namespace Halley;
 
 PackResourceLocator::PackResourceLocator(std::unique_ptr<ResourceDataReader> reader, Path path, String key, bool preLoad, std::optional<int> priority)
@@ -17,6 +18,14 @@ PackResourceLocator::~PackResourceLocator()
 {
 }
 
+std::unique_ptr<ResourceDataReader> PackResourceLocator::openPack(SystemAPI& system, const Path& path)
+{
+	if (auto mapped = MemoryMappedDataReader::tryOpen(path)) {
+		return mapped;
+	}
+	return system.getDataReader(path.string());
+}
+
 std::unique_ptr<ResourceData> PackResourceLocator::getData(const String& asset, AssetType type, bool stream)
 {
 	if (!assetPack) {
@@ -41,7 +50,7 @@ void PackResourceLocator::purge(SystemAPI& sys)
 
 void PackResourceLocator::loadAfterPurge()
 {
-	assetPack = std::make_unique<AssetPack>(system->getDataReader(path.string()), encryptionKey, preLoad);
+	assetPack = std::make_unique<AssetPack>(openPack(*system, path), encryptionKey, preLoad);
 }
 
 int PackResourceLocator::getPriority() const
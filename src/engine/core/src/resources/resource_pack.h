@@ -12,6 +12,9 @@ namespace Halley {
 		explicit PackResourceLocator(std::unique_ptr<ResourceDataReader> reader, Path path, String encryptionKey = "", bool preLoad = false, std::optional<int> priority = {});
 		~PackResourceLocator();
 
+		// Memory-maps the pack if the platform allows it, otherwise falls back to the system's data reader
+		static std::unique_ptr<ResourceDataReader> openPack(SystemAPI& system, const Path& path);
+
 	protected:
 		std::unique_ptr<ResourceData> getData(const String& asset, AssetType type, bool stream) override;
 		const AssetDatabase& getAssetDatabase() override;
@@ -0,0 +1,217 @@
+#include "resources/resource_prefetcher.h"
+#include "halley/support/logger.h"
+#include "halley/support/profiler.h"
+#include "halley/text/string_converter.h"
+#include "halley/time/stopwatch.h"
+
+using namespace Halley;
+
+namespace {
+	String makeKey(AssetType type, const String& assetId)
+	{
+		return toString(type) + ":" + assetId;
+	}
+}
+
+ResourcePrefetcher::ResourcePrefetcher(Resources& resources, size_t budgetBytes)
+	: resources(resources)
+	, budget(budgetBytes)
+{
+}
+
+ResourcePrefetcher::~ResourcePrefetcher() = default;
+
+void ResourcePrefetcher::setBudget(size_t bytes)
+{
+	budget = bytes;
+}
+
+size_t ResourcePrefetcher::getBudget() const
+{
+	return budget;
+}
+
+void ResourcePrefetcher::setHintLifetime(Time time)
+{
+	hintLifetime = time;
+}
+
+void ResourcePrefetcher::prefetch(AssetType type, const String& assetId, ResourceLoadPriority priority)
+{
+	auto key = makeKey(type, assetId);
+
+	std::unique_lock<std::mutex> lock(mutex);
+	const auto iter = hints.find(key);
+	if (iter != hints.end()) {
+		iter->second.timeLeft = hintLifetime;
+		return;
+	}
+
+	auto& hint = hints[std::move(key)];
+	hint.future = resources.ofType(type).getUntypedAsync(assetId, priority);
+	hint.timeLeft = hintLifetime;
+	++stats.prefetches;
+}
+
+void ResourcePrefetcher::prefetch(const String& typedAssetId, ResourceLoadPriority priority)
+{
+	const auto splitPos = typedAssetId.find(':');
+	if (splitPos == String::npos) {
+		Logger::logError("Invalid asset id for prefetching, expected \"type:name\": " + typedAssetId);
+		return;
+	}
+	prefetch(fromString<AssetType>(typedAssetId.left(splitPos)), typedAssetId.mid(splitPos + 1), priority);
+}
+
+std::shared_ptr<Resource> ResourcePrefetcher::getUntyped(AssetType type, const String& assetId, ResourceLoadPriority priority)
+{
+	auto& collection = resources.ofType(type);
+	auto& profiler = ProfilerCapture::get();
+
+	std::optional<Future<std::shared_ptr<Resource>>> pending;
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		const auto iter = hints.find(makeKey(type, assetId));
+		if (iter != hints.end()) {
+			auto hint = std::move(iter->second);
+			hints.erase(iter);
+
+			if (hint.resource) {
+				++stats.hits;
+				profiler.addCounter(ProfilerCounterType::ResourceHits, 1);
+				return std::move(hint.resource);
+			}
+			pending = std::move(hint.future);
+		}
+	}
+
+	if (pending) {
+		if (pending->hasValue()) {
+			if (auto result = pending->get()) {
+				std::unique_lock<std::mutex> lock(mutex);
+				++stats.hits;
+				profiler.addCounter(ProfilerCounterType::ResourceHits, 1);
+				return result;
+			}
+		} else {
+			// The prefetch hasn't finished, so load it here; this will either wait for it or, if it hasn't started, do it ourselves
+			Stopwatch timer;
+			auto result = collection.getUntyped(assetId, priority);
+			timer.pause();
+
+			std::unique_lock<std::mutex> lock(mutex);
+			++stats.stalls;
+			stats.stallTime += timer.elapsedNanoseconds() / 1000000000.0;
+			profiler.addCounter(ProfilerCounterType::ResourceStalls, 1);
+			return result;
+		}
+	}
+
+	{
+		const bool loaded = collection.isLoaded(assetId);
+		std::unique_lock<std::mutex> lock(mutex);
+		if (loaded) {
+			++stats.hits;
+			profiler.addCounter(ProfilerCounterType::ResourceHits, 1);
+		} else {
+			++stats.misses;
+			profiler.addCounter(ProfilerCounterType::ResourceMisses, 1);
+		}
+	}
+	return collection.getUntyped(assetId, priority);
+}
+
+void ResourcePrefetcher::clearHints()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	hints.clear();
+}
+
+void ResourcePrefetcher::update(Time t)
+{
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		for (auto iter = hints.begin(); iter != hints.end(); ) {
+			auto& hint = iter->second;
+			if (!hint.resource && hint.future.hasValue()) {
+				hint.resource = hint.future.get();
+			}
+
+			hint.timeLeft -= t;
+			if (hint.timeLeft <= 0 && hint.future.hasValue()) {
+				iter = hints.erase(iter);
+			} else {
+				++iter;
+			}
+		}
+	}
+
+	size_t totalBytes = 0;
+	for (auto* collection: resources.getCollections()) {
+		const auto usage = collection->getMemoryUsageAndAge(static_cast<float>(t));
+		totalBytes += usage.ramUsage + usage.vramUsage;
+	}
+
+	if (totalBytes > budget) {
+		evict(totalBytes);
+	} else {
+		std::unique_lock<std::mutex> lock(mutex);
+		stats.residentBytes = totalBytes;
+	}
+}
+
+void ResourcePrefetcher::evict(size_t totalBytes)
+{
+	struct Candidate {
+		ResourceCollectionBase* collection;
+		ResourceCollectionBase::UnreferencedResource resource;
+	};
+
+	Vector<Candidate> candidates;
+	Vector<ResourceCollectionBase::UnreferencedResource> unreferenced;
+	for (auto* collection: resources.getCollections()) {
+		unreferenced.clear();
+		collection->getUnreferencedResources(unreferenced);
+		for (auto& r: unreferenced) {
+			candidates.push_back(Candidate{ collection, std::move(r) });
+		}
+	}
+
+	// Age only grows while a resource is unreferenced, so the oldest ones are the least recently used
+	std::sort(candidates.begin(), candidates.end(), [] (const Candidate& a, const Candidate& b)
+	{
+		return a.resource.age > b.resource.age;
+	});
+
+	uint64_t evictions = 0;
+	size_t evictedBytes = 0;
+	for (auto& c: candidates) {
+		if (totalBytes <= budget) {
+			break;
+		}
+		if (c.collection->unloadIfUnreferenced(c.resource.assetId)) {
+			totalBytes -= std::min(totalBytes, c.resource.bytes);
+			evictedBytes += c.resource.bytes;
+			++evictions;
+		}
+	}
+
+	std::unique_lock<std::mutex> lock(mutex);
+	stats.evictions += evictions;
+	stats.evictedBytes += evictedBytes;
+	stats.residentBytes = totalBytes;
+}
+
+ResourcePrefetcher::Stats ResourcePrefetcher::getStats() const
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	return stats;
+}
+
+void ResourcePrefetcher::resetStats()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	const auto residentBytes = stats.residentBytes;
+	stats = {};
+	stats.residentBytes = residentBytes;
+}
@@ -2,11 +2,13 @@
 #include "resources/resource_locator.h"
 #include "api/halley_api.h"
 #include "halley/support/logger.h"
+#include "halley/concurrency/concurrent.h"
 
 using namespace Halley;
 
 Resources::Resources(std::unique_ptr<ResourceLocator> locator, const HalleyAPI& api, ResourceOptions options)
 	: locator(std::move(locator))
+	, asyncLoads(std::make_shared<AsyncLoadQueue>())
 	, api(&api)
 	, options(options)
 {
@@ -76,4 +78,100 @@ void Resources::generateMemoryReport()
 	}	
 }
 
-Resources::~Resources() = default;
+Resources::~Resources()
+{
+	// Queued runners might still be on the disk IO thread, but they'll find nothing to do
+	// Loads that haven't started get cancelled, and the ones that already started reference the collections, so wait for them to finish
+	asyncLoads->close();
+}
+
+Vector<ResourceCollectionBase*> Resources::getCollections() const
+{
+	Vector<ResourceCollectionBase*> result;
+	for (const auto& r: resources) {
+		if (r) {
+			result.push_back(r.get());
+		}
+	}
+	return result;
+}
+
+void Resources::enqueueAsyncLoad(ResourceLoadPriority priority, std::function<void()> load, std::function<void()> cancel)
+{
+	asyncLoads->enqueue(priority, std::move(load), std::move(cancel));
+
+	// Every runner picks the highest priority load pending when it gets to run, rather than the one it was queued for
+	Concurrent::execute(Executors::getDiskIO(), [queue = asyncLoads] ()
+	{
+		queue->runNext();
+	});
+}
+
+void Resources::AsyncLoadQueue::enqueue(ResourceLoadPriority priority, std::function<void()> load, std::function<void()> cancel)
+{
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		if (!closed) {
+			loads.at(static_cast<size_t>(priority)).push_back(AsyncLoad{ std::move(load), std::move(cancel) });
+			return;
+		}
+	}
+	cancel();
+}
+
+void Resources::AsyncLoadQueue::runNext()
+{
+	std::function<void()> load;
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		for (auto iter = loads.rbegin(); iter != loads.rend(); ++iter) {
+			if (!iter->empty()) {
+				load = std::move(iter->front().load);
+				iter->pop_front();
+				break;
+			}
+		}
+		if (!load) {
+			return;
+		}
+		++nRunning;
+	}
+
+	auto onDone = [&] ()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		--nRunning;
+		idle.notify_all();
+	};
+
+	try {
+		load();
+	} catch (...) {
+		onDone();
+		throw;
+	}
+	onDone();
+}
+
+void Resources::AsyncLoadQueue::close()
+{
+	Vector<std::function<void()>> cancelled;
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		closed = true;
+		for (auto& queue: loads) {
+			for (auto& load: queue) {
+				cancelled.push_back(std::move(load.cancel));
+			}
+			queue.clear();
+		}
+	}
+
+	// Outside the lock, as whoever is waiting on these might go on to queue more
+	for (auto& cancel: cancelled) {
+		cancel();
+	}
+
+	std::unique_lock<std::mutex> lock(mutex);
+	idle.wait(lock, [&] () { return nRunning == 0; });
+}
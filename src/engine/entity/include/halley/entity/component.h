@@ -5,11 +5,26 @@
 
 namespace Halley
 {
+	// Components in entities are created by EntityRef::addComponent, in their type's pool
+	// new/delete are for components that live anywhere else, and use pools shared by size, so delete them through their own type
 	class Component
 	{
 	public:
 		void* operator new(size_t size);
-		void operator delete(void* ptr);
+		void operator delete(void* ptr, size_t size);
+	};
+
+	// Each component type gets its own chunked pool, so the components a family iterates over are packed together
+	// instead of being interleaved with every other component type of the same size
+	class ComponentPools
+	{
+	public:
+		static void* alloc(int componentIndex, size_t size);
+		static void free(int componentIndex, void* ptr);
+
+		// For components that aren't in an entity, so whose type isn't known
+		static void* allocBySize(size_t size);
+		static void freeBySize(size_t size, void* ptr);
 	};
 }
 
@@ -72,10 +72,11 @@ namespace Halley
 		AveragingLatched<int64_t> renderTime;
 		AveragingLatched<int64_t> vsyncTime;
 		AveragingLatched<int64_t> audioTime;
+		AveragingLatched<int64_t> uiWidgetsLaidOut;
 		
 		Vector<FrameData> frameData;
 		size_t lastFrameData = 0;
-		HashMap<String, EventHistoryData> eventHistory;
+		HashMap<std::string_view, EventHistoryData> eventHistory;
 		std::shared_ptr<ProfilerData> lastProfileData;
 
 		bool capturing = true;
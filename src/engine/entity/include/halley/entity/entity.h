@@ -149,6 +149,15 @@ namespace Halley {
 
 		int getParentingDepth() const;
 
+		// Bumped whenever a component is added, removed or marked as modified, or the entity's own properties change
+		// Fetching a component doesn't count as a write, so code that changes one outside of a system should mark it
+		// Children have their own revisions, so this does not cover the hierarchy below this entity
+		uint32_t getRevision() const { return revision; }
+		uint32_t getComponentRevision(int componentId) const;
+		void markModified() { ++revision; }
+		void markComponentModified(int componentId);
+		void markComponentsModified(const FamilyMask::RealType& componentMask);
+
 	private:
 		// !!! WARNING !!!
 		// The order of elements in this class was carefully chosen to maximise cache performance!
@@ -184,6 +193,9 @@ namespace Halley {
 
 		uint8_t hierarchyRevision = 0;
 
+		uint32_t revision = 0;
+		Vector<uint32_t> componentRevisions; // Parallel to components
+
 		Entity();
 		void destroyComponents(ComponentDeleterTable& storage);
 
@@ -319,7 +331,7 @@ namespace Halley {
 			validateComponentType<T>();
 			validate();
 			
-			auto c = new T(std::move(component));
+			auto c = ::new (ComponentPools::alloc(T::componentIndex, sizeof(T))) T(std::move(component));
 			entity->addComponent(*world, c);
 
 			if constexpr (HasOnAddedToEntityMember<T>::value) {
@@ -547,6 +559,7 @@ namespace Halley {
 		{
 			validate();
 			entity->name = std::move(name);
+			entity->markModified();
 		}
 
 		const UUID& getInstanceUUID() const
@@ -654,6 +667,25 @@ namespace Halley {
 			return entity->childrenRevision;
 		}
 
+		uint32_t getRevision() const
+		{
+			validate();
+			return entity->getRevision();
+		}
+
+		uint32_t getComponentRevision(int componentId) const
+		{
+			validate();
+			return entity->getComponentRevision(componentId);
+		}
+
+		template <typename T>
+		void markComponentModified()
+		{
+			validate();
+			entity->markComponentModified(T::componentIndex);
+		}
+
 		uint8_t getWorldPartition() const
 		{
 			validate();
@@ -681,6 +713,7 @@ namespace Halley {
 		{
 			validate();
 			entity->selectable = selectable;
+			entity->markModified();
 		}
 
 		bool isEnabled() const
@@ -944,6 +977,16 @@ namespace Halley {
 			return entity->childrenRevision;
 		}
 
+		uint32_t getRevision() const
+		{
+			return entity->getRevision();
+		}
+
+		uint32_t getComponentRevision(int componentId) const
+		{
+			return entity->getComponentRevision(componentId);
+		}
+
 		size_t getNumComponents() const
 		{
 			Expects(entity);
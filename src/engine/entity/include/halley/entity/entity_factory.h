@@ -12,6 +12,27 @@ namespace Halley {
 	class Resources;
 	class EntityScene;
 	class EntityData;
+
+	// Keeps the last serialized data of each component along with its revision (see Entity::getComponentRevision),
+	// so serializing an entity again only re-serializes the components that changed since
+	// A cache must always be used with the same serialization type
+	class EntitySerializationCache {
+	public:
+		void clear();
+		void removeDeadEntities(const World& world);
+		void invalidate(EntityRef entity); // Forgets the entity and its children, for writes that didn't bump a revision
+
+	private:
+		friend class EntityFactory;
+
+		struct CachedComponent {
+			int componentId;
+			uint32_t revision;
+			ConfigNode data;
+		};
+
+		HashMap<EntityId, Vector<CachedComponent>> entities;
+	};
 	
 	class EntityFactory {
 	public:
@@ -24,6 +45,7 @@ namespace Halley {
 		struct SerializationOptions {
 			EntitySerialization::Type type = EntitySerialization::Type::Undefined;
 			std::function<bool(EntityRef)> serializeAsStub;
+			EntitySerializationCache* cache = nullptr;
 
 			SerializationOptions() = default;
 			explicit SerializationOptions(EntitySerialization::Type type, std::function<bool(EntityRef)> serializeAsStub = {})
@@ -6,6 +6,7 @@
 #include "family_mask.h"
 #include "entity_id.h"
 #include "halley/data_structures/nullable_reference.h"
+#include "halley/data_structures/hash_map.h"
 #include "halley/support/exception.h"
 #include "halley/support/debug.h"
 #include "halley/utils/utils.h"
@@ -116,6 +117,18 @@ namespace Halley {
 	protected:
 		void addEntity(Entity& entity) override
 		{
+			const auto id = entity.getEntityId();
+			const auto iter = indices.find(id);
+			if (iter == indices.end()) {
+				indices[id] = entities.size();
+			} else {
+				// Removed and added back in the same frame. The old entry stays until removeDeadEntities gets rid of it, so that both the removal and the addition get notified.
+				Expects(std::find(toRemove.begin(), toRemove.end(), id) != toRemove.end());
+				Expects(staleIndices.find(id) == staleIndices.end());
+				staleIndices[id] = iter->second;
+				iter->second = entities.size();
+			}
+
 			auto& e = entities.emplace_back();
 			e.entityId = entity.getEntityId();
 			T::Type::loadComponents(entity, &e.data[0]);
@@ -125,11 +138,9 @@ namespace Halley {
 		
 		void refreshEntity(Entity& entity) override
 		{
-			for (auto& e: entities) {
-				if (e.entityId == entity.getEntityId()) {
-					T::Type::loadComponents(entity, &e.data[0]);
-					break;
-				}
+			const auto iter = indices.find(entity.getEntityId());
+			if (iter != indices.end()) {
+				T::Type::loadComponents(entity, &entities[iter->second].data[0]);
 			}
 		}
 
@@ -153,9 +164,11 @@ namespace Halley {
 				// Notify reloads
 				HALLEY_DEBUG_TRACE();
 				Vector<StorageType*> reloadedEntities;
-				for (auto& entity : entities) {
-					if (std::find(toReload.begin(), toReload.end(), entity.entityId) != toReload.end()) {
-						reloadedEntities.push_back(&entity);
+				reloadedEntities.reserve(toReload.size());
+				for (const auto& id : toReload) {
+					const auto iter = indices.find(id);
+					if (iter != indices.end()) {
+						reloadedEntities.push_back(&entities[iter->second]);
 					}
 				}
 				notifyReload(reloadedEntities.data(), reloadedEntities.size());
@@ -170,11 +183,15 @@ namespace Halley {
 		{
 			notifyRemove(entities.data(), entities.size());
 			entities.clear();
+			indices.clear();
+			staleIndices.clear();
 			updateElems();
 		}
 
 	private:
 		Vector<StorageType> entities;
+		HashMap<EntityId, size_t> indices; // Position of each entity in entities
+		HashMap<EntityId, size_t> staleIndices; // Position of the old entry of entities that were re-added while their removal was pending
 		bool dirty = false;
 
 		void updateElems()
@@ -187,46 +204,43 @@ namespace Halley {
 		void removeDeadEntities()
 		{
 			// Performance-critical code
-			// Benchmarks suggest that using a Vector is faster than std::set and std::unordered_set
 			if (!toRemove.empty()) {
 				HALLEY_DEBUG_TRACE();
-				size_t removeCount = toRemove.size();
-				Expects(removeCount > 0);
+				const size_t removeCount = toRemove.size();
 				Expects(removeCount <= entities.size());
-				std::sort(toRemove.begin(), toRemove.end());
 
-				for (size_t i = 1; i < toRemove.size(); ++i) {
-					Expects(toRemove[i - 1] != toRemove[i]);
-				}
+				// Swap each entity to be removed with the last live one, so they all end up at the back of the vector
+				// Note: an entity can be removed and added to the same family in one frame. In that case, it's the old entry that goes.
+				size_t n = entities.size();
+				for (const auto& id: toRemove) {
+					size_t idx;
+					if (const auto staleIter = staleIndices.find(id); staleIter != staleIndices.end()) {
+						idx = staleIter->second;
+						staleIndices.erase(staleIter);
+					} else {
+						const auto iter = indices.find(id);
+						Expects(iter != indices.end());
+						idx = iter->second;
+						indices.erase(iter);
+					}
 
-				// Move all entities to be removed to the back of the vector
-				{
-					int n = int(entities.size());
-					// Note: it's important to scan it forward. Scanning backwards would improve performance for short-lived entities,
-					// but it causes an issue where an entity is removed and added to the same family in one frame.
-					for (int i = 0; i < n; i++) {
-						EntityId id = entities[i].entityId;
-						auto iter = std::lower_bound(toRemove.begin(), toRemove.end(), id);
-						if (iter != toRemove.end() && id == *iter) {
-							toRemove.erase(iter);
-							if (i != n - 1) {
-								std::swap(entities[i], entities[n - 1]);
-								i--;
-							}
-							n--;
-							if (toRemove.empty()) {
-								break;
-							}
+					--n;
+					if (idx != n) {
+						std::swap(entities[idx], entities[n]);
+						const auto movedId = entities[idx].entityId;
+						const auto movedStaleIter = staleIndices.find(movedId);
+						if (movedStaleIter != staleIndices.end() && movedStaleIter->second == n) {
+							movedStaleIter->second = idx;
+						} else {
+							indices[movedId] = idx;
 						}
 					}
-					Ensures(size_t(n) + removeCount == entities.size());
 				}
-
-				Expects(toRemove.empty());
+				toRemove.clear();
 
 				// Notify removal
-				size_t newSize = entities.size() - removeCount;
-				Ensures(newSize < entities.size());
+				const size_t newSize = entities.size() - removeCount;
+				Ensures(newSize == n);
 				notifyRemove(entities.data() + newSize, removeCount);
 
 				// Remove them
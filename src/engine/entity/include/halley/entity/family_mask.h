@@ -25,6 +25,7 @@ namespace Halley {
 			constexpr bool operator==(const Handle& h) const { return value == h.value; }
 			constexpr bool operator!=(const Handle& h) const { return value != h.value; }
 			constexpr bool operator<(const Handle& h) const { return value < h.value; }
+			constexpr size_t getHash() const { return static_cast<size_t>(value); }
 
 			const RealType& getRealValue(MaskStorage& storage) const;
 			
@@ -104,7 +105,7 @@ namespace Halley {
 				if constexpr (!std::is_const<T>::value) {
 					FamilyMask::setBit(mask, RetrieveComponentIndex<T>::componentIndex);
 				}
-				Evaluator<Ts...>::makeMask(mask);
+				MutableEvaluator<Ts...>::makeMask(mask);
 			}
 
 			constexpr static HandleType getMask(MaskStorage& storage) {
@@ -185,3 +186,14 @@ namespace Halley {
 
 	using FamilyMaskType = FamilyMask::HandleType;
 }
+
+namespace std {
+	template<>
+	struct hash<Halley::FamilyMask::Handle>
+	{
+		size_t operator()(const Halley::FamilyMask::Handle& v) const noexcept
+		{
+			return v.getHash();
+		}
+	};
+}
@@ -11,6 +11,7 @@
 #include "halley/utils/type_traits.h"
 #include "system_message.h"
 #include "halley/bytes/byte_serializer.h"
+#include "halley/support/profiler.h"
 
 namespace Halley {
 	class Message;
@@ -40,6 +41,28 @@ namespace Halley {
 		System* system = nullptr;
 	};
 	
+	// Declares what a system touches while updating, so the World can run non-conflicting systems concurrently
+	// Default constructed signatures are exclusive, i.e. they conflict with every other system
+	class SystemAccessSignature {
+	public:
+		SystemAccessSignature() = default;
+		SystemAccessSignature(Vector<int> componentsRead, Vector<int> componentsWritten, Vector<String> services);
+
+		bool isExclusive() const { return exclusive; }
+		bool conflictsWith(const SystemAccessSignature& other) const;
+
+		// Groups signatures into stages that can run concurrently, keeping the declared order between conflicting ones
+		static Vector<Vector<size_t>> makeStages(gsl::span<const SystemAccessSignature* const> signatures);
+
+		const Vector<int>& getComponentsWritten() const { return componentsWritten; }
+
+	private:
+		Vector<int> componentsRead;
+		Vector<int> componentsWritten;
+		Vector<String> services;
+		bool exclusive = true;
+	};
+
 	class System
 	{
 		friend class SystemMessageBridge;
@@ -49,7 +72,7 @@ namespace Halley {
 		virtual ~System() {}
 
 		const String& getName() const { return name; }
-		void setName(String n) { name = std::move(n); }
+		void setName(String n) { name = std::move(n); profilerName = ProfilerName(name); }
 		size_t getEntityCount() const;
 		bool tryInit();
 
@@ -64,11 +87,14 @@ namespace Halley {
 		void sendEntityMessageConfig(EntityId target, const String& messageType, const ConfigNode& data);
 		void sendSystemMessageConfig(const String& targetSystem, const String& messageType, const ConfigNode& data);
 
+		const SystemAccessSignature& getAccessSignature() const { return accessSignature; }
+
 	protected:
 		const HalleyAPI& doGetAPI() const { return *api; }
 		World& doGetWorld() const { return *world; }
 		Resources& doGetResources() const { return *resources; }
 		SystemMessageBridge doGetMessageBridge() { return SystemMessageBridge(*this); }
+		void setAccessSignature(SystemAccessSignature signature) { accessSignature = std::move(signature); }
 
 		virtual void initBase() {}
 		virtual void deInit() {}
@@ -89,11 +115,11 @@ namespace Halley {
 		}
 
 		template <typename F, typename V>
-		static void invokeParallel(F&& f, V& fam)
+		static void invokeParallel(F&& f, V& fam, size_t grainSize = 0)
 		{
-			Concurrent::foreach(std::begin(fam), std::end(fam), [&] (auto& e) {
+			Concurrent::parallelFor(std::begin(fam), std::end(fam), [&] (auto& e) {
 				f(e);
-			});
+			}, grainSize);
 		}
 
 		template <typename T>
@@ -194,16 +220,19 @@ namespace Halley {
 		Vector<std::pair<EntityId, MessageEntry>> outbox;
 		Vector<const SystemMessageContext*> systemMessageInbox;
 		Vector<const SystemMessageContext*> systemMessages;
+		SystemAccessSignature accessSignature;
 
 		World* world = nullptr;
 		const HalleyAPI* api = nullptr;
 		Resources* resources = nullptr;
 		String name;
+		ProfilerName profilerName;
 		int systemId = -1;
 		bool initialised = false;
 
 		void doUpdate(Time time);
 		void doRender(RenderContext& rc);
+		void markModifiedComponents();
 		void onAddedToWorld(World& world, int id);
 
 		void purgeMessages();
@@ -161,6 +161,15 @@ namespace Halley {
 		void setEditor(bool isEditor);
 		bool isEditor() const;
 
+		// When enabled, update systems with non-conflicting access signatures run concurrently on the CPU executor
+		void setParallelSystemUpdates(bool enabled);
+		bool hasParallelSystemUpdates() const;
+
+		// When enabled, components that update systems have write access to get their revision bumped after the system runs
+		// (see Entity::getComponentRevision), so things like network replication can skip anything that hasn't changed
+		void setComponentChangeTracking(bool enabled);
+		bool hasComponentChangeTracking() const;
+
 	private:
 		const HalleyAPI& api;
 		Resources& resources;
@@ -169,6 +178,8 @@ namespace Halley {
 		bool entityDirty = false;
 		bool entityReloaded = false;
 		bool editor = false;
+		bool parallelSystemUpdates = false;
+		bool componentChangeTracking = false;
 		
 		Vector<Entity*> entities;
 		Vector<Entity*> entitiesPendingCreation;
@@ -181,6 +192,16 @@ namespace Halley {
 
 		TreeMap<FamilyMaskType, Vector<Family*>> familyCache;
 
+		struct FamilyTodo {
+			Vector<std::pair<FamilyMaskType, Entity*>> toAdd;
+			Vector<std::pair<FamilyMaskType, Entity*>> toRemove;
+			Vector<std::pair<FamilyMaskType, Entity*>> toReload;
+
+			bool empty() const { return toAdd.empty() && toRemove.empty() && toReload.empty(); }
+		};
+		HashMap<FamilyMaskType, FamilyTodo> pendingFamilyChanges; // Kept between updates to reuse the buckets' memory
+		Vector<size_t> entitiesRemoved;
+
 		std::shared_ptr<MaskStorage> maskStorage;
 		std::shared_ptr<ComponentDeleterTable> componentDeleterTable;
 		std::shared_ptr<PoolAllocator<Entity>> entityPool;
@@ -198,6 +219,7 @@ namespace Halley {
 		void deleteEntity(Entity* entity);
 
 		void updateSystems(TimeLine timeline, Time elapsed);
+		void updateSystemsParallel(TimeLine timeline, Time elapsed);
 		void renderSystems(RenderContext& rc) const;
 
 		NOINLINE Family& addFamily(std::unique_ptr<Family> family) noexcept;
@@ -1,17 +1,71 @@
 #include <halley/data_structures/memory_pool.h>
+#include <gsl/gsl_assert>
 #include <halley/support/exception.h>
 #include "component.h"
-#include <iostream>
-#include <halley/support/console.h>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include "family_mask.h"
 
 using namespace Halley;
 
 void* Component::operator new(size_t size)
+{
+	return ComponentPools::allocBySize(size);
+}
+
+void Component::operator delete(void* ptr, size_t size)
+{
+	ComponentPools::freeBySize(size, ptr);
+}
+
+namespace {
+	constexpr size_t maxComponentTypes = FamilyMask::RealType().size();
+
+	std::array<std::atomic<SizePool*>, maxComponentTypes> componentPools = {};
+	std::mutex componentPoolsMutex;
+
+	SizePool& getComponentPool(int componentIndex, size_t size)
+	{
+		Expects(componentIndex >= 0 && size_t(componentIndex) < maxComponentTypes);
+
+		auto& slot = componentPools[componentIndex];
+		if (auto* pool = slot.load(std::memory_order_acquire)) {
+			return *pool;
+		}
+
+		std::unique_lock<std::mutex> lock(componentPoolsMutex);
+		if (auto* pool = slot.load(std::memory_order_acquire)) {
+			return *pool;
+		}
+		auto* pool = new SizePool(size);
+		slot.store(pool, std::memory_order_release);
+		return *pool;
+	}
+}
+
+void* ComponentPools::alloc(int componentIndex, size_t size)
+{
+	auto& pool = getComponentPool(componentIndex, size);
+	Expects(pool.getSize() == size);
+	return pool.alloc();
+}
+
+void ComponentPools::free(int componentIndex, void* ptr)
+{
+	auto* pool = componentPools[componentIndex].load(std::memory_order_acquire);
+	Expects(pool != nullptr);
+	pool->free(ptr);
+}
+
+void* ComponentPools::allocBySize(size_t size)
 {
 	return PoolPool::getPool(size)->alloc();
 }
 
-void Component::operator delete(void*)
+void ComponentPools::freeBySize(size_t size, void* ptr)
 {
-	std::cout << ConsoleColour(Console::RED) << "Attempting to delete component!" << ConsoleColour() << std::endl;
+	if (ptr) {
+		PoolPool::getPool(size)->free(ptr);
+	}
 }
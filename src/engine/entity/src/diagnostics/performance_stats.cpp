@@ -24,6 +24,7 @@ PerformanceStatsView::PerformanceStatsView(Resources& resources, const HalleyAPI
 	, totalFrameTime(60)
 	, updateTime(60)
 	, renderTime(60)
+	, uiWidgetsLaidOut(60)
 {
 	api.core->addProfilerCallback(this);
 	
@@ -87,6 +88,7 @@ void PerformanceStatsView::onProfileData(std::shared_ptr<ProfilerData> data)
 	renderTime.pushValue(data->getElapsedTime(ProfilerEventType::CoreRender).count());
 	totalFrameTime.pushValue(data->getTotalElapsedTime().count() - vsyncTime.getLatest());
 	audioTime.pushValue(api.audio->getLastTimeElapsed());
+	uiWidgetsLaidOut.pushValue(data->getCounter(ProfilerCounterType::UIWidgetsLaidOut));
 
 	auto getTime = [&](TimeLine timeline) -> int
 	{
@@ -233,6 +235,10 @@ void PerformanceStatsView::drawHeader(Painter& painter, bool simple)
 			strBuilder.append(toString(percent, 1));
 			strBuilder.append("%)");
 		}
+
+		strBuilder.append(" | ");
+		strBuilder.append(toString(uiWidgetsLaidOut.getAverage()));
+		strBuilder.append(" UI layouts");
 	}
 
 	if (simple) {
@@ -450,6 +456,9 @@ Colour4f PerformanceStatsView::getEventColour(ProfilerEventType type) const
 	case ProfilerEventType::StatsView:
 		return Colour4f(0.7f, 0.7f, 0.7f);
 	case ProfilerEventType::AudioGenerateBuffer:
+	case ProfilerEventType::AudioMixVoices:
+	case ProfilerEventType::AudioMixVoiceGroup:
+	case ProfilerEventType::AudioPostProcess:
 		return Colour4f(0.5f, 0.8f, 1.0f);
 	default:
 		return Colour4f(0.1f, 0.7f, 0.1f);
@@ -480,7 +489,7 @@ Colour4f PerformanceStatsView::getNetworkStatsCol(const AckUnreliableConnectionS
 void PerformanceStatsView::drawTopSystems(Painter& painter, Rect4f rect)
 {
 	struct CurEventData {
-		const String* name;
+		std::string_view name;
 		ProfilerEventType type;
 		int64_t avg;
 		int64_t high;
@@ -499,7 +508,7 @@ void PerformanceStatsView::drawTopSystems(Painter& painter, Rect4f rect)
 	Vector<CurEventData> curEvents;
 	curEvents.reserve(eventHistory.size());
 	for (const auto& [k, v]: eventHistory) {
-		curEvents.emplace_back(CurEventData{ &k, v.getType(), v.getAverage(), v.getHighest(), v.getLowest(), v.getHighestEver(), v.getLowestEver() });
+		curEvents.emplace_back(CurEventData{ k, v.getType(), v.getAverage(), v.getHighest(), v.getLowest(), v.getHighestEver(), v.getLowestEver() });
 	}
 	std::sort(curEvents.begin(), curEvents.end());
 
@@ -519,7 +528,7 @@ void PerformanceStatsView::drawTopSystems(Painter& painter, Rect4f rect)
 	for (size_t i = 0; i < nToShow; ++i) {
 		const auto& system = curEvents[i];
 		columns[0].append(toString(i + 1) + ": ");
-		columns[0].append(*system.name + "\n", getEventColour(system.type).inverseMultiplyLuma(0.5f));
+		columns[0].append(String(system.name) + "\n", getEventColour(system.type).inverseMultiplyLuma(0.5f));
 		columns[1].append(getTimeLabel(system.avg) + " us\n");
 		columns[2].append(getTimeLabel(system.low) + " us\n");
 		columns[3].append(getTimeLabel(system.high) + " us\n");
@@ -561,9 +570,12 @@ void PerformanceStatsView::drawNetworkStats(Painter& painter, Rect4f rect)
 		const Rect4f totalArea = Rect4f(rect.getTopLeft() + Vector2f(0, i * (boxHeight + spacing)), rect.getWidth(), boxHeight);
 		const Rect4f area = totalArea.grow(0, -20, 0, 0);
 
+		const auto& connStats = networkSession->getConnectionStats(i);
+
 		connLabel
 			.setPosition(totalArea.getTopLeft())
-			.setText("Connection #" + toString(i + 1) + ": latency = " + toString(lroundl(networkSession->getLatency(i) * 1000)) + " ms.")
+			.setText("Connection #" + toString(i + 1) + ": latency = " + toString(lroundl(networkSession->getLatency(i) * 1000)) + " ms, out = "
+				+ toString(connStats.getSentDataPerSecond() / 1000.0, 3) + " kBps, in = " + toString(connStats.getReceivedDataPerSecond() / 1000.0, 3) + " kBps.")
 			.draw(painter);
 
 		boxBg
@@ -572,7 +584,6 @@ void PerformanceStatsView::drawNetworkStats(Painter& painter, Rect4f rect)
 			.scaleTo(area.getSize())
 			.draw(painter);
 
-		const auto& connStats = networkSession->getConnectionStats(i);
 		const auto& stats = connStats.getPacketStats();
 		const auto start = connStats.getLineStart();
 		const auto lineLen = connStats.getLineSize();
@@ -30,6 +30,7 @@ void Entity::destroyComponents(ComponentDeleterTable& table)
 		deleteComponent(component.second, component.first, table);
 	}
 	components.clear();
+	componentRevisions.clear();
 	liveComponents = 0;
 }
 
@@ -61,10 +62,12 @@ void Entity::addComponent(Component* component, int id)
 	
 	// Put it at the back of the list...
 	components.push_back(std::pair<int, Component*>(id, component));
+	componentRevisions.push_back(++revision);
 
 	// ...if there's dead components, swap with the first dead component...
 	if (static_cast<size_t>(liveComponents) < components.size()) {
 		std::swap(components[liveComponents], components.back());
+		std::swap(componentRevisions[liveComponents], componentRevisions.back());
 	}
 
 	// ...and increase the list, therefore putting it in living component territory
@@ -75,14 +78,17 @@ void Entity::removeComponentAt(int i)
 {
 	// Put it at the end of the list of living components... (guaranteed to swap with living component)
 	std::swap(components[i], components[static_cast<size_t>(liveComponents) - 1]);
+	std::swap(componentRevisions[i], componentRevisions[static_cast<size_t>(liveComponents) - 1]);
 
 	// ...then shrink that list, therefore moving it into dead component territory
 	--liveComponents;
+	++revision;
 }
 
 void Entity::removeAllComponents(World& world)
 {
 	liveComponents = 0;
+	++revision;
 	markDirty(world);
 }
 
@@ -90,7 +96,7 @@ void Entity::deleteComponent(Component* component, int id, ComponentDeleterTable
 {
 	TypeDeleterBase* deleter = table.get(id);
 	deleter->callDestructor(component);
-	PoolPool::getPool(deleter->getSize())->free(component);
+	ComponentPools::free(id, component);
 }
 
 void Entity::keepOnlyComponentsWithIds(const Vector<int>& ids, World& world)
@@ -98,8 +104,10 @@ void Entity::keepOnlyComponentsWithIds(const Vector<int>& ids, World& world)
 	for (uint8_t i = 0; i < liveComponents; ++i) {
 		if (std::find(ids.begin(), ids.end(), components[i].first) == ids.end()) {
 			std::swap(components[i], components[liveComponents - 1]);
+			std::swap(componentRevisions[i], componentRevisions[liveComponents - 1]);
 			--liveComponents;
 			--i;
+			++revision;
 		}
 	}
 	
@@ -225,9 +233,42 @@ void Entity::propagateEnabled(bool enabledStatus, bool parentStatus)
 
 void Entity::setEnabled(bool enabled)
 {
+	if (enabled != this->enabled) {
+		markModified();
+	}
 	propagateEnabled(enabled, parentEnabled);
 }
 
+uint32_t Entity::getComponentRevision(int componentId) const
+{
+	for (uint8_t i = 0; i < liveComponents; i++) {
+		if (components[i].first == componentId) {
+			return componentRevisions[i];
+		}
+	}
+	return 0;
+}
+
+void Entity::markComponentModified(int componentId)
+{
+	const auto rev = ++revision;
+	for (uint8_t i = 0; i < liveComponents; i++) {
+		if (components[i].first == componentId) {
+			componentRevisions[i] = rev;
+		}
+	}
+}
+
+void Entity::markComponentsModified(const FamilyMask::RealType& componentMask)
+{
+	const auto rev = ++revision;
+	for (uint8_t i = 0; i < liveComponents; i++) {
+		if (componentMask[components[i].first]) {
+			componentRevisions[i] = rev;
+		}
+	}
+}
+
 FamilyMaskType Entity::getMask() const
 {
 	return mask;
@@ -243,6 +284,7 @@ void Entity::refresh(MaskStorage& storage, ComponentDeleterTable& table)
 			deleteComponent(components[i].second, components[i].first, table);
 		}
 		components.resize(liveComponents);
+		componentRevisions.resize(liveComponents);
 
 		// Re-generate mask
 		auto m = FamilyMask::RealType();
@@ -14,6 +14,24 @@
 
 using namespace Halley;
 
+void EntitySerializationCache::clear()
+{
+	entities.clear();
+}
+
+void EntitySerializationCache::removeDeadEntities(const World& world)
+{
+	std_ex::erase_if_key(entities, [&] (EntityId id) { return world.tryGetRawEntity(id) == nullptr; });
+}
+
+void EntitySerializationCache::invalidate(EntityRef entity)
+{
+	entities.erase(entity.getEntityId());
+	for (const auto& child: entity.getChildren()) {
+		invalidate(child);
+	}
+}
+
 EntityFactory::EntityFactory(World& world, Resources& resources)
 	: world(world)
 	, resources(resources)
@@ -53,9 +71,22 @@ EntityData EntityFactory::serializeEntity(EntityRef entity, const SerializationO
 
 	// Components
 	const auto serializeContext = std::make_shared<EntityFactoryContext>(world, resources, EntitySerialization::makeMask(options.type), false);
+	auto* cachedComponents = options.cache ? &options.cache->entities[entity.getEntityId()] : nullptr;
 	for (auto [componentId, component]: entity) {
 		auto& reflector = getComponentReflector(componentId);
-		result.getComponents().emplace_back(reflector.getName(), reflector.serialize(serializeContext->getEntitySerializationContext(), *component));
+		if (cachedComponents) {
+			const auto revision = entity.getComponentRevision(componentId);
+			auto iter = std::find_if(cachedComponents->begin(), cachedComponents->end(), [&] (const auto& c) { return c.componentId == componentId; });
+			if (iter == cachedComponents->end()) {
+				iter = cachedComponents->insert(cachedComponents->end(), EntitySerializationCache::CachedComponent{ componentId, revision, reflector.serialize(serializeContext->getEntitySerializationContext(), *component) });
+			} else if (iter->revision != revision) {
+				iter->revision = revision;
+				iter->data = reflector.serialize(serializeContext->getEntitySerializationContext(), *component);
+			}
+			result.getComponents().emplace_back(reflector.getName(), ConfigNode(iter->data));
+		} else {
+			result.getComponents().emplace_back(reflector.getName(), reflector.serialize(serializeContext->getEntitySerializationContext(), *component));
+		}
 	}
 
 	// Children
@@ -32,6 +32,56 @@ void SystemMessageBridge::sendMessageToSystem(const String& targetSystem, int me
 	system->sendSystemMessage(targetSystem, messageType, data, std::move(callback));
 }
 
+SystemAccessSignature::SystemAccessSignature(Vector<int> componentsRead, Vector<int> componentsWritten, Vector<String> services)
+	: componentsRead(std::move(componentsRead))
+	, componentsWritten(std::move(componentsWritten))
+	, services(std::move(services))
+	, exclusive(false)
+{
+}
+
+bool SystemAccessSignature::conflictsWith(const SystemAccessSignature& other) const
+{
+	if (exclusive || other.exclusive) {
+		return true;
+	}
+
+	const auto intersects = [] (const auto& a, const auto& b)
+	{
+		return std::any_of(a.begin(), a.end(), [&] (const auto& v) { return std::find(b.begin(), b.end(), v) != b.end(); });
+	};
+
+	// Services have no declared access level, so sharing one is treated as a write
+	return intersects(componentsWritten, other.componentsWritten)
+		|| intersects(componentsWritten, other.componentsRead)
+		|| intersects(componentsRead, other.componentsWritten)
+		|| intersects(services, other.services);
+}
+
+Vector<Vector<size_t>> SystemAccessSignature::makeStages(gsl::span<const SystemAccessSignature* const> signatures)
+{
+	// Each signature goes right after the last earlier one it conflicts with
+	// Exclusive signatures conflict with everything, so they always end up alone in their stage
+	const size_t n = signatures.size();
+	Vector<size_t> signatureStage(n, 0);
+	Vector<Vector<size_t>> stages;
+	for (size_t i = 0; i < n; ++i) {
+		size_t stage = 0;
+		for (size_t j = 0; j < i; ++j) {
+			if (signatureStage[j] + 1 > stage && signatures[i]->conflictsWith(*signatures[j])) {
+				stage = signatureStage[j] + 1;
+			}
+		}
+		signatureStage[i] = stage;
+
+		if (stage >= stages.size()) {
+			stages.resize(stage + 1);
+		}
+		stages[stage].push_back(i);
+	}
+	return stages;
+}
+
 System::System(Vector<FamilyBindingBase*> uninitializedFamilies, Vector<int> messageTypesReceived)
 	: families(std::move(uninitializedFamilies))
 	, messageTypesReceived(std::move(messageTypesReceived))
@@ -65,6 +115,35 @@ void System::onAddedToWorld(World& w, int id) {
 	}
 }
 
+void System::markModifiedComponents()
+{
+	// Families hand out raw component references, so anything a system can write to is assumed to have been written
+	FamilyMask::RealType declaredWrites;
+	if (accessSignature.isExclusive()) {
+		declaredWrites.set();
+	} else {
+		for (const int id: accessSignature.getComponentsWritten()) {
+			declaredWrites.set(id);
+		}
+	}
+
+	auto& storage = world->getMaskStorage();
+	for (auto* binding: families) {
+		const auto written = binding->writeMask.getRealValue(storage) & declaredWrites;
+		if (written.none()) {
+			continue;
+		}
+
+		const size_t sz = binding->count();
+		for (size_t i = 0; i < sz; i++) {
+			const FamilyBase* elem = static_cast<FamilyBase*>(binding->getElement(i));
+			if (Entity* entity = world->tryGetRawEntity(elem->entityId)) {
+				entity->markComponentsModified(written);
+			}
+		}
+	}
+}
+
 void System::purgeMessages()
 {
 	if (!messagesSentTo.empty()) {
@@ -214,7 +293,7 @@ void System::sendSystemMessageConfig(const String& targetSystem, const String& m
 
 void System::doUpdate(Time time) {
 	HALLEY_DEBUG_TRACE_COMMENT(name.c_str());
-	ProfilerEvent event(ProfilerEventType::WorldSystemUpdate, name);
+	ProfilerEvent event(ProfilerEventType::WorldSystemUpdate, profilerName);
 
 	purgeMessages();
 	if (!messageTypesReceived.empty()) {
@@ -231,7 +310,7 @@ void System::doRender(RenderContext& rc) {
 		throw Exception("System " + name + " is being rendered before being initialised. Make sure a World::step() happens before World::render().", HalleyExceptions::Entity);
 	}
 	
-	ProfilerEvent event(ProfilerEventType::WorldSystemRender, name);
+	ProfilerEvent event(ProfilerEventType::WorldSystemRender, profilerName);
 	renderBase(rc);
 
 	HALLEY_DEBUG_TRACE_COMMENT(name.c_str());
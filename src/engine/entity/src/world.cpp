@@ -458,6 +458,26 @@ void World::setEditor(bool isEditor)
 	editor = isEditor;
 }
 
+void World::setParallelSystemUpdates(bool enabled)
+{
+	parallelSystemUpdates = enabled;
+}
+
+bool World::hasParallelSystemUpdates() const
+{
+	return parallelSystemUpdates;
+}
+
+void World::setComponentChangeTracking(bool enabled)
+{
+	componentChangeTracking = enabled;
+}
+
+bool World::hasComponentChangeTracking() const
+{
+	return componentChangeTracking;
+}
+
 bool World::isEditor() const
 {
 	return editor;
@@ -529,14 +549,8 @@ void World::updateEntities()
 	HALLEY_DEBUG_TRACE();
 	size_t nEntities = entities.size();
 
-	Vector<size_t> entitiesRemoved;
-
-	struct FamilyTodo {
-		Vector<std::pair<FamilyMaskType, Entity*>> toAdd;
-		Vector<std::pair<FamilyMaskType, Entity*>> toRemove;
-		Vector<std::pair<FamilyMaskType, Entity*>> toReload;
-	};
-	std::map<FamilyMaskType, FamilyTodo> pending;
+	auto& pending = pendingFamilyChanges;
+	entitiesRemoved.clear();
 
 	// Update all entities
 	// This loop should be as fast as reasonably possible
@@ -583,6 +597,10 @@ void World::updateEntities()
 	HALLEY_DEBUG_TRACE();
 	// Go through every family adding/removing entities as needed
 	for (auto& todo: pending) {
+		if (todo.second.empty()) {
+			continue;
+		}
+
 		for (auto* fam: getFamiliesFor(todo.first)) {
 			const auto& famMask = fam->inclusionMask;
 			const auto& optFamMask = fam->optionalMask;
@@ -611,6 +629,10 @@ void World::updateEntities()
 				fam->reloadEntity(*e.second);
 			}
 		}
+
+		todo.second.toAdd.clear();
+		todo.second.toRemove.clear();
+		todo.second.toReload.clear();
 	}
 
 	HALLEY_DEBUG_TRACE();
@@ -655,8 +677,77 @@ void World::initSystems(gsl::span<const TimeLine> timelines)
 
 void World::updateSystems(TimeLine timeline, Time elapsed)
 {
+	if (parallelSystemUpdates) {
+		updateSystemsParallel(timeline, elapsed);
+		return;
+	}
+
 	for (auto& system : getSystems(timeline)) {
 		system->doUpdate(elapsed);
+		if (componentChangeTracking) {
+			system->markModifiedComponents();
+		}
+		spawnPending();
+	}
+}
+
+void World::updateSystemsParallel(TimeLine timeline, Time elapsed)
+{
+	auto& timelineSystems = getSystems(timeline);
+
+	Vector<const SystemAccessSignature*> signatures;
+	signatures.reserve(timelineSystems.size());
+	for (auto& system: timelineSystems) {
+		signatures.push_back(&system->getAccessSignature());
+	}
+
+	Vector<Vector<System*>> stages;
+	for (auto& stageIndices: SystemAccessSignature::makeStages(signatures)) {
+		auto& stage = stages.emplace_back();
+		stage.reserve(stageIndices.size());
+		for (auto i: stageIndices) {
+			stage.push_back(timelineSystems[i].get());
+		}
+	}
+
+	// Only exclusive systems can create or destroy entities, so stage boundaries are the only sync points needed
+	for (auto& stage: stages) {
+		if (stage.size() == 1) {
+			stage[0]->doUpdate(elapsed);
+		} else {
+			Vector<std::exception_ptr> exceptions(stage.size());
+			Vector<Future<void>> tasks;
+			tasks.reserve(stage.size() - 1);
+
+			for (size_t i = 1; i < stage.size(); ++i) {
+				tasks.push_back(Concurrent::execute(Executors::getCPU(), [system = stage[i], &exception = exceptions[i], elapsed] () {
+					try {
+						system->doUpdate(elapsed);
+					} catch (...) {
+						exception = std::current_exception();
+					}
+				}));
+			}
+
+			try {
+				stage[0]->doUpdate(elapsed);
+			} catch (...) {
+				exceptions[0] = std::current_exception();
+			}
+			Concurrent::whenAll(tasks.begin(), tasks.end()).wait();
+
+			for (auto& e: exceptions) {
+				if (e) {
+					std::rethrow_exception(e);
+				}
+			}
+		}
+
+		if (componentChangeTracking) {
+			for (auto* system: stage) {
+				system->markModifiedComponents();
+			}
+		}
 		spawnPending();
 	}
 }
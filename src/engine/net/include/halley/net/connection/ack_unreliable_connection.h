@@ -34,7 +34,7 @@ namespace Halley
 	class AckUnreliableSubPacket
 	{
 	public:
-		Vector<gsl::byte> data;
+		OutboundNetworkPacket packet;
 		int tag = -1;
 		//bool reliable = false;
 		bool resends = false;
@@ -46,13 +46,13 @@ namespace Halley
 
 		AckUnreliableSubPacket(AckUnreliableSubPacket&& other) = default;
 
-		AckUnreliableSubPacket(Vector<gsl::byte>&& data)
-			: data(data)
+		AckUnreliableSubPacket(OutboundNetworkPacket packet)
+			: packet(std::move(packet))
 			, resends(false)
 		{}
 
-		AckUnreliableSubPacket(Vector<gsl::byte>&& data, uint16_t resendSeq)
-			: data(data)
+		AckUnreliableSubPacket(OutboundNetworkPacket packet, uint16_t resendSeq)
+			: packet(std::move(packet))
 			, resends(true)
 			, resendSeq(resendSeq)
 		{}
@@ -78,7 +78,8 @@ namespace Halley
 		[[nodiscard]] bool receive(InboundNetworkPacket& packet) override;
 
 		void send(TransmissionType type, OutboundNetworkPacket packet) override;
-		[[nodiscard]] uint16_t sendTagged(gsl::span<const AckUnreliableSubPacket> subPackets);
+		// A lone sub-packet is sent in its own buffer with the headers prepended in place, so it's moved out of subPackets
+		[[nodiscard]] uint16_t sendTagged(gsl::span<AckUnreliableSubPacket> subPackets);
 		void sendAckPacketsIfNeeded();
 
 		void addAckListener(IAckUnreliableConnectionListener& listener);
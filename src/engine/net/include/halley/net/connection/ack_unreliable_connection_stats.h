@@ -33,6 +33,13 @@ namespace Halley {
         [[nodiscard]] size_t getLineStart() const;
         [[nodiscard]] size_t getLineSize() const;
 
+        // Bandwidth used by this connection alone, measured over the last second
+        [[nodiscard]] size_t getSentDataPerSecond() const;
+        [[nodiscard]] size_t getReceivedDataPerSecond() const;
+        [[nodiscard]] size_t getSentPacketsPerSecond() const;
+        [[nodiscard]] size_t getReceivedPacketsPerSecond() const;
+        [[nodiscard]] size_t getResentPacketsPerSecond() const;
+
     private:
         size_t capacity = 0;
         size_t lineSize = 0;
@@ -41,6 +48,18 @@ namespace Halley {
         std::vector<PacketStats> packetStats;
         size_t pos = 0;
 
+        Time statsTime = 0;
+        size_t sentSize = 0;
+        size_t receivedSize = 0;
+        size_t sentPackets = 0;
+        size_t receivedPackets = 0;
+        size_t resentPackets = 0;
+        size_t lastSentSize = 0;
+        size_t lastReceivedSize = 0;
+        size_t lastSentPackets = 0;
+        size_t lastReceivedPackets = 0;
+        size_t lastResentPackets = 0;
+
         void addPacket(PacketStats stats);
     };
 }
@@ -72,6 +72,7 @@ namespace Halley
 
 		std::list<Outbound> outboundQueued;
 		std::map<int, PendingPacket> pendingPackets;
+		Vector<AckUnreliableSubPacket> toSend; // Kept between sends to reuse its memory
 		int nextPacketId = 0;
 
 		void onPacketAcked(int tag) override;
@@ -79,7 +80,7 @@ namespace Halley
 
 		AckUnreliableSubPacket createPacket();
 		AckUnreliableSubPacket makeTaggedPacket(Vector<Outbound>& msgs, size_t size, bool resends = false, uint16_t resendSeq = 0);
-		Vector<gsl::byte> serializeMessages(const Vector<Outbound>& msgs, size_t size) const;
+		OutboundNetworkPacket serializeMessages(const Vector<Outbound>& msgs, size_t size) const;
 
 		void receiveMessages();
 	};
@@ -1,10 +1,86 @@
 #pragma once
 #include "halley/data_structures/vector.h"
 #include <gsl/gsl>
+#include <atomic>
+#include <mutex>
 #include "halley/utils/utils.h"
 
 namespace Halley
 {
+	// A reference-counted block of memory holding a network packet. Copies share the same block, and blocks are
+	// recycled through NetworkPacketBufferPool, so packets can be passed around without copying or touching the heap.
+	class NetworkPacketBuffer
+	{
+	public:
+		NetworkPacketBuffer() = default;
+		NetworkPacketBuffer(const NetworkPacketBuffer& other);
+		NetworkPacketBuffer(NetworkPacketBuffer&& other) noexcept;
+		~NetworkPacketBuffer();
+
+		NetworkPacketBuffer& operator=(const NetworkPacketBuffer& other);
+		NetworkPacketBuffer& operator=(NetworkPacketBuffer&& other) noexcept;
+
+		bool isValid() const { return block != nullptr; }
+		bool isShared() const;
+		size_t getCapacity() const;
+
+		gsl::span<gsl::byte> getSpan();
+		gsl::span<const gsl::byte> getSpan() const;
+
+		void reset();
+
+	private:
+		friend class NetworkPacketBufferPool;
+
+		struct Block
+		{
+			std::atomic<int> refCount;
+			size_t capacity;
+
+			gsl::byte* getData() { return reinterpret_cast<gsl::byte*>(this + 1); }
+		};
+
+		Block* block = nullptr;
+
+		explicit NetworkPacketBuffer(Block* block);
+	};
+
+	class NetworkPacketBufferPool
+	{
+	public:
+		struct Stats
+		{
+			uint64_t acquired = 0;
+			uint64_t allocated = 0; // Acquired blocks that had to come from the heap
+		};
+
+		// Big enough for any datagram plus headers; anything larger gets a block of its own, which is freed instead of pooled
+		constexpr static size_t blockSize = 2048;
+		constexpr static size_t maxFreeBlocks = 1024;
+
+		static NetworkPacketBufferPool& get();
+
+		NetworkPacketBufferPool();
+		~NetworkPacketBufferPool();
+
+		NetworkPacketBufferPool(const NetworkPacketBufferPool& other) = delete;
+		NetworkPacketBufferPool& operator=(const NetworkPacketBufferPool& other) = delete;
+
+		NetworkPacketBuffer acquire(size_t minCapacity = blockSize);
+
+		Stats getStats() const;
+		void resetStats();
+
+	private:
+		friend class NetworkPacketBuffer;
+
+		mutable std::mutex mutex;
+		Vector<NetworkPacketBuffer::Block*> freeBlocks;
+		Stats stats;
+
+		void release(NetworkPacketBuffer::Block* block);
+	};
+
 	class NetworkPacketBase
 	{
 	public:
@@ -12,25 +88,38 @@ namespace Halley
 		size_t getSize() const;
 		gsl::span<const gsl::byte> getBytes() const;
 
-		NetworkPacketBase(NetworkPacketBase&& other) = delete;
-		NetworkPacketBase& operator=(NetworkPacketBase&& other) = delete;
-
 	protected:
+		friend class InboundNetworkPacket;
+
 		NetworkPacketBase();
 		NetworkPacketBase(gsl::span<const gsl::byte> data, size_t prePadding);
+		NetworkPacketBase(NetworkPacketBuffer buffer, size_t dataStart, size_t size);
+		NetworkPacketBase(const NetworkPacketBase& other) = default;
+		NetworkPacketBase(NetworkPacketBase&& other) noexcept;
+
+		NetworkPacketBase& operator=(const NetworkPacketBase& other) = default;
+		NetworkPacketBase& operator=(NetworkPacketBase&& other) noexcept;
 
+		NetworkPacketBuffer buffer;
 		size_t dataStart;
-		Vector<gsl::byte> data;
+		size_t dataEnd;
 	};
 
 	class OutboundNetworkPacket : public NetworkPacketBase
 	{
 	public:
+		// Space left in front of the data, so headers can be prepended in place
+		constexpr static size_t headerReserve = 128;
+
+		OutboundNetworkPacket();
 		OutboundNetworkPacket(const OutboundNetworkPacket& other);
 		OutboundNetworkPacket(OutboundNetworkPacket&& other) noexcept;
 		explicit OutboundNetworkPacket(gsl::span<const gsl::byte> data);
 		explicit OutboundNetworkPacket(const Bytes& data);
-		
+
+		// Takes over data that was written straight into buffer, usually at headerReserve
+		OutboundNetworkPacket(NetworkPacketBuffer buffer, size_t dataStart, size_t size);
+
 		void addHeader(gsl::span<const gsl::byte> src);
 
 		template <typename T>
@@ -39,6 +128,7 @@ namespace Halley
 			addHeader(gsl::as_bytes(gsl::span<const T>(&h, 1)));
 		}
 
+		OutboundNetworkPacket& operator=(const OutboundNetworkPacket& other);
 		OutboundNetworkPacket& operator=(OutboundNetworkPacket&& other) noexcept;
 	};
 
@@ -46,8 +136,14 @@ namespace Halley
 	{
 	public:
 		InboundNetworkPacket();
+		InboundNetworkPacket(const InboundNetworkPacket& other);
 		InboundNetworkPacket(InboundNetworkPacket&& other) noexcept;
 		explicit InboundNetworkPacket(gsl::span<const gsl::byte> data);
+		InboundNetworkPacket(NetworkPacketBuffer buffer, size_t dataStart, size_t size);
+
+		// Receives the packet exactly as it was sent, e.g. on a local connection
+		explicit InboundNetworkPacket(OutboundNetworkPacket packet);
+
 		void extractHeader(gsl::span<gsl::byte> dst);
 
 		template <typename T>
@@ -56,6 +152,10 @@ namespace Halley
 			extractHeader(gsl::as_writable_bytes(gsl::span<T>(&h, 1)));
 		}
 
+		// Returns a packet viewing part of this one, sharing its buffer. Offset is relative to the start of getBytes().
+		InboundNetworkPacket getSubPacket(size_t offset, size_t size) const;
+
+		InboundNetworkPacket& operator=(const InboundNetworkPacket& other);
 		InboundNetworkPacket& operator=(InboundNetworkPacket&& other) noexcept;
 	};
 }
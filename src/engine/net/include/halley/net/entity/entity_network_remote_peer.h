@@ -13,6 +13,12 @@ namespace Halley {
 	struct EntityId;
     class EntityData;
 
+    // Serialized state of an outbound entity, shared by every peer it's sent to
+    struct EntityNetworkSnapshot {
+        uint64_t revision = 0;
+        std::shared_ptr<const EntityData> data;
+    };
+
     class EntityNetworkRemotePeer {
         constexpr static Time maxSendInterval = 1.0;
     	
@@ -26,13 +32,28 @@ namespace Halley {
     	void sendEntities(Time t, gsl::span<const std::pair<EntityId, uint8_t>> entityIds, const EntityClientSharedData& clientData);
         void receiveNetworkMessage(NetworkSession::PeerId fromPeerId, EntityNetworkMessage msg);
 
+        struct PendingSend {
+            EntityRef entity;
+            bool create = false;
+            float relevance = 1;
+            Time timeSinceSend = 0; // Only used by updates
+
+            float getPriority() const;
+        };
+
+        // Returns how many bytes were sent, or 0 if it didn't fit in maxSize
+        using SendFunction = std::function<size_t(const PendingSend& pending, size_t maxSize)>;
+
+        // Creations go first, then updates by relevance times time since they were last sent, until the budget (in bytes, 0 for unlimited) runs out
+        static void sendByPriority(Vector<PendingSend>& pending, size_t budget, const SendFunction& send);
+
     private:
         class OutboundEntity {
         public:
             bool alive = true;
             Time timeSinceSend = 0;
             EntityNetworkId networkId = 0;
-            EntityData data;
+            EntityNetworkSnapshot lastSent;
         };
 
         class InboundEntity {
@@ -53,10 +74,11 @@ namespace Halley {
         uint16_t nextId = 0;
 
         Time timeSinceSend = 0;
+        Vector<PendingSend> pendingSends;
 
         uint16_t assignId();
-        void sendCreateEntity(EntityRef entity);
-        void sendUpdateEntity(Time t, OutboundEntity& remote, EntityRef entity);
+        size_t sendCreateEntity(EntityRef entity, size_t maxSize);
+        size_t sendUpdateEntity(OutboundEntity& remote, EntityRef entity, size_t maxSize);
         void sendDestroyEntity(OutboundEntity& remote);
         void sendKeepAlive();
         void send(EntityNetworkMessage message);
@@ -60,10 +60,24 @@ namespace Halley {
 
 		Time getMinSendInterval() const;
 
+		// Caps how many bytes of entity data are sent to each peer per update (0 for unlimited)
+		// Entities that don't fit are starved until their priority builds up enough to win a slot
+		void setPeerBandwidthBudget(size_t bytesPerUpdate);
+		size_t getPeerBandwidthBudget() const;
+
+		// Distance from a peer's viewport at which an entity's relevance halves
+		void setRelevanceFalloff(float distance);
+		float getEntityRelevance(EntityRef entity, const EntityClientSharedData& clientData) const;
+
 		void onRemoteEntityCreated(EntityRef entity, NetworkSession::PeerId peerId);
 		void requestSetupInterpolators(DataInterpolatorSet& interpolatorSet, EntityRef entity, bool remote);
 		void setupOutboundInterpolators(EntityRef entity);
 
+		// These are computed at most once per update and shared between peers; the entity is only re-serialized if its revision changed
+		const EntityNetworkSnapshot& getOutboundSnapshot(EntityRef entity);
+		const Bytes& getOutboundCreate(EntityRef entity);
+		const std::optional<Bytes>& getOutboundUpdate(EntityRef entity, const EntityNetworkSnapshot& from); // Empty if there's nothing worth sending
+
 		bool isReadyToStart() const;
 		bool isEntityInView(EntityRef entity, const EntityClientSharedData& clientData) const;
 
@@ -93,6 +107,17 @@ namespace Halley {
 		struct PendingSysMsgResponse {
 			SystemMessageCallback callback;
 		};
+
+		struct OutboundCacheEntry {
+			EntityNetworkSnapshot snapshot;
+			Time age = 0;
+			uint32_t generation = 0;
+			std::optional<Bytes> create;
+			Vector<std::pair<const EntityData*, std::optional<Bytes>>> updates; // Keyed by the snapshot they're from
+		};
+		
+		// Writes through component pointers kept across frames aren't tracked, so snapshots get refreshed at least this often
+		constexpr static Time maxSnapshotAge = 1.0;
 		
 		Resources& resources;
 		std::shared_ptr<EntityFactory> factory;
@@ -105,6 +130,10 @@ namespace Halley {
 		EntityDataDelta::Options deltaOptions;
 		SerializerOptions byteSerializationOptions;
 		SerializationDictionary serializationDictionary;
+		EntitySerializationCache serializationCache;
+
+		HashMap<EntityId, OutboundCacheEntry> outboundCache;
+		uint32_t outboundGeneration = 0;
 
 		std::shared_ptr<NetworkSession> session;
 		Vector<EntityNetworkRemotePeer> peers;
@@ -115,6 +144,9 @@ namespace Halley {
 
 		bool readyToStart = false;
 
+		size_t peerBandwidthBudget = 0;
+		float relevanceFalloff = 500.0f;
+
 		bool canProcessMessage(const EntityNetworkMessage& msg) const;
 		void processMessage(NetworkSession::PeerId fromPeerId, EntityNetworkMessage msg);
 		void onReceiveEntityUpdate(NetworkSession::PeerId fromPeerId, EntityNetworkMessage msg);
@@ -124,6 +156,11 @@ namespace Halley {
 		void onReceiveSystemMessageResponse(NetworkSession::PeerId fromPeerId, const EntityNetworkMessageSystemMsgResponse& msg);
 
 		void sendMessages();
+
+		void updateComponentChangeTracking();
+		void updateOutboundCache(Time t);
+		OutboundCacheEntry& getOutboundCacheEntry(EntityRef entity);
+		uint64_t getEntityTreeRevision(EntityRef entity) const;
 		
 		void setupDictionary();
 	};
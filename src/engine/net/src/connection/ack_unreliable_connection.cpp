@@ -35,6 +35,19 @@ void AckUnreliableHeader::deserialize(Deserializer& s)
 }
 
 constexpr size_t BUFFER_SIZE = 1024;
+constexpr size_t MAX_HEADER_SIZE = 16;
+constexpr size_t MAX_SUB_PACKET_HEADER_SIZE = 6;
+
+namespace {
+	void serializeSubPacketHeader(Serializer& s, const AckUnreliableSubPacket& subPacket)
+	{
+		const uint16_t sizeAndResend = static_cast<uint16_t>(subPacket.packet.getSize() << 1) | static_cast<uint16_t>(subPacket.resends ? 1 : 0);
+		s << sizeAndResend;
+		if (subPacket.resends) {
+			s << subPacket.resendSeq;
+		}
+	}
+}
 
 AckUnreliableConnection::AckUnreliableConnection(std::shared_ptr<IConnection> parent)
 	: parent(std::move(parent))
@@ -61,10 +74,7 @@ bool AckUnreliableConnection::isSupported(TransmissionType type) const
 
 void AckUnreliableConnection::send(TransmissionType type, OutboundNetworkPacket packet)
 {
-	AckUnreliableSubPacket subPacket;
-	subPacket.data.resize(packet.getSize());
-	packet.copyTo(subPacket.data);
-	subPacket.resends = false;
+	AckUnreliableSubPacket subPacket(std::move(packet));
 	subPacket.tag = -1;
 
 	const auto seq = sendTagged(gsl::span<AckUnreliableSubPacket>(&subPacket, 1));
@@ -95,38 +105,58 @@ bool AckUnreliableConnection::receive(InboundNetworkPacket& packet)
 	return false;
 }
 
-uint16_t AckUnreliableConnection::sendTagged(gsl::span<const AckUnreliableSubPacket> subPackets)
+uint16_t AckUnreliableConnection::sendTagged(gsl::span<AckUnreliableSubPacket> subPackets)
 {
-	std::array<gsl::byte, 2048> buffer;
-	const auto dst = gsl::span<gsl::byte>(buffer);
-
-	auto s = Serializer(dst, SerializerOptions(SerializerOptions::maxVersion));
-
-	// Add header
 	const auto seq = nextSequenceToSend++;
 	AckUnreliableHeader header;
 	header.sequence = seq;
 	header.ack = highestReceived;
 	header.ackBits = generateAckBits();
-	s << header;
 
 	auto& sent = sentPackets[seq % BUFFER_SIZE];
-	sent = SentPacketData{};
+	sent.tags.clear(); // Keeps its capacity
+	sent.waiting = false;
 
-	// Add subpackets
 	for (auto& subPacket : subPackets) {
-		const uint16_t sizeAndResend = static_cast<uint16_t>(subPacket.data.size() << 1) | static_cast<uint16_t>(subPacket.resends ? 1 : 0);
-		s << sizeAndResend;
+		sent.tags.push_back(subPacket.tag);
 		if (subPacket.resends) {
-			s << subPacket.resendSeq;
+			notifyResend(subPacket.resendSeq);
 		}
-		s << gsl::span<const gsl::byte>(subPacket.data);
+	}
 
-		sent.tags.push_back(subPacket.tag);
+	// Add subpackets
+	OutboundNetworkPacket packet;
+	const auto options = SerializerOptions(SerializerOptions::maxVersion);
+	if (subPackets.size() == 1) {
+		// Send it in its own buffer, with the headers added in front
+		std::array<gsl::byte, MAX_SUB_PACKET_HEADER_SIZE> subHeader;
+		auto s = Serializer(gsl::span<gsl::byte>(subHeader), options);
+		serializeSubPacketHeader(s, subPackets[0]);
+
+		packet = std::move(subPackets[0].packet);
+		packet.addHeader(gsl::span<const gsl::byte>(subHeader).subspan(0, s.getSize()));
+	} else {
+		// Gather them into a single buffer
+		size_t maxSize = 0;
+		for (auto& subPacket : subPackets) {
+			maxSize += MAX_SUB_PACKET_HEADER_SIZE + subPacket.packet.getSize();
+		}
 
-		if (subPacket.resends) {
-			notifyResend(subPacket.resendSeq);
+		auto buffer = NetworkPacketBufferPool::get().acquire(OutboundNetworkPacket::headerReserve + maxSize);
+		auto s = Serializer(buffer.getSpan().subspan(OutboundNetworkPacket::headerReserve), options);
+		for (auto& subPacket : subPackets) {
+			serializeSubPacketHeader(s, subPacket);
+			s << subPacket.packet.getBytes();
 		}
+		packet = OutboundNetworkPacket(std::move(buffer), OutboundNetworkPacket::headerReserve, s.getSize());
+	}
+
+	// Add header
+	{
+		std::array<gsl::byte, MAX_HEADER_SIZE> headerBytes;
+		auto s = Serializer(gsl::span<gsl::byte>(headerBytes), options);
+		s << header;
+		packet.addHeader(gsl::span<const gsl::byte>(headerBytes).subspan(0, s.getSize()));
 	}
 
 	// Mark waiting
@@ -134,8 +164,9 @@ uint16_t AckUnreliableConnection::sendTagged(gsl::span<const AckUnreliableSubPac
 	lastSend = sent.timestamp = Clock::now();
 
 	// Send
-	parent->send(TransmissionType::Unreliable, OutboundNetworkPacket(dst.subspan(0, s.getSize())));
-	notifySend(header.sequence, s.getSize());
+	const auto size = packet.getSize();
+	parent->send(TransmissionType::Unreliable, std::move(packet));
+	notifySend(header.sequence, size);
 	earliestUnackedMsg = {};
 
 	return seq;
@@ -181,16 +212,15 @@ void AckUnreliableConnection::processReceivedPacket(InboundNetworkPacket& packet
 				s >> resendOf;
 			}
 
-			// Extract data
-			std::array<char, 2048> buffer;
-			if (size > buffer.size() || size > s.getBytesLeft()) {
+			// Extract data, sharing the packet's buffer
+			if (size > s.getBytesLeft()) {
 				throw Exception("Unexpected sub-packet size: " + toString(size) + " bytes, " + toString(s.getBytesLeft()) + " bytes remaining.", HalleyExceptions::Network);
 			}
-			auto subPacketData = gsl::as_writable_bytes(gsl::span<char>(buffer).subspan(0, size));
-			s >> subPacketData;
+			const size_t offset = s.getPosition();
+			s.skip(size);
 			
 			if (!resend || onSeqReceived(resendOf, true)) {
-				pendingPackets.emplace_back(subPacketData);
+				pendingPackets.emplace_back(packet.getSubPacket(offset, size));
 			}
 
 			notifyReceive(seq, size, resend);
@@ -1,4 +1,5 @@
 #include "connection/ack_unreliable_connection_stats.h"
+#include <cmath>
 
 using namespace Halley;
 
@@ -12,20 +13,41 @@ AckUnreliableConnectionStats::AckUnreliableConnectionStats(size_t capacity, size
 
 void AckUnreliableConnectionStats::update(Time time)
 {
+	statsTime += time;
+	if (statsTime > 1.0) {
+		// Keep the remainder, so that each window still averages out to one second
+		statsTime = std::fmod(statsTime, 1.0);
+
+		lastSentSize = sentSize;
+		lastReceivedSize = receivedSize;
+		lastSentPackets = sentPackets;
+		lastReceivedPackets = receivedPackets;
+		lastResentPackets = resentPackets;
+		sentSize = 0;
+		receivedSize = 0;
+		sentPackets = 0;
+		receivedPackets = 0;
+		resentPackets = 0;
+	}
 }
 
 void AckUnreliableConnectionStats::onPacketSent(uint16_t sequence, size_t size)
 {
+	sentSize += size;
+	++sentPackets;
 	addPacket(PacketStats{ sequence, State::Sent, true, size });
 }
 
 void AckUnreliableConnectionStats::onPacketReceived(uint16_t sequence, size_t size, bool resend)
 {
+	receivedSize += size;
+	++receivedPackets;
 	addPacket(PacketStats{ sequence, State::Received, false, size });
 }
 
 void AckUnreliableConnectionStats::onPacketResent(uint16_t sequence)
 {
+	++resentPackets;
 	for (auto& packet: packetStats) {
 		if (packet.outbound && packet.seq == sequence) {
 			packet.state = State::Resent;
@@ -59,6 +81,31 @@ size_t AckUnreliableConnectionStats::getLineSize() const
 	return lineSize;
 }
 
+size_t AckUnreliableConnectionStats::getSentDataPerSecond() const
+{
+	return lastSentSize;
+}
+
+size_t AckUnreliableConnectionStats::getReceivedDataPerSecond() const
+{
+	return lastReceivedSize;
+}
+
+size_t AckUnreliableConnectionStats::getSentPacketsPerSecond() const
+{
+	return lastSentPackets;
+}
+
+size_t AckUnreliableConnectionStats::getReceivedPacketsPerSecond() const
+{
+	return lastReceivedPackets;
+}
+
+size_t AckUnreliableConnectionStats::getResentPacketsPerSecond() const
+{
+	return lastResentPackets;
+}
+
 void AckUnreliableConnectionStats::addPacket(PacketStats stats)
 {
 	packetStats[pos] = stats;
@@ -5,6 +5,10 @@
 #include "halley/support/logger.h"
 using namespace Halley;
 
+namespace {
+	constexpr size_t maxPacketSize = 1350;
+}
+
 void MessageQueueUDP::Channel::getReadyMessages(Vector<InboundNetworkPacket>& out)
 {
 	if (settings.ordered) {
@@ -85,10 +89,12 @@ void MessageQueueUDP::setChannel(uint8_t channel, ChannelSettings settings)
 	c.initialized = true;
 }
 
-Vector<gsl::byte> MessageQueueUDP::serializeMessages(const Vector<Outbound>& msgs, size_t size) const
+OutboundNetworkPacket MessageQueueUDP::serializeMessages(const Vector<Outbound>& msgs, size_t size) const
 {
-	Vector<gsl::byte> result(size);
-	auto s = Serializer(result, SerializerOptions(SerializerOptions::maxVersion));
+	// Serialize straight into a packet buffer, leaving room for the connection's headers
+	constexpr size_t reserve = OutboundNetworkPacket::headerReserve;
+	auto buffer = NetworkPacketBufferPool::get().acquire(reserve + size);
+	auto s = Serializer(buffer.getSpan().subspan(reserve, size), SerializerOptions(SerializerOptions::maxVersion));
 	
 	for (auto& msg: msgs) {
 		const uint8_t channelN = msg.channel;
@@ -104,8 +110,7 @@ Vector<gsl::byte> MessageQueueUDP::serializeMessages(const Vector<Outbound>& msg
 		s << msg.packet.getBytes();
 	}
 
-	result.resize(s.getSize());
-	return result;
+	return OutboundNetworkPacket(std::move(buffer), reserve, s.getSize());
 }
 
 void MessageQueueUDP::receiveMessages()
@@ -125,11 +130,14 @@ void MessageQueueUDP::receiveMessages()
 					s >> sequence;
 				}
 
-				Bytes msgData;
-				s >> msgData;
+				// Serialized as a vector, read it in place
+				uint32_t size = 0;
+				s >> size;
+				const size_t offset = s.getPosition();
+				s.skip(size);
 
 				// Read message
-				channel.receiveQueue.emplace_back(Inbound{ InboundNetworkPacket(gsl::as_bytes(gsl::span<const Byte>(msgData))), sequence, channelN });
+				channel.receiveQueue.emplace_back(Inbound{ packet.getSubPacket(offset, size), sequence, channelN });
 			}
 		}
 	} catch (std::exception& e) {
@@ -166,7 +174,7 @@ void MessageQueueUDP::enqueue(OutboundNetworkPacket packet, uint8_t channelNumbe
 void MessageQueueUDP::sendAll()
 {
 	//int firstTag = nextPacketId;
-	Vector<AckUnreliableSubPacket> toSend;
+	toSend.clear();
 
 	// Add packets which need to be re-sent
 	checkReSend(toSend);
@@ -176,14 +184,23 @@ void MessageQueueUDP::sendAll()
 		toSend.emplace_back(createPacket());
 	}
 
-	// Send and update sequences
-	if (!toSend.empty()) {
-		const auto seq = connection->sendTagged(toSend);
-		for (auto& packet: toSend) {
+	// Send and update sequences, splitting them so no datagram goes over the maximum packet size
+	for (size_t start = 0; start < toSend.size(); ) {
+		size_t end = start + 1;
+		size_t size = toSend[start].packet.getSize();
+		while (end < toSend.size() && size + toSend[end].packet.getSize() <= maxPacketSize) {
+			size += toSend[end].packet.getSize();
+			++end;
+		}
+
+		const auto subPackets = gsl::span<AckUnreliableSubPacket>(toSend).subspan(start, end - start);
+		const auto seq = connection->sendTagged(subPackets);
+		for (auto& packet: subPackets) {
 			if (packet.tag != -1) {
 				pendingPackets[packet.tag].seq = seq;
 			}
 		}
+		start = end;
 	}
 
 	connection->sendAckPacketsIfNeeded();
@@ -254,7 +271,6 @@ void MessageQueueUDP::checkReSend(Vector<AckUnreliableSubPacket>& collect)
 AckUnreliableSubPacket MessageQueueUDP::createPacket()
 {
 	Vector<Outbound> sentMsgs;
-	const size_t maxSize = 1350;
 	size_t size = 0;
 	bool first = true;
 	bool packetReliable = false;
@@ -276,7 +292,7 @@ AckUnreliableSubPacket MessageQueueUDP::createPacket()
 			const size_t headerSize = 8; // Max header size
 			const size_t totalSize = msgSize + headerSize;
 
-			if (size + totalSize <= maxSize || (first && allowMaxSizeViolation)) {
+			if (size + totalSize <= maxPacketSize || (first && allowMaxSizeViolation)) {
 				// It fits, so add it
 				size += totalSize;
 
@@ -300,7 +316,7 @@ AckUnreliableSubPacket MessageQueueUDP::makeTaggedPacket(Vector<Outbound>& msgs,
 {
 	const bool reliable = !msgs.empty() && channels[msgs[0].channel].settings.reliable;
 
-	auto data = serializeMessages(msgs, size);
+	auto packet = serializeMessages(msgs, size);
 
 	const int tag = nextPacketId++;
 	auto& pendingData = pendingPackets[tag];
@@ -309,7 +325,7 @@ AckUnreliableSubPacket MessageQueueUDP::makeTaggedPacket(Vector<Outbound>& msgs,
 	pendingData.reliable = reliable;
 	pendingData.timeSent = std::chrono::steady_clock::now();
 
-	auto result = AckUnreliableSubPacket(std::move(data));
+	auto result = AckUnreliableSubPacket(std::move(packet));
 	result.tag = tag;
 	result.resends = resends;
 	result.resendSeq = resendSeq;
@@ -4,15 +4,188 @@
 
 using namespace Halley;
 
+NetworkPacketBuffer::NetworkPacketBuffer(Block* block)
+	: block(block)
+{}
+
+NetworkPacketBuffer::NetworkPacketBuffer(const NetworkPacketBuffer& other)
+	: block(other.block)
+{
+	if (block) {
+		block->refCount.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+NetworkPacketBuffer::NetworkPacketBuffer(NetworkPacketBuffer&& other) noexcept
+	: block(other.block)
+{
+	other.block = nullptr;
+}
+
+NetworkPacketBuffer::~NetworkPacketBuffer()
+{
+	reset();
+}
+
+NetworkPacketBuffer& NetworkPacketBuffer::operator=(const NetworkPacketBuffer& other)
+{
+	if (block != other.block) {
+		reset();
+		block = other.block;
+		if (block) {
+			block->refCount.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+	return *this;
+}
+
+NetworkPacketBuffer& NetworkPacketBuffer::operator=(NetworkPacketBuffer&& other) noexcept
+{
+	if (this != &other) {
+		reset();
+		block = other.block;
+		other.block = nullptr;
+	}
+	return *this;
+}
+
+bool NetworkPacketBuffer::isShared() const
+{
+	return block && block->refCount.load(std::memory_order_acquire) > 1;
+}
+
+size_t NetworkPacketBuffer::getCapacity() const
+{
+	return block ? block->capacity : 0;
+}
+
+gsl::span<gsl::byte> NetworkPacketBuffer::getSpan()
+{
+	return block ? gsl::span<gsl::byte>(block->getData(), block->capacity) : gsl::span<gsl::byte>();
+}
+
+gsl::span<const gsl::byte> NetworkPacketBuffer::getSpan() const
+{
+	return block ? gsl::span<const gsl::byte>(block->getData(), block->capacity) : gsl::span<const gsl::byte>();
+}
+
+void NetworkPacketBuffer::reset()
+{
+	if (block) {
+		if (block->refCount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+			NetworkPacketBufferPool::get().release(block);
+		}
+		block = nullptr;
+	}
+}
+
+NetworkPacketBufferPool& NetworkPacketBufferPool::get()
+{
+	static NetworkPacketBufferPool pool;
+	return pool;
+}
+
+NetworkPacketBufferPool::NetworkPacketBufferPool()
+{
+	freeBlocks.reserve(maxFreeBlocks);
+}
+
+NetworkPacketBufferPool::~NetworkPacketBufferPool()
+{
+	for (auto* block: freeBlocks) {
+		block->~Block();
+		::operator delete(block);
+	}
+}
+
+NetworkPacketBuffer NetworkPacketBufferPool::acquire(size_t minCapacity)
+{
+	NetworkPacketBuffer::Block* block = nullptr;
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		++stats.acquired;
+		if (minCapacity <= blockSize && !freeBlocks.empty()) {
+			block = freeBlocks.back();
+			freeBlocks.pop_back();
+		} else {
+			++stats.allocated;
+		}
+	}
+
+	if (!block) {
+		const size_t capacity = std::max(minCapacity, blockSize);
+		block = new (::operator new(sizeof(NetworkPacketBuffer::Block) + capacity)) NetworkPacketBuffer::Block();
+		block->capacity = capacity;
+	}
+	block->refCount.store(1, std::memory_order_relaxed);
+
+	return NetworkPacketBuffer(block);
+}
+
+void NetworkPacketBufferPool::release(NetworkPacketBuffer::Block* block)
+{
+	if (block->capacity == blockSize) {
+		std::unique_lock<std::mutex> lock(mutex);
+		if (freeBlocks.size() < maxFreeBlocks) {
+			freeBlocks.push_back(block);
+			return;
+		}
+	}
+
+	block->~Block();
+	::operator delete(block);
+}
+
+NetworkPacketBufferPool::Stats NetworkPacketBufferPool::getStats() const
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	return stats;
+}
+
+void NetworkPacketBufferPool::resetStats()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	stats = {};
+}
+
 NetworkPacketBase::NetworkPacketBase()
 	: dataStart(0)
+	, dataEnd(0)
 {}
 
 NetworkPacketBase::NetworkPacketBase(gsl::span<const gsl::byte> src, size_t prePadding)
-	: dataStart(prePadding)
+	: buffer(NetworkPacketBufferPool::get().acquire(src.size_bytes() + prePadding))
+	, dataStart(prePadding)
+	, dataEnd(prePadding + src.size_bytes())
+{
+	if (!src.empty()) {
+		memcpy(buffer.getSpan().data() + prePadding, src.data(), src.size_bytes());
+	}
+}
+
+NetworkPacketBase::NetworkPacketBase(NetworkPacketBuffer buf, size_t dataStart, size_t size)
+	: buffer(std::move(buf))
+	, dataStart(dataStart)
+	, dataEnd(dataStart + size)
+{
+	Expects(dataEnd <= buffer.getCapacity());
+}
+
+NetworkPacketBase::NetworkPacketBase(NetworkPacketBase&& other) noexcept
+	: buffer(std::move(other.buffer))
+	, dataStart(other.dataStart)
+	, dataEnd(other.dataEnd)
+{
+	other.dataStart = other.dataEnd = 0;
+}
+
+NetworkPacketBase& NetworkPacketBase::operator=(NetworkPacketBase&& other) noexcept
 {
-	data.resize(src.size_bytes() + prePadding);
-	memcpy(data.data() + prePadding, src.data(), src.size_bytes());
+	buffer = std::move(other.buffer);
+	dataStart = other.dataStart;
+	dataEnd = other.dataEnd;
+	other.dataStart = other.dataEnd = 0;
+	return *this;
 }
 
 size_t NetworkPacketBase::copyTo(gsl::span<gsl::byte> dst) const
@@ -24,88 +197,102 @@ size_t NetworkPacketBase::copyTo(gsl::span<gsl::byte> dst) const
 	if (dst.size() < signed(getSize())) {
 		throw Exception("Destination buffer is too small for network packet.", HalleyExceptions::Network);
 	}
-	memcpy(dst.data(), data.data() + dataStart, getSize());
+	memcpy(dst.data(), getBytes().data(), getSize());
 	return getSize();
 }
 
 size_t NetworkPacketBase::getSize() const
 {
-	Expects(data.size() >= dataStart);
-	return data.size() - dataStart;
+	Expects(dataEnd >= dataStart);
+	return dataEnd - dataStart;
 }
 
 gsl::span<const gsl::byte> NetworkPacketBase::getBytes() const
 {
-	return gsl::span<const gsl::byte>(data).subspan(dataStart, getSize());
+	return buffer.getSpan().subspan(dataStart, getSize());
 }
 
-OutboundNetworkPacket::OutboundNetworkPacket(const OutboundNetworkPacket& other)
+OutboundNetworkPacket::OutboundNetworkPacket()
 	: NetworkPacketBase()
-{
-	data = other.data;
-	dataStart = other.dataStart;
-}
+{}
 
-OutboundNetworkPacket::OutboundNetworkPacket(OutboundNetworkPacket&& other) noexcept
-{
-	data = other.data;
-	dataStart = other.dataStart;
-	other.dataStart = 0;
-}
+OutboundNetworkPacket::OutboundNetworkPacket(const OutboundNetworkPacket& other) = default;
+
+OutboundNetworkPacket::OutboundNetworkPacket(OutboundNetworkPacket&& other) noexcept = default;
 
 OutboundNetworkPacket::OutboundNetworkPacket(gsl::span<const gsl::byte> data)
-	: NetworkPacketBase(data, 128)
+	: NetworkPacketBase(data, headerReserve)
 {}
 
 OutboundNetworkPacket::OutboundNetworkPacket(const Bytes& data)
-	: NetworkPacketBase(gsl::as_bytes(gsl::span<const Byte>(data)), 128)
+	: NetworkPacketBase(gsl::as_bytes(gsl::span<const Byte>(data)), headerReserve)
 {
 }
 
+OutboundNetworkPacket::OutboundNetworkPacket(NetworkPacketBuffer buffer, size_t dataStart, size_t size)
+	: NetworkPacketBase(std::move(buffer), dataStart, size)
+{}
+
 void OutboundNetworkPacket::addHeader(gsl::span<const gsl::byte> src)
 {
-	Expects(src.size_bytes() <= dataStart);
-	
-	dataStart -= src.size_bytes();
-	memcpy(data.data() + dataStart, src.data(), src.size_bytes());
-}
+	const size_t headerSize = src.size_bytes();
 
-OutboundNetworkPacket& OutboundNetworkPacket::operator=(OutboundNetworkPacket&& other) noexcept
-{
-	data = std::move(other.data);
-	dataStart = other.dataStart;
-	other.dataStart = 0;
-	return *this;
+	if (buffer.isShared() || headerSize > dataStart) {
+		// Someone else can see this buffer (or it's out of room), so copy before writing to it
+		const auto size = getSize();
+		const auto padding = std::max(headerReserve, headerSize);
+		auto newBuffer = NetworkPacketBufferPool::get().acquire(padding + size);
+		if (size > 0) {
+			memcpy(newBuffer.getSpan().data() + padding, getBytes().data(), size);
+		}
+		buffer = std::move(newBuffer);
+		dataStart = padding;
+		dataEnd = padding + size;
+	}
+
+	dataStart -= headerSize;
+	memcpy(buffer.getSpan().data() + dataStart, src.data(), headerSize);
 }
 
+OutboundNetworkPacket& OutboundNetworkPacket::operator=(const OutboundNetworkPacket& other) = default;
+
+OutboundNetworkPacket& OutboundNetworkPacket::operator=(OutboundNetworkPacket&& other) noexcept = default;
+
 InboundNetworkPacket::InboundNetworkPacket()
 	: NetworkPacketBase()
 {}
 
-InboundNetworkPacket::InboundNetworkPacket(InboundNetworkPacket&& other) noexcept
-	: NetworkPacketBase()
-{
-	data = std::move(other.data);
-	dataStart = other.dataStart;
-	other.dataStart = 0;
-}
+InboundNetworkPacket::InboundNetworkPacket(const InboundNetworkPacket& other) = default;
+
+InboundNetworkPacket::InboundNetworkPacket(InboundNetworkPacket&& other) noexcept = default;
 
 InboundNetworkPacket::InboundNetworkPacket(gsl::span<const gsl::byte> data)
 	: NetworkPacketBase(data, 0)
 {}
 
+InboundNetworkPacket::InboundNetworkPacket(NetworkPacketBuffer buffer, size_t dataStart, size_t size)
+	: NetworkPacketBase(std::move(buffer), dataStart, size)
+{}
+
+InboundNetworkPacket::InboundNetworkPacket(OutboundNetworkPacket packet)
+	: NetworkPacketBase(std::move(packet.buffer), packet.dataStart, packet.getSize())
+{}
+
 void InboundNetworkPacket::extractHeader(gsl::span<gsl::byte> dst)
 {
-	Expects(dst.size_bytes() <= signed(data.size()));
+	Expects(dst.size_bytes() <= getSize());
 
-	memcpy(dst.data(), data.data() + dataStart, dst.size_bytes());
+	memcpy(dst.data(), getBytes().data(), dst.size_bytes());
 	dataStart += dst.size_bytes();
 }
 
-InboundNetworkPacket& InboundNetworkPacket::operator=(InboundNetworkPacket&& other) noexcept
+InboundNetworkPacket InboundNetworkPacket::getSubPacket(size_t offset, size_t size) const
 {
-	data = other.data;
-	dataStart = other.dataStart;
-	other.dataStart = 0;
-	return *this;
+	Expects(offset + size <= getSize());
+
+	return InboundNetworkPacket(buffer, dataStart + offset, size);
 }
+
+InboundNetworkPacket& InboundNetworkPacket::operator=(const InboundNetworkPacket& other) = default;
+
+InboundNetworkPacket& InboundNetworkPacket::operator=(InboundNetworkPacket&& other) noexcept = default;
@@ -7,7 +7,6 @@
 #include "halley/utils/algorithm.h"
 #include "halley/entity/data_interpolator.h"
 
-class NetworkComponent;
 using namespace Halley;
 
 EntityNetworkRemotePeer::EntityNetworkRemotePeer(EntityNetworkSession& parent, NetworkSession::PeerId peerId)
@@ -35,6 +34,8 @@ void EntityNetworkRemotePeer::sendEntities(Time t, gsl::span<const std::pair<Ent
 		e.second.alive = false;
 	}
 	
+	// Gather everything that has something to send
+	pendingSends.clear();
 	for (auto [entityId, ownerId]: entityIds) {
 		if (ownerId == peerId) {
 			// Don't send updates back to the owner
@@ -45,13 +46,27 @@ void EntityNetworkRemotePeer::sendEntities(Time t, gsl::span<const std::pair<Ent
 		if (peerId == 0 || parent->isEntityInView(entity, clientData)) { // Always send to host
 			if (const auto iter = outboundEntities.find(entityId); iter == outboundEntities.end()) {
 				parent->setupOutboundInterpolators(entity);
-				sendCreateEntity(entity);
+				pendingSends.push_back(PendingSend{ entity, true, parent->getEntityRelevance(entity, clientData), 0 });
 			} else {
-				sendUpdateEntity(t, iter->second, entity);
+				auto& remote = iter->second;
+				remote.alive = true; // Important: mark it back alive
+				remote.timeSinceSend += t;
+				if (remote.timeSinceSend >= parent->getMinSendInterval() && parent->getOutboundSnapshot(entity).data != remote.lastSent.data) {
+					pendingSends.push_back(PendingSend{ entity, false, parent->getEntityRelevance(entity, clientData), remote.timeSinceSend });
+				}
 			}
 		}
 	}
 
+	sendByPriority(pendingSends, parent->getPeerBandwidthBudget(), [&] (const PendingSend& pending, size_t maxSize)
+	{
+		if (pending.create) {
+			return sendCreateEntity(pending.entity, maxSize);
+		} else {
+			return sendUpdateEntity(outboundEntities.at(pending.entity.getEntityId()), pending.entity, maxSize);
+		}
+	});
+
 	// Destroy dead entities
 	for (auto& e: outboundEntities) {
 		if (!e.second.alive) {
@@ -70,6 +85,30 @@ void EntityNetworkRemotePeer::sendEntities(Time t, gsl::span<const std::pair<Ent
 	}
 }
 
+float EntityNetworkRemotePeer::PendingSend::getPriority() const
+{
+	// Priority keeps building up while an update is starved, so everything eventually gets its turn
+	return create ? relevance : relevance * static_cast<float>(timeSinceSend);
+}
+
+void EntityNetworkRemotePeer::sendByPriority(Vector<PendingSend>& pending, size_t budget, const SendFunction& send)
+{
+	std::sort(pending.begin(), pending.end(), [] (const PendingSend& a, const PendingSend& b)
+	{
+		return a.create != b.create ? a.create : a.getPriority() > b.getPriority();
+	});
+
+	size_t bytesSent = 0;
+	for (const auto& p: pending) {
+		// Always let something through, even if it's over the budget on its own
+		const size_t maxSize = budget == 0 || bytesSent == 0 ? std::numeric_limits<size_t>::max() : budget - std::min(budget, bytesSent);
+		if (maxSize == 0) {
+			break;
+		}
+		bytesSent += send(p, maxSize);
+	}
+}
+
 void EntityNetworkRemotePeer::receiveNetworkMessage(NetworkSession::PeerId fromPeerId, EntityNetworkMessage msg)
 {
 	Expects(isAlive());
@@ -117,46 +156,35 @@ uint16_t EntityNetworkRemotePeer::assignId()
 	throw Exception("Unable to allocate network id for entity.", HalleyExceptions::Network);
 }
 
-void EntityNetworkRemotePeer::sendCreateEntity(EntityRef entity)
+size_t EntityNetworkRemotePeer::sendCreateEntity(EntityRef entity, size_t maxSize)
 {
-	OutboundEntity result;
+	const auto& bytes = parent->getOutboundCreate(entity);
+	if (bytes.size() > maxSize) {
+		return 0;
+	}
 
+	OutboundEntity result;
 	result.networkId = assignId();
-	result.data = parent->getFactory().serializeEntity(entity, parent->getEntitySerializationOptions());
-
-	auto deltaData = parent->getFactory().entityDataToPrefabDelta(result.data, entity.getPrefab(), parent->getEntityDeltaOptions());
-	auto bytes = Serializer::toBytes(deltaData, parent->getByteSerializationOptions());
-	//Logger::logDev("Send Create: " + entity.getName() + " (" + entity.getInstanceUUID() + ") to peer " + toString(static_cast<int>(peerId)) + " (" + toString(bytes.size()) + " B):\n" + EntityData(deltaData).toYAML() + "\n");
+	result.lastSent = parent->getOutboundSnapshot(entity);
 
-	send(EntityNetworkMessageCreate(result.networkId, std::move(bytes)));
+	send(EntityNetworkMessageCreate(result.networkId, Bytes(bytes)));
 	
 	outboundEntities[entity.getEntityId()] = std::move(result);
+	return bytes.size();
 }
 
-void EntityNetworkRemotePeer::sendUpdateEntity(Time t, OutboundEntity& remote, EntityRef entity)
+size_t EntityNetworkRemotePeer::sendUpdateEntity(OutboundEntity& remote, EntityRef entity, size_t maxSize)
 {
-	remote.alive = true; // Important: mark it back alive
-	remote.timeSinceSend += t;
-	if (remote.timeSinceSend < parent->getMinSendInterval()) {
-		return;
+	const auto& update = parent->getOutboundUpdate(entity, remote.lastSent);
+	if (!update || update->size() > maxSize) {
+		return 0;
 	}
 
-	// Encode delta using interpolators
-	auto newData = parent->getFactory().serializeEntity(entity, parent->getEntitySerializationOptions());
-	auto retriever = DataInterpolatorSetRetriever(entity, true);
-	auto options = parent->getEntityDeltaOptions();
-	options.interpolatorSet = &retriever;
-	auto deltaData = EntityDataDelta(remote.data, newData, options);
-	
-	if (deltaData.hasChange()) {
-		remote.data = std::move(newData);
-		remote.timeSinceSend = 0;
+	remote.lastSent = parent->getOutboundSnapshot(entity);
+	remote.timeSinceSend = 0;
 
-		auto bytes = Serializer::toBytes(deltaData, parent->getByteSerializationOptions());
-		//Logger::logDev("Send Update " + entity.getName() + " to peer " + toString(static_cast<int>(peerId)) + " (" + toString(bytes.size()) + " B):\n" + deltaData.toYAML() + "\n");
-		
-		send(EntityNetworkMessageUpdate(remote.networkId, std::move(bytes)));
-	}
+	send(EntityNetworkMessageUpdate(remote.networkId, Bytes(*update)));
+	return update->size();
 }
 
 void EntityNetworkRemotePeer::sendDestroyEntity(OutboundEntity& remote)
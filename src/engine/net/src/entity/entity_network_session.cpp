@@ -9,8 +9,14 @@
 #include "halley/entity/world.h"
 #include "halley/support/logger.h"
 #include "halley/utils/algorithm.h"
+#include "halley/utils/hash.h"
+
+#ifndef DONT_INCLUDE_HALLEY_HPP
+#define DONT_INCLUDE_HALLEY_HPP
+#endif
+#include "halley/entity/components/transform_2d_component.h"
+#include "components/network_component.h"
 
-class NetworkComponent;
 using namespace Halley;
 
 EntityNetworkSession::EntityNetworkSession(std::shared_ptr<NetworkSession> session, Resources& resources, std::set<String> ignoreComponents, IEntityNetworkSessionListener* listener)
@@ -25,6 +31,7 @@ EntityNetworkSession::EntityNetworkSession(std::shared_ptr<NetworkSession> sessi
 	this->session->setSharedDataHandler(this);
 
 	entitySerializationOptions.type = EntitySerialization::Type::Network;
+	entitySerializationOptions.cache = &serializationCache;
 
 	deltaOptions.preserveOrder = false;
 	deltaOptions.shallow = false;
@@ -46,6 +53,11 @@ void EntityNetworkSession::setWorld(World& world, SystemMessageBridge bridge)
 	factory = std::make_shared<EntityFactory>(world, resources);
 	messageBridge = bridge;
 
+	// Turned on by sendUpdates once there's someone to send to
+	world.setComponentChangeTracking(false);
+	outboundCache.clear();
+	serializationCache.clear();
+
 	// Clear queue
 	if (!queuedPackets.empty()) {
 		for (auto& qp: queuedPackets) {
@@ -68,6 +80,8 @@ void EntityNetworkSession::sendUpdates(Time t, Rect4i viewRect, gsl::span<const
 	}
 
 	// Update entities
+	updateComponentChangeTracking();
+	updateOutboundCache(t);
 	for (auto& peer: peers) {
 		peer.sendEntities(t, entityIds, session->getClientSharedData<EntityClientSharedData>(peer.getPeerId()));
 	}
@@ -296,6 +310,42 @@ Time EntityNetworkSession::getMinSendInterval() const
 	return 0.05;
 }
 
+void EntityNetworkSession::setPeerBandwidthBudget(size_t bytesPerUpdate)
+{
+	peerBandwidthBudget = bytesPerUpdate;
+}
+
+size_t EntityNetworkSession::getPeerBandwidthBudget() const
+{
+	return peerBandwidthBudget;
+}
+
+void EntityNetworkSession::setRelevanceFalloff(float distance)
+{
+	relevanceFalloff = distance;
+}
+
+float EntityNetworkSession::getEntityRelevance(EntityRef entity, const EntityClientSharedData& clientData) const
+{
+	// Use a const ref so looking these up doesn't count as modifying the components
+	const auto constEntity = ConstEntityRef(entity);
+
+	float relevance = 1.0f;
+	if (const auto* network = constEntity.tryGetComponent<NetworkComponent>()) {
+		relevance = network->importance;
+	}
+
+	if (clientData.viewRect) {
+		if (const auto* transform = constEntity.tryGetComponent<Transform2DComponent>()) {
+			const auto pos = transform->getGlobalPosition();
+			const float distance = (pos - Rect4f(clientData.viewRect.value()).getClosestPoint(pos)).length();
+			relevance *= relevanceFalloff / (relevanceFalloff + distance);
+		}
+	}
+
+	return relevance;
+}
+
 void EntityNetworkSession::onRemoteEntityCreated(EntityRef entity, NetworkSession::PeerId peerId)
 {
 	if (listener) {
@@ -325,6 +375,116 @@ void EntityNetworkSession::setupOutboundInterpolators(EntityRef entity)
 	}
 }
 
+void EntityNetworkSession::updateComponentChangeTracking()
+{
+	// Tracking makes every update system walk its families, so it's only worth it while there are peers to send entities to
+	if (!factory) {
+		return;
+	}
+
+	auto& world = factory->getWorld();
+	const bool tracking = !peers.empty();
+	if (tracking != world.hasComponentChangeTracking()) {
+		world.setComponentChangeTracking(tracking);
+		if (tracking) {
+			// Anything cached was serialized before writes were being tracked
+			outboundCache.clear();
+			serializationCache.clear();
+		}
+	}
+}
+
+void EntityNetworkSession::updateOutboundCache(Time t)
+{
+	// Entries not used last update belong to entities that were destroyed or aren't being sent to anyone anymore
+	std_ex::erase_if_value(outboundCache, [&] (const OutboundCacheEntry& entry) { return entry.generation != outboundGeneration; });
+	for (auto& [id, entry]: outboundCache) {
+		entry.age += t;
+	}
+	if (factory) {
+		serializationCache.removeDeadEntities(factory->getWorld());
+	}
+
+	++outboundGeneration;
+}
+
+EntityNetworkSession::OutboundCacheEntry& EntityNetworkSession::getOutboundCacheEntry(EntityRef entity)
+{
+	auto& entry = outboundCache[entity.getEntityId()];
+	if (entry.generation != outboundGeneration) {
+		entry.generation = outboundGeneration;
+		entry.create.reset();
+		entry.updates.clear();
+
+		const auto revision = getEntityTreeRevision(entity);
+		if (!entry.snapshot.data || entry.snapshot.revision != revision || entry.age > maxSnapshotAge) {
+			if (entry.age > maxSnapshotAge) {
+				serializationCache.invalidate(entity);
+			}
+			entry.snapshot.revision = revision;
+			entry.snapshot.data = std::make_shared<EntityData>(factory->serializeEntity(entity, entitySerializationOptions));
+			entry.age = 0;
+		}
+	}
+	return entry;
+}
+
+const EntityNetworkSnapshot& EntityNetworkSession::getOutboundSnapshot(EntityRef entity)
+{
+	return getOutboundCacheEntry(entity).snapshot;
+}
+
+const Bytes& EntityNetworkSession::getOutboundCreate(EntityRef entity)
+{
+	auto& entry = getOutboundCacheEntry(entity);
+	if (!entry.create) {
+		auto deltaData = factory->entityDataToPrefabDelta(EntityData(*entry.snapshot.data), entity.getPrefab(), deltaOptions);
+		entry.create = Serializer::toBytes(deltaData, byteSerializationOptions);
+		//Logger::logDev("Send Create: " + entity.getName() + " (" + entity.getInstanceUUID() + ") (" + toString(entry.create->size()) + " B):\n" + EntityData(deltaData).toYAML() + "\n");
+	}
+	return *entry.create;
+}
+
+const std::optional<Bytes>& EntityNetworkSession::getOutboundUpdate(EntityRef entity, const EntityNetworkSnapshot& from)
+{
+	auto& entry = getOutboundCacheEntry(entity);
+	for (const auto& [fromData, update]: entry.updates) {
+		if (fromData == from.data.get()) {
+			return update;
+		}
+	}
+
+	// Encode delta using interpolators
+	auto retriever = DataInterpolatorSetRetriever(entity, true);
+	auto options = deltaOptions;
+	options.interpolatorSet = &retriever;
+	auto deltaData = EntityDataDelta(*from.data, *entry.snapshot.data, options);
+
+	std::optional<Bytes> update;
+	if (deltaData.hasChange()) {
+		update = Serializer::toBytes(deltaData, byteSerializationOptions);
+		//Logger::logDev("Send Update " + entity.getName() + " (" + toString(update->size()) + " B):\n" + deltaData.toYAML() + "\n");
+	}
+	return entry.updates.emplace_back(from.data.get(), std::move(update)).second;
+}
+
+uint64_t EntityNetworkSession::getEntityTreeRevision(EntityRef entity) const
+{
+	// Entity revisions only cover the entity itself, but it's serialized along with all its children
+	Hash::Hasher hasher;
+	const auto feed = [&] (const auto& self, EntityRef e) -> void
+	{
+		hasher.feed(e.getEntityId());
+		hasher.feed(e.getRevision());
+		hasher.feed(e.getHierarchyRevision());
+		for (const auto& child: e.getChildren()) {
+			self(self, child);
+		}
+	};
+	feed(feed, entity);
+	return hasher.digest();
+}
+
 bool EntityNetworkSession::isReadyToStart() const
 {
 	return readyToStart;
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "halley/maths/rect.h"
+#include "halley/data_structures/vector.h"
+#include <gsl/span>
+
+namespace Halley {
+	class UIParent;
+	class UIWidget;
+
+	// A flattened copy of the widget tree, bucketed into a uniform grid by mouse rect, for finding the widget under the mouse.
+	// Resolves hits the same way a depth-first walk of the tree does: a widget's descendants take precedence over it, siblings
+	// compete on layer adjustment (earliest wins ties), and an active mouse blocker at the root stops the search.
+	// It holds raw pointers, so it must be rebuilt whenever widgets are added, removed, activated, enabled or change layer.
+	// Widgets that only moved can be updated in place instead.
+	class UIHitTestGrid {
+	public:
+		void rebuild(const UIParent& root);
+		UIWidget* getWidgetAt(Vector2f pos, bool includeDisabled) const;
+
+		// Picks up a new mouse rect for a widget. Returns false if so many widgets have moved that it's better off rebuilt.
+		bool updateWidget(const UIWidget& widget);
+		size_t getMaxMoved() const;
+
+		size_t getNumEntries() const;
+
+	private:
+		struct Entry {
+			UIWidget* widget;
+			Rect4f mouseRect;
+			uint32_t subtreeEnd;
+			int layer;
+			bool enabled;
+			bool moved; // Left in the cells it was in, but tested from the moved list instead
+		};
+
+		struct RootEntry {
+			UIWidget* widget;
+			uint32_t begin;
+			uint32_t end;
+		};
+
+		constexpr static float minCellSize = 64.0f;
+		constexpr static float maxCells = 16384.0f;
+		constexpr static size_t minMovedBeforeRebuild = 256;
+
+		Vector<Entry> entries;
+		Vector<RootEntry> roots;
+		Vector<uint32_t> moved;
+
+		Rect4f bounds;
+		Vector2i gridSize;
+		float cellSize = minCellSize;
+		Vector<uint32_t> cellStart;
+		Vector<uint32_t> cellEntries;
+
+		mutable Vector<uint32_t> hits;
+
+		void addWidget(UIWidget& widget, int layer, bool enabled);
+		void buildGrid();
+		Vector2i getCell(Vector2f pos) const;
+		uint32_t resolve(gsl::span<const uint32_t> hits) const;
+	};
+}
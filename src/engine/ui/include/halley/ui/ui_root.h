@@ -4,6 +4,7 @@
 #include "ui_event.h"
 #include "ui_parent.h"
 #include "ui_input.h"
+#include "ui_hit_test_grid.h"
 
 namespace Halley {
 	class UIStyle;
@@ -25,6 +26,8 @@ namespace Halley {
 	};
 	
 	class UIRoot final : public UIParent {
+		friend class UIWidget;
+
 	public:
 		explicit UIRoot(const HalleyAPI& api, Rect4f rect = {});
 		~UIRoot();
@@ -42,6 +45,7 @@ namespace Halley {
 
 		void mouseOverNext(bool forward = true);
 		void runLayout();
+		size_t getNumWidgetsLaidOut() const; // During the last update
 		
 		std::optional<std::shared_ptr<IAudioHandle>> playSound(const String& eventName);
 		void sendEvent(UIEvent event) const override;
@@ -94,6 +98,15 @@ namespace Halley {
 
 		std::shared_ptr<UIToolTip> toolTip;
 
+		size_t widgetsLaidOut = 0;
+		size_t lastWidgetsLaidOut = 0;
+
+		mutable UIHitTestGrid hitTestGrid;
+		mutable bool hitTestDirty = true;
+		uint64_t frameNumber = 0;
+		uint64_t hitTestInvalidatedFrame = 0;
+		size_t hitTestMovesThisFrame = 0;
+
 		void updateMouse(const std::shared_ptr<InputDevice>& mouse, KeyMods keyMods);
 		void updateGamepadInputTree(const std::shared_ptr<InputDevice>& input, UIWidget& c, Vector<UIWidget*>& inputTargets, UIGamepadInput::Priority& bestPriority, bool accepting);
 		void updateGamepadInput(const std::shared_ptr<InputDevice>& input);
@@ -106,6 +119,8 @@ namespace Halley {
 
 		std::shared_ptr<UIWidget> getWidgetUnderMouse(Vector2f mousePos, bool includeDisabled = false) const;
 		std::pair<std::shared_ptr<UIWidget>, int> getWidgetUnderMouse(const std::shared_ptr<UIWidget>& curWidget, Vector2f mousePos, bool includeDisabled = false, int childLayerAdjustment = 0) const;
+		void invalidateHitTest();
+		void onWidgetMouseRectChanged(const UIWidget& widget);
 		void updateMouseOver(const std::shared_ptr<UIWidget>& underMouse);
 		void collectWidgets(const std::shared_ptr<UIWidget>& start, Vector<std::shared_ptr<UIWidget>>& output);
 
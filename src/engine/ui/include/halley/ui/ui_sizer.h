@@ -145,6 +145,7 @@ namespace Halley {
 		{
 			std::sort(entries.begin(), entries.end(), f);
 			sortChildrenBySizerOrder();
+			markAsNeedingLayout();
 		}
 
 	private:
@@ -180,5 +181,6 @@ namespace Halley {
 		float getRowProportion(int row) const;
 
 		void sortChildrenBySizerOrder();
+		void markAsNeedingLayout();
 	};
 }
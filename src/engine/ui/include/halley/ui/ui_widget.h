@@ -30,6 +30,7 @@ namespace Halley {
 	class UIWidget : public IUIElement, public UIParent, public IUISizer, public std::enable_shared_from_this<UIWidget> {
 		friend class UIParent;
 		friend class UIRoot;
+		friend class UIHitTestGrid;
 
 	public:
 		UIWidget(String id = "", Vector2f minSize = {}, std::optional<UISizer> sizer = {}, Vector4f innerBorder = {});
@@ -78,7 +79,7 @@ namespace Halley {
 		const String& getId() const final override;
 
 		Vector2f getPosition() const;
-		virtual Vector2f getLayoutOriginPosition() const;
+		virtual Vector2f getLayoutOriginPosition() const; // Overrides must call markLayoutDirty() when this changes
 		Vector2f getSize() const;
 		Vector2f getMinimumSize() const;
 		Vector4f getInnerBorder() const;
@@ -167,6 +168,7 @@ namespace Halley {
 
 		bool needsLayout() const;
 		void markAsNeedingLayout() final override;
+		void markLayoutDirty() final override;
 
 		virtual bool canReceiveFocus() const;
 		std::shared_ptr<UIWidget> getFocusableOrAncestor();
@@ -222,6 +224,8 @@ namespace Halley {
 
 		virtual void checkActive();
 
+		void notifyMouseRectChanged(); // Call when something getMouseRect depends on changes, other than the rect itself
+
 		Vector<UIStyle> styles = {};
 
 	private:
@@ -246,6 +250,7 @@ namespace Halley {
 		UIInputType lastInputType = UIInputType::Undefined;
 	private:
 		mutable int layoutNeeded = 1;
+		bool layoutDirty = true; // This widget or something below it has to be placed again, even if its rect is unchanged
 		
 		Vector2f position;
 		Vector2f size;
@@ -256,6 +261,7 @@ namespace Halley {
 		std::optional<UISizer> sizer;
 
 		mutable Vector2f layoutSize;
+		Vector2f layoutOrigin;
 
 		std::shared_ptr<UIEventHandler> eventHandler;
 		std::shared_ptr<UIValidator> validator;
@@ -266,6 +272,7 @@ namespace Halley {
 		std::unique_ptr<LocalisedString> toolTip;
 
 		int childLayerAdjustment = 0;
+		uint32_t hitTestIndex = std::numeric_limits<uint32_t>::max(); // Where it was in the root's hit test grid when that was last rebuilt
 
 		bool activeByUser = true;
 		bool activeByInput = true;
@@ -4,6 +4,7 @@
 #include "../ui_style.h"
 #include "halley/core/graphics/sprite/sprite.h"
 #include "halley/core/graphics/text/text_renderer.h"
+#include "halley/data_structures/hash_map.h"
 #include "ui_button.h"
 
 namespace Halley {
@@ -21,6 +22,13 @@ namespace Halley {
 			ShiftSelect,
 			AddToSelect
 		};
+
+		struct VirtualItem {
+			String id;
+			LocalisedString label;
+			Sprite icon;
+		};
+		using VirtualItemCallback = std::function<VirtualItem(int index)>;
 		
 		explicit UIList(String id, UIStyle style, UISizerType orientation = UISizerType::Vertical, int nColumns = 1);
 
@@ -84,6 +92,13 @@ namespace Halley {
 
         void setScrollToSelection(bool enabled);
 
+		// Virtualised mode: the list has count items, but only those in view (plus a margin) get widgets, which are recycled as the list scrolls.
+		// Their contents come from callback, and every item is assumed to be as big as the first one, unless itemSize is given.
+		// Items can't be added, removed, filtered or dragged individually in this mode, call this again (or refreshVirtualItems) when the data changes instead.
+		void setVirtualItems(int count, VirtualItemCallback callback, float itemSize = -1);
+		void refreshVirtualItems();
+		bool isVirtual() const;
+
 		bool ignoreClip() const override;
 
 		bool canReceiveFocus() const override;
@@ -118,6 +133,15 @@ namespace Halley {
 		void reassignIds();
 		void resetSelectionIfInvalid();
 
+		virtual std::shared_ptr<UIListItem> makeVirtualItem();
+		virtual void bindVirtualItem(int index, UIListItem& item);
+		virtual int findVirtualItem(const String& id) const;
+		virtual String getVirtualItemId(int index) const;
+		void setVirtualItemCount(int count);
+		void refreshVirtualItem(int index); // Binds it again if it's in view
+		void setVirtualSelection(gsl::span<const int> selection, int current);
+		void selectFirstIfRequired();
+
 		Vector<std::shared_ptr<UIListItem>> items;
 		int curOption = -1;
 		int curHover = -1;
@@ -141,6 +165,18 @@ namespace Halley {
 
 		bool requiresSelection = true;
 
+		constexpr static int virtualItemMargin = 8;
+		bool virtualised = false;
+		bool virtualItemsDirty = false;
+		int virtualCount = 0;
+		int virtualFirst = 0;
+		float virtualItemSize = -1;
+		Vector<uint8_t> virtualSelected;
+		Vector<std::shared_ptr<UIListItem>> virtualPool;
+		VirtualItemCallback virtualCallback;
+		mutable HashMap<String, int> virtualIndices; // Built by findVirtualItem when it's first needed
+		mutable bool virtualIndicesDirty = true;
+
 		void onItemClicked(UIListItem& item, int button, KeyMods keyMods);
 		void onItemClickReleased(UIListItem& item, int button, KeyMods keyMods);
 		SelectionMode getMode(KeyMods mods, int button) const;
@@ -153,6 +189,18 @@ namespace Halley {
 
 		void applyImageColour(UIImage& image) const;
 
+		bool isOptionSelectable(int option) const;
+		bool isOptionSelected(int option) const;
+		void setOptionSelected(int option, bool selected);
+
+		void updateVirtualItems();
+		void bindVirtualItemAt(int index, UIListItem& item);
+		std::shared_ptr<UIListItem> tryGetVirtualItem(int index) const;
+		std::pair<int, int> getVirtualRange() const;
+		Rect4f getVirtualViewport() const;
+		float getVirtualStride() const;
+		int getVirtualAxis() const;
+
 		bool changeSelection(int oldItem, int newItem, SelectionMode mode);
 		bool deselectAll(std::optional<int> exceptFor);
 		void notifyNewItemSelected();
@@ -2,6 +2,7 @@
 
 #include "ui_list.h"
 #include "ui_label.h"
+#include "halley/data_structures/hash_map.h"
 
 namespace Halley {
     class UITreeListControls : public UIWidget {
@@ -48,6 +49,7 @@ namespace Halley {
     	
     	UITreeListItem();
     	UITreeListItem(String id, std::shared_ptr<UIListItem> listItem, std::shared_ptr<UITreeListControls> treeControls, std::shared_ptr<UILabel> label, std::shared_ptr<UIImage> iconWidget, bool forceLeaf, bool expanded);
+    	UITreeListItem(String id, LocalisedString label, String labelStyle, Sprite icon, bool forceLeaf, bool expanded);
 
     	UITreeListItem* tryFindId(const String& id);
         UITreeListItem& addChild(std::unique_ptr<UITreeListItem> item, size_t pos);
@@ -59,6 +61,7 @@ namespace Halley {
         Colour4f getLabelColour() const;
     	void setIcon(Sprite icon);
         bool setExpanded(bool expanded);
+        bool isExpanded() const;
         bool setAllExpanded(UITreeList& tree, bool expanded);
         void setForceLeaf(bool leaf);
 
@@ -88,13 +91,20 @@ namespace Halley {
         bool hasTagInAncestors(const String& tag) const;
 
     private:
+        friend class UITreeList;
+
     	String id;
     	String parentId;
         UITreeListItem* parent = nullptr;
+        UITreeList* virtualTree = nullptr; // Only set in virtual trees, which have no widgets of their own to update
         std::shared_ptr<UIListItem> listItem;
         std::shared_ptr<UILabel> label;
     	std::shared_ptr<UIImage> icon;
         std::shared_ptr<UITreeListControls> treeControls;
+        LocalisedString labelText;
+        String labelStyle;
+        Sprite iconSprite;
+        std::optional<Colour4f> labelColour;
     	Vector<std::unique_ptr<UITreeListItem>> children;
         Vector<String> tags;
     	bool expanded = true;
@@ -124,6 +134,10 @@ namespace Halley {
     	void setSingleRoot(bool enabled);
     	bool isSingleRoot() const;
 
+        // Only creates widgets for the items in view, see UIList::setVirtualItems. Must be called while the tree is empty.
+        // Items can't be dragged in this mode, and getListItem() returns null for all of them.
+        void setVirtual();
+
         void setAllExpanded(bool expanded);
 
         bool canDragListItem(const UIListItem& listItem) override;
@@ -142,20 +156,40 @@ namespace Halley {
         void onItemDragging(UIListItem& item, int index, Vector2f pos) override;
         void onItemDoneDragging(UIListItem& item, int index, Vector2f pos) override;
 
+        std::shared_ptr<UIListItem> makeVirtualItem() override;
+        void bindVirtualItem(int index, UIListItem& item) override;
+        int findVirtualItem(const String& id) const override;
+        String getVirtualItemId(int index) const override;
+
     	virtual bool canParentItemTo(const String& itemId, const String& parentId) const;
         virtual bool canDragItemId(const String& itemId) const;
     	
     private:
         friend class UITreeListItem;
 
+        struct VirtualRow {
+        	UITreeListItem* item;
+        	uint32_t guidesStart;
+        	uint32_t depth;
+        };
+
     	UITreeListItem root;
+        HashMap<String, UITreeListItem*> itemsById;
     	Sprite insertCursor;
     	bool needsRefresh = true;
     	bool singleRoot = false;
 
+        Vector<VirtualRow> virtualRows;
+        Vector<int> virtualGuides;
+        HashMap<String, int> virtualRowIndices;
+
     	UITreeListItem& getItemOrRoot(const String& id);
+        std::shared_ptr<UILabel> makeItemLabel(const String& id, const LocalisedString& label, const String& labelStyleName) const;
         void setupEvents();
     	void reparentItems(gsl::span<const String> ids, const String& newParentId, int childIndex);
     	void removeTree(const UITreeListItem& tree);
+        void refreshVirtualRows(const String& curId);
+        void onVirtualItemChanged(const UITreeListItem& item);
+        void collectVirtualRows(UITreeListItem& item, Vector<int>& itemsLeftPerDepth);
     };
 }
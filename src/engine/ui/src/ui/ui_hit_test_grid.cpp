@@ -0,0 +1,199 @@
+#include "halley/ui/ui_hit_test_grid.h"
+#include "ui_parent.h"
+#include "ui_widget.h"
+using namespace Halley;
+
+namespace {
+	constexpr uint32_t noEntry = std::numeric_limits<uint32_t>::max();
+
+	bool isEmpty(const Rect4f& rect)
+	{
+		return !(rect.getWidth() > 0 && rect.getHeight() > 0);
+	}
+}
+
+void UIHitTestGrid::rebuild(const UIParent& root)
+{
+	entries.clear();
+	roots.clear();
+	moved.clear();
+
+	for (const auto& c: root.getChildren()) {
+		if (c->isActive()) {
+			const auto begin = static_cast<uint32_t>(entries.size());
+			addWidget(*c, 0, true);
+			roots.push_back(RootEntry{ c.get(), begin, static_cast<uint32_t>(entries.size()) });
+		}
+	}
+
+	buildGrid();
+}
+
+UIWidget* UIHitTestGrid::getWidgetAt(Vector2f pos, bool includeDisabled) const
+{
+	hits.clear();
+	if (!cellStart.empty() && bounds.contains(pos)) {
+		const auto cell = getCell(pos);
+		const auto cellIdx = size_t(cell.y) * size_t(gridSize.x) + size_t(cell.x);
+		for (uint32_t i = cellStart[cellIdx]; i < cellStart[cellIdx + 1]; ++i) {
+			const auto& entry = entries[cellEntries[i]];
+			if (!entry.moved && (includeDisabled || entry.enabled) && entry.mouseRect.contains(pos) && entry.widget->canInteractWithMouse()) {
+				hits.push_back(cellEntries[i]);
+			}
+		}
+	}
+	if (!moved.empty()) {
+		for (const auto idx: moved) {
+			const auto& entry = entries[idx];
+			if ((includeDisabled || entry.enabled) && entry.mouseRect.contains(pos) && entry.widget->canInteractWithMouse()) {
+				hits.push_back(idx);
+			}
+		}
+		std::sort(hits.begin(), hits.end());
+	}
+
+	// Hits are in tree order, so each root widget's hits are a contiguous range
+	for (auto root = roots.rbegin(); root != roots.rend(); ++root) {
+		const auto first = std::lower_bound(hits.begin(), hits.end(), root->begin);
+		const auto last = std::lower_bound(first, hits.end(), root->end);
+		if (first != last) {
+			return entries[resolve(gsl::span<const uint32_t>(&*first, last - first))].widget;
+		}
+		if (root->widget->isMouseBlocker()) {
+			return nullptr;
+		}
+	}
+	return nullptr;
+}
+
+bool UIHitTestGrid::updateWidget(const UIWidget& widget)
+{
+	// Widgets that aren't in the grid are inactive, and will be added by a rebuild when that changes
+	const auto idx = widget.hitTestIndex;
+	if (idx >= entries.size() || entries[idx].widget != &widget) {
+		return true;
+	}
+
+	auto& entry = entries[idx];
+	const auto rect = widget.getMouseRect();
+	if (rect == entry.mouseRect) {
+		return true;
+	}
+
+	entry.mouseRect = rect;
+	if (!entry.moved) {
+		entry.moved = true;
+		moved.push_back(idx);
+	}
+	return moved.size() <= getMaxMoved();
+}
+
+size_t UIHitTestGrid::getMaxMoved() const
+{
+	return std::max(minMovedBeforeRebuild, entries.size() / 8);
+}
+
+size_t UIHitTestGrid::getNumEntries() const
+{
+	return entries.size();
+}
+
+void UIHitTestGrid::addWidget(UIWidget& widget, int layer, bool enabled)
+{
+	if (!widget.isActive()) {
+		return;
+	}
+
+	const auto idx = entries.size();
+	entries.push_back(Entry{ &widget, widget.getMouseRect(), 0, layer, enabled && widget.isEnabled(), false });
+	widget.hitTestIndex = static_cast<uint32_t>(idx);
+
+	const int childLayer = layer + widget.getChildLayerAdjustment();
+	const bool childEnabled = entries[idx].enabled;
+	for (const auto& c: widget.getChildren()) {
+		addWidget(*c, childLayer, childEnabled);
+	}
+
+	entries[idx].subtreeEnd = static_cast<uint32_t>(entries.size());
+}
+
+void UIHitTestGrid::buildGrid()
+{
+	cellStart.clear();
+	cellEntries.clear();
+
+	std::optional<Rect4f> totalBounds;
+	for (const auto& e: entries) {
+		if (!isEmpty(e.mouseRect)) {
+			totalBounds = totalBounds ? totalBounds->merge(e.mouseRect) : e.mouseRect;
+		}
+	}
+	if (!totalBounds) {
+		return;
+	}
+
+	bounds = *totalBounds;
+	const auto size = bounds.getSize();
+	cellSize = std::max(minCellSize, std::sqrt(size.x * size.y / maxCells));
+	gridSize = Vector2i(std::max(1, int(std::ceil(size.x / cellSize))), std::max(1, int(std::ceil(size.y / cellSize))));
+
+	// Count entries per cell, then fill them in tree order
+	cellStart.resize(size_t(gridSize.x) * size_t(gridSize.y) + 1, 0);
+	auto forEachCell = [&] (const Rect4f& rect, auto f)
+	{
+		const auto c0 = getCell(rect.getTopLeft());
+		const auto c1 = getCell(rect.getBottomRight());
+		for (int y = c0.y; y <= c1.y; ++y) {
+			for (int x = c0.x; x <= c1.x; ++x) {
+				f(size_t(y) * size_t(gridSize.x) + size_t(x));
+			}
+		}
+	};
+
+	for (const auto& e: entries) {
+		if (!isEmpty(e.mouseRect)) {
+			forEachCell(e.mouseRect, [&] (size_t cellIdx) { ++cellStart[cellIdx + 1]; });
+		}
+	}
+	for (size_t i = 1; i < cellStart.size(); ++i) {
+		cellStart[i] += cellStart[i - 1];
+	}
+
+	cellEntries.resize(cellStart.back());
+	Vector<uint32_t> cursor(cellStart.begin(), cellStart.end() - 1);
+	for (uint32_t i = 0; i < static_cast<uint32_t>(entries.size()); ++i) {
+		if (!isEmpty(entries[i].mouseRect)) {
+			forEachCell(entries[i].mouseRect, [&] (size_t cellIdx) { cellEntries[cursor[cellIdx]++] = i; });
+		}
+	}
+}
+
+Vector2i UIHitTestGrid::getCell(Vector2f pos) const
+{
+	const auto rel = (pos - bounds.getTopLeft()) / cellSize;
+	return Vector2i(clamp(int(std::floor(rel.x)), 0, gridSize.x - 1), clamp(int(std::floor(rel.y)), 0, gridSize.y - 1));
+}
+
+uint32_t UIHitTestGrid::resolve(gsl::span<const uint32_t> hits) const
+{
+	// Each hit is followed by the hits in its subtree, which take precedence over it
+	uint32_t best = noEntry;
+	for (size_t i = 0; i < hits.size(); ) {
+		const auto& top = entries[hits[i]];
+		size_t groupEnd = i + 1;
+		while (groupEnd < hits.size() && hits[groupEnd] < top.subtreeEnd) {
+			++groupEnd;
+		}
+
+		uint32_t result = resolve(hits.subspan(i + 1, groupEnd - i - 1));
+		if (result == noEntry) {
+			result = hits[i];
+		}
+		if (best == noEntry || entries[result].layer > entries[best].layer) {
+			best = result;
+		}
+
+		i = groupEnd;
+	}
+	return best;
+}
@@ -9,6 +9,7 @@
 #include "halley/core/input/input_virtual.h"
 #include "halley/maths/random.h"
 #include "halley/support/logger.h"
+#include "halley/support/profiler.h"
 #include "widgets/ui_tooltip.h"
 
 using namespace Halley;
@@ -67,10 +68,18 @@ void UIRoot::runLayout()
 	}
 }
 
+size_t UIRoot::getNumWidgetsLaidOut() const
+{
+	return lastWidgetsLaidOut;
+}
+
 void UIRoot::update(Time t, UIInputType activeInputType, spInputDevice mouse, spInputDevice manual)
 {
 	auto joystickType = manual ? manual->getJoystickType() : JoystickType::Generic;
 	bool first = true;
+	widgetsLaidOut = 0;
+	++frameNumber;
+	hitTestMovesThisFrame = 0;
 
 	updateKeyboardInput();
 
@@ -92,16 +101,22 @@ void UIRoot::update(Time t, UIInputType activeInputType, spInputDevice mouse, sp
 		removeDeadChildren();
 
 		// Layout all widgets
+		const auto laidOutBefore = widgetsLaidOut;
 		runLayout();
 
 		// Update again, to reflect what happened >_>
-		for (auto& c: getChildren()) {
-			c->doUpdate(UIWidgetUpdateType::Partial, 0, activeInputType, joystickType);
+		if (widgetsLaidOut != laidOutBefore) {
+			for (auto& c: getChildren()) {
+				c->doUpdate(UIWidgetUpdateType::Partial, 0, activeInputType, joystickType);
+			}
 		}
 
 		// For subsequent iterations, make sure t = 0
 		t = 0;
 	} while (isWaitingToSpawnChildren());
+
+	lastWidgetsLaidOut = widgetsLaidOut;
+	ProfilerCapture::get().addCounter(ProfilerCounterType::UIWidgetsLaidOut, int64_t(widgetsLaidOut));
 }
 
 void UIRoot::updateGamepadInputTree(const spInputDevice& input, UIWidget& widget, Vector<UIWidget*>& inputTargets, UIGamepadInput::Priority& bestPriority, bool accepting)
@@ -442,19 +457,31 @@ void UIRoot::updateMouseOver(const std::shared_ptr<UIWidget>& underMouse)
 
 std::shared_ptr<UIWidget> UIRoot::getWidgetUnderMouse(Vector2f mousePos, bool includeDisabled) const
 {
-	const auto& cs = getChildren();
-	for (int i = static_cast<int>(cs.size()); --i >= 0; ) {
-		const auto& curRootWidget = cs[i];
-		const auto result = getWidgetUnderMouse(curRootWidget, mousePos, includeDisabled);
-		if (result.first) {
-			return result.first;
-		} else {
-			if (curRootWidget->isMouseBlocker() && curRootWidget->isActiveInHierarchy()) {
-				return {};
+	if (hitTestDirty) {
+		if (hitTestInvalidatedFrame + 1 >= frameNumber) {
+			// Changed during this frame or the last one, which laid it out after its hit test. It might still be changing (e.g. being built or scrolled),
+			// so walk the tree rather than rebuild a grid that might not last until the next frame.
+			const auto& cs = getChildren();
+			for (int i = static_cast<int>(cs.size()); --i >= 0; ) {
+				const auto& curRootWidget = cs[i];
+				const auto result = getWidgetUnderMouse(curRootWidget, mousePos, includeDisabled);
+				if (result.first) {
+					return result.first;
+				} else {
+					if (curRootWidget->isMouseBlocker() && curRootWidget->isActiveInHierarchy()) {
+						return {};
+					}
+				}
 			}
+			return {};
 		}
+
+		hitTestGrid.rebuild(*this);
+		hitTestDirty = false;
 	}
-	return {};
+
+	auto* widget = hitTestGrid.getWidgetAt(mousePos, includeDisabled);
+	return widget ? widget->shared_from_this() : std::shared_ptr<UIWidget>();
 }
 
 std::pair<std::shared_ptr<UIWidget>, int> UIRoot::getWidgetUnderMouse(const std::shared_ptr<UIWidget>& curWidget, Vector2f mousePos, bool includeDisabled, int childLayerAdjustment) const
@@ -484,6 +511,24 @@ std::pair<std::shared_ptr<UIWidget>, int> UIRoot::getWidgetUnderMouse(const std:
 	}
 }
 
+void UIRoot::invalidateHitTest()
+{
+	hitTestDirty = true;
+	hitTestInvalidatedFrame = frameNumber;
+}
+
+void UIRoot::onWidgetMouseRectChanged(const UIWidget& widget)
+{
+	if (hitTestDirty) {
+		// As many widgets moving as it takes to need a rebuild, every frame (e.g. while scrolling), keeps it from being rebuilt until they stop
+		if (++hitTestMovesThisFrame > hitTestGrid.getMaxMoved()) {
+			hitTestInvalidatedFrame = frameNumber;
+		}
+	} else if (!hitTestGrid.updateWidget(widget)) {
+		invalidateHitTest();
+	}
+}
+
 void UIRoot::setUIMouseRemapping(std::function<Vector2f(Vector2f)> remapFunction)
 {
 	Expects(remapFunction != nullptr);
@@ -591,6 +636,8 @@ void UIRoot::focusNext(bool reverse)
 
 void UIRoot::onWidgetRemoved(const UIWidget& widget)
 {
+	invalidateHitTest();
+
 	auto focus = currentFocus.lock();
 	if (focus && focus.get() == &widget) {
 		currentFocus.reset();
@@ -610,6 +657,7 @@ Vector<std::shared_ptr<UIWidget>> UIRoot::collectWidgets()
 void UIRoot::onChildAdded(UIWidget& child)
 {
 	//child.notifyTreeAddedToRoot(*this);
+	invalidateHitTest();
 }
 
 void UIRoot::collectWidgets(const std::shared_ptr<UIWidget>& start, Vector<std::shared_ptr<UIWidget>>& output)
@@ -176,6 +176,7 @@ void UISizer::add(std::shared_ptr<IUIElement> element, float proportion, Vector4
 {
 	entries.emplace(entries.begin() + std::min(entries.size(), insertPos), UISizerEntry(element, proportion, border, fillFlags, position));
 	reparentEntry(entries.back());
+	markAsNeedingLayout();
 }
 
 void UISizer::addSpacer(float size)
@@ -192,6 +193,7 @@ void UISizer::addStretchSpacer(float proportion)
 void UISizer::remove(IUIElement& element)
 {
 	entries.erase(std::remove_if(entries.begin(), entries.end(), [&] (const UISizerEntry& e) { return e.getPointer().get() == &element; }), entries.end());
+	markAsNeedingLayout();
 }
 
 void UISizer::reparent(UIParent& parent)
@@ -265,6 +267,7 @@ void UISizer::updateEnabled() const
 void UISizer::swapItems(int idxA, int idxB)
 {
 	std::swap(entries[idxA], entries[idxB]);
+	markAsNeedingLayout();
 }
 
 void UISizer::clear()
@@ -281,6 +284,7 @@ void UISizer::clear()
 		}
 	}
 	entries.clear();
+	markAsNeedingLayout();
 }
 
 bool UISizer::isActive() const
@@ -297,6 +301,7 @@ void UISizer::setColumnProportions(const Vector<float>& values)
 {
 	if (gridProportions) {
 		gridProportions->columnProportions = values;
+		markAsNeedingLayout();
 	}
 }
 
@@ -307,6 +312,7 @@ void UISizer::setEvenColumns()
 		for (auto& c: gridProportions->columnProportions) {
 			c = 1.0f;
 		}
+		markAsNeedingLayout();
 	}
 }
 
@@ -315,6 +321,7 @@ void UISizer::setRowProportions(const Vector<float>& values)
 {
 	if (gridProportions) {
 		gridProportions->rowProportions = values;
+		markAsNeedingLayout();
 	}
 }
 
@@ -640,6 +647,13 @@ float UISizer::getRowProportion(int row) const
 	return 0.0f;
 }
 
+void UISizer::markAsNeedingLayout()
+{
+	if (curParent) {
+		curParent->markAsNeedingLayout();
+	}
+}
+
 void UISizer::sortChildrenBySizerOrder()
 {
 	auto& children = curParent->getChildren();
@@ -141,10 +141,21 @@ Vector2f UIWidget::getLayoutMinimumSize(bool force) const
 
 void UIWidget::setRect(Rect4f rect, IUIElementListener* listener)
 {
+	// Nothing in this subtree changed since it was last placed at this rect, so every child would land where it already is
+	if (!layoutDirty && !listener && rect.getTopLeft() == position && rect.getSize() == size && getLayoutOriginPosition() == layoutOrigin) {
+		return;
+	}
+	layoutDirty = false;
+	if (root) {
+		++root->widgetsLaidOut;
+	}
+
 	setWidgetRect(rect);
+	notifyMouseRectChanged();
+	layoutOrigin = getLayoutOriginPosition();
 	if (sizer) {
 		auto border = getInnerBorder();
-		auto p0 = getLayoutOriginPosition();
+		auto p0 = layoutOrigin;
 		sizer->setRect(Rect4f(p0 + Vector2f(border.x, border.y), p0 + rect.getSize() - Vector2f(border.z, border.w)), listener);
 	} else {
 		for (auto& c: getChildren()) {
@@ -222,6 +233,7 @@ void UIWidget::setSizer(std::optional<UISizer> sizer)
 	if (this->sizer) {
 		this->sizer->reparent(*this);
 	}
+	markAsNeedingLayout();
 }
 
 void UIWidget::add(std::shared_ptr<IUIElement> element, float proportion, Vector4f border, int fillFlags, Vector2f position, size_t insertPos)
@@ -366,7 +378,11 @@ void UIWidget::setPosition(Vector2f pos)
 {
 	Expects(pos.isValid());
 	
-	position = pos;
+	if (position != pos) {
+		position = pos;
+		markLayoutDirty();
+		notifyMouseRectChanged();
+	}
 	positionUpdated = true;
 }
 
@@ -434,6 +450,9 @@ void UIWidget::updateActive(bool wasActiveBefore)
 		}
 
 		markAsNeedingLayout();
+		if (root) {
+			root->invalidateHitTest();
+		}
 		notifyActivationChange(isActive());
 	}
 }
@@ -464,6 +483,9 @@ void UIWidget::setEnabled(bool e)
 		}
 
 		markAsNeedingLayout();
+		if (root) {
+			root->invalidateHitTest();
+		}
 		onEnabledChanged();
 	}
 }
@@ -583,6 +605,7 @@ void UIWidget::setMouseClip(std::optional<Rect4f> clip, bool force)
 {
 	if (force || clip != mouseClip) {
 		mouseClip = clip;
+		notifyMouseRectChanged();
 		for (auto& c: getChildren()) {
 			c->setMouseClip(clip, force);
 		}
@@ -642,6 +665,7 @@ void UIWidget::setParent(UIParent* p)
 void UIWidget::notifyTreeAddedToRoot(UIRoot& root)
 {
 	this->root = &root;
+	root.invalidateHitTest();
 	onAddedToRoot(root);
 	
 	for (auto& c: getChildren()) {
@@ -915,6 +939,7 @@ bool UIWidget::needsLayout() const
 void UIWidget::markAsNeedingLayout()
 {
 	layoutNeeded = 1;
+	layoutDirty = true;
 	if (parent) {
 		parent->markAsNeedingLayout();
 	}
@@ -923,6 +948,14 @@ void UIWidget::markAsNeedingLayout()
 	}
 }
 
+void UIWidget::markLayoutDirty()
+{
+	layoutDirty = true;
+	if (parent) {
+		parent->markLayoutDirty();
+	}
+}
+
 bool UIWidget::canReceiveFocus() const
 {
 	return false;
@@ -972,6 +1005,13 @@ void UIWidget::checkActive()
 {
 }
 
+void UIWidget::notifyMouseRectChanged()
+{
+	if (root) {
+		root->onWidgetMouseRectChanged(*this);
+	}
+}
+
 void UIWidget::setWidgetRect(Rect4f rect)
 {
 	if (position != rect.getTopLeft()) {
@@ -1130,7 +1170,12 @@ UIGamepadInput::Priority UIWidget::getInputPriority() const
 
 void UIWidget::setChildLayerAdjustment(int delta)
 {
-	childLayerAdjustment = delta;
+	if (childLayerAdjustment != delta) {
+		childLayerAdjustment = delta;
+		if (root) {
+			root->invalidateHitTest();
+		}
+	}
 }
 
 int UIWidget::getChildLayerAdjustment() const
@@ -187,6 +187,7 @@ void UIClickable::onMouseDoubleClicked(Vector2f mousePos, int button, KeyMods ke
 void UIClickable::setMouseExtraBorder(std::optional<Vector4f> override)
 {
 	mouseExtraBorder = override;
+	notifyMouseRectChanged();
 }
 
 void UIClickable::update(Time t, bool)
@@ -3,6 +3,7 @@
 #include "halley/core/input/input_keyboard.h"
 #include "widgets/ui_label.h"
 #include "widgets/ui_image.h"
+#include "widgets/ui_scroll_pane.h"
 #include "halley/support/logger.h"
 
 using namespace Halley;
@@ -21,7 +22,10 @@ UIList::UIList(String id, UIStyle style, UISizerType orientation, int nColumns)
 	setHandle(UIEventType::SetSelected, [=] (const UIEvent& event) {});
 	setHandle(UIEventType::SetHovered, [=] (const UIEvent& event) {
 		const auto hoveredChild = std::find_if(getChildren().begin(), getChildren().end(), [=](std::shared_ptr<UIWidget> child) { return child->getId() == event.getSourceId(); });
-		const auto childIdx = int(hoveredChild - getChildren().begin());
+		int childIdx = int(hoveredChild - getChildren().begin());
+		if (virtualised) {
+			childIdx = hoveredChild != getChildren().end() ? std::static_pointer_cast<UIListItem>(*hoveredChild)->getIndex() : -1;
+		}
 
 		if (event.getBoolData()) {
 			curHover = childIdx;
@@ -83,12 +87,24 @@ String UIList::getSelectedOptionId() const
 	if (curOption < 0 || curOption >= int(getNumberOfItems())) {
 		return "";
 	}
+	if (virtualised) {
+		return getVirtualItemId(curOption);
+	}
 	return getItem(curOption)->getId();
 }
 
 Vector<int> UIList::getSelectedOptions() const
 {
 	Vector<int> result;
+	if (virtualised) {
+		for (int i = 0; i < virtualCount; ++i) {
+			if (virtualSelected[i]) {
+				result.push_back(i);
+			}
+		}
+		return result;
+	}
+
 	for (const auto& item: items) {
 		if (item->isSelected()) {
 			result.push_back(item->getIndex());
@@ -100,6 +116,15 @@ Vector<int> UIList::getSelectedOptions() const
 Vector<String> UIList::getSelectedOptionIds() const
 {
 	Vector<String> result;
+	if (virtualised) {
+		for (int i = 0; i < virtualCount; ++i) {
+			if (virtualSelected[i]) {
+				result.push_back(getVirtualItemId(i));
+			}
+		}
+		return result;
+	}
+
 	for (const auto& item: items) {
 		if (item->isSelected()) {
 			result.push_back(item->getId());
@@ -156,7 +181,7 @@ Vector2f UIList::getDragPositionAdjustment(Vector2f pos, Vector2f startPos) cons
 
 void UIList::setItemText(int optionId, const String& text)
 {
-	if (optionId < 0 || optionId >= static_cast<int>(getNumberOfItems())) {
+	if (virtualised || optionId < 0 || optionId >= static_cast<int>(getNumberOfItems())) {
 		return;
 	}
 	const auto label = getItem(optionId)->getWidgetAs<UILabel>(getSelectedOptionId() + "_label");
@@ -228,6 +253,35 @@ void UIList::applyImageColour(UIImage& image) const
 	}
 }
 
+bool UIList::isOptionSelectable(int option) const
+{
+	if (virtualised) {
+		return option >= 0 && option < virtualCount;
+	}
+	const auto item = tryGetItem(option);
+	return item && item->isEnabled();
+}
+
+bool UIList::isOptionSelected(int option) const
+{
+	if (virtualised) {
+		return virtualSelected.at(option) != 0;
+	}
+	return tryGetItem(option)->isSelected();
+}
+
+void UIList::setOptionSelected(int option, bool selected)
+{
+	if (virtualised) {
+		virtualSelected.at(option) = selected ? 1 : 0;
+		if (const auto item = tryGetVirtualItem(option)) {
+			item->setSelected(selected);
+		}
+	} else {
+		tryGetItem(option)->setSelected(selected);
+	}
+}
+
 bool UIList::changeSelection(int oldItem, int newItem, SelectionMode mode)
 {
 	std::optional<int> newItemToFocus;
@@ -241,21 +295,19 @@ bool UIList::changeSelection(int oldItem, int newItem, SelectionMode mode)
 	}
 
 	if (mode == SelectionMode::Normal || mode == SelectionMode::AddToSelect) {
-		const auto curItem = tryGetItem(newItem);
-		if (curItem->isEnabled()) {
-			if (!curItem->isSelected()) {
+		if (isOptionSelectable(newItem)) {
+			if (!isOptionSelected(newItem)) {
 				changed = true;
 			}
-			curItem->setSelected(true);
+			setOptionSelected(newItem, true);
 			if (oldItem != newItem) {
 				newItemToFocus = newItem;
 			}
 		}
 	} else if (mode == SelectionMode::CtrlSelect) {
-		const auto curItem = tryGetItem(newItem);
-		if (curItem->isEnabled()) {
-			const bool wasSelected = curItem->isSelected();
-			curItem->setSelected(!wasSelected);
+		if (isOptionSelectable(newItem)) {
+			const bool wasSelected = isOptionSelected(newItem);
+			setOptionSelected(newItem, !wasSelected);
 			if (wasSelected) {
 				shouldFocusElsewhere = true;
 			} else {
@@ -267,9 +319,8 @@ bool UIList::changeSelection(int oldItem, int newItem, SelectionMode mode)
 		const int a = std::min(oldItem, newItem);
 		const int b = std::max(oldItem, newItem);
 		for (int i = a; i <= b; ++i) {
-			const auto curItem = tryGetItem(i);
-			if (curItem->isEnabled()) {
-				curItem->setSelected(true);
+			if (isOptionSelectable(i)) {
+				setOptionSelected(i, true);
 			}
 		}
 		changed = true;
@@ -278,11 +329,8 @@ bool UIList::changeSelection(int oldItem, int newItem, SelectionMode mode)
 	if (shouldFocusElsewhere) {
 		const auto& sels = getSelectedOptions();
 		const int fallback = sels.empty() ? newItem : sels.front();
-		if (sels.empty()) {
-			auto curItem = tryGetItem(fallback);
-			if (curItem && curItem->isEnabled()) {
-				curItem->setSelected(true);
-			}
+		if (sels.empty() && isOptionSelectable(fallback)) {
+			setOptionSelected(fallback, true);
 		}
 		if (curOption != fallback) {
 			newItemToFocus = fallback;
@@ -290,7 +338,6 @@ bool UIList::changeSelection(int oldItem, int newItem, SelectionMode mode)
 	}
 
 	if (newItemToFocus) {
-		const auto curItem = getItem(newItemToFocus.value());
 		curOption = newItemToFocus.value();
 		changed = true;
 	}
@@ -305,6 +352,16 @@ bool UIList::changeSelection(int oldItem, int newItem, SelectionMode mode)
 bool UIList::deselectAll(std::optional<int> exceptFor)
 {
 	bool changed = false;
+	if (virtualised) {
+		for (int i = 0; i < virtualCount; ++i) {
+			if (i != exceptFor && virtualSelected[i]) {
+				setOptionSelected(i, false);
+				changed = true;
+			}
+		}
+		return changed;
+	}
+
 	for (auto& item: items) {
 		if (item->getIndex() != exceptFor && item->isSelected()) {
 			item->setSelected(false);
@@ -349,6 +406,15 @@ void UIList::clear()
 	curOption = -1;
 	UIWidget::clear();
 
+	if (virtualised) {
+		virtualCount = 0;
+		virtualFirst = 0;
+		virtualSelected.clear();
+		virtualPool.clear();
+		virtualIndices.clear();
+		virtualIndicesDirty = true;
+	}
+
 	if (hadItems) {
 		layout();
 
@@ -435,6 +501,8 @@ void UIList::filterOptions(const String& filter)
 
 std::shared_ptr<UIListItem> UIList::addItem(std::shared_ptr<UIListItem> item, Vector4f border, int fillFlags)
 {
+	Expects(!virtualised);
+
 	add(item, uniformSizedItems ? 1.0f : 0.0f, border, fillFlags);
 	items.push_back(item);
 
@@ -497,6 +565,10 @@ void UIList::onCancel()
 
 void UIList::reassignIds()
 {
+	if (virtualised) {
+		return;
+	}
+
 	int newCurOption = curOption;
 
 	int i = 0;
@@ -521,6 +593,12 @@ std::shared_ptr<UIListItem> UIList::getItem(int n) const
 	if (n < 0) {
 		throw Exception("Invalid item", HalleyExceptions::UI);
 	}
+	if (virtualised) {
+		if (auto item = tryGetVirtualItem(n)) {
+			return item;
+		}
+		throw Exception("Item " + toString(n) + " is not in view", HalleyExceptions::UI);
+	}
 	int i = 0;
 	for (auto& item: items) {
 		if (item->isActive() && item->isEnabled()) {
@@ -544,6 +622,10 @@ std::shared_ptr<UIListItem> UIList::getItem(const String& id) const
 
 int UIList::tryGetItemId(const String& id) const
 {
+	if (virtualised) {
+		return findVirtualItem(id);
+	}
+
 	const auto iter = std::find_if(items.begin(), items.end(), [&] (const std::shared_ptr<UIListItem>& item)
 	{
 		return item->getId() == id;
@@ -557,6 +639,10 @@ int UIList::tryGetItemId(const String& id) const
 
 std::shared_ptr<UIListItem> UIList::tryGetItem(int n) const
 {
+	if (virtualised) {
+		return tryGetVirtualItem(n);
+	}
+
 	int i = 0;
 	for (auto& item: items) {
 		if (item->isActive() && item->isEnabled()) {
@@ -580,6 +666,10 @@ std::shared_ptr<UIListItem> UIList::tryGetItem(const String& id) const
 
 std::shared_ptr<UIListItem> UIList::getItemUnderCursor() const
 {
+	if (virtualised) {
+		return tryGetVirtualItem(itemUnderCursor);
+	}
+
 	if (itemUnderCursor >= 0 && itemUnderCursor < static_cast<int>(items.size())) {
 		return items[itemUnderCursor];
 	} else {
@@ -614,7 +704,7 @@ void UIList::setDragOutsideEnabled(bool dragOutside)
 
 bool UIList::canDragListItem(const UIListItem& listItem)
 {
-	return isDragEnabled();
+	return isDragEnabled() && !virtualised;
 }
 
 void UIList::setUniformSizedItems(bool enabled)
@@ -657,8 +747,112 @@ void UIList::setRequiresSelection(bool r)
 	requiresSelection = r;
 }
 
+void UIList::setVirtualItems(int count, VirtualItemCallback callback, float itemSize)
+{
+	virtualCallback = std::move(callback);
+	if (itemSize > 0) {
+		virtualItemSize = itemSize;
+	}
+	setVirtualItemCount(count);
+	selectFirstIfRequired();
+}
+
+void UIList::refreshVirtualItems()
+{
+	virtualItemsDirty = true;
+	virtualIndicesDirty = true;
+}
+
+bool UIList::isVirtual() const
+{
+	return virtualised;
+}
+
+std::shared_ptr<UIListItem> UIList::makeVirtualItem()
+{
+	const auto& style = styles.at(0);
+	auto item = std::make_shared<UIListItem>("", *this, style.getSubStyle("item"), 0, style.getBorder("extraMouseBorder"));
+	item->add(makeIcon("icon", Sprite()), 0, Vector4f(0, 0, 4, 0), UISizerAlignFlags::Centre);
+	item->add(makeLabel("label", LocalisedString()), 0, {}, UISizerFillFlags::Fill);
+	return item;
+}
+
+void UIList::bindVirtualItem(int index, UIListItem& item)
+{
+	auto data = virtualCallback(index);
+	item.setId(data.id);
+
+	const auto icon = item.getWidgetAs<UIImage>("icon");
+	icon->setActive(data.icon.hasMaterial());
+	icon->setSprite(std::move(data.icon));
+	item.getWidgetAs<UILabel>("label")->setText(std::move(data.label));
+}
+
+int UIList::findVirtualItem(const String& id) const
+{
+	if (virtualIndicesDirty) {
+		virtualIndices.clear();
+		for (int i = 0; i < virtualCount; ++i) {
+			auto itemId = getVirtualItemId(i);
+			if (virtualIndices.find(itemId) == virtualIndices.end()) {
+				virtualIndices[std::move(itemId)] = i;
+			}
+		}
+		virtualIndicesDirty = false;
+	}
+
+	const auto iter = virtualIndices.find(id);
+	return iter != virtualIndices.end() ? iter->second : -1;
+}
+
+String UIList::getVirtualItemId(int index) const
+{
+	return virtualCallback(index).id;
+}
+
+void UIList::setVirtualItemCount(int count)
+{
+	Expects(count >= 0);
+	Expects(orientation != UISizerType::Grid);
+	Expects(virtualised || items.empty());
+
+	virtualised = true;
+	virtualItemsDirty = true;
+	virtualIndicesDirty = true;
+	virtualCount = count;
+	virtualSelected.resize(count, 0);
+	if (curOption >= count) {
+		curOption = -1;
+	}
+	markAsNeedingLayout();
+}
+
+void UIList::setVirtualSelection(gsl::span<const int> selection, int current)
+{
+	std::fill(virtualSelected.begin(), virtualSelected.end(), uint8_t(0));
+	for (const auto i: selection) {
+		virtualSelected.at(i) = 1;
+	}
+	for (auto& item: items) {
+		const int idx = item->getIndex();
+		item->setSelected(idx < virtualCount && virtualSelected[idx] != 0);
+	}
+	curOption = current;
+}
+
+void UIList::selectFirstIfRequired()
+{
+	if (curOption < 0 && requiresSelection && getNumberOfItems() > 0) {
+		setSelectedOption(0);
+	}
+}
+
 size_t UIList::getNumberOfItems() const
 {
+	if (virtualised) {
+		return size_t(virtualCount);
+	}
+
 	size_t n = 0;
 	for (auto& item: items) {
 		if (item->isActive() && item->isEnabled()) {
@@ -718,7 +912,7 @@ void UIList::onGamepadInput(const UIInputResults& input, Time time)
 	Expects(nColumns >= 1);
 
 	// Drag
-	if (dragEnabled && input.isButtonHeld(UIGamepadInput::Button::Hold)) {
+	if (dragEnabled && !virtualised && input.isButtonHeld(UIGamepadInput::Button::Hold)) {
 		// Manual dragging
 		manualDragging = true;
 
@@ -837,6 +1031,8 @@ void UIList::moveSelection(int dx, int dy)
 
 void UIList::update(Time t, bool moved)
 {
+	updateVirtualItems();
+
 	if (moved) {
 		if (sprite.hasMaterial()) {
 			sprite.scaleTo(getSize()).setPos(getPosition());
@@ -851,6 +1047,162 @@ void UIList::update(Time t, bool moved)
 	}
 }
 
+void UIList::updateVirtualItems()
+{
+	if (!virtualised) {
+		return;
+	}
+
+	// All items are assumed to be the size of the first one
+	const int axis = getVirtualAxis();
+	if (virtualItemSize < 0 && virtualCount > 0) {
+		if (items.empty()) {
+			auto item = makeVirtualItem();
+			add(item, uniformSizedItems ? 1.0f : 0.0f);
+			items.push_back(std::move(item));
+			virtualFirst = 0;
+			virtualItemsDirty = true;
+		}
+		bindVirtualItemAt(virtualFirst, *items.front());
+		virtualItemSize = items.front()->getLayoutMinimumSize(false)[axis];
+	}
+
+	const auto [first, last] = getVirtualRange();
+	const int oldFirst = virtualFirst;
+	const int oldLast = virtualFirst + int(items.size());
+	if (first == oldFirst && last == oldLast && !virtualItemsDirty) {
+		return;
+	}
+
+	// Items that are still in range keep their widgets, the others are rebound to the items coming into view
+	Vector<std::shared_ptr<UIListItem>> spare;
+	Vector<std::shared_ptr<UIListItem>> newItems(size_t(last - first));
+	for (int i = oldFirst; i < oldLast; ++i) {
+		auto& item = items[i - oldFirst];
+		if (i >= first && i < last) {
+			newItems[i - first] = std::move(item);
+		} else {
+			spare.push_back(std::move(item));
+		}
+	}
+
+	for (int i = first; i < last; ++i) {
+		auto& item = newItems[i - first];
+		if (item && !virtualItemsDirty) {
+			continue;
+		}
+		if (!item && !spare.empty()) {
+			item = std::move(spare.back());
+			spare.pop_back();
+		} else if (!item) {
+			if (virtualPool.empty()) {
+				item = makeVirtualItem();
+			} else {
+				item = std::move(virtualPool.back());
+				virtualPool.pop_back();
+			}
+			add(item, uniformSizedItems ? 1.0f : 0.0f);
+		}
+		bindVirtualItemAt(i, *item);
+	}
+
+	// Widgets that aren't needed right now are kept aside, in case the view grows again
+	for (auto& item: spare) {
+		getSizer().remove(*item);
+		removeChild(*item);
+		virtualPool.push_back(std::move(item));
+	}
+	items = std::move(newItems);
+	virtualFirst = first;
+	virtualItemsDirty = false;
+
+	// Keep the sizer in item order, and pad the first and last items so the list spans every item
+	getSizer().sortItems([&] (const UISizerEntry& a, const UISizerEntry& b)
+	{
+		return std::static_pointer_cast<UIListItem>(a.getPointer())->getAbsoluteIndex() < std::static_pointer_cast<UIListItem>(b.getPointer())->getAbsoluteIndex();
+	});
+	const float stride = getVirtualStride();
+	for (size_t i = 0; i < getSizer().size(); ++i) {
+		Vector4f border;
+		if (i == 0) {
+			border[axis] = first * stride;
+		}
+		if (i + 1 == getSizer().size()) {
+			border[axis + 2] = (virtualCount - last) * stride;
+		}
+		getSizer()[i].setBorder(border);
+	}
+
+	// Place the new items straight away, this might be running after the layout pass for this frame
+	layout();
+}
+
+void UIList::bindVirtualItemAt(int index, UIListItem& item)
+{
+	// Deselect first, so whatever the new contents are get told if they're selected
+	item.setSelected(false);
+	item.setIndex(index);
+	item.setAbsoluteIndex(index);
+	bindVirtualItem(index, item);
+	item.setSelected(virtualSelected[index] != 0);
+}
+
+void UIList::refreshVirtualItem(int index)
+{
+	if (const auto item = tryGetVirtualItem(index)) {
+		bindVirtualItemAt(index, *item);
+	}
+}
+
+std::shared_ptr<UIListItem> UIList::tryGetVirtualItem(int index) const
+{
+	if (index >= virtualFirst && index < virtualFirst + int(items.size())) {
+		return items[index - virtualFirst];
+	}
+	return {};
+}
+
+std::pair<int, int> UIList::getVirtualRange() const
+{
+	if (virtualCount == 0) {
+		return { 0, 0 };
+	}
+
+	// There's always at least one item, so the sizer has something to pad out to the full size of the list
+	const int axis = getVirtualAxis();
+	const float stride = getVirtualStride();
+	const auto view = getVirtualViewport();
+	const float origin = getPosition()[axis] + getInnerBorder()[axis];
+	const int first = int(std::floor((view.getTopLeft()[axis] - origin) / stride)) - virtualItemMargin;
+	const int last = int(std::ceil((view.getBottomRight()[axis] - origin) / stride)) + virtualItemMargin;
+
+	const int clampedFirst = clamp(first, 0, virtualCount - 1);
+	return { clampedFirst, clamp(last, clampedFirst + 1, virtualCount) };
+}
+
+Rect4f UIList::getVirtualViewport() const
+{
+	// The list is only visible through its scroll pane, if it has one
+	auto* parent = getParent();
+	while (const auto* widget = dynamic_cast<const UIWidget*>(parent)) {
+		if (dynamic_cast<const UIScrollPane*>(widget)) {
+			return widget->getRect();
+		}
+		parent = widget->getParent();
+	}
+	return parent ? parent->getRect() : getRect();
+}
+
+float UIList::getVirtualStride() const
+{
+	return std::max(virtualItemSize + styles.at(0).getFloat("gap"), 1.0f);
+}
+
+int UIList::getVirtualAxis() const
+{
+	return orientation == UISizerType::Horizontal ? 0 : 1;
+}
+
 void UIList::onItemClicked(UIListItem& item, int button, KeyMods keyMods)
 {
 	if (button == 0 || !singleClickAccept) {
@@ -1185,6 +1537,7 @@ Rect4f UIListItem::getRawRect() const
 void UIListItem::setClickableInnerBorder(Vector4f ib)
 {
 	innerBorder = ib;
+	notifyMouseRectChanged();
 }
 
 Vector4f UIListItem::getClickableInnerBorder() const
@@ -1219,6 +1572,15 @@ void UIListItem::setDraggableSubWidget(UIWidget* widget)
 
 bool UIList::setSelectedOptionId(const String& id, SelectionMode mode)
 {
+	if (virtualised) {
+		const int idx = findVirtualItem(id);
+		if (idx >= 0) {
+			setSelectedOption(idx, mode);
+			return true;
+		}
+		return false;
+	}
+
 	for (auto& i: items) {
 		if (i->getId() == id) {
 			if (i->isActive()) {
@@ -1232,6 +1594,10 @@ bool UIList::setSelectedOptionId(const String& id, SelectionMode mode)
 
 bool UIList::isValidSelection(const String& id)
 {
+	if (virtualised) {
+		return findVirtualItem(id) >= 0;
+	}
+
 	for (auto& i: items) {
 		if (i->getId() == id) {
 			if (i->isActive()) {
@@ -1280,26 +1646,50 @@ bool UIList::setSelectedOptionIds(gsl::span<const String> ids, SelectionMode mod
 
 		auto sortedIds = Vector<String>(ids.begin(), ids.end());
 		std::sort(sortedIds.begin(), sortedIds.end());
-		for (auto& item: items) {
-			const bool inSet = std::binary_search(sortedIds.begin(), sortedIds.end(), item->getId());
-			const bool wasSelected = item->isSelected();
-			const bool shouldBeSelected = (mode == SelectionMode::Normal && inSet) || (mode == SelectionMode::AddToSelect && inSet) || (mode == SelectionMode::CtrlSelect && inSet && !wasSelected);
-			const bool shouldDeselect = (mode == SelectionMode::Normal && !shouldBeSelected) || (mode == SelectionMode::CtrlSelect && inSet && wasSelected);
-
-			if (item->isActive() && item->isEnabled() && shouldBeSelected) {
-				if (!wasSelected) {
-					item->setSelected(true);
+		if (virtualised) {
+			for (int i = 0; i < virtualCount; ++i) {
+				const auto id = getVirtualItemId(i);
+				const bool inSet = std::binary_search(sortedIds.begin(), sortedIds.end(), id);
+				const bool wasSelected = isOptionSelected(i);
+				const bool shouldBeSelected = inSet && (mode != SelectionMode::CtrlSelect || !wasSelected);
+				const bool shouldDeselect = (mode == SelectionMode::Normal && !inSet) || (mode == SelectionMode::CtrlSelect && inSet && wasSelected);
+
+				if (shouldBeSelected) {
+					if (!wasSelected) {
+						setOptionSelected(i, true);
+						modified = true;
+					}
+					if (id == ids[0] && curOption != i) {
+						curOption = i;
+						modified = true;
+					}
+				} else if (wasSelected && shouldDeselect) {
+					setOptionSelected(i, false);
 					modified = true;
 				}
-				if (item->getId() == ids[0]) {
-					if (curOption != item->getIndex()) {
-						curOption = item->getIndex();
+			}
+		} else {
+			for (auto& item: items) {
+				const bool inSet = std::binary_search(sortedIds.begin(), sortedIds.end(), item->getId());
+				const bool wasSelected = item->isSelected();
+				const bool shouldBeSelected = (mode == SelectionMode::Normal && inSet) || (mode == SelectionMode::AddToSelect && inSet) || (mode == SelectionMode::CtrlSelect && inSet && !wasSelected);
+				const bool shouldDeselect = (mode == SelectionMode::Normal && !shouldBeSelected) || (mode == SelectionMode::CtrlSelect && inSet && wasSelected);
+
+				if (item->isActive() && item->isEnabled() && shouldBeSelected) {
+					if (!wasSelected) {
+						item->setSelected(true);
 						modified = true;
 					}
+					if (item->getId() == ids[0]) {
+						if (curOption != item->getIndex()) {
+							curOption = item->getIndex();
+							modified = true;
+						}
+					}
+				} else if (item->isSelected() && shouldDeselect) {
+					item->setSelected(false);
+					modified = true;
 				}
-			} else if (item->isSelected() && shouldDeselect) {
-				item->setSelected(false);
-				modified = true;
 			}
 		}
 	}
@@ -1315,6 +1705,14 @@ Rect4f UIList::getOptionRect(int curOption) const
 {
 	if (getNumberOfItems() == 0) {
 		return Rect4f();
+	} else if (virtualised) {
+		const int axis = getVirtualAxis();
+		const auto border = getInnerBorder();
+		Vector2f pos = border.xy();
+		pos[axis] += clamp(curOption, 0, virtualCount - 1) * getVirtualStride();
+		Vector2f size = getSize() - border.xy() - border.zw();
+		size[axis] = std::max(virtualItemSize, 0.0f);
+		return Rect4f(pos, pos + size);
 	} else {
 		const auto item = getItem(clamp(curOption, 0, int(getNumberOfItems()) - 1));
 		return item->getRawRect() - getPosition();
@@ -57,6 +57,8 @@ Vector2f UIScrollPane::getRelativeScrollEndPosition() const
 
 void UIScrollPane::scrollTo(Vector2f position)
 {	
+	const auto prevOrigin = getLayoutOriginPosition();
+
 	if (scrollHorizontal) {
 		scrollPos.x = clamp2(position.x, 0.0f, contentsSize.x - getSize().x);
 	}
@@ -64,6 +66,10 @@ void UIScrollPane::scrollTo(Vector2f position)
 	if (scrollVertical) {
 		scrollPos.y = clamp2(position.y, 0.0f, contentsSize.y - getSize().y);
 	}
+
+	if (getLayoutOriginPosition() != prevOrigin) {
+		markLayoutDirty();
+	}
 }
 
 void UIScrollPane::scrollBy(Vector2f delta)
@@ -116,6 +122,7 @@ bool UIScrollPane::isScrollWheelEnabled() const
 
 void UIScrollPane::refresh(bool force)
 {
+	const auto prevOrigin = getLayoutOriginPosition();
 	if (!scrollHorizontal) {
 		clipSize.x = getSize().x;
 		scrollPos.x = 0;
@@ -128,6 +135,10 @@ void UIScrollPane::refresh(bool force)
 
 	setMouseClip(getRect(), force);
 	scrollTo(getScrollPosition());
+
+	if (getLayoutOriginPosition() != prevOrigin) {
+		markLayoutDirty();
+	}
 }
 
 void UIScrollPane::drawChildren(UIPainter& painter) const
@@ -11,6 +11,20 @@
 #include "widgets/ui_label.h"
 using namespace Halley;
 
+namespace {
+	// A recycled row of a virtual tree list
+	class UITreeListRow final : public UIListItem {
+	public:
+		using UIListItem::UIListItem;
+
+		std::shared_ptr<UITreeListControls> controls;
+		std::shared_ptr<UIWidget> content;
+		std::shared_ptr<UIImage> icon;
+		std::shared_ptr<UILabel> label;
+		String labelStyle;
+	};
+}
+
 
 UITreeList::UITreeList(String id, UIStyle style)
 	: UIList(std::move(id), std::move(style))
@@ -20,6 +34,15 @@ UITreeList::UITreeList(String id, UIStyle style)
 
 UITreeListItem& UITreeList::addTreeItem(const String& id, const String& parentId, size_t childIndex, const LocalisedString& label, const String& labelStyleName, Sprite icon, bool forceLeaf, bool expanded)
 {
+	if (isVirtual()) {
+		auto treeItem = std::make_unique<UITreeListItem>(id, label, labelStyleName, std::move(icon), forceLeaf, expanded);
+		auto& result = getItemOrRoot(parentId).addChild(std::move(treeItem), childIndex);
+		result.virtualTree = this;
+		itemsById[id] = &result;
+		needsRefresh = true;
+		return result;
+	}
+
 	const auto& style = styles.at(0);
 	auto listItem = std::make_shared<UIListItem>(id, *this, style.getSubStyle("item"), int(getNumberOfItems()), style.getBorder("extraMouseBorder"));
 
@@ -36,14 +59,7 @@ UITreeListItem& UITreeList::addTreeItem(const String& id, const String& parentId
 	}
 
 	// Label
-	const auto& labelStyle = style.getSubStyle(labelStyleName);
-	auto labelWidget = std::make_shared<UILabel>(id + "_label", labelStyle, labelStyle.getTextRenderer("normal"), label);
-	if (labelStyle.hasTextRenderer("selected")) {
-		labelWidget->setSelectable(labelStyle.getTextRenderer("normal"), labelStyle.getTextRenderer("selected"), true);
-	}
-	if (labelStyle.hasTextRenderer("disabled")) {
-		labelWidget->setDisablable(labelStyle.getTextRenderer("normal"), labelStyle.getTextRenderer("disabled"));
-	}
+	auto labelWidget = makeItemLabel(id + "_label", label, labelStyleName);
 	root->add(labelWidget, 0, style.getBorder("labelBorder"), UISizerFillFlags::Fill);
 
 	listItem->add(root, 1);
@@ -53,6 +69,7 @@ UITreeListItem& UITreeList::addTreeItem(const String& id, const String& parentId
 	auto treeItem = std::make_unique<UITreeListItem>(id, listItem, treeControls, labelWidget, iconWidget, forceLeaf, expanded);
 	auto& parentItem = getItemOrRoot(parentId);
 	auto& result = parentItem.addChild(std::move(treeItem), childIndex);
+	itemsById[id] = &result;
 
 	addItem(listItem, Vector4f(), UISizerAlignFlags::Left | UISizerFillFlags::FillVertical);
 	needsRefresh = true;
@@ -76,13 +93,17 @@ void UITreeList::removeItem(const String& id, bool immediate)
 
 void UITreeList::removeTree(const UITreeListItem& tree)
 {
-	getSizer().remove(*tree.getListItem());
-	removeChild(*tree.getListItem());
+	itemsById.erase(tree.getId());
 
-	items.erase(std::remove_if(items.begin(), items.end(), [&] (const std::shared_ptr<UIListItem>& i)
-	{
-		return i->getId() == tree.getId();
-	}), items.end());
+	if (const auto& listItem = tree.getListItem()) {
+		getSizer().remove(*listItem);
+		removeChild(*listItem);
+
+		items.erase(std::remove_if(items.begin(), items.end(), [&] (const std::shared_ptr<UIListItem>& i)
+		{
+			return i->getId() == tree.getId();
+		}), items.end());
+	}
 
 	for (auto& subTree: tree.getChildren()) {
 		removeTree(*subTree);
@@ -91,7 +112,7 @@ void UITreeList::removeTree(const UITreeListItem& tree)
 
 void UITreeList::setLabel(const String& id, const LocalisedString& label, Sprite icon)
 {
-	auto item = root.tryFindId(id);
+	auto item = tryGetTreeItem(id);
 	if (item) {
 		item->setLabel(label);
 		item->setIcon(std::move(icon));
@@ -100,7 +121,7 @@ void UITreeList::setLabel(const String& id, const LocalisedString& label, Sprite
 
 void UITreeList::setForceLeaf(const String& id, bool forceLeaf)
 {
-	auto item = root.tryFindId(id);
+	auto item = tryGetTreeItem(id);
 	if (item) {
 		item->setForceLeaf(forceLeaf);
 	}
@@ -108,6 +129,10 @@ void UITreeList::setForceLeaf(const String& id, bool forceLeaf)
 
 bool UITreeList::setSelectedOptionIds(gsl::span<const String> ids, SelectionMode mode)
 {
+	if (needsRefresh && isVirtual()) {
+		refresh();
+	}
+
 	for (const auto& id: ids) {
 		makeParentsOfItemExpanded(id);
 	}
@@ -117,31 +142,42 @@ bool UITreeList::setSelectedOptionIds(gsl::span<const String> ids, SelectionMode
 
 UITreeListItem* UITreeList::tryGetTreeItem(const String& id)
 {
-	return root.tryFindId(id);
+	const auto iter = itemsById.find(id);
+	return iter != itemsById.end() ? iter->second : nullptr;
 }
 
 void UITreeList::clear()
 {
 	UIList::clear();
 	root = UITreeListItem();
+	itemsById.clear();
+	virtualRows.clear();
+	virtualGuides.clear();
+	virtualRowIndices.clear();
 	needsRefresh = true;
 }
 
 void UITreeList::update(Time t, bool moved)
 {
-	UIList::update(t, moved);
 	if (needsRefresh) {
 		refresh();
 	}
+	UIList::update(t, moved);
 }
 
 void UITreeList::refresh()
 {
 	const auto sel = getSelectedOptionId();
 
-	root.updateTree(*this);
+	if (isVirtual()) {
+		refreshVirtualRows(sel);
+	} else {
+		root.updateTree(*this);
+		reassignIds();
+	}
 
-	reassignIds();
+	// Needs to be cleared before selecting, which might refresh again
+	needsRefresh = false;
 
 	const auto toSel = root.getLastExpandedItem(sel);
 	if (toSel) {
@@ -149,8 +185,121 @@ void UITreeList::refresh()
 	}
 
 	resetSelectionIfInvalid();
+	if (isVirtual()) {
+		selectFirstIfRequired();
+	}
+}
 
-	needsRefresh = false;
+void UITreeList::setVirtual()
+{
+	Expects(root.getChildren().empty());
+	setVirtualItemCount(0);
+}
+
+std::shared_ptr<UIListItem> UITreeList::makeVirtualItem()
+{
+	const auto& style = styles.at(0);
+	auto row = std::make_shared<UITreeListRow>("", *this, style.getSubStyle("item"), 0, style.getBorder("extraMouseBorder"));
+
+	row->controls = std::make_shared<UITreeListControls>("", style.getSubStyle("controls"));
+	row->add(row->controls, 0, {}, UISizerFillFlags::Fill);
+
+	row->content = std::make_shared<UIWidget>("root", Vector2f(), UISizer());
+	row->icon = std::make_shared<UIImage>(Sprite());
+	row->content->add(row->icon, 0, {}, UISizerAlignFlags::Centre);
+	row->add(row->content, 1);
+	row->setDraggableSubWidget(row->content.get());
+
+	return row;
+}
+
+void UITreeList::bindVirtualItem(int index, UIListItem& item)
+{
+	auto& row = static_cast<UITreeListRow&>(item);
+	const auto& virtualRow = virtualRows.at(index);
+	const auto& treeItem = *virtualRow.item;
+
+	row.setId(treeItem.id);
+	row.controls->setId(treeItem.id);
+	const auto guideStart = virtualGuides.begin() + virtualRow.guidesStart;
+	const float totalIndent = row.controls->updateGuides(Vector<int>(guideStart, guideStart + virtualRow.depth), !treeItem.children.empty(), treeItem.expanded);
+	row.controls->setExpanded(treeItem.expanded);
+	row.setClickableInnerBorder(Vector4f(totalIndent, 0, 0, 0));
+
+	row.icon->setActive(treeItem.iconSprite.hasMaterial());
+	row.icon->setSprite(treeItem.iconSprite);
+
+	if (!row.label || row.labelStyle != treeItem.labelStyle) {
+		if (row.label) {
+			row.content->getSizer().remove(*row.label);
+			row.content->removeChild(*row.label);
+		}
+		row.label = makeItemLabel("label", treeItem.labelText, treeItem.labelStyle);
+		row.labelStyle = treeItem.labelStyle;
+		row.content->add(row.label, 0, styles.at(0).getBorder("labelBorder"), UISizerFillFlags::Fill);
+	} else {
+		row.label->setText(treeItem.labelText);
+	}
+	row.label->setColour(treeItem.labelColour ? *treeItem.labelColour : styles.at(0).getSubStyle(treeItem.labelStyle).getTextRenderer("normal").getColour());
+}
+
+int UITreeList::findVirtualItem(const String& id) const
+{
+	const auto iter = virtualRowIndices.find(id);
+	return iter != virtualRowIndices.end() ? iter->second : -1;
+}
+
+String UITreeList::getVirtualItemId(int index) const
+{
+	return virtualRows.at(index).item->getId();
+}
+
+void UITreeList::refreshVirtualRows(const String& curId)
+{
+	const auto selectedIds = getSelectedOptionIds();
+
+	virtualRows.clear();
+	virtualGuides.clear();
+	virtualRowIndices.clear();
+	Vector<int> itemsLeftPerDepth;
+	collectVirtualRows(root, itemsLeftPerDepth);
+	setVirtualItemCount(static_cast<int>(virtualRows.size()));
+
+	// Rows have moved, so carry the selection over by id
+	Vector<int> selection;
+	for (const auto& id: selectedIds) {
+		const int idx = findVirtualItem(id);
+		if (idx >= 0) {
+			selection.push_back(idx);
+		}
+	}
+	setVirtualSelection(selection, findVirtualItem(curId));
+}
+
+void UITreeList::onVirtualItemChanged(const UITreeListItem& item)
+{
+	// Rows out of view will be bound with the change when they come into view, and a pending refresh rebinds everything
+	if (!needsRefresh) {
+		refreshVirtualItem(findVirtualItem(item.id));
+	}
+}
+
+void UITreeList::collectVirtualRows(UITreeListItem& item, Vector<int>& itemsLeftPerDepth)
+{
+	if (!item.id.isEmpty()) {
+		virtualRowIndices[item.id] = static_cast<int>(virtualRows.size());
+		virtualRows.push_back(VirtualRow{ &item, static_cast<uint32_t>(virtualGuides.size()), static_cast<uint32_t>(itemsLeftPerDepth.size()) });
+		virtualGuides.insert(virtualGuides.end(), itemsLeftPerDepth.begin(), itemsLeftPerDepth.end());
+	}
+
+	if (item.expanded) {
+		itemsLeftPerDepth.push_back(int(item.children.size()));
+		for (auto& c: item.children) {
+			collectVirtualRows(*c, itemsLeftPerDepth);
+			itemsLeftPerDepth.back()--;
+		}
+		itemsLeftPerDepth.pop_back();
+	}
 }
 
 void UITreeList::draw(UIPainter& painter) const
@@ -222,18 +371,31 @@ bool UITreeList::canDragItemId(const String& itemId) const
 
 UITreeListItem& UITreeList::getItemOrRoot(const String& id)
 {
-	const auto res = root.tryFindId(id);
+	const auto res = tryGetTreeItem(id);
 	if (res) {
 		return *res;
 	}
 	return root;
 }
 
+std::shared_ptr<UILabel> UITreeList::makeItemLabel(const String& id, const LocalisedString& label, const String& labelStyleName) const
+{
+	const auto& labelStyle = styles.at(0).getSubStyle(labelStyleName);
+	auto labelWidget = std::make_shared<UILabel>(id, labelStyle, labelStyle.getTextRenderer("normal"), label);
+	if (labelStyle.hasTextRenderer("selected")) {
+		labelWidget->setSelectable(labelStyle.getTextRenderer("normal"), labelStyle.getTextRenderer("selected"), true);
+	}
+	if (labelStyle.hasTextRenderer("disabled")) {
+		labelWidget->setDisablable(labelStyle.getTextRenderer("normal"), labelStyle.getTextRenderer("disabled"));
+	}
+	return labelWidget;
+}
+
 void UITreeList::setupEvents()
 {
 	setHandle(UIEventType::TreeCollapseHandle, [=] (const UIEvent& event)
 	{
-		auto elem = root.tryFindId(event.getStringData());
+		auto elem = tryGetTreeItem(event.getStringData());
 		if (elem) {
 			elem->setExpanded(false);
 		}
@@ -243,7 +405,7 @@ void UITreeList::setupEvents()
 
 	setHandle(UIEventType::TreeExpandHandle, [=](const UIEvent& event)
 	{
-		auto elem = root.tryFindId(event.getStringData());
+		auto elem = tryGetTreeItem(event.getStringData());
 		if (elem) {
 			elem->setExpanded(true);
 		}
@@ -310,6 +472,12 @@ void UITreeList::reparentItems(gsl::span<const String> itemIds, const String& ne
 
 void UITreeList::sortItems()
 {
+	// Virtual rows are always in tree order
+	if (isVirtual()) {
+		refresh();
+		return;
+	}
+
 	// Store previous curOption
 	setCanSendEvents(false);
 	const auto oldOption = getSelectedOptionId();
@@ -353,7 +521,7 @@ void UITreeList::setAllExpanded(bool expanded)
 
 bool UITreeList::canDragListItem(const UIListItem& listItem)
 {
-	return isDragEnabled() && (!singleRoot || listItem.getAbsoluteIndex() != 0) && canDragItemId(listItem.getId());
+	return isDragEnabled() && !isVirtual() && (!singleRoot || listItem.getAbsoluteIndex() != 0) && canDragItemId(listItem.getId());
 }
 
 void UITreeList::makeParentsOfItemExpanded(const String& id)
@@ -366,6 +534,10 @@ void UITreeList::makeParentsOfItemExpanded(const String& id)
 
 bool UITreeList::setSelectedOptionId(const String& id, SelectionMode mode)
 {
+	if (needsRefresh && isVirtual()) {
+		refresh();
+	}
+
 	makeParentsOfItemExpanded(id);
 	return UIList::setSelectedOptionId(id, mode);
 }
@@ -492,6 +664,16 @@ UITreeListItem::UITreeListItem(String id, std::shared_ptr<UIListItem> listItem,
 	}
 }
 
+UITreeListItem::UITreeListItem(String id, LocalisedString label, String labelStyle, Sprite icon, bool forceLeaf, bool expanded)
+	: id(std::move(id))
+	, labelText(std::move(label))
+	, labelStyle(std::move(labelStyle))
+	, iconSprite(std::move(icon))
+	, expanded(expanded)
+	, forceLeaf(forceLeaf)
+{
+}
+
 UITreeListItem* UITreeListItem::tryFindId(const String& id)
 {
 	if (id == this->id) {
@@ -555,6 +737,11 @@ void UITreeListItem::setLabel(const LocalisedString& text)
 {
 	if (label) {
 		label->setText(text);
+	} else {
+		labelText = text;
+		if (virtualTree) {
+			virtualTree->onVirtualItemChanged(*this);
+		}
 	}
 }
 
@@ -562,6 +749,11 @@ void UITreeListItem::setLabelColour(Colour4f colour)
 {
 	if (label) {
 		label->setColour(colour);
+	} else {
+		labelColour = colour;
+		if (virtualTree) {
+			virtualTree->onVirtualItemChanged(*this);
+		}
 	}
 }
 
@@ -570,27 +762,40 @@ Colour4f UITreeListItem::getLabelColour() const
 	if (label) {
 		return label->getColour();
 	}
-	return Colour4f();
+	return labelColour.value_or(Colour4f());
 }
 
 void UITreeListItem::setIcon(Sprite sprite)
 {
 	if (icon) {
 		icon->setSprite(std::move(sprite));
+	} else {
+		iconSprite = std::move(sprite);
+		if (virtualTree) {
+			virtualTree->onVirtualItemChanged(*this);
+		}
 	}
 }
 
 bool UITreeListItem::setExpanded(bool e)
 {
-	if (!children.empty() && treeControls) {
+	// The root is always expanded; in virtual trees, items don't have controls
+	if (!children.empty() && parent) {
 		const bool changed = e != expanded;
 		expanded = e;
-		treeControls->setExpanded(e);
+		if (treeControls) {
+			treeControls->setExpanded(e);
+		}
 		return changed;
 	}
 	return false;
 }
 
+bool UITreeListItem::isExpanded() const
+{
+	return expanded;
+}
+
 bool UITreeListItem::setAllExpanded(UITreeList& tree, bool expanded)
 {
 	bool changed = setExpanded(expanded);
@@ -821,8 +1026,8 @@ void UITreeListItem::enumerateIdsAndLabels(Vector<String>& ids, Vector<String>&
 {
 	if (!id.isEmpty()) {
 		ids.push_back(id);
-		names.push_back(label->getTextRenderer().getText());
-		icons.push_back(icon->getSprite());
+		names.push_back(label ? label->getTextRenderer().getText() : labelText.getString());
+		icons.push_back(icon ? icon->getSprite() : iconSprite);
 	}
 
 	for (const auto& c: children) {
@@ -832,7 +1037,12 @@ void UITreeListItem::enumerateIdsAndLabels(Vector<String>& ids, Vector<String>&
 
 void UITreeListItem::doUpdateTree(UITreeList& treeList, Vector<int>& itemsLeftPerDepth, bool treeExpanded)
 {
-	treeList.doSetItemActive(id, treeExpanded);
+	if (listItem) {
+		if (!treeExpanded) {
+			listItem->setSelected(false);
+		}
+		listItem->setActive(treeExpanded);
+	}
 
 	if (listItem && treeControls && treeExpanded) {
 		const float totalIndent = treeControls->updateGuides(itemsLeftPerDepth, !children.empty(), expanded);
@@ -70,15 +70,19 @@ namespace Halley {
 		Serializer(SerializerOptions options);
 		explicit Serializer(gsl::span<gsl::byte> dst, SerializerOptions options);
 
+		// Writes from the start of dst, growing it as needed. dst can end up larger than what was written (see getSize()),
+		// so its memory can be reused by serializing into it again.
+		explicit Serializer(Bytes& dst, SerializerOptions options);
+
 		template <typename T, typename std::enable_if<std::is_convertible<T, std::function<void(Serializer&)>>::value, int>::type = 0>
 		static Bytes toBytes(const T& f, SerializerOptions options = {})
 		{
-			auto dry = Serializer(options);
-			f(dry);
-			Bytes result(dry.getSize());
-			auto s = Serializer(gsl::as_writable_bytes(gsl::span<Halley::Byte>(result)), options);
+			// Single pass into a thread-local scratch buffer, which is then copied out at the exact size
+			ScratchBuffer scratch;
+			auto s = Serializer(scratch.getBytes(), options);
 			f(s);
-			return result;
+			const auto& bytes = scratch.getBytes();
+			return Bytes(bytes.begin(), bytes.begin() + s.getSize());
 		}
 
 		template <typename T, typename std::enable_if<!std::is_convertible<T, std::function<void(Serializer&)>>::value, int>::type = 0>
@@ -238,8 +242,23 @@ namespace Halley {
 		}
 
 	private:
+		class ScratchBuffer {
+		public:
+			ScratchBuffer();
+			~ScratchBuffer();
+
+			ScratchBuffer(const ScratchBuffer& other) = delete;
+			ScratchBuffer& operator=(const ScratchBuffer& other) = delete;
+
+			Bytes& getBytes() { return bytes; }
+
+		private:
+			Bytes& bytes;
+		};
+
 		size_t size = 0;
 		gsl::span<gsl::byte> dst;
+		Bytes* growableDst = nullptr;
 		bool dryRun;
 
 		template <typename T>
@@ -268,6 +287,7 @@ namespace Halley {
 
 		void serializeVariableInteger(uint64_t val, std::optional<bool> sign);
 		void copyBytes(const void* src, size_t size);
+		void grow(size_t minSize);
 	};
 
 	class Deserializer : public ByteSerializationBase {
@@ -512,6 +532,8 @@ namespace Halley {
 			pos = oldPos;
 		}
 
+		void skip(size_t bytes);
+
 		size_t getPosition() const { return pos; }
 		size_t getBytesLeft() const { return src.size() - pos; }
 
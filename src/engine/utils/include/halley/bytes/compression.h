@@ -14,5 +14,13 @@ namespace Halley {
 
 		static Bytes compressRaw(gsl::span<const gsl::byte> bytes, bool insertLength);
 		static Bytes decompressRaw(gsl::span<const gsl::byte> bytes, size_t maxSize, size_t expectedSize = 0);
+
+		// LZ4 block format, for data that needs to decompress fast rather than small. Same 8-byte length header as compress().
+		static Bytes lz4Compress(gsl::span<const gsl::byte> bytes);
+		static Bytes lz4Decompress(gsl::span<const gsl::byte> bytes, size_t maxSize = std::numeric_limits<size_t>::max());
+		static std::shared_ptr<const char> lz4DecompressToSharedPtr(gsl::span<const gsl::byte> bytes, size_t& outSize, size_t maxSize = std::numeric_limits<size_t>::max());
+
+		static Bytes lz4CompressRaw(gsl::span<const gsl::byte> bytes);
+		static void lz4DecompressRaw(gsl::span<const gsl::byte> bytes, gsl::span<gsl::byte> dst);
 	};
 }
@@ -1,5 +1,7 @@
 #pragma once
 #include <array>
+#include <algorithm>
+#include <exception>
 #include <functional>
 #include <halley/text/halleystring.h>
 #include "executor.h"
@@ -41,28 +43,117 @@ namespace Halley
 			return future.getFuture();
 		}
 
-		template <typename T, typename F>
-		void foreach(ExecutionQueue& e, T begin, T end, F f)
+		class ParallelForState
 		{
-			const size_t n = end - begin;
-			constexpr size_t maxThreads = 8;
-			size_t nThreads = std::max(size_t(1), std::min(maxThreads, e.threadCount()));
-			std::array<Future<void>, maxThreads> futures;
-
-			size_t prevEnd = 0;
-			for (size_t j = 0; j < nThreads; ++j) {
-				size_t curStart = prevEnd;
-				size_t curEnd = n * (j + 1) / nThreads;
-				prevEnd = curEnd;
-
-				futures[j] = execute([begin, f, curStart, curEnd]() {
-					for (auto i = begin + curStart; i < begin + curEnd; ++i) {
-						f(*i);
+		public:
+			explicit ParallelForState(size_t n)
+				: n(n)
+			{}
+
+			// Claims chunks of grainSize elements until none are left, calling f(start, end) on each
+			template <typename F>
+			void run(size_t grainSize, F&& f)
+			{
+				while (true) {
+					const size_t start = next.fetch_add(grainSize);
+					if (start >= n) {
+						return;
+					}
+					const size_t end = std::min(start + grainSize, n);
+
+					// After a failure, remaining chunks are still claimed, but skipped
+					if (!failed.load()) {
+						try {
+							f(start, end);
+						} catch (...) {
+							std::unique_lock<std::mutex> lock(mutex);
+							if (!exception) {
+								exception = std::current_exception();
+							}
+							failed.store(true);
+						}
+					}
+
+					if (done.fetch_add(end - start) + (end - start) == n) {
+						promise.set();
 					}
-				});
+				}
+			}
+
+			void wait()
+			{
+				promise.getFuture().wait();
+				if (exception) {
+					std::rethrow_exception(exception);
+				}
+			}
+
+		private:
+			const size_t n;
+			std::atomic<size_t> next = 0;
+			std::atomic<size_t> done = 0;
+			std::atomic<bool> failed = false;
+			std::exception_ptr exception;
+			std::mutex mutex;
+			Promise<void> promise;
+		};
+
+		// Calls f(start, end) on chunks of grainSize indices in [0, n), claimed dynamically by the workers of e and by the calling thread
+		// A grainSize of 0 picks one that gives each thread several chunks to balance uneven costs
+		template <typename F>
+		void parallelForChunks(ExecutionQueue& e, size_t n, F f, size_t grainSize = 0)
+		{
+			const size_t nThreads = e.threadCount();
+			if (grainSize == 0) {
+				grainSize = std::max(size_t(1), n / (std::max(nThreads, size_t(1)) * 8));
+			}
+			const size_t nChunks = (n + grainSize - 1) / grainSize;
+
+			if (nChunks <= 1 || nThreads == 0) {
+				if (n > 0) {
+					f(size_t(0), n);
+				}
+				return;
 			}
 
-			whenAll(futures.data(), futures.data() + nThreads).wait();
+			// Helpers only touch f after claiming a chunk, and we don't return until every chunk is done, so it's safe to reference it
+			auto state = std::make_shared<ParallelForState>(n);
+			auto run = [state, grainSize, fPtr = &f] ()
+			{
+				state->run(grainSize, *fPtr);
+			};
+
+			const size_t nHelpers = std::min(nThreads, nChunks - 1);
+			for (size_t i = 0; i < nHelpers; ++i) {
+				e.addToQueue(run);
+			}
+			run();
+			state->wait();
+		}
+
+		// Runs f on every element, with chunks of grainSize elements claimed dynamically by the workers of e and by the calling thread
+		// A grainSize of 0 picks one that gives each thread several chunks to balance uneven costs
+		template <typename T, typename F>
+		void parallelFor(ExecutionQueue& e, T begin, T end, F f, size_t grainSize = 0)
+		{
+			parallelForChunks(e, size_t(end - begin), [&] (size_t chunkStart, size_t chunkEnd)
+			{
+				for (auto i = begin + chunkStart; i < begin + chunkEnd; ++i) {
+					f(*i);
+				}
+			}, grainSize);
+		}
+
+		template <typename T, typename F>
+		void parallelFor(T begin, T end, F f, size_t grainSize = 0)
+		{
+			parallelFor(ExecutionQueue::getDefault(), begin, end, std::move(f), grainSize);
+		}
+
+		template <typename T, typename F>
+		void foreach(ExecutionQueue& e, T begin, T end, F f)
+		{
+			parallelFor(e, begin, end, std::move(f));
 		}
 
 		template <typename T, typename F>
@@ -5,6 +5,8 @@
 #include <condition_variable>
 #include <functional>
 #include <atomic>
+#include <array>
+#include <memory>
 #include "halley/data_structures/vector.h"
 #include "halley/text/halleystring.h"
 
@@ -15,27 +17,58 @@ namespace Halley
 	class ExecutionQueue
 	{
 	public:
-		ExecutionQueue();
+		// With workStealing enabled, tasks queued from one of this queue's own workers go to that worker's
+		// local deque (LIFO for the owner, FIFO for thieves); everything else goes to the shared FIFO queue.
+		explicit ExecutionQueue(bool workStealing = false);
+		~ExecutionQueue();
+
+		ExecutionQueue(const ExecutionQueue& other) = delete;
+		ExecutionQueue(ExecutionQueue&& other) = delete;
+		ExecutionQueue& operator=(const ExecutionQueue& other) = delete;
+		ExecutionQueue& operator=(ExecutionQueue&& other) = delete;
+
 		void addToQueue(TaskBase task);
 
 		TaskBase getNext();
 		Vector<TaskBase> getAll();
 
 		size_t threadCount() const;
-		void onAttached();
-		void onDetached();
+		int onAttached();
+		void onDetached(int workerIdx);
 		void abort();
 
+		bool isWorkStealing() const;
+		size_t getQueueDepth() const;
+		uint64_t getStealCount() const;
+
 		static ExecutionQueue& getDefault();
 
+		// If the calling thread is a worker of a work stealing queue, runs one pending task from it and returns true
+		static bool runOneOnCurrentWorker();
+
 	private:
+		class WorkerSlot;
+		static constexpr int maxWorkers = 64;
+
+		const bool workStealing;
+
 		std::deque<TaskBase> queue;
 		std::mutex mutex;
 		std::condition_variable condition;
 
+		std::array<std::unique_ptr<WorkerSlot>, maxWorkers> workers;
+		std::atomic<int> numWorkerSlots;
+
 		std::atomic<int> attachedCount;
+		std::atomic<int> sleepingCount;
+		std::atomic<int64_t> pendingCount;
+		std::atomic<uint64_t> stealCount;
 		std::atomic<bool> hasTasks;
 		std::atomic<bool> aborted;
+
+		bool tryGetNext(TaskBase& task, int workerIdx);
+		bool tryPopShared(TaskBase& task);
+		bool trySteal(TaskBase& task, int workerIdx);
 	};
 
 	class Executors
@@ -56,8 +89,8 @@ namespace Halley
 	private:
 		static Executors* instance;
 
-		ExecutionQueue cpu;
-		ExecutionQueue cpuAux;
+		ExecutionQueue cpu { true };
+		ExecutionQueue cpuAux { true };
 		ExecutionQueue videoAux;
 		ExecutionQueue mainUpdateThread;
 		ExecutionQueue mainRenderThread;
@@ -77,6 +110,7 @@ namespace Halley
 	private:
 		ExecutionQueue& queue;
 		std::atomic<bool> running;
+		int workerIdx = -1;
 	};
 
 	class SingleThreadExecutor {
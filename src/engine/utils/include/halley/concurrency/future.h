@@ -103,6 +103,9 @@ namespace Halley
 
 		void wait()
 		{
+			// Worker threads of a work stealing queue help run tasks while they wait, instead of idling
+			while (!available && ExecutionQueue::runOneOnCurrentWorker()) {}
+
 			if (!available) {
 				std::unique_lock<std::mutex> lock(mutex);
 				while (!available) {
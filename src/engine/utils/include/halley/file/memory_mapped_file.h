@@ -0,0 +1,48 @@
+#pragma once
+
+#include <memory>
+#include <gsl/span>
+#include "halley/resources/resource_data.h"
+
+namespace Halley
+{
+	class Path;
+	class MemoryMappedFilePimpl;
+
+	// Read-only mapping of a whole file into the address space. Pages are loaded on demand by the OS, and can be read from any thread without locking.
+	class MemoryMappedFile
+	{
+	public:
+		explicit MemoryMappedFile(const Path& path);
+		~MemoryMappedFile();
+
+		MemoryMappedFile(const MemoryMappedFile& other) = delete;
+		MemoryMappedFile& operator=(const MemoryMappedFile& other) = delete;
+
+		bool isValid() const;
+		gsl::span<const gsl::byte> getSpan() const;
+
+	private:
+		std::unique_ptr<MemoryMappedFilePimpl> pimpl;
+	};
+
+	class MemoryMappedDataReader final : public ResourceDataReader
+	{
+	public:
+		explicit MemoryMappedDataReader(std::shared_ptr<MemoryMappedFile> file);
+
+		// Returns null if the file doesn't exist or can't be mapped on this platform
+		static std::unique_ptr<MemoryMappedDataReader> tryOpen(const Path& path);
+
+		size_t size() const override;
+		int read(gsl::span<gsl::byte> dst) override;
+		void seek(int64_t pos, int whence) override;
+		size_t tell() const override;
+		void close() override;
+		std::shared_ptr<const char> getMappedData() const override;
+
+	private:
+		std::shared_ptr<MemoryMappedFile> file;
+		size_t pos = 0;
+	};
+}
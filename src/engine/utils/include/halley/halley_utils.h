@@ -29,6 +29,7 @@ namespace Halley {} // Get GitHub to realise this is C++ :3
 #include "data_structures/vector.h"
 
 #include "file/directory_monitor.h"
+#include "file/memory_mapped_file.h"
 #include "file/path.h"
 
 #include "file_formats/binary_file.h"
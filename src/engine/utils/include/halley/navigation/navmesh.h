@@ -73,6 +73,40 @@ namespace Halley {
 			void deserialize(Deserializer& s);
 		};
 
+		// Scratch memory for pathfinding, reused between queries so they don't allocate
+		// Node state is stamped with the query that wrote it, rather than being reset for every node at the start of each query
+		class QueryContext {
+		public:
+			// A context for the calling thread, used by the overloads that don't take one
+			static QueryContext& getThreadLocal();
+
+		private:
+			friend class Navmesh;
+
+			struct State {
+				float gScore;
+				float fScore;
+				NodeAndConn cameFrom;
+				uint32_t generation = 0;
+				bool inClosedSet;
+			};
+
+			struct OpenNode {
+				float fScore;
+				NodeId node;
+			};
+
+			Vector<State> state;
+			Vector<OpenNode> openSet;
+			Vector<NodeAndConn> nodePath;
+			Vector<NodeId> nodeIds;
+			Vector<float> pathCosts;
+			uint32_t generation = 0;
+
+			void begin(size_t nNodes);
+			State& getState(NodeId id);
+		};
+
 		struct Portal {
 			int id;
 			Vector2f pos;
@@ -107,7 +141,9 @@ namespace Halley {
 		void deserialize(Deserializer& s);
 
 		[[nodiscard]] std::optional<Vector<NodeAndConn>> pathfindNodes(const NavigationQuery& query) const;
+		[[nodiscard]] std::optional<Vector<NodeAndConn>> pathfindNodes(const NavigationQuery& query, QueryContext& context) const;
 		[[nodiscard]] std::optional<NavigationPath> pathfind(const NavigationQuery& query) const;
+		[[nodiscard]] std::optional<NavigationPath> pathfind(const NavigationQuery& query, QueryContext& context) const;
 
 		[[nodiscard]] const Vector<Node>& getNodes() const { return nodes; }
 		[[nodiscard]] const Vector<Polygon>& getPolygons() const { return polygons; }
@@ -138,27 +174,6 @@ namespace Halley {
 		Base2D getNormalisedCoordinatesBase() const { return normalisedCoordinatesBase; }
 
 	private:
-		struct State {
-			float gScore = std::numeric_limits<float>::infinity();
-			float fScore = std::numeric_limits<float>::infinity();
-			NodeAndConn cameFrom;
-			bool inOpenSet = false;
-			bool inClosedSet = false;
-		};
-
-		class NodeComparator {
-		public:
-			NodeComparator(const Vector<State>& state) : state(state) {}
-			
-			bool operator()(Navmesh::NodeId a, Navmesh::NodeId b) const
-			{
-				return state[a].fScore > state[b].fScore;
-			}
-
-		private:
-			const Vector<State>& state;
-		};
-
 		Vector<Node> nodes;
 		Vector<Polygon> polygons;
 		Vector<Portal> portals;
@@ -178,10 +193,11 @@ namespace Halley {
 
 		float totalArea = 0;
 
-		std::optional<Vector<NodeAndConn>> pathfind(int fromId, int toId) const;
-		Vector<NodeAndConn> makeResult(const Vector<State>& state, int startId, int endId) const;
-		std::optional<NavigationPath> makePath(const NavigationQuery& query, const Vector<NodeAndConn>& nodePath) const;
-		void postProcessPath(Vector<Vector2f>& points, NavigationQuery::PostProcessingType type) const;
+		bool pathfindNodes(const NavigationQuery& query, QueryContext& context, Vector<NodeAndConn>& result) const;
+		bool pathfind(int fromId, int toId, QueryContext& context, Vector<NodeAndConn>& result) const;
+		void makeResult(QueryContext& context, int startId, int endId, Vector<NodeAndConn>& result) const;
+		std::optional<NavigationPath> makePath(const NavigationQuery& query, const Vector<NodeAndConn>& nodePath, QueryContext& context) const;
+		void postProcessPath(Vector<Vector2f>& points, NavigationQuery::PostProcessingType type, QueryContext& context) const;
 
 		void processPolygons();
 		void addPolygonsToGrid();
@@ -3,8 +3,11 @@
 #include "navmesh.h"
 #include "navigation_query.h"
 #include "navigation_path.h"
+#include <mutex>
 
 namespace Halley {
+	class ExecutionQueue;
+
 	class NavmeshSet : public Resource {
 	public:
 		NavmeshSet();
@@ -31,6 +34,11 @@ namespace Halley {
 		void reportUnlinkedPortals(std::function<String(Vector2i)> getChunkName) const;
 
 		std::optional<NavigationPath> pathfind(const NavigationQuery& query) const;
+
+		// Runs the queries on the threads of the queue (the CPU queue by default), returning their results in the same order
+		Vector<std::optional<NavigationPath>> pathfindBatch(gsl::span<const NavigationQuery> queries) const;
+		Vector<std::optional<NavigationPath>> pathfindBatch(gsl::span<const NavigationQuery> queries, ExecutionQueue& queue) const;
+
 		std::optional<NavigationPath> pathfindInRegion(const NavigationQuery& query, uint16_t regionId) const;
 		std::optional<NavigationPath> pathfindBetweenRegions(const NavigationQuery& queryStart, const NavigationQuery& queryEnd, uint16_t startRegionId, uint16_t endRegionId, const Navmesh::Portal& portal, NavigationQuery::PostProcessingType postProcessing) const;
 
@@ -40,6 +48,10 @@ namespace Halley {
 
 		std::pair<uint16_t, uint16_t> getPortalDestination(uint16_t region, uint16_t edge) const;
 
+		// Memory allowed for the routes cached into busy regions, in bytes
+		void setRouteCacheMaxSize(size_t bytes);
+		size_t getRouteCacheSize() const;
+
 	private:
 		struct PortalConnection {
 			uint16_t portalId;
@@ -57,6 +69,7 @@ namespace Halley {
 		struct PortalNode {
 			Vector2f pos;
 			Vector<PortalConnection> connections;
+			Vector<PortalConnection> incomingConnections;
 			uint16_t fromRegion;
 			uint16_t fromPortal;
 			uint16_t toRegion;
@@ -96,13 +109,66 @@ namespace Halley {
 			const Vector<State>& state;
 		};
 
+		// Shortest routes through the portal graph into one region, from every portal node
+		struct RegionRoutes {
+			struct Entrance {
+				NodeId portalId;
+				Vector<float> distance;
+				Vector<NodeId> next;
+			};
+
+			Vector<Entrance> entrances;
+
+			size_t getSize() const;
+		};
+
+		// Routes into the regions that queries head to often, dropping the least recently used ones once over the size limit
+		// Everything is dropped whenever the portal graph changes. Copies start out empty, so that sets can be copied and moved around as before
+		class RouteCache {
+		public:
+			constexpr static size_t defaultMaxSize = 16 * 1024 * 1024;
+			constexpr static uint16_t missesToBuild = 16;
+
+			RouteCache() = default;
+			RouteCache(const RouteCache& other);
+			RouteCache& operator=(const RouteCache& other);
+
+			// Returns null on a miss, setting build once the region has been asked for often enough to be worth building
+			std::shared_ptr<const RegionRoutes> get(NodeId regionId, bool& build);
+			void set(NodeId regionId, std::shared_ptr<const RegionRoutes> routes);
+			void clear();
+
+			void setMaxSize(size_t bytes);
+			size_t getSize() const;
+
+		private:
+			struct Entry {
+				std::shared_ptr<const RegionRoutes> routes;
+				uint64_t lastUsed = 0;
+				uint16_t misses = 0;
+				bool tooLarge = false;
+			};
+
+			mutable std::mutex mutex;
+			Vector<Entry> regions;
+			size_t size = 0;
+			size_t maxSize = defaultMaxSize;
+			uint64_t nUses = 0;
+
+			void evict(size_t maxRemaining);
+		};
+
 		Vector<Navmesh> navmeshes;
 		Vector<PortalNode> portalNodes;
 		Vector<RegionNode> regionNodes;
+		mutable RouteCache routeCache;
 
 		void tryLinkNavMeshes(uint16_t idxA, uint16_t idxB);
 
 		Vector<NavigationPath::RegionNode> findRegionPath(Vector2f startPos, Vector2f endPos, uint16_t fromRegionId, uint16_t toRegionId) const;
+		Vector<NavigationPath::RegionNode> findRegionPath(Vector2f startPos, Vector2f endPos, uint16_t fromRegionId, const RegionRoutes& routes) const;
+		Vector<NavigationPath::RegionNode> searchRegionPath(Vector2f startPos, Vector2f endPos, uint16_t fromRegionId, uint16_t toRegionId) const;
+		std::shared_ptr<const RegionRoutes> makeRoutesTo(NodeId regionId) const;
 
 		Vector<Vector2f> postProcessPathBetweenRegions(
 			const NavigationQuery& queryStart, const NavigationQuery& queryEnd, 
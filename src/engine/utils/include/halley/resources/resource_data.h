@@ -41,6 +41,9 @@ namespace Halley {
 		virtual size_t tell() const = 0;
 		virtual void close() = 0;
 
+		// If the whole data is directly addressable in memory (e.g. a memory-mapped file), returns a pointer to its start that keeps it alive
+		virtual std::shared_ptr<const char> getMappedData() const { return {}; }
+
 		Bytes readAll();
 	};
 
@@ -59,6 +62,7 @@ namespace Halley {
 	public:
 		ResourceDataStatic(String path);
 		ResourceDataStatic(const void* data, size_t size, String path, bool owning = true);
+		ResourceDataStatic(std::shared_ptr<const char> data, size_t size, String path);
 
 		void set(const void* data, size_t size, bool owning = true);
 		bool isLoaded() const;
@@ -68,6 +72,10 @@ namespace Halley {
 		size_t getSize() const;
 		String getString() const;
 		void inflate();
+		void decompressLZ4();
+
+		// Undoes the "asset_compression" set on the asset's metadata, if any
+		void decompress(const Metadata* metadata);
 
 		static std::unique_ptr<ResourceDataStatic> loadFromFileSystem(Path path);
 		void writeToFileSystem(String path) const;
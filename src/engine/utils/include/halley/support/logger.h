@@ -3,6 +3,8 @@
 #include <exception>
 #include <set>
 #include <mutex>
+#include <memory>
+#include <atomic>
 
 namespace Halley
 {
@@ -21,6 +23,9 @@ namespace Halley
 	public:
 		virtual ~ILoggerSink() {}
 		virtual void log(LoggerLevel level, const String& msg) = 0;
+
+		// Called after each batch of messages
+		virtual void flush() {}
 	};
 
 	class StdOutSink final : public ILoggerSink {
@@ -28,6 +33,7 @@ namespace Halley
 		explicit StdOutSink(bool devMode);
 		~StdOutSink();
 		void log(LoggerLevel level, const String& msg) override;
+		void flush() override;
 
 	private:
 		std::mutex mutex;
@@ -37,6 +43,9 @@ namespace Halley
 	class Logger
 	{
 	public:
+		explicit Logger(size_t maxQueuedMessages = 4096);
+		~Logger();
+
 		static void setInstance(Logger& logger);
 
 		static void addSink(ILoggerSink& sink);
@@ -50,9 +59,26 @@ namespace Halley
 		static void logError(const String& msg);
 		static void logException(const std::exception& e);
 
+		// When async, messages are queued and written to the sinks in batches by a background thread
+		// If the queue is full, info and dev messages are dropped, while warnings and errors are written straight away
+		// Sinks can log from inside log(), in which case the message is written to the sinks there and then
+		static void setAsync(bool async);
+		static bool isAsync();
+		static void flush();
+		static size_t getNumDroppedMessages();
+
 	private:
+		class AsyncWriter;
+
 		static Logger* instance;
 
 		std::set<ILoggerSink*> sinks;
+		std::mutex sinksMutex;
+
+		const size_t maxQueuedMessages;
+		std::unique_ptr<AsyncWriter> asyncWriter;
+		std::atomic<bool> async;
+
+		void logNow(LoggerLevel level, const String& msg);
 	};
 }
@@ -4,8 +4,12 @@
 #include <thread>
 #include <gsl/span>
 #include <atomic>
+#include <array>
+#include <memory>
+#include <mutex>
 
 #include "halley/data_structures/hash_map.h"
+#include "halley/text/enum_names.h"
 #include "halley/time/halleytime.h"
 
 namespace Halley {
@@ -33,6 +37,9 @@ namespace Halley {
 		WorldSystemRender,
 
 		AudioGenerateBuffer,
+		AudioMixVoices,
+		AudioMixVoiceGroup,
+		AudioPostProcess,
 
 		DiskIO,
 
@@ -41,6 +48,80 @@ namespace Halley {
 		Game
     };	
 
+	enum class ProfilerCounterType {
+		AudioUnderruns,
+		AudioVoicesMixed,
+		AudioVoiceGroups,
+		ResourceHits,
+		ResourceMisses,
+		ResourceStalls,
+		UIWidgetsLaidOut,
+
+		NumberOfCounters
+	};
+
+	template <>
+	struct EnumNames<ProfilerEventType> {
+		constexpr std::array<const char*, 26> operator()() const {
+			return{{
+				"corePumpEvents",
+				"coreDevConClient",
+				"corePumpAudio",
+				"coreFixedUpdate",
+				"coreVariableUpdate",
+				"coreUpdateSystem",
+				"coreUpdatePlatform",
+				"coreUpdate",
+				"coreStartRender",
+				"coreRender",
+				"coreVSync",
+				"painterDrawCall",
+				"painterEndRender",
+				"painterUpdateProjection",
+				"worldVariableUpdate",
+				"worldFixedUpdate",
+				"worldRender",
+				"worldSystemUpdate",
+				"worldSystemRender",
+				"audioGenerateBuffer",
+				"audioMixVoices",
+				"audioMixVoiceGroup",
+				"audioPostProcess",
+				"diskIO",
+				"statsView",
+				"game"
+			}};
+		}
+	};
+
+	template <>
+	struct EnumNames<ProfilerCounterType> {
+		constexpr std::array<const char*, 7> operator()() const {
+			return{{
+				"audioUnderruns",
+				"audioVoicesMixed",
+				"audioVoiceGroups",
+				"resourceHits",
+				"resourceMisses",
+				"resourceStalls",
+				"uiWidgetsLaidOut"
+			}};
+		}
+	};
+
+	// An event name, interned so that events can refer to it for as long as the program runs
+	// Interning takes a lock (and allocates the first time a name is seen), so names used every frame should be made once and kept
+	class ProfilerName {
+	public:
+		ProfilerName() = default;
+		explicit ProfilerName(std::string_view name);
+
+		std::string_view getString() const { return name; }
+
+	private:
+		std::string_view name;
+	};
+
     class ProfilerData {
     public:
         using TimePoint = std::chrono::steady_clock::time_point;
@@ -48,11 +129,10 @@ namespace Halley {
     	
 		class Event {
         public:
-	        String name;
+	        std::string_view name;
         	std::thread::id threadId;
 			ProfilerEventType type;
 			int depth;
-        	uint64_t id;
         	TimePoint startTime;
         	TimePoint endTime;
         };
@@ -69,38 +149,56 @@ namespace Halley {
     		bool operator< (const ThreadInfo& other) const;
     	};
 
+    	using Counters = std::array<int64_t, static_cast<size_t>(ProfilerCounterType::NumberOfCounters)>;
+
+    	using ThreadNames = Vector<std::pair<std::thread::id, String>>;
+
     	ProfilerData() = default;
-    	ProfilerData(TimePoint frameStartTime, TimePoint frameEndTime, Vector<Event> events);
+    	ProfilerData(TimePoint frameStartTime, TimePoint frameEndTime, Vector<Event> events, Counters counters = {}, ThreadNames threadNames = {});
 
     	TimePoint getStartTime() const;
     	TimePoint getEndTime() const;
     	const Vector<Event>& getEvents() const;
     	Duration getTotalElapsedTime() const;
 		Duration getElapsedTime(ProfilerEventType eventType) const;
+		int64_t getCounter(ProfilerCounterType type) const;
 
     	gsl::span<const ThreadInfo> getThreads() const;
 
+    	// Chrome's trace event format, as loaded by chrome://tracing, Perfetto and Speedscope, with times relative to the start of the capture
+    	String toChromeTrace() const;
+
     private:
     	TimePoint frameStartTime;
     	TimePoint frameEndTime;
     	Vector<Event> events;
+    	Counters counters = {};
 
     	Vector<ThreadInfo> threads;
 
-    	void processEvents();
+    	void processEvents(const ThreadNames& threadNames);
     };
 	
+	// Each thread records into a ring buffer of its own, which only that thread writes to, so recording takes no locks and doesn't allocate
+	// The buffers are read at the end of each frame, pairing up the start and end of each event
     class ProfilerCapture {
     public:
         using EventId = uint64_t;
     	
-        ProfilerCapture(size_t maxEvents = 16384);
+        ProfilerCapture(size_t maxEventsPerThread = 16384, size_t maxSessionEvents = 1024 * 1024);
+        ~ProfilerCapture();
     	
     	[[nodiscard]] static ProfilerCapture& get();
 
-    	[[nodiscard]] EventId recordEventStart(ProfilerEventType type, std::string_view name);
+    	// Names the calling thread in captures. Call it before the thread records any events.
+    	static void setThreadName(String name);
+
+    	[[nodiscard]] EventId recordEventStart(ProfilerEventType type, ProfilerName name);
     	void recordEventEnd(EventId id);
 
+    	// Counters are always accumulated (not just while recording), and each capture holds what was added during its frame
+    	void addCounter(ProfilerCounterType type, int64_t value);
+
     	[[nodiscard]] bool isRecording() const;
 
     	void startFrame(bool record);
@@ -109,6 +207,15 @@ namespace Halley {
 
     	Time getFrameTime() const;
 
+    	// Records every frame, whether or not startFrame asks for it, into one capture covering the whole session
+    	// The session keeps its first maxSessionEvents events, and counts any after that as dropped
+    	void startContinuousCapture();
+    	[[nodiscard]] bool isCapturingContinuously() const;
+    	ProfilerData stopContinuousCapture();
+
+    	// Events that didn't fit in their thread's buffer or in the session since the capture was created
+    	[[nodiscard]] size_t getNumDroppedEvents() const;
+
     private:
     	enum class State {
     		Idle,
@@ -116,21 +223,43 @@ namespace Halley {
     		FrameEnded
     	};
 
+    	class ThreadBuffer;
+
+    	const uint64_t captureId;
+    	const size_t maxEventsPerThread;
+    	const size_t maxSessionEvents;
+
     	std::atomic<bool> recording;
-    	std::atomic<uint64_t> curId;
-    	uint64_t startId;
-    	std::atomic<uint64_t> endId;
         State state = State::Idle;
     	
     	std::chrono::steady_clock::time_point frameStartTime;
     	std::chrono::steady_clock::time_point frameEndTime;
 
-    	Vector<ProfilerData::Event> events;
+    	mutable std::mutex threadBuffersMutex;
+    	Vector<std::shared_ptr<ThreadBuffer>> threadBuffers;
+    	ProfilerData::ThreadNames threadNames;
+    	size_t droppedEventsFromExitedThreads = 0;
+
+    	Vector<ProfilerData::Event> frameEvents;
+
+    	bool capturingContinuously = false;
+    	std::chrono::steady_clock::time_point sessionStartTime;
+    	Vector<ProfilerData::Event> sessionEvents;
+    	std::atomic<size_t> droppedSessionEvents = 0;
+    	ProfilerData::Counters sessionCounters = {};
+
+    	std::array<std::atomic<int64_t>, static_cast<size_t>(ProfilerCounterType::NumberOfCounters)> counters;
+    	ProfilerData::Counters frameCounters = {};
+
+    	ThreadBuffer& getThreadBuffer();
+    	void readThreadBuffers();
+    	ProfilerData::ThreadNames getThreadNames() const;
     };
 
 	class ProfilerEvent {
 	public:
 		ProfilerEvent(ProfilerEventType type, std::string_view name = "");
+		ProfilerEvent(ProfilerEventType type, ProfilerName name);
 		~ProfilerEvent() noexcept;
 
 		ProfilerEvent(const ProfilerEvent& other) = delete;
@@ -139,6 +268,6 @@ namespace Halley {
 		ProfilerEvent& operator=(ProfilerEvent&& other) = delete;
 
 	private:
-		ProfilerCapture::EventId id;
+		ProfilerCapture::EventId id = 0;
 	};
 }
@@ -24,6 +24,46 @@ Serializer::Serializer(gsl::span<gsl::byte> dst, SerializerOptions options)
 	, dryRun(false)
 {}
 
+Serializer::Serializer(Bytes& dst, SerializerOptions options)
+	: ByteSerializationBase(std::move(options))
+	, dst(gsl::as_writable_bytes(gsl::span<Byte>(dst)))
+	, growableDst(&dst)
+	, dryRun(false)
+{}
+
+namespace {
+	// One buffer per nesting level, as serializing something can involve calling toBytes on its parts
+	thread_local Vector<std::unique_ptr<Bytes>> scratchBuffers;
+	thread_local size_t scratchDepth = 0;
+
+	constexpr size_t maxRetainedScratchSize = 4 * 1024 * 1024;
+
+	Bytes& acquireScratchBuffer()
+	{
+		if (scratchDepth == scratchBuffers.size()) {
+			scratchBuffers.push_back(std::make_unique<Bytes>());
+		}
+		return *scratchBuffers[scratchDepth++];
+	}
+
+	void releaseScratchBuffer(Bytes& bytes)
+	{
+		--scratchDepth;
+		if (bytes.size() > maxRetainedScratchSize) {
+			Bytes().swap(bytes);
+		}
+	}
+}
+
+Serializer::ScratchBuffer::ScratchBuffer()
+	: bytes(acquireScratchBuffer())
+{}
+
+Serializer::ScratchBuffer::~ScratchBuffer()
+{
+	releaseScratchBuffer(bytes);
+}
+
 Serializer& Serializer::operator<<(const std::string& str)
 {
 	return *this << String(str);
@@ -147,13 +187,22 @@ void Serializer::copyBytes(const void* src, size_t srcSize)
 {
 	if (!dryRun) {
 		if (dst.size() - size < srcSize) {
-			throw Exception("Insufficient bytes to serialize data.", HalleyExceptions::Utils);
+			if (!growableDst) {
+				throw Exception("Insufficient bytes to serialize data.", HalleyExceptions::Utils);
+			}
+			grow(size + srcSize);
 		}
 		memcpy(dst.data() + size, src, srcSize);
 	}
 	size += srcSize;
 }
 
+void Serializer::grow(size_t minSize)
+{
+	growableDst->resize(std::max(minSize, std::max(growableDst->size() * 2, size_t(256))));
+	dst = gsl::as_writable_bytes(gsl::span<Byte>(*growableDst));
+}
+
 Deserializer::Deserializer(gsl::span<const gsl::byte> src, SerializerOptions options)
 	: ByteSerializationBase(std::move(options))
 	, src(src)
@@ -239,6 +288,12 @@ Deserializer& Deserializer::operator>>(gsl::span<gsl::byte> span)
 	return *this;
 }
 
+void Deserializer::skip(size_t bytes)
+{
+	ensureSufficientBytesRemaining(bytes);
+	pos += bytes;
+}
+
 Deserializer& Deserializer::operator>>(Bytes& bytes)
 {
 	uint32_t sz;
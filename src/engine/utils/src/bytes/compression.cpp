@@ -167,3 +167,226 @@ Bytes Compression::decompressRaw(gsl::span<const gsl::byte> bytes, size_t maxSiz
 		return result;
 	}
 }
+
+namespace {
+	constexpr size_t lz4MinMatch = 4;
+	constexpr size_t lz4LastLiterals = 5; // The last 5 bytes are always literals
+	constexpr size_t lz4MatchFindLimit = 12; // The last match must start at least 12 bytes before the end
+	constexpr size_t lz4MaxOffset = 65535;
+	constexpr int lz4HashLog = 16;
+
+	uint32_t lz4Read32(const uint8_t* p)
+	{
+		uint32_t v;
+		memcpy(&v, p, 4);
+		return v;
+	}
+
+	uint32_t lz4Hash(uint32_t v)
+	{
+		return (v * 2654435761u) >> (32 - lz4HashLog);
+	}
+
+	void lz4WriteLength(Bytes& out, size_t length)
+	{
+		while (length >= 255) {
+			out.push_back(255);
+			length -= 255;
+		}
+		out.push_back(uint8_t(length));
+	}
+
+	void lz4WriteSequence(Bytes& out, const uint8_t* literals, size_t nLiterals, size_t offset, size_t matchLength)
+	{
+		const size_t extraMatch = matchLength - lz4MinMatch;
+		out.push_back(uint8_t((std::min(nLiterals, size_t(15)) << 4) | std::min(extraMatch, size_t(15))));
+		if (nLiterals >= 15) {
+			lz4WriteLength(out, nLiterals - 15);
+		}
+		out.insert(out.end(), literals, literals + nLiterals);
+		out.push_back(uint8_t(offset & 0xFF));
+		out.push_back(uint8_t(offset >> 8));
+		if (extraMatch >= 15) {
+			lz4WriteLength(out, extraMatch - 15);
+		}
+	}
+
+	void lz4WriteLastLiterals(Bytes& out, const uint8_t* literals, size_t nLiterals)
+	{
+		out.push_back(uint8_t(std::min(nLiterals, size_t(15)) << 4));
+		if (nLiterals >= 15) {
+			lz4WriteLength(out, nLiterals - 15);
+		}
+		out.insert(out.end(), literals, literals + nLiterals);
+	}
+
+	size_t lz4ReadLength(const uint8_t* src, size_t srcSize, size_t& pos)
+	{
+		size_t length = 0;
+		uint8_t b;
+		do {
+			if (pos >= srcSize) {
+				throw Exception("Unable to decompress LZ4 data: truncated length.", HalleyExceptions::Compression);
+			}
+			b = src[pos++];
+			length += b;
+		} while (b == 255);
+		return length;
+	}
+}
+
+Bytes Compression::lz4Compress(gsl::span<const gsl::byte> bytes)
+{
+	const uint64_t inSize = bytes.size_bytes();
+	auto compressed = lz4CompressRaw(bytes);
+
+	Bytes result(8 + compressed.size());
+	memcpy(result.data(), &inSize, 8);
+	memcpy(result.data() + 8, compressed.data(), compressed.size());
+	return result;
+}
+
+Bytes Compression::lz4Decompress(gsl::span<const gsl::byte> bytes, size_t maxSize)
+{
+	Expects (bytes.size_bytes() >= 8);
+	uint64_t expectedOutSize;
+	memcpy(&expectedOutSize, bytes.data(), 8);
+	if (expectedOutSize > uint64_t(maxSize)) {
+		throw Exception("File is too big to decompress: " + String::prettySize(expectedOutSize), HalleyExceptions::Compression);
+	}
+
+	auto result = Bytes(size_t(expectedOutSize));
+	lz4DecompressRaw(bytes.subspan(8), gsl::as_writable_bytes(gsl::span<Byte>(result)));
+	return result;
+}
+
+std::shared_ptr<const char> Compression::lz4DecompressToSharedPtr(gsl::span<const gsl::byte> bytes, size_t& outSize, size_t maxSize)
+{
+	Expects (bytes.size_bytes() >= 8);
+	uint64_t expectedOutSize;
+	memcpy(&expectedOutSize, bytes.data(), 8);
+	if (expectedOutSize > uint64_t(maxSize)) {
+		throw Exception("File is too big to decompress: " + String::prettySize(expectedOutSize), HalleyExceptions::Compression);
+	}
+
+	// Decompress straight into the final buffer, rather than going through a Bytes copy
+	auto result = std::shared_ptr<char>(new char[size_t(expectedOutSize)], deleter);
+	lz4DecompressRaw(bytes.subspan(8), gsl::as_writable_bytes(gsl::span<char>(result.get(), size_t(expectedOutSize))));
+	outSize = size_t(expectedOutSize);
+	return result;
+}
+
+Bytes Compression::lz4CompressRaw(gsl::span<const gsl::byte> bytes)
+{
+	const auto* src = reinterpret_cast<const uint8_t*>(bytes.data());
+	const size_t n = bytes.size_bytes();
+
+	Bytes result;
+	result.reserve(n + n / 255 + 16);
+
+	size_t anchor = 0;
+	if (n > lz4MatchFindLimit) {
+		Vector<uint32_t> table(size_t(1) << lz4HashLog, 0);
+		const size_t matchLimit = n - lz4LastLiterals;
+
+		size_t i = 1;
+		while (i + lz4MatchFindLimit <= n) {
+			const uint32_t sequence = lz4Read32(src + i);
+			const uint32_t h = lz4Hash(sequence);
+			size_t candidate = table[h];
+			table[h] = uint32_t(i);
+
+			if (candidate < i && i - candidate <= lz4MaxOffset && lz4Read32(src + candidate) == sequence) {
+				// Extend backwards into pending literals, then forwards as far as allowed
+				while (i > anchor && candidate > 0 && src[i - 1] == src[candidate - 1]) {
+					--i;
+					--candidate;
+				}
+				size_t length = lz4MinMatch;
+				while (i + length < matchLimit && src[candidate + length] == src[i + length]) {
+					++length;
+				}
+
+				lz4WriteSequence(result, src + anchor, i - anchor, i - candidate, length);
+				i += length;
+				anchor = i;
+
+				if (i + lz4MatchFindLimit <= n) {
+					table[lz4Hash(lz4Read32(src + i - 2))] = uint32_t(i - 2);
+				}
+			} else {
+				// Skip ahead faster through data that isn't compressing
+				i += 1 + ((i - anchor) >> 6);
+			}
+		}
+	}
+
+	lz4WriteLastLiterals(result, src + anchor, n - anchor);
+	return result;
+}
+
+void Compression::lz4DecompressRaw(gsl::span<const gsl::byte> bytes, gsl::span<gsl::byte> dst)
+{
+	const auto* src = reinterpret_cast<const uint8_t*>(bytes.data());
+	const size_t srcSize = bytes.size_bytes();
+	auto* out = reinterpret_cast<uint8_t*>(dst.data());
+	const size_t outSize = dst.size_bytes();
+
+	size_t ip = 0;
+	size_t op = 0;
+	while (true) {
+		if (ip >= srcSize) {
+			throw Exception("Unable to decompress LZ4 data: unexpected end of input.", HalleyExceptions::Compression);
+		}
+		const uint8_t token = src[ip++];
+
+		size_t nLiterals = token >> 4;
+		if (nLiterals == 15) {
+			nLiterals += lz4ReadLength(src, srcSize, ip);
+		}
+		if (nLiterals > srcSize - ip || nLiterals > outSize - op) {
+			throw Exception("Unable to decompress LZ4 data: literals out of bounds.", HalleyExceptions::Compression);
+		}
+		memcpy(out + op, src + ip, nLiterals);
+		ip += nLiterals;
+		op += nLiterals;
+
+		if (ip == srcSize) {
+			break;
+		}
+
+		if (srcSize - ip < 2) {
+			throw Exception("Unable to decompress LZ4 data: truncated offset.", HalleyExceptions::Compression);
+		}
+		const size_t offset = size_t(src[ip]) | (size_t(src[ip + 1]) << 8);
+		ip += 2;
+		if (offset == 0 || offset > op) {
+			throw Exception("Unable to decompress LZ4 data: invalid offset.", HalleyExceptions::Compression);
+		}
+
+		size_t length = token & 15;
+		if (length == 15) {
+			length += lz4ReadLength(src, srcSize, ip);
+		}
+		length += lz4MinMatch;
+		if (length > outSize - op) {
+			throw Exception("Unable to decompress LZ4 data: match out of bounds.", HalleyExceptions::Compression);
+		}
+
+		uint8_t* dstMatch = out + op;
+		const uint8_t* srcMatch = dstMatch - offset;
+		if (offset >= length) {
+			memcpy(dstMatch, srcMatch, length);
+		} else {
+			// Overlapping match, repeats the last offset bytes
+			for (size_t j = 0; j < length; ++j) {
+				dstMatch[j] = srcMatch[j];
+			}
+		}
+		op += length;
+	}
+
+	if (op != outSize) {
+		throw Exception("Unexpected outsize (" + toString(op) + ") when decompressing LZ4 data, expected (" + toString(outSize) + ").", HalleyExceptions::Compression);
+	}
+}
@@ -3,57 +3,299 @@
 #include <halley/support/exception.h>
 #include "halley/text/string_converter.h"
 #include "halley/support/logger.h"
+#include <algorithm>
+#include <iterator>
 
 using namespace Halley;
 
 Executors* Executors::instance = nullptr;
 
-ExecutionQueue::ExecutionQueue()
-	: aborted(false)
+namespace {
+	// Chase-Lev deque, following "Correct and Efficient Work-Stealing for Weak Memory Models" (Le et al, 2013)
+	// The owner pushes and pops at the bottom, any other thread can steal from the top.
+	// Capacity is fixed, push fails when it's full and the caller falls back to the shared queue.
+	class WorkStealingDeque
+	{
+	public:
+		WorkStealingDeque() = default;
+		WorkStealingDeque(const WorkStealingDeque& other) = delete;
+		WorkStealingDeque& operator=(const WorkStealingDeque& other) = delete;
+
+		~WorkStealingDeque()
+		{
+			while (auto* task = pop()) {
+				delete task;
+			}
+		}
+
+		bool push(TaskBase* task)
+		{
+			const int64_t b = bottom.load(std::memory_order_relaxed);
+			const int64_t t = top.load(std::memory_order_acquire);
+			if (b - t >= capacity) {
+				return false;
+			}
+			buffer[b & mask].store(task, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+			bottom.store(b + 1, std::memory_order_relaxed);
+			return true;
+		}
+
+		TaskBase* pop()
+		{
+			const int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+			bottom.store(b, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			int64_t t = top.load(std::memory_order_relaxed);
+
+			if (t > b) {
+				// Empty
+				bottom.store(b + 1, std::memory_order_relaxed);
+				return nullptr;
+			}
+
+			TaskBase* task = buffer[b & mask].load(std::memory_order_relaxed);
+			if (t == b) {
+				// Last element, race against thieves for it
+				if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+					task = nullptr;
+				}
+				bottom.store(b + 1, std::memory_order_relaxed);
+			}
+			return task;
+		}
+
+		TaskBase* steal()
+		{
+			int64_t t = top.load(std::memory_order_acquire);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			const int64_t b = bottom.load(std::memory_order_acquire);
+			if (t >= b) {
+				return nullptr;
+			}
+
+			TaskBase* task = buffer[t & mask].load(std::memory_order_relaxed);
+			if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+				// Lost the race to the owner or another thief
+				return nullptr;
+			}
+			return task;
+		}
+
+	private:
+		constexpr static int64_t capacity = 4096;
+		constexpr static int64_t mask = capacity - 1;
+
+		alignas(64) std::atomic<int64_t> top { 0 };
+		alignas(64) std::atomic<int64_t> bottom { 0 };
+		std::array<std::atomic<TaskBase*>, capacity> buffer;
+	};
+
+	thread_local ExecutionQueue* currentQueue = nullptr;
+	thread_local int currentWorkerIdx = -1;
+}
+
+class ExecutionQueue::WorkerSlot
+{
+public:
+	WorkStealingDeque deque;
+	bool inUse = false;
+};
+
+ExecutionQueue::ExecutionQueue(bool workStealing)
+	: workStealing(workStealing)
+	, numWorkerSlots(0)
+	, attachedCount(0)
+	, sleepingCount(0)
+	, pendingCount(0)
+	, stealCount(0)
+	, hasTasks(false)
+	, aborted(false)
 {
-	hasTasks.store(false);
 }
 
+ExecutionQueue::~ExecutionQueue() = default;
+
 TaskBase ExecutionQueue::getNext()
 {
-	std::unique_lock<std::mutex> lock(mutex);
-	while (queue.empty()) {
-		if (!aborted) {
-			condition.wait(lock);
+	const int workerIdx = currentQueue == this ? currentWorkerIdx : -1;
+	TaskBase task;
+
+	while (true) {
+		if (tryGetNext(task, workerIdx)) {
+			return task;
 		}
+
+		std::unique_lock<std::mutex> lock(mutex);
 		if (aborted) {
 			queue.clear();
+			hasTasks.store(false);
 			return TaskBase([] () {});
 		}
-	}
 
-	TaskBase value = queue.front();
-	queue.pop_front();
-	return value;
+		// Producers bump pendingCount before checking sleepingCount, so either they see us here, or we see their task
+		++sleepingCount;
+		if (pendingCount.load() == 0) {
+			condition.wait(lock);
+		}
+		--sleepingCount;
+	}
 }
 
 Vector<TaskBase> ExecutionQueue::getAll()
 {
-	std::unique_lock<std::mutex> lock(mutex);
-	hasTasks.store(false);
-	Vector<TaskBase> tasks(queue.begin(), queue.end());
-	queue.clear();
+	Vector<TaskBase> tasks;
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		hasTasks.store(false);
+		tasks.reserve(queue.size());
+		std::move(queue.begin(), queue.end(), std::back_inserter(tasks));
+		queue.clear();
+	}
+
+	if (workStealing) {
+		TaskBase task;
+		while (trySteal(task, -1)) {
+			tasks.push_back(std::move(task));
+		}
+	}
+
+	pendingCount -= static_cast<int64_t>(tasks.size());
 	return tasks;
 }
 
 void ExecutionQueue::addToQueue(TaskBase task)
 {
 #if HAS_THREADS
+	++pendingCount;
+
+	if (workStealing && currentQueue == this && currentWorkerIdx >= 0) {
+		auto* localTask = new TaskBase(std::move(task));
+		if (workers[currentWorkerIdx]->deque.push(localTask)) {
+			if (sleepingCount.load() > 0) {
+				std::unique_lock<std::mutex> lock(mutex);
+				condition.notify_one();
+			}
+			return;
+		}
+
+		// Local deque is full, overflow to the shared queue
+		task = std::move(*localTask);
+		delete localTask;
+	}
+
 	std::unique_lock<std::mutex> lock(mutex);
-	queue.emplace_back(task);
+	queue.emplace_back(std::move(task));
 	hasTasks.store(true);
 
-	condition.notify_one();
+	if (sleepingCount.load() > 0) {
+		condition.notify_one();
+	}
 #else
 	task();
 #endif
 }
 
+bool ExecutionQueue::tryGetNext(TaskBase& task, int workerIdx)
+{
+	bool found = false;
+
+	if (workerIdx >= 0) {
+		if (auto* localTask = workers[workerIdx]->deque.pop()) {
+			task = std::move(*localTask);
+			delete localTask;
+			found = true;
+		}
+	}
+
+	if (!found) {
+		found = tryPopShared(task);
+	}
+
+	if (!found && workStealing) {
+		found = trySteal(task, workerIdx);
+	}
+
+	if (found) {
+		--pendingCount;
+	}
+	return found;
+}
+
+bool ExecutionQueue::tryPopShared(TaskBase& task)
+{
+	if (!hasTasks.load()) {
+		return false;
+	}
+
+	std::unique_lock<std::mutex> lock(mutex);
+	if (queue.empty()) {
+		hasTasks.store(false);
+		return false;
+	}
+
+	task = std::move(queue.front());
+	queue.pop_front();
+	if (queue.empty()) {
+		hasTasks.store(false);
+	}
+	return true;
+}
+
+bool ExecutionQueue::trySteal(TaskBase& task, int workerIdx)
+{
+	const int n = numWorkerSlots.load(std::memory_order_acquire);
+	const int start = std::max(workerIdx, 0);
+
+	for (int i = 1; i <= n; ++i) {
+		const int victim = (start + i) % n;
+		if (victim == workerIdx) {
+			continue;
+		}
+
+		if (auto* stolenTask = workers[victim]->deque.steal()) {
+			task = std::move(*stolenTask);
+			delete stolenTask;
+			stealCount.fetch_add(1, std::memory_order_relaxed);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool ExecutionQueue::runOneOnCurrentWorker()
+{
+#if HAS_THREADS
+	auto* queue = currentQueue;
+	if (!queue || !queue->workStealing) {
+		return false;
+	}
+
+	TaskBase task;
+	if (queue->tryGetNext(task, currentWorkerIdx)) {
+		task();
+		return true;
+	}
+#endif
+	return false;
+}
+
+bool ExecutionQueue::isWorkStealing() const
+{
+	return workStealing;
+}
+
+size_t ExecutionQueue::getQueueDepth() const
+{
+	return static_cast<size_t>(std::max(pendingCount.load(std::memory_order_relaxed), int64_t(0)));
+}
+
+uint64_t ExecutionQueue::getStealCount() const
+{
+	return stealCount.load(std::memory_order_relaxed);
+}
+
 Executors& Executors::get()
 {
 	if (!instance) {
@@ -72,14 +314,48 @@ size_t ExecutionQueue::threadCount() const
 	return attachedCount.load();
 }
 
-void ExecutionQueue::onAttached()
+int ExecutionQueue::onAttached()
 {
 	++attachedCount;
+	if (!workStealing) {
+		return -1;
+	}
+
+	std::unique_lock<std::mutex> lock(mutex);
+	const int n = numWorkerSlots.load();
+	for (int i = 0; i < n; ++i) {
+		if (!workers[i]->inUse) {
+			workers[i]->inUse = true;
+			return i;
+		}
+	}
+
+	if (n < maxWorkers) {
+		workers[n] = std::make_unique<WorkerSlot>();
+		workers[n]->inUse = true;
+		numWorkerSlots.store(n + 1, std::memory_order_release);
+		return n;
+	}
+
+	// Too many workers, this one will only use the shared queue
+	return -1;
 }
 
-void ExecutionQueue::onDetached()
+void ExecutionQueue::onDetached(int workerIdx)
 {
 	--attachedCount;
+
+	if (workerIdx >= 0) {
+		// Hand anything left behind to the other workers
+		std::unique_lock<std::mutex> lock(mutex);
+		auto& slot = *workers[workerIdx];
+		while (auto* task = slot.deque.pop()) {
+			queue.emplace_back(std::move(*task));
+			delete task;
+			hasTasks.store(true);
+		}
+		slot.inUse = false;
+	}
 }
 
 void ExecutionQueue::abort()
@@ -104,14 +380,14 @@ Executor::Executor(ExecutionQueue& queue)
 	, running(true)
 {
 #if HAS_THREADS
-	queue.onAttached();
+	workerIdx = queue.onAttached();
 #endif
 }
 
 Executor::~Executor()
 {
 #if HAS_THREADS
-	queue.onDetached();
+	queue.onDetached(workerIdx);
 #endif
 }
 
@@ -129,6 +405,9 @@ bool Executor::runPending()
 void Executor::runForever()
 {
 #if HAS_THREADS
+	currentQueue = &queue;
+	currentWorkerIdx = workerIdx;
+
 	try {
 		while (running)	{
 			auto next = queue.getNext();
@@ -142,6 +421,9 @@ void Executor::runForever()
 	} catch (...) {
 		Logger::logError("Executor aborting due to unknown exception.");
 	}
+
+	currentQueue = nullptr;
+	currentWorkerIdx = -1;
 #endif
 }
 
@@ -0,0 +1,214 @@
+#include "halley/file/memory_mapped_file.h"
+#include "halley/support/exception.h"
+#include "halley/file/path.h"
+
+using namespace Halley;
+
+#if defined(_WIN32) && !defined(WINDOWS_STORE)
+
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+
+namespace Halley {
+	class MemoryMappedFilePimpl
+	{
+	public:
+		MemoryMappedFilePimpl(const Path& path)
+		{
+			file = CreateFileW(path.getNativeString().getUTF16().c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+			if (file == INVALID_HANDLE_VALUE) {
+				return;
+			}
+
+			LARGE_INTEGER fileSize;
+			if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+				return;
+			}
+
+			mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (!mapping) {
+				return;
+			}
+
+			data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+			if (data) {
+				size = size_t(fileSize.QuadPart);
+			}
+		}
+
+		~MemoryMappedFilePimpl()
+		{
+			if (data) {
+				UnmapViewOfFile(data);
+			}
+			if (mapping) {
+				CloseHandle(mapping);
+			}
+			if (file != INVALID_HANDLE_VALUE) {
+				CloseHandle(file);
+			}
+		}
+
+		bool isValid() const
+		{
+			return data != nullptr;
+		}
+
+		gsl::span<const gsl::byte> getSpan() const
+		{
+			return gsl::span<const gsl::byte>(static_cast<const gsl::byte*>(data), size);
+		}
+
+	private:
+		HANDLE file = INVALID_HANDLE_VALUE;
+		HANDLE mapping = nullptr;
+		void* data = nullptr;
+		size_t size = 0;
+	};
+}
+
+#elif defined(__unix__) || defined(__APPLE__)
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace Halley {
+	class MemoryMappedFilePimpl
+	{
+	public:
+		MemoryMappedFilePimpl(const Path& path)
+		{
+			const int fd = open(path.getNativeString().c_str(), O_RDONLY);
+			if (fd < 0) {
+				return;
+			}
+
+			struct stat st;
+			if (fstat(fd, &st) == 0 && st.st_size > 0) {
+				void* result = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+				if (result != MAP_FAILED) {
+					data = result;
+					size = size_t(st.st_size);
+				}
+			}
+
+			// The mapping holds its own reference to the file
+			::close(fd);
+		}
+
+		~MemoryMappedFilePimpl()
+		{
+			if (data) {
+				munmap(data, size);
+			}
+		}
+
+		bool isValid() const
+		{
+			return data != nullptr;
+		}
+
+		gsl::span<const gsl::byte> getSpan() const
+		{
+			return gsl::span<const gsl::byte>(static_cast<const gsl::byte*>(data), size);
+		}
+
+	private:
+		void* data = nullptr;
+		size_t size = 0;
+	};
+}
+
+#else
+
+namespace Halley {
+	// Not implemented
+	class MemoryMappedFilePimpl
+	{
+	public:
+		MemoryMappedFilePimpl(const Path&) {}
+		bool isValid() const { return false; }
+		gsl::span<const gsl::byte> getSpan() const { return {}; }
+	};
+}
+
+#endif
+
+MemoryMappedFile::MemoryMappedFile(const Path& path)
+	: pimpl(std::make_unique<MemoryMappedFilePimpl>(path))
+{}
+
+MemoryMappedFile::~MemoryMappedFile() = default;
+
+bool MemoryMappedFile::isValid() const
+{
+	return pimpl->isValid();
+}
+
+gsl::span<const gsl::byte> MemoryMappedFile::getSpan() const
+{
+	return pimpl->getSpan();
+}
+
+MemoryMappedDataReader::MemoryMappedDataReader(std::shared_ptr<MemoryMappedFile> file)
+	: file(std::move(file))
+{
+	Expects(this->file && this->file->isValid());
+}
+
+std::unique_ptr<MemoryMappedDataReader> MemoryMappedDataReader::tryOpen(const Path& path)
+{
+	auto file = std::make_shared<MemoryMappedFile>(path);
+	if (!file->isValid()) {
+		return {};
+	}
+	return std::make_unique<MemoryMappedDataReader>(std::move(file));
+}
+
+size_t MemoryMappedDataReader::size() const
+{
+	return size_t(file->getSpan().size());
+}
+
+int MemoryMappedDataReader::read(gsl::span<gsl::byte> dst)
+{
+	const auto src = file->getSpan();
+	const size_t toRead = std::min(size_t(dst.size()), size_t(src.size()) - std::min(pos, size_t(src.size())));
+	if (toRead > 0) {
+		memcpy(dst.data(), src.data() + pos, toRead);
+		pos += toRead;
+	}
+	return int(toRead);
+}
+
+void MemoryMappedDataReader::seek(int64_t offset, int whence)
+{
+	switch (whence) {
+	case SEEK_SET:
+		pos = size_t(offset);
+		break;
+	case SEEK_CUR:
+		pos = size_t(int64_t(pos) + offset);
+		break;
+	case SEEK_END:
+		pos = size_t(int64_t(size()) + offset);
+		break;
+	}
+}
+
+size_t MemoryMappedDataReader::tell() const
+{
+	return pos;
+}
+
+void MemoryMappedDataReader::close()
+{
+}
+
+std::shared_ptr<const char> MemoryMappedDataReader::getMappedData() const
+{
+	// Aliases the file, so the mapping outlives this reader for as long as anyone points into it
+	return std::shared_ptr<const char>(file, reinterpret_cast<const char*>(file->getSpan().data()));
+}
@@ -2,7 +2,6 @@
 
 #include <cassert>
 
-#include "halley/data_structures/priority_queue.h"
 #include "halley/maths/random.h"
 #include "halley/maths/ray.h"
 #include "halley/support/logger.h"
@@ -322,60 +321,119 @@ void Navmesh::NodeAndConn::deserialize(Deserializer& s)
 	s >> connectionIdx;
 }
 
+Navmesh::QueryContext& Navmesh::QueryContext::getThreadLocal()
+{
+	static thread_local QueryContext context;
+	return context;
+}
+
+void Navmesh::QueryContext::begin(size_t nNodes)
+{
+	if (state.size() < nNodes) {
+		state.resize(nNodes);
+	}
+	openSet.clear();
+
+	++generation;
+	if (generation == 0) {
+		// Wrapped around, so stamps from long ago could look current
+		for (auto& s: state) {
+			s.generation = 0;
+		}
+		generation = 1;
+	}
+}
+
+Navmesh::QueryContext::State& Navmesh::QueryContext::getState(NodeId id)
+{
+	auto& s = state[id];
+	if (s.generation != generation) {
+		s.gScore = std::numeric_limits<float>::infinity();
+		s.fScore = std::numeric_limits<float>::infinity();
+		s.cameFrom = NodeAndConn();
+		s.generation = generation;
+		s.inClosedSet = false;
+	}
+	return s;
+}
+
 std::optional<Vector<Navmesh::NodeAndConn>> Navmesh::pathfindNodes(const NavigationQuery& query) const
 {
-	if (query.fromSubWorld != subWorld || query.toSubWorld != subWorld) {
+	return pathfindNodes(query, QueryContext::getThreadLocal());
+}
+
+std::optional<Vector<Navmesh::NodeAndConn>> Navmesh::pathfindNodes(const NavigationQuery& query, QueryContext& context) const
+{
+	Vector<NodeAndConn> result;
+	if (!pathfindNodes(query, context, result)) {
 		return {};
 	}
+	return result;
+}
 
-	auto fromId = getNodeAt(query.from);
-	auto toId = getNodeAt(query.to);
+std::optional<NavigationPath> Navmesh::pathfind(const NavigationQuery& query) const
+{
+	return pathfind(query, QueryContext::getThreadLocal());
+}
 
-	if (!fromId || !toId) {
+std::optional<NavigationPath> Navmesh::pathfind(const NavigationQuery& query, QueryContext& context) const
+{
+	if (!pathfindNodes(query, context, context.nodePath)) {
 		return {};
 	}
 
-	return pathfind(fromId.value(), toId.value());
+	return makePath(query, context.nodePath, context);
 }
 
-std::optional<NavigationPath> Navmesh::pathfind(const NavigationQuery& query) const
+bool Navmesh::pathfindNodes(const NavigationQuery& query, QueryContext& context, Vector<NodeAndConn>& result) const
 {
-	auto nodePath = pathfindNodes(query);
-	if (!nodePath) {
-		return {};
+	if (query.fromSubWorld != subWorld || query.toSubWorld != subWorld) {
+		return false;
+	}
+
+	auto fromId = getNodeAt(query.from);
+	auto toId = getNodeAt(query.to);
+
+	if (!fromId || !toId) {
+		return false;
 	}
 
-	return makePath(query, nodePath.value());
+	return pathfind(fromId.value(), toId.value(), context, result);
 }
 
-Vector<Navmesh::NodeAndConn> Navmesh::makeResult(const Vector<State>& state, int startId, int endId) const
+void Navmesh::makeResult(QueryContext& context, int startId, int endId, Vector<NodeAndConn>& result) const
 {
-	Vector<NodeAndConn> result;
-	for (NodeAndConn curNode(endId); true; curNode = state[curNode.node].cameFrom) {
+	result.clear();
+	for (NodeAndConn curNode(endId); true; curNode = context.state[curNode.node].cameFrom) {
 		result.push_back(curNode);
 		if (curNode.node == startId) {
 			break;
 		}
 	}
 	std::reverse(result.begin(), result.end());
-	return result;
 }
 
-std::optional<Vector<Navmesh::NodeAndConn>> Navmesh::pathfind(int fromId, int toId) const
+bool Navmesh::pathfind(int fromId, int toId, QueryContext& context, Vector<NodeAndConn>& result) const
 {
 	// Ensure the query is valid
 	if (fromId < 0 || fromId >= static_cast<int>(nodes.size()) || toId < 0 || toId >= static_cast<int>(nodes.size())) {
 		// Invalid query
-		return {};
+		return false;
 	}
 
-	// State map. Using vector for perf, trading space for CPU.
-	// TODO: measure this vs unordered_map or some other hashtable, it's not impossible that it'd perform better (compact memory)
-	Vector<State> state(nodes.size(), State{});
+	context.begin(nodes.size());
 
-	// Open set
-	auto openSet = PriorityQueue<NodeId, NodeComparator>(NodeComparator(state));
-	openSet.reserve(std::min(static_cast<size_t>(100), nodes.size()));
+	// Open set. Nodes are pushed again when their score improves, rather than updated in place, and the stale entries skipped.
+	auto& openSet = context.openSet;
+	auto compare = [] (const QueryContext::OpenNode& a, const QueryContext::OpenNode& b)
+	{
+		return a.fScore > b.fScore;
+	};
+	auto push = [&] (NodeId id, float fScore)
+	{
+		openSet.push_back(QueryContext::OpenNode{ fScore, id });
+		std::push_heap(openSet.begin(), openSet.end(), compare);
+	};
 
 	// Define heuristic function
 	const Vector2f endPos = nodes[toId].pos;
@@ -387,55 +445,57 @@ std::optional<Vector<Navmesh::NodeAndConn>> Navmesh::pathfind(int fromId, int to
 
 	// Initialize the query
 	{
-		auto& firstNodeState = state[fromId];
+		auto& firstNodeState = context.getState(static_cast<NodeId>(fromId));
 		firstNodeState.cameFrom = NodeAndConn();
 		firstNodeState.gScore = 0;
 		firstNodeState.fScore = h(nodes[fromId].pos);
-		firstNodeState.inOpenSet = true;
-		openSet.push(fromId);
+		push(static_cast<NodeId>(fromId), firstNodeState.fScore);
 	}
 
 	// Run A*
 	while (!openSet.empty()) {
-		const auto curId = openSet.top();
+		std::pop_heap(openSet.begin(), openSet.end(), compare);
+		const auto cur = openSet.back();
+		openSet.pop_back();
+
+		const auto curId = cur.node;
+		auto& curState = context.getState(curId);
+		if (curState.inClosedSet || cur.fScore != curState.fScore) {
+			continue;
+		}
+
 		if (curId == toId) {
 			// Done!
-			return makeResult(state, fromId, toId);
+			makeResult(context, fromId, toId, result);
+			return true;
 		}
 
-		state[curId].inOpenSet = false;
-		state[curId].inClosedSet = true;
-		openSet.pop();
+		curState.inClosedSet = true;
 		
-		const float gScore = state[curId].gScore;
+		const float gScore = curState.gScore;
 		const auto& curNode = nodes[curId];
 		for (size_t i = 0; i < curNode.nConnections; ++i) {
 			if (curNode.connections[i]) {
 				const auto nodeId = curNode.connections[i].value();
-				if (!state[nodeId].inClosedSet) {
-					auto& neighState = state[nodeId];
+				auto& neighState = context.getState(nodeId);
+				if (!neighState.inClosedSet) {
 					const float neighScore = gScore + curNode.costs[i];
 
 					if (neighScore < neighState.gScore) {
 						neighState.cameFrom = NodeAndConn(curId, static_cast<uint16_t>(i));
 						neighState.gScore = neighScore;
 						neighState.fScore = neighScore + h(nodes[nodeId].pos);
-						if (!neighState.inOpenSet) {
-							neighState.inOpenSet = true;
-							openSet.push(nodeId);
-						} else {
-							openSet.update(nodeId);
-						}
+						push(nodeId, neighState.fScore);
 					}
 				}
 			}
 		}
 	}
 	
-	return {};
+	return false;
 }
 
-std::optional<NavigationPath> Navmesh::makePath(const NavigationQuery& query, const Vector<NodeAndConn>& nodePath) const
+std::optional<NavigationPath> Navmesh::makePath(const NavigationQuery& query, const Vector<NodeAndConn>& nodePath, QueryContext& context) const
 {
 	Vector<Vector2f> points;
 	points.reserve(nodePath.size() + 1);
@@ -452,7 +512,7 @@ std::optional<NavigationPath> Navmesh::makePath(const NavigationQuery& query, co
 	points.push_back(query.to);
 	
 	if (query.postProcessingType != NavigationQuery::PostProcessingType::None) {
-		postProcessPath(points, query.postProcessingType);
+		postProcessPath(points, query.postProcessingType, context);
 	}
 
 	// Check for NaN/inf
@@ -466,7 +526,7 @@ std::optional<NavigationPath> Navmesh::makePath(const NavigationQuery& query, co
 	return NavigationPath(query, points);
 }
 
-void Navmesh::postProcessPath(Vector<Vector2f>& points, NavigationQuery::PostProcessingType type) const
+void Navmesh::postProcessPath(Vector<Vector2f>& points, NavigationQuery::PostProcessingType type, QueryContext& context) const
 {
 	if (type == NavigationQuery::PostProcessingType::None) {
 		return;
@@ -475,14 +535,14 @@ void Navmesh::postProcessPath(Vector<Vector2f>& points, NavigationQuery::PostPro
 		return;
 	}
 
-	Vector<NodeId> nodeIds;
+	auto& nodeIds = context.nodeIds;
 	nodeIds.resize(points.size());
 	for (size_t i = 0; i < points.size(); ++i) {
 		nodeIds[i] = getNodeAt(points[i]).value_or(-1);
 		assert(nodeIds[i] != -1);
 	}
 
-	Vector<float> pathCosts;
+	auto& pathCosts = context.pathCosts;
 	pathCosts.resize(points.size());
 	pathCosts[0] = 0.0f;
 	for(size_t i = 1; i < points.size(); i++) {
@@ -1,6 +1,7 @@
 #include "halley/navigation/navmesh_set.h"
 
 #include "halley/bytes/byte_serializer.h"
+#include "halley/concurrency/concurrent.h"
 #include "halley/data_structures/priority_queue.h"
 #include "halley/maths/ray.h"
 #include "halley/support/logger.h"
@@ -48,11 +49,13 @@ void NavmeshSet::serialize(Serializer& s) const
 void NavmeshSet::deserialize(Deserializer& s)
 {
 	s >> navmeshes;
+	routeCache.clear();
 }
 
 void NavmeshSet::add(Navmesh navmesh)
 {
 	navmeshes.push_back(std::move(navmesh));
+	routeCache.clear();
 }
 
 void NavmeshSet::addChunk(NavmeshSet navmeshSet, Vector2f origin, Vector2i gridPosition)
@@ -68,16 +71,19 @@ void NavmeshSet::addRaw(NavmeshSet navmeshSet)
 	for (auto& navmesh: navmeshSet.navmeshes) {
 		navmeshes.push_back(std::move(navmesh));
 	}
+	routeCache.clear();
 }
 
 void NavmeshSet::clear()
 {
 	navmeshes.clear();
+	routeCache.clear();
 }
 
 void NavmeshSet::clearSubWorld(int subWorld)
 {
 	navmeshes.erase(std::remove_if(navmeshes.begin(), navmeshes.end(), [&] (const Navmesh& nav) { return nav.getSubWorld() == subWorld; }), navmeshes.end());
+	routeCache.clear();
 }
 
 std::optional<NavigationPath> NavmeshSet::pathfind(const NavigationQuery& query) const
@@ -104,6 +110,24 @@ std::optional<NavigationPath> NavmeshSet::pathfind(const NavigationQuery& query)
 	}
 }
 
+Vector<std::optional<NavigationPath>> NavmeshSet::pathfindBatch(gsl::span<const NavigationQuery> queries) const
+{
+	return pathfindBatch(queries, ExecutionQueue::getDefault());
+}
+
+Vector<std::optional<NavigationPath>> NavmeshSet::pathfindBatch(gsl::span<const NavigationQuery> queries, ExecutionQueue& queue) const
+{
+	// Each thread pathfinds with its own Navmesh::QueryContext
+	Vector<std::optional<NavigationPath>> results(queries.size());
+	Concurrent::parallelForChunks(queue, queries.size(), [&] (size_t start, size_t end)
+	{
+		for (size_t i = start; i < end; ++i) {
+			results[i] = pathfind(queries[i]);
+		}
+	});
+	return results;
+}
+
 std::optional<NavigationPath> NavmeshSet::pathfindInRegion(const NavigationQuery& query, uint16_t regionId) const
 {
 	return navmeshes[regionId].pathfind(query);
@@ -145,6 +169,7 @@ size_t NavmeshSet::getNavMeshIdxAt(Vector2f pos, int subWorld) const
 
 void NavmeshSet::linkNavmeshes()
 {
+	routeCache.clear();
 	regionNodes.clear();
 	regionNodes.resize(navmeshes.size());
 	portalNodes.clear();
@@ -178,6 +203,13 @@ void NavmeshSet::linkNavmeshes()
 			}
 		}
 	}
+
+	// Reverse them, for searching back from a destination
+	for (size_t curPortalId = 0; curPortalId < portalNodes.size(); ++curPortalId) {
+		for (const auto& conn: portalNodes[curPortalId].connections) {
+			portalNodes[conn.portalId].incomingConnections.emplace_back(static_cast<uint16_t>(curPortalId), conn.regionId, conn.cost);
+		}
+	}
 }
 
 void NavmeshSet::reportUnlinkedPortals(std::function<String(Vector2i)> getChunkName) const
@@ -274,6 +306,53 @@ Vector<NavmeshSet::NodeAndConn> NavmeshSet::findRegionPath(Vector2f startPos, Ve
 		return {};
 	}
 
+	// Busy destinations get their routes cached, everything else is searched directly
+	bool build = false;
+	auto routes = routeCache.get(toRegionId, build);
+	if (!routes && build) {
+		// If two threads get here at once, both build the same routes and either can be kept
+		routes = makeRoutesTo(toRegionId);
+		routeCache.set(toRegionId, routes);
+	}
+
+	return routes ? findRegionPath(startPos, endPos, fromRegionId, *routes) : searchRegionPath(startPos, endPos, fromRegionId, toRegionId);
+}
+
+Vector<NavmeshSet::NodeAndConn> NavmeshSet::findRegionPath(Vector2f startPos, Vector2f endPos, NodeId fromRegionId, const RegionRoutes& routes) const
+{
+	// Pick the cheapest way out of the start region and into the end one, counting the straight lines from and to the query's endpoints
+	const RegionRoutes::Entrance* bestEntrance = nullptr;
+	NodeId bestStart = 0;
+	float bestCost = std::numeric_limits<float>::infinity();
+	for (const auto& entrance: routes.entrances) {
+		const float endCost = (portalNodes[entrance.portalId].pos - endPos).length();
+		for (const auto portalId: regionNodes[fromRegionId].portals) {
+			const float cost = (portalNodes[portalId].pos - startPos).length() + entrance.distance[portalId] + endCost;
+			if (cost < bestCost) {
+				bestCost = cost;
+				bestEntrance = &entrance;
+				bestStart = portalId;
+			}
+		}
+	}
+
+	if (!bestEntrance) {
+		return {};
+	}
+
+	// Follow the route from the start region's portal to the entrance
+	Vector<NodeAndConn> result;
+	result.push_back(NodeAndConn(fromRegionId, portalNodes[bestStart].fromPortal));
+	for (NodeId i = bestStart; i != bestEntrance->portalId; ) {
+		i = bestEntrance->next[i];
+		result.push_back(NodeAndConn(portalNodes[i].fromRegion, portalNodes[i].fromPortal));
+	}
+	result.push_back(NodeAndConn(portalNodes[bestEntrance->portalId].toRegion));
+	return result;
+}
+
+Vector<NavmeshSet::NodeAndConn> NavmeshSet::searchRegionPath(Vector2f startPos, Vector2f endPos, NodeId fromRegionId, NodeId toRegionId) const
+{
 	// State map. Using vector for perf, trading space for CPU.
 	// TODO: measure this vs unordered_map or some other hashtable, it's not impossible that it'd perform better (compact memory)
 	Vector<State> state(portalNodes.size(), State{});
@@ -283,6 +362,7 @@ Vector<NavmeshSet::NodeAndConn> NavmeshSet::findRegionPath(Vector2f startPos, Ve
 	openSet.reserve(std::min(static_cast<size_t>(100), portalNodes.size()));
 
 	// Define heuristic function
+	// Portal costs are straight lines too, so the first entrance into the end region to come out of the open set is on the cheapest route
 	auto h = [&] (Vector2f pos) -> float
 	{
 		return (pos - endPos).length();
@@ -296,7 +376,7 @@ Vector<NavmeshSet::NodeAndConn> NavmeshSet::findRegionPath(Vector2f startPos, Ve
 			const auto pos = portalNodes[portalId].pos;
 			nodeState.cameFrom = std::numeric_limits<uint16_t>::max();
 			nodeState.gScore = (pos - startPos).length();
-			nodeState.fScore = h(pos);
+			nodeState.fScore = nodeState.gScore + h(pos);
 			nodeState.inOpenSet = true;
 			openSet.push(portalId);
 		}
@@ -357,6 +437,55 @@ Vector<NavmeshSet::NodeAndConn> NavmeshSet::findRegionPath(Vector2f startPos, Ve
 	return {};
 }
 
+std::shared_ptr<const NavmeshSet::RegionRoutes> NavmeshSet::makeRoutesTo(NodeId regionId) const
+{
+	struct OpenNode {
+		float distance;
+		NodeId portalId;
+	};
+	auto compare = [] (const OpenNode& a, const OpenNode& b)
+	{
+		return a.distance > b.distance;
+	};
+	Vector<OpenNode> openSet;
+
+	auto result = std::make_shared<RegionRoutes>();
+	for (size_t i = 0; i < portalNodes.size(); ++i) {
+		if (portalNodes[i].toRegion != regionId) {
+			continue;
+		}
+
+		// Dijkstra back from the entrance, over the incoming connections
+		auto& entrance = result->entrances.emplace_back();
+		entrance.portalId = static_cast<NodeId>(i);
+		entrance.distance.resize(portalNodes.size(), std::numeric_limits<float>::infinity());
+		entrance.next.resize(portalNodes.size(), std::numeric_limits<NodeId>::max());
+
+		entrance.distance[i] = 0;
+		openSet.push_back(OpenNode{ 0, entrance.portalId });
+		while (!openSet.empty()) {
+			std::pop_heap(openSet.begin(), openSet.end(), compare);
+			const auto cur = openSet.back();
+			openSet.pop_back();
+			if (cur.distance > entrance.distance[cur.portalId]) {
+				continue;
+			}
+
+			for (const auto& in: portalNodes[cur.portalId].incomingConnections) {
+				const float distance = cur.distance + in.cost;
+				if (distance < entrance.distance[in.portalId]) {
+					entrance.distance[in.portalId] = distance;
+					entrance.next[in.portalId] = cur.portalId;
+					openSet.push_back(OpenNode{ distance, in.portalId });
+					std::push_heap(openSet.begin(), openSet.end(), compare);
+				}
+			}
+		}
+	}
+
+	return result;
+}
+
 std::pair<uint16_t, uint16_t> NavmeshSet::getPortalDestination(uint16_t region, uint16_t edge) const
 {
 	constexpr auto maxVal = std::numeric_limits<uint16_t>::max();
@@ -565,4 +694,115 @@ Vector<Vector2f> NavmeshSet::postProcessPathBetweenRegions(
 	}
 	
 	return points;
-}
\ No newline at end of file
+}
+
+void NavmeshSet::setRouteCacheMaxSize(size_t bytes)
+{
+	routeCache.setMaxSize(bytes);
+}
+
+size_t NavmeshSet::getRouteCacheSize() const
+{
+	return routeCache.getSize();
+}
+
+size_t NavmeshSet::RegionRoutes::getSize() const
+{
+	size_t result = sizeof(RegionRoutes);
+	for (const auto& entrance: entrances) {
+		result += sizeof(Entrance) + entrance.distance.size() * sizeof(float) + entrance.next.size() * sizeof(NodeId);
+	}
+	return result;
+}
+
+NavmeshSet::RouteCache::RouteCache(const RouteCache& other)
+	: maxSize(other.maxSize)
+{
+}
+
+NavmeshSet::RouteCache& NavmeshSet::RouteCache::operator=(const RouteCache& other)
+{
+	clear();
+	setMaxSize(other.maxSize);
+	return *this;
+}
+
+std::shared_ptr<const NavmeshSet::RegionRoutes> NavmeshSet::RouteCache::get(NodeId regionId, bool& build)
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	if (regions.size() <= regionId) {
+		regions.resize(regionId + 1);
+	}
+
+	auto& entry = regions[regionId];
+	if (entry.routes) {
+		entry.lastUsed = ++nUses;
+		return entry.routes;
+	}
+
+	build = !entry.tooLarge && ++entry.misses >= missesToBuild;
+	return {};
+}
+
+void NavmeshSet::RouteCache::set(NodeId regionId, std::shared_ptr<const RegionRoutes> routes)
+{
+	const auto routesSize = routes->getSize();
+
+	std::unique_lock<std::mutex> lock(mutex);
+	if (regions.size() <= regionId) {
+		regions.resize(regionId + 1);
+	}
+
+	auto& entry = regions[regionId];
+	if (entry.routes) {
+		return;
+	}
+	entry.misses = 0;
+	if (routesSize > maxSize) {
+		entry.tooLarge = true;
+		return;
+	}
+
+	evict(maxSize - routesSize);
+	entry.routes = std::move(routes);
+	entry.lastUsed = ++nUses;
+	size += routesSize;
+}
+
+void NavmeshSet::RouteCache::clear()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	regions.clear();
+	size = 0;
+}
+
+void NavmeshSet::RouteCache::setMaxSize(size_t bytes)
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	maxSize = bytes;
+	for (auto& entry: regions) {
+		entry.tooLarge = false;
+	}
+	evict(maxSize);
+}
+
+size_t NavmeshSet::RouteCache::getSize() const
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	return size;
+}
+
+void NavmeshSet::RouteCache::evict(size_t maxRemaining)
+{
+	// Only runs after routes have been built, which costs far more than going through the regions
+	while (size > maxRemaining) {
+		Entry* oldest = nullptr;
+		for (auto& entry: regions) {
+			if (entry.routes && (!oldest || entry.lastUsed < oldest->lastUsed)) {
+				oldest = &entry;
+			}
+		}
+		size -= oldest->routes->getSize();
+		oldest->routes.reset();
+	}
+}
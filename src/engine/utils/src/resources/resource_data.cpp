@@ -34,6 +34,14 @@ ResourceDataStatic::ResourceDataStatic(const void* _data, size_t _size, String p
 	set(_data, _size, owning);
 }
 
+ResourceDataStatic::ResourceDataStatic(std::shared_ptr<const char> data, size_t size, String path)
+	: ResourceData(path)
+	, data(std::move(data))
+	, size(size)
+	, loaded(true)
+{
+}
+
 static void deleter(const char* data)
 {
 	delete[] data;
@@ -82,6 +90,23 @@ void ResourceDataStatic::inflate()
 	data = Compression::decompressToSharedPtr(getSpan(), size);
 }
 
+void ResourceDataStatic::decompressLZ4()
+{
+	data = Compression::lz4DecompressToSharedPtr(getSpan(), size);
+}
+
+void ResourceDataStatic::decompress(const Metadata* metadata)
+{
+	if (metadata) {
+		const auto compression = metadata->getString("asset_compression", "");
+		if (compression == "deflate") {
+			inflate();
+		} else if (compression == "lz4") {
+			decompressLZ4();
+		}
+	}
+}
+
 std::unique_ptr<ResourceDataStatic> ResourceDataStatic::loadFromFileSystem(Path path)
 {
 	std::ifstream fp(path.string(), std::ios::binary | std::ios::in);
@@ -144,12 +169,12 @@ std::unique_ptr<ResourceDataStatic> ResourceLoader::getStatic(bool throwOnFail)
 {
 	auto result = locator.getStatic(name, type, throwOnFail);
 	if (result) {
-		if (metadata && metadata->getString("asset_compression", "") == "deflate") {
+		if (metadata) {
 			try {
-				result->inflate();
+				result->decompress(metadata);
 			} catch (Exception &e) {
 				if (throwOnFail) {
-					throw Exception("Failed to load resource \"" + getName() + "\" due to inflate exception: " + e.what(), HalleyExceptions::Resources);
+					throw Exception("Failed to load resource \"" + getName() + "\" due to decompression exception: " + e.what(), HalleyExceptions::Resources);
 				} else {
 					return nullptr;
 				}
@@ -175,12 +200,15 @@ Future<std::unique_ptr<ResourceDataStatic>> ResourceLoader::getAsync(bool throwO
 	auto n = name;
 	auto t = type;
 	auto meta = getMeta();
-	return Concurrent::execute(Executors::getDiskIO(), [meta, loc, n, t, throwOnFail] () -> std::unique_ptr<ResourceDataStatic>
+	return Concurrent::execute(Executors::getDiskIO(), [loc, n, t, throwOnFail] () -> std::unique_ptr<ResourceDataStatic>
 	{
 		ProfilerEvent event(ProfilerEventType::DiskIO);
-		auto result = loc.get().getStatic(n, t, throwOnFail);
-		if (meta.getString("asset_compression", "") == "deflate") {
-			result->inflate();
+		return loc.get().getStatic(n, t, throwOnFail);
+	}).then(Executors::getCPU(), [meta] (std::unique_ptr<ResourceDataStatic> result) -> std::unique_ptr<ResourceDataStatic>
+	{
+		// Decompress on the CPU executor, so the disk thread can move on to the next read
+		if (result) {
+			result->decompress(&meta);
 		}
 		return result;
 	});
@@ -1,7 +1,11 @@
 #include "halley/support/logger.h"
 #include "halley/text/halleystring.h"
+#include "halley/text/string_converter.h"
+#include "halley/utils/utils.h"
 #include <gsl/gsl_assert>
 #include <iostream>
+#include <thread>
+#include <condition_variable>
 #include "halley/support/console.h"
 
 using namespace Halley;
@@ -40,6 +44,206 @@ void StdOutSink::log(LoggerLevel level, const String& msg)
 	std::cout << msg << ConsoleColour() << '\n';
 }
 
+void StdOutSink::flush()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	std::cout.flush();
+}
+
+namespace {
+	// Set while a thread writes to the sinks holding sinksMutex, so that a sink that logs from inside log() doesn't deadlock on it
+	thread_local bool writingToSinks = false;
+
+	class WritingToSinks {
+	public:
+		WritingToSinks() : previous(writingToSinks) { writingToSinks = true; }
+		~WritingToSinks() { writingToSinks = previous; }
+
+	private:
+		bool previous;
+	};
+}
+
+// A bounded lock-free queue, which any thread can push to, and a thread that writes out whatever got queued
+// Only one thread can pop at a time, which is ensured by only popping while holding the logger's sinksMutex
+class Logger::AsyncWriter {
+public:
+	explicit AsyncWriter(size_t maxMessages)
+		: capacity(nextPowerOf2(std::max(maxMessages, size_t(2))))
+		, cells(std::make_unique<Cell[]>(capacity))
+	{
+		for (size_t i = 0; i < capacity; ++i) {
+			cells[i].sequence.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	~AsyncWriter()
+	{
+		stop();
+	}
+
+	bool tryPush(LoggerLevel level, const String& msg)
+	{
+		size_t pos = enqueuePos.load(std::memory_order_relaxed);
+		Cell* cell;
+		while (true) {
+			cell = &cells[pos & (capacity - 1)];
+			const auto diff = static_cast<std::ptrdiff_t>(cell->sequence.load(std::memory_order_acquire)) - static_cast<std::ptrdiff_t>(pos);
+			if (diff == 0) {
+				if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+					break;
+				}
+			} else if (diff < 0) {
+				return false;
+			} else {
+				pos = enqueuePos.load(std::memory_order_relaxed);
+			}
+		}
+
+		cell->level = level;
+		cell->msg = msg;
+		cell->sequence.store(pos + 1, std::memory_order_release);
+
+		if (waiting.load(std::memory_order_relaxed)) {
+			condition.notify_one();
+		}
+		return true;
+	}
+
+	void addDropped()
+	{
+		dropped.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	size_t getNumDropped() const
+	{
+		return dropped.load(std::memory_order_relaxed);
+	}
+
+	bool isEmpty() const
+	{
+		const auto pos = dequeuePos.load(std::memory_order_relaxed);
+		return cells[pos & (capacity - 1)].sequence.load(std::memory_order_acquire) != pos + 1;
+	}
+
+	// Writes everything currently queued as one batch. The caller must hold sinksMutex.
+	void drain(const std::set<ILoggerSink*>& sinks)
+	{
+		WritingToSinks writing;
+		auto write = [&] (LoggerLevel level, const String& msg)
+		{
+			for (const auto& s: sinks) {
+				s->log(level, msg);
+			}
+		};
+
+		bool wroteAny = false;
+		// Stop after a full queue's worth, so that a thread that never stops logging doesn't starve the flush
+		for (size_t i = 0; i < capacity; ++i) {
+			const auto pos = dequeuePos.load(std::memory_order_relaxed);
+			auto& cell = cells[pos & (capacity - 1)];
+			if (cell.sequence.load(std::memory_order_acquire) != pos + 1) {
+				break;
+			}
+			write(cell.level, cell.msg);
+			cell.msg = String();
+			cell.sequence.store(pos + capacity, std::memory_order_release);
+			dequeuePos.store(pos + 1, std::memory_order_relaxed);
+			wroteAny = true;
+		}
+
+		// Anything dropped was logged after what was in the queue at the time, so report it after those
+		const auto nDropped = getNumDropped();
+		const auto nDroppedBefore = droppedReported.load(std::memory_order_relaxed);
+		if (nDropped != nDroppedBefore) {
+			write(LoggerLevel::Warning, "Logger queue was full, dropped " + toString(nDropped - nDroppedBefore) + " messages.");
+			droppedReported.store(nDropped, std::memory_order_relaxed);
+			wroteAny = true;
+		}
+
+		if (wroteAny) {
+			for (const auto& s: sinks) {
+				s->flush();
+			}
+		}
+	}
+
+	void start(Logger& logger)
+	{
+		Expects(!thread.joinable());
+		running = true;
+		thread = std::thread([this, &logger] () { run(logger); });
+	}
+
+	void stop()
+	{
+		if (thread.joinable()) {
+			{
+				std::unique_lock<std::mutex> lock(waitMutex);
+				running = false;
+			}
+			condition.notify_one();
+			thread.join();
+		}
+	}
+
+private:
+	struct Cell {
+		std::atomic<size_t> sequence;
+		LoggerLevel level = LoggerLevel::Info;
+		String msg;
+	};
+
+	const size_t capacity;
+	std::unique_ptr<Cell[]> cells;
+	alignas(64) std::atomic<size_t> enqueuePos{ 0 };
+	alignas(64) std::atomic<size_t> dequeuePos{ 0 };
+	std::atomic<size_t> dropped{ 0 };
+	std::atomic<size_t> droppedReported{ 0 };
+
+	std::thread thread;
+	std::mutex waitMutex;
+	std::condition_variable condition;
+	std::atomic<bool> waiting{ false };
+	bool running = false;
+
+	void run(Logger& logger)
+	{
+		while (true) {
+			{
+				// Producers only notify when they see the writer waiting, so time out in case one looked just before it started to
+				std::unique_lock<std::mutex> lock(waitMutex);
+				waiting = true;
+				condition.wait_for(lock, std::chrono::milliseconds(20), [&] { return !running || !isEmpty() || getNumDropped() != droppedReported.load(std::memory_order_relaxed); });
+				waiting = false;
+				if (!running) {
+					break;
+				}
+			}
+
+			std::unique_lock<std::mutex> lock(logger.sinksMutex);
+			drain(logger.sinks);
+		}
+	}
+};
+
+Logger::Logger(size_t maxQueuedMessages)
+	: maxQueuedMessages(maxQueuedMessages)
+	, async(false)
+{
+}
+
+Logger::~Logger()
+{
+	if (asyncWriter) {
+		asyncWriter->stop();
+
+		// Write out whatever was still queued
+		std::unique_lock<std::mutex> lock(sinksMutex);
+		asyncWriter->drain(sinks);
+	}
+}
+
 void Logger::setInstance(Logger& logger)
 {
 	instance = &logger;
@@ -48,21 +252,39 @@ void Logger::setInstance(Logger& logger)
 void Logger::addSink(ILoggerSink& sink)
 {
 	Expects(instance);
+	std::unique_lock<std::mutex> lock(instance->sinksMutex);
 	instance->sinks.insert(&sink);
 }
 
 void Logger::removeSink(ILoggerSink& sink)
 {
 	Expects(instance);
+	std::unique_lock<std::mutex> lock(instance->sinksMutex);
+
+	// Hand the sink whatever was queued while it was still registered
+	if (instance->asyncWriter) {
+		instance->asyncWriter->drain(instance->sinks);
+	}
 	instance->sinks.erase(&sink);
 }
 
 void Logger::log(LoggerLevel level, const String& msg)
 {
 	if (instance) {
-		for (const auto& s: instance->sinks) {
-			s->log(level, msg);
+		if (instance->async) {
+			if (instance->asyncWriter->tryPush(level, msg)) {
+				// Async got turned off while this was being pushed, so the writer might already be gone
+				if (!instance->async) {
+					flush();
+				}
+				return;
+			}
+			if (level == LoggerLevel::Info || level == LoggerLevel::Dev) {
+				instance->asyncWriter->addDropped();
+				return;
+			}
 		}
+		instance->logNow(level, msg);
 	} else {
 		std::cout << msg << '\n';
 	}
@@ -99,7 +321,89 @@ void Logger::logError(const String& msg)
 
 void Logger::logException(const std::exception& e)
 {
-	logError(e.what());
+	if (instance) {
+		instance->logNow(LoggerLevel::Error, e.what());
+	} else {
+		logError(e.what());
+	}
+}
+
+void Logger::setAsync(bool async)
+{
+	Expects(instance);
+	if (async == instance->async) {
+		return;
+	}
+
+	if (async) {
+		// The writer is kept once created, as other threads might still be pushing to it after async gets turned off
+		if (!instance->asyncWriter) {
+			instance->asyncWriter = std::make_unique<AsyncWriter>(instance->maxQueuedMessages);
+		}
+		instance->asyncWriter->start(*instance);
+		instance->async = true;
+	} else {
+		instance->async = false;
+		instance->asyncWriter->stop();
+
+		// Write out whatever was queued before the writer stopped, or by threads that saw async just before it was turned off
+		flush();
+	}
+}
+
+bool Logger::isAsync()
+{
+	return instance && instance->async;
+}
+
+void Logger::flush()
+{
+	if (writingToSinks) {
+		// A sink flushing the logger from inside log(); whatever is writing to it flushes once it's done
+		return;
+	}
+
+	if (instance) {
+		std::unique_lock<std::mutex> lock(instance->sinksMutex);
+		if (instance->asyncWriter) {
+			instance->asyncWriter->drain(instance->sinks);
+		}
+		for (const auto& s: instance->sinks) {
+			s->flush();
+		}
+	} else {
+		std::cout.flush();
+	}
+}
+
+size_t Logger::getNumDroppedMessages()
+{
+	return instance && instance->asyncWriter ? instance->asyncWriter->getNumDropped() : 0;
+}
+
+void Logger::logNow(LoggerLevel level, const String& msg)
+{
+	// Only errors are flushed straight away, as sinks might be slow to flush and get a lot of messages
+	auto write = [&] ()
+	{
+		for (const auto& s: sinks) {
+			s->log(level, msg);
+			if (level == LoggerLevel::Error) {
+				s->flush();
+			}
+		}
+	};
+
+	if (asyncWriter && !writingToSinks) {
+		// Write out anything that was queued first, so that messages stay in order
+		std::unique_lock<std::mutex> lock(sinksMutex);
+		asyncWriter->drain(sinks);
+		WritingToSinks writing;
+		write();
+	} else {
+		// Nothing was ever queued, or this is a sink logging from inside log(), on the thread that's already writing
+		write();
+	}
 }
 
 Logger* Logger::instance = nullptr;
@@ -1,21 +1,75 @@
 #include "halley/support/profiler.h"
 
+#include "halley/text/string_converter.h"
 #include "halley/utils/algorithm.h"
 
 using namespace Halley;
 
+namespace {
+	class ProfilerNameTable {
+	public:
+		std::string_view intern(std::string_view name)
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			const auto iter = names.find(name);
+			if (iter != names.end()) {
+				return *iter;
+			}
+
+			const std::string_view result = *storage.emplace_back(std::make_unique<std::string>(name));
+			names.insert(result);
+			return result;
+		}
+
+	private:
+		std::mutex mutex;
+		Vector<std::unique_ptr<std::string>> storage;
+		HashSet<std::string_view> names;
+	};
+
+	std::atomic<uint64_t> nextCaptureId{ 1 };
+	thread_local String currentThreadName;
+
+	void appendJSONString(std::string& dst, std::string_view str)
+	{
+		dst += '"';
+		for (const char c: str) {
+			if (c == '"' || c == '\\') {
+				dst += '\\';
+				dst += c;
+			} else if (static_cast<unsigned char>(c) < 0x20) {
+				char buffer[8];
+				snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+				dst += buffer;
+			} else {
+				dst += c;
+			}
+		}
+		dst += '"';
+	}
+}
+
+ProfilerName::ProfilerName(std::string_view name)
+{
+	static ProfilerNameTable table;
+	if (!name.empty()) {
+		this->name = table.intern(name);
+	}
+}
+
 
 bool ProfilerData::ThreadInfo::operator<(const ThreadInfo& other) const
 {
 	return totalTime > other.totalTime;
 }
 
-ProfilerData::ProfilerData(TimePoint frameStartTime, TimePoint frameEndTime, Vector<Event> events)
+ProfilerData::ProfilerData(TimePoint frameStartTime, TimePoint frameEndTime, Vector<Event> events, Counters counters, ThreadNames threadNames)
 	: frameStartTime(frameStartTime)
 	, frameEndTime(frameEndTime)
 	, events(std::move(events))
+	, counters(counters)
 {
-	processEvents();
+	processEvents(threadNames);
 }
 
 ProfilerData::TimePoint ProfilerData::getStartTime() const
@@ -57,16 +111,83 @@ ProfilerData::Duration ProfilerData::getElapsedTime(ProfilerEventType eventType)
 	return end - start;
 }
 
+int64_t ProfilerData::getCounter(ProfilerCounterType type) const
+{
+	return counters[static_cast<size_t>(type)];
+}
+
 gsl::span<const ProfilerData::ThreadInfo> ProfilerData::getThreads() const
 {
 	return threads;
 }
 
-void ProfilerData::processEvents()
+String ProfilerData::toChromeTrace() const
+{
+	std::string result;
+	result.reserve(256 + events.size() * 128);
+	char buffer[128];
+	bool first = true;
+
+	auto beginEntry = [&] (const char* ph)
+	{
+		result += first ? "{\"ph\":\"" : ",{\"ph\":\"";
+		result += ph;
+		result += "\",\"pid\":1";
+		first = false;
+	};
+
+	auto appendTime = [&] (const char* key, Duration time)
+	{
+		snprintf(buffer, sizeof(buffer), ",\"%s\":%.3f", key, static_cast<double>(time.count()) / 1000.0);
+		result += buffer;
+	};
+
+	// Threads are numbered from the busiest down
+	HashMap<std::thread::id, size_t> threadIdx;
+	result += "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	for (size_t i = 0; i < threads.size(); ++i) {
+		threadIdx[threads[i].id] = i + 1;
+		const auto name = threads[i].name.isEmpty() ? "Thread " + toString(i + 1) : threads[i].name;
+		beginEntry("M");
+		snprintf(buffer, sizeof(buffer), ",\"tid\":%zu,\"name\":\"thread_name\",\"args\":{\"name\":", i + 1);
+		result += buffer;
+		appendJSONString(result, name.cppStr());
+		result += "}}";
+		beginEntry("M");
+		snprintf(buffer, sizeof(buffer), ",\"tid\":%zu,\"name\":\"thread_sort_index\",\"args\":{\"sort_index\":%zu}}", i + 1, i);
+		result += buffer;
+	}
+
+	for (const auto& e: events) {
+		const char* typeName = EnumNames<ProfilerEventType>()()[static_cast<size_t>(e.type)];
+		beginEntry("X");
+		snprintf(buffer, sizeof(buffer), ",\"tid\":%zu,\"name\":", threadIdx[e.threadId]);
+		result += buffer;
+		appendJSONString(result, e.name.empty() ? std::string_view(typeName) : e.name);
+		result += ",\"cat\":";
+		appendJSONString(result, typeName);
+		appendTime("ts", e.startTime - frameStartTime);
+		appendTime("dur", e.endTime - e.startTime);
+		result += '}';
+	}
+
+	beginEntry("C");
+	result += ",\"name\":\"counters\"";
+	appendTime("ts", frameEndTime - frameStartTime);
+	result += ",\"args\":{";
+	for (size_t i = 0; i < counters.size(); ++i) {
+		snprintf(buffer, sizeof(buffer), "%s\"%s\":%lld", i == 0 ? "" : ",", EnumNames<ProfilerCounterType>()()[i], static_cast<long long>(counters[i]));
+		result += buffer;
+	}
+	result += "}}]}";
+
+	return String(std::move(result));
+}
+
+void ProfilerData::processEvents(const ThreadNames& threadNames)
 {
 	struct ThreadCurInfo {
-		size_t maxDepth = 0;
-		Vector<TimePoint> stackEnds;
+		int maxDepth = 0;
 		TimePoint start;
 		TimePoint end;
 		Duration totalTime;
@@ -74,32 +195,21 @@ void ProfilerData::processEvents()
 	};
 	HashMap<std::thread::id, ThreadCurInfo> threadInfo;
 
+	// Events are read in the order they end, so put parents back before their children
+	std::sort(events.begin(), events.end(), [] (const Event& a, const Event& b)
+	{
+		return a.startTime != b.startTime ? a.startTime < b.startTime : a.depth < b.depth;
+	});
+
 	// Process each event
 	for (auto& e: events) {
 		auto& curThread = threadInfo[e.threadId];
-
-		// Normalize ends
-		if (e.startTime == TimePoint{}) {
-			e.startTime = frameStartTime;
-		}
-		if (e.endTime == TimePoint{}) {
-			e.endTime = frameEndTime;
-		}
-
-		// Compute depth
-		// If this event starts after the end of the previous stack, then it's not nested in it, pop previous.
-		// Repeat for as many levels as needed, up to the root
-		while (!curThread.stackEnds.empty() && e.startTime >= curThread.stackEnds.back()) {
-			curThread.stackEnds.pop_back();
-		}
-		const auto depth = curThread.stackEnds.size();
-		curThread.maxDepth = std::max(curThread.maxDepth, depth);
-		e.depth = static_cast<int>(depth);
-		curThread.stackEnds.push_back(e.endTime);
+		curThread.maxDepth = std::max(curThread.maxDepth, e.depth);
 
 		// Store timing
 		if (curThread.first) {
 			curThread.start = e.startTime;
+			curThread.first = false;
 		} else {
 			curThread.start = std::min(curThread.start, e.startTime);
 		}
@@ -111,19 +221,91 @@ void ProfilerData::processEvents()
 
 	// Generate the thread list
 	for (const auto& [k, v]: threadInfo) {
-		const String name; // TODO
-		threads.emplace_back(ThreadInfo{ k, static_cast<int>(v.maxDepth), name, v.start, v.end, v.totalTime });
+		const auto nameIter = std::find_if(threadNames.begin(), threadNames.end(), [&] (const auto& n) { return n.first == k; });
+		const String name = nameIter != threadNames.end() ? nameIter->second : String();
+		threads.emplace_back(ThreadInfo{ k, v.maxDepth, name, v.start, v.end, v.totalTime });
 	}
 	std::sort(threads.begin(), threads.end());
 }
 
-ProfilerCapture::ProfilerCapture(size_t maxEvents)
-	: recording(false)
-	, curId(0)
+class ProfilerCapture::ThreadBuffer {
+public:
+	struct Record {
+		ProfilerData::TimePoint time;
+		std::string_view name;
+		ProfilerEventType type;
+		int depth;
+		bool isStart;
+	};
+
+	const std::thread::id threadId;
+	std::atomic<bool> threadExited{ false };
+
+	// Only used by the thread that owns the buffer
+	int depth = 0;
+
+	// Only used by the reader, holding events that have started but not ended yet
+	Vector<ProfilerData::Event> openEvents;
+
+	ThreadBuffer(size_t size)
+		: threadId(std::this_thread::get_id())
+		, records(size)
+	{}
+
+	bool push(const Record& record)
+	{
+		const auto h = head.load(std::memory_order_relaxed);
+		if (h - tail.load(std::memory_order_acquire) >= records.size()) {
+			dropped.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+		records[h % records.size()] = record;
+		head.store(h + 1, std::memory_order_release);
+		return true;
+	}
+
+	template <typename F>
+	void read(F f)
+	{
+		const auto t = tail.load(std::memory_order_relaxed);
+		const auto h = head.load(std::memory_order_acquire);
+		for (auto i = t; i < h; ++i) {
+			f(records[i % records.size()]);
+		}
+		tail.store(h, std::memory_order_release);
+	}
+
+	bool isEmpty() const
+	{
+		return head.load(std::memory_order_acquire) == tail.load(std::memory_order_relaxed);
+	}
+
+	size_t getNumDropped() const
+	{
+		return dropped.load(std::memory_order_relaxed);
+	}
+
+private:
+	Vector<Record> records;
+	alignas(64) std::atomic<uint64_t> head{ 0 };
+	alignas(64) std::atomic<uint64_t> tail{ 0 };
+	std::atomic<size_t> dropped{ 0 };
+};
+
+ProfilerCapture::ProfilerCapture(size_t maxEventsPerThread, size_t maxSessionEvents)
+	: captureId(nextCaptureId++)
+	, maxEventsPerThread(maxEventsPerThread)
+	, maxSessionEvents(maxSessionEvents)
+	, recording(false)
 {
-	events.resize(maxEvents);
+	Expects(maxEventsPerThread > 0);
+	for (auto& c: counters) {
+		c = 0;
+	}
 }
 
+ProfilerCapture::~ProfilerCapture() = default;
+
 ProfilerCapture& ProfilerCapture::get()
 {
 	// TODO: move to HalleyStatics?
@@ -131,18 +313,20 @@ ProfilerCapture& ProfilerCapture::get()
 	return profiler;
 }
 
-ProfilerCapture::EventId ProfilerCapture::recordEventStart(ProfilerEventType type, std::string_view name)
+void ProfilerCapture::setThreadName(String name)
+{
+	currentThreadName = std::move(name);
+}
+
+ProfilerCapture::EventId ProfilerCapture::recordEventStart(ProfilerEventType type, ProfilerName name)
 {
 	if (recording) {
-		const auto id = curId++; // I think this is thread-safe?
-		if (id < endId) {
-			const auto pos = id % events.size();
-			const auto threadId = std::this_thread::get_id();
-			const auto time = std::chrono::steady_clock::now();
-			events[pos] = ProfilerData::Event{ name, threadId, type, 0, id, time, {} };
-			return id;
-		} else {
-			--curId;
+		auto& buffer = getThreadBuffer();
+		const int depth = buffer.depth;
+		if (buffer.push(ThreadBuffer::Record{ std::chrono::steady_clock::now(), name.getString(), type, depth, true })) {
+			// The id is the depth, so the end can be matched up with the start even if other records are lost
+			++buffer.depth;
+			return static_cast<EventId>(depth) + 1;
 		}
 	}
 	return 0;
@@ -150,15 +334,20 @@ ProfilerCapture::EventId ProfilerCapture::recordEventStart(ProfilerEventType typ
 
 void ProfilerCapture::recordEventEnd(EventId id)
 {
-	if (recording && id != 0) {
-		const auto time = std::chrono::steady_clock::now();
-		const auto pos = id % events.size();
-		if (events[pos].id == id) { // Dodgy, potential race condition here
-			events[pos].endTime = time;
-		}
+	// Ends are recorded even if recording stopped since the start, so that the event gets closed
+	if (id != 0) {
+		auto& buffer = getThreadBuffer();
+		const int depth = static_cast<int>(id - 1);
+		buffer.depth = depth;
+		buffer.push(ThreadBuffer::Record{ std::chrono::steady_clock::now(), {}, ProfilerEventType::Game, depth, false });
 	}
 }
 
+void ProfilerCapture::addCounter(ProfilerCounterType type, int64_t value)
+{
+	counters[static_cast<size_t>(type)].fetch_add(value, std::memory_order_relaxed);
+}
+
 bool ProfilerCapture::isRecording() const
 {
 	return recording;
@@ -174,11 +363,9 @@ void ProfilerCapture::startFrame(bool rec)
 		frameStartTime = frameEndTime;
 	}
 	frameEndTime = {};
+	frameEvents.clear();
 
-	startId = curId.fetch_add(events.size()) + events.size();
-	endId = startId + events.size();
-
-	recording = rec;
+	recording = rec || capturingContinuously;
 	state = State::FrameStarted;
 }
 
@@ -187,6 +374,26 @@ void ProfilerCapture::endFrame()
 	Expects(state == State::FrameStarted);
 	
 	frameEndTime = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < counters.size(); ++i) {
+		frameCounters[i] = counters[i].exchange(0, std::memory_order_relaxed);
+	}
+	readThreadBuffers();
+
+	if (capturingContinuously) {
+		for (const auto& e: frameEvents) {
+			if (e.startTime >= sessionStartTime) {
+				if (sessionEvents.size() < maxSessionEvents) {
+					sessionEvents.push_back(e);
+				} else {
+					droppedSessionEvents.fetch_add(1, std::memory_order_relaxed);
+				}
+			}
+		}
+		for (size_t i = 0; i < counters.size(); ++i) {
+			sessionCounters[i] += frameCounters[i];
+		}
+	}
+
 	state = State::FrameEnded;
 }
 
@@ -194,18 +401,31 @@ ProfilerData ProfilerCapture::getCapture()
 {
 	Expects(state == State::FrameEnded);
 
-	const auto startIdx = startId % events.size();
-	const auto endIdx = curId % events.size();
+	// Trim to the frame, with events that are still going ending with it
+	Vector<ProfilerData::Event> events;
+	events.reserve(frameEvents.size());
+	auto addEvent = [&] (ProfilerData::Event e)
+	{
+		if (e.endTime >= frameStartTime) {
+			e.startTime = std::max(e.startTime, frameStartTime);
+			events.push_back(e);
+		}
+	};
 
-	Vector<ProfilerData::Event> eventsCopy;
-	if (startIdx < endIdx) {
-		eventsCopy.insert(eventsCopy.end(), events.begin() + startIdx, events.begin() + endIdx);
-	} else {
-		eventsCopy.insert(eventsCopy.end(), events.begin() + startIdx, events.end());
-		eventsCopy.insert(eventsCopy.end(), events.begin(), events.begin() + endIdx);
+	for (const auto& e: frameEvents) {
+		addEvent(e);
+	}
+	{
+		std::unique_lock<std::mutex> lock(threadBuffersMutex);
+		for (const auto& buffer: threadBuffers) {
+			for (auto e: buffer->openEvents) {
+				e.endTime = frameEndTime;
+				addEvent(e);
+			}
+		}
 	}
 	
-	return ProfilerData(frameStartTime, frameEndTime, std::move(eventsCopy));
+	return ProfilerData(frameStartTime, frameEndTime, std::move(events), frameCounters, getThreadNames());
 }
 
 Time ProfilerCapture::getFrameTime() const
@@ -215,6 +435,119 @@ Time ProfilerCapture::getFrameTime() const
 	return std::chrono::duration<Time>(frameEndTime - frameStartTime).count();
 }
 
+void ProfilerCapture::startContinuousCapture()
+{
+	Expects(!capturingContinuously);
+
+	capturingContinuously = true;
+	sessionStartTime = std::chrono::steady_clock::now();
+	sessionEvents.clear();
+	sessionCounters = {};
+	recording = true;
+}
+
+bool ProfilerCapture::isCapturingContinuously() const
+{
+	return capturingContinuously;
+}
+
+ProfilerData ProfilerCapture::stopContinuousCapture()
+{
+	Expects(capturingContinuously);
+
+	// The capture covers every frame that has ended since it started
+	capturingContinuously = false;
+	if (state != State::FrameEnded) {
+		recording = false;
+	}
+	const auto endTime = std::max(sessionStartTime, state == State::FrameEnded ? frameEndTime : frameStartTime);
+	return ProfilerData(sessionStartTime, endTime, std::move(sessionEvents), sessionCounters, getThreadNames());
+}
+
+size_t ProfilerCapture::getNumDroppedEvents() const
+{
+	std::unique_lock<std::mutex> lock(threadBuffersMutex);
+	size_t total = droppedEventsFromExitedThreads + droppedSessionEvents.load(std::memory_order_relaxed);
+	for (const auto& buffer: threadBuffers) {
+		total += buffer->getNumDropped();
+	}
+	return total;
+}
+
+ProfilerCapture::ThreadBuffer& ProfilerCapture::getThreadBuffer()
+{
+	struct CachedBuffer {
+		uint64_t captureId = 0;
+		std::shared_ptr<ThreadBuffer> buffer;
+
+		~CachedBuffer()
+		{
+			if (buffer) {
+				buffer->threadExited = true;
+			}
+		}
+	};
+	static thread_local CachedBuffer cached;
+
+	if (cached.captureId != captureId) {
+		// First event on this thread for this capture, or the thread has been switching between captures
+		std::unique_lock<std::mutex> lock(threadBuffersMutex);
+		const auto threadId = std::this_thread::get_id();
+		const auto iter = std::find_if(threadBuffers.begin(), threadBuffers.end(), [&] (const auto& b) { return b->threadId == threadId && !b->threadExited; });
+		if (iter != threadBuffers.end()) {
+			cached.buffer = *iter;
+		} else {
+			cached.buffer = std::make_shared<ThreadBuffer>(maxEventsPerThread);
+			threadBuffers.push_back(cached.buffer);
+
+			// Names are kept apart from the buffers, so that threads that have exited still get named in captures
+			std_ex::erase_if(threadNames, [&] (const auto& n) { return n.first == threadId; });
+			if (!currentThreadName.isEmpty()) {
+				threadNames.emplace_back(threadId, currentThreadName);
+			}
+		}
+		cached.captureId = captureId;
+	}
+	return *cached.buffer;
+}
+
+void ProfilerCapture::readThreadBuffers()
+{
+	std::unique_lock<std::mutex> lock(threadBuffersMutex);
+
+	for (auto& buffer: threadBuffers) {
+		auto& openEvents = buffer->openEvents;
+		buffer->read([&] (const ThreadBuffer::Record& record)
+		{
+			// Anything open at this depth or deeper ends here. Usually that's just the event being ended, but it also closes events whose end didn't fit in the buffer.
+			while (openEvents.size() > static_cast<size_t>(record.depth)) {
+				auto& e = frameEvents.emplace_back(openEvents.back());
+				e.endTime = record.time;
+				openEvents.pop_back();
+			}
+			if (record.isStart) {
+				openEvents.push_back(ProfilerData::Event{ record.name, buffer->threadId, record.type, record.depth, record.time, {} });
+			}
+		});
+	}
+
+	// Forget threads that are gone, once everything they recorded has been read
+	std_ex::erase_if(threadBuffers, [&] (const std::shared_ptr<ThreadBuffer>& buffer)
+	{
+		if (buffer->threadExited && buffer->isEmpty()) {
+			droppedEventsFromExitedThreads += buffer->getNumDropped();
+			return true;
+		}
+		return false;
+	});
+}
+
+ProfilerData::ThreadNames ProfilerCapture::getThreadNames() const
+{
+	std::unique_lock<std::mutex> lock(threadBuffersMutex);
+	return threadNames;
+}
+
 constexpr static bool isDevMode()
 {
 #ifdef DEV_BUILD
@@ -238,6 +571,16 @@ constexpr static bool alwaysLogType(ProfilerEventType type)
 }
 
 ProfilerEvent::ProfilerEvent(ProfilerEventType type, std::string_view name)
+{
+	if (isDevMode() || alwaysLogType(type)) {
+		auto& capture = ProfilerCapture::get();
+		if (capture.isRecording()) {
+			id = capture.recordEventStart(type, ProfilerName(name));
+		}
+	}
+}
+
+ProfilerEvent::ProfilerEvent(ProfilerEventType type, ProfilerName name)
 {
 	if (isDevMode() || alwaysLogType(type)) {
 		id = ProfilerCapture::get().recordEventStart(type, name);
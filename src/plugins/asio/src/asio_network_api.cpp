@@ -4,12 +4,23 @@
 
 using namespace Halley;
 
-std::unique_ptr<NetworkService> AsioNetworkAPI::createService(NetworkProtocol protocol, int port)
+AsioNetworkAPI::AsioNetworkAPI(SystemAPI* system)
+	: system(system)
+{}
+
+std::unique_ptr<NetworkService> AsioNetworkAPI::createService(NetworkProtocol protocol, int port, NetworkServiceOptions options)
 {
 	if (protocol == NetworkProtocol::TCP) {
 		return std::make_unique<AsioTCPNetworkService>(port);
 	} else if (protocol == NetworkProtocol::UDP) {
-		return std::make_unique<AsioUDPNetworkService>(port);
+		AsioUDPNetworkService::MakeThread makeThread;
+		if (system) {
+			makeThread = [system = system] (String name, std::function<void()> runnable)
+			{
+				return system->createThread(name, ThreadPriority::High, std::move(runnable));
+			};
+		}
+		return std::make_unique<AsioUDPNetworkService>(port, IPVersion::IPv4, options.threadedIO, std::move(makeThread));
 	} else {
 		return {};
 	}
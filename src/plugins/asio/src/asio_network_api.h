@@ -6,8 +6,13 @@ namespace Halley
 	class AsioNetworkAPI : public NetworkAPIInternal
 	{
 	public:
-		std::unique_ptr<NetworkService> createService(NetworkProtocol protocol, int port) override;
+		explicit AsioNetworkAPI(SystemAPI* system);
+
+		std::unique_ptr<NetworkService> createService(NetworkProtocol protocol, int port, NetworkServiceOptions options) override;
 		void init() override;
 		void deInit() override;
+
+	private:
+		SystemAPI* system;
 	};
 }
@@ -1,5 +1,6 @@
 #include <iostream>
 #include "asio_udp_connection.h"
+#include "asio_udp_io_thread.h"
 #include "halley/net/connection/network_packet.h"
 
 using namespace Halley;
@@ -20,9 +21,10 @@ struct HandshakeAccept
 
 
 
-AsioUDPConnection::AsioUDPConnection(UDPSocket& socket, UDPEndpoint remote)
+AsioUDPConnection::AsioUDPConnection(UDPSocket& socket, UDPEndpoint remote, AsioUDPIOThread* ioThread)
 	: socket(socket)
 	, remote(remote)
+	, ioThread(ioThread)
 	, status(ConnectionStatus::Connecting)
 	, connectionId(0)
 {
@@ -63,6 +65,11 @@ void AsioUDPConnection::send(TransmissionType type, OutboundNetworkPacket packet
 		}
 		packet.addHeader(gsl::as_bytes(gsl::span<unsigned char>(id).subspan(0, len)));
 
+		if (ioThread) {
+			ioThread->send(remote, std::move(packet));
+			return;
+		}
+
 		bool needsSend = pendingSend.empty();
 		pendingSend.emplace_back(std::move(packet));
 		if (needsSend) {
@@ -87,11 +94,12 @@ bool AsioUDPConnection::matchesEndpoint(const UDPEndpoint& remoteEndpoint) const
 	return remote == remoteEndpoint;
 }
 
-void AsioUDPConnection::onReceive(gsl::span<const gsl::byte> data)
+void AsioUDPConnection::onReceive(InboundNetworkPacket packet)
 {
-	Expects(data.size() <= 1500);
+	Expects(packet.getSize() <= 1500);
 
 	if (status == ConnectionStatus::Connecting) {
+		const auto data = packet.getBytes();
 		if (data.size_bytes() == sizeof(HandshakeAccept)) {
 			HandshakeAccept accept;
 			if (memcmp(data.data(), &accept, sizeof(accept.handshake)) == 0) {
@@ -101,8 +109,8 @@ void AsioUDPConnection::onReceive(gsl::span<const gsl::byte> data)
 			}
 		}
 	} else if (status == ConnectionStatus::Connected) {
-		if (data.size() <= 1500) {
-			pendingReceive.push_back(InboundNetworkPacket(data));
+		if (packet.getSize() <= 1500) {
+			pendingReceive.push_back(std::move(packet));
 		}
 	}
 }
@@ -137,12 +145,11 @@ void AsioUDPConnection::sendNext()
 		return;
 	}
 
-	auto& packet = pendingSend.front();
-	size_t size = packet.copyTo(sendBuffer);
-	pendingSend.pop_front();
-
-	socket.async_send_to(boost::asio::buffer(sendBuffer, size), remote, [this] (const boost::system::error_code& error, std::size_t)
+	// The packet stays at the front of the queue until it's sent, so asio can read straight from its buffer
+	const auto bytes = pendingSend.front().getBytes();
+	socket.async_send_to(boost::asio::buffer(bytes.data(), bytes.size_bytes()), remote, [this] (const boost::system::error_code& error, std::size_t)
 	{
+		pendingSend.pop_front();
 		if (error) {
 			std::cout << "Error sending packet: " << error.message() << std::endl;
 			close();
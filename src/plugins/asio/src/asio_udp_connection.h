@@ -18,13 +18,14 @@
 namespace Halley
 {
 	class NetworkService;
+	class AsioUDPIOThread;
 	using UDPEndpoint = boost::asio::ip::udp::endpoint;
 	using UDPSocket = boost::asio::ip::udp::socket;
 
 	class AsioUDPConnection : public IConnection
 	{
 	public:
-		AsioUDPConnection(UDPSocket& socket, UDPEndpoint remote);
+		AsioUDPConnection(UDPSocket& socket, UDPEndpoint remote, AsioUDPIOThread* ioThread = nullptr);
 
 		void close() override;
 		ConnectionStatus getStatus() const override { return status; }
@@ -33,7 +34,7 @@ namespace Halley
 		bool receive(InboundNetworkPacket& packet) override;
 		
 		bool matchesEndpoint(const UDPEndpoint& remoteEndpoint) const;
-		void onReceive(gsl::span<const gsl::byte> data);
+		void onReceive(InboundNetworkPacket packet);
 		void setError(const std::string& cs);
 		
 		void open(short connectionId);
@@ -44,12 +45,12 @@ namespace Halley
 	private:
 		UDPSocket& socket;
 		UDPEndpoint remote;
+		AsioUDPIOThread* ioThread;
 		ConnectionStatus status;
 		short connectionId;
 
 		std::deque<OutboundNetworkPacket> pendingSend;
 		std::deque<InboundNetworkPacket> pendingReceive;
-		std::array<gsl::byte, 2048> sendBuffer;
 		std::string error;
 
 		void sendNext();
@@ -0,0 +1,238 @@
+#include "asio_udp_io_thread.h"
+#include "halley/support/exception.h"
+#include "halley/support/logger.h"
+#include "halley/text/string_converter.h"
+
+#ifdef __linux__
+#include <sys/socket.h>
+#include <errno.h>
+#endif
+#ifndef _WIN32
+#include <poll.h>
+#endif
+
+using namespace Halley;
+
+AsioUDPIOThread::AsioUDPIOThread(UDPSocket& socket, const MakeThread& makeThread)
+	: socket(socket)
+	, running(true)
+	, inbound(queueSize)
+	, outbound(queueSize)
+	, receivedDatagrams(0)
+	, receiveCalls(0)
+	, sentDatagrams(0)
+	, sendCalls(0)
+	, droppedDatagrams(0)
+{
+	sending.reserve(batchSize);
+
+	boost::system::error_code ec;
+	socket.non_blocking(true, ec);
+	if (ec) {
+		throw Exception("Unable to make UDP socket non-blocking: " + String(ec.message()), HalleyExceptions::NetworkPlugin);
+	}
+
+	auto runnable = [this] () { run(); };
+	thread = makeThread ? makeThread("Network", runnable) : std::thread(runnable);
+}
+
+AsioUDPIOThread::~AsioUDPIOThread()
+{
+	running = false;
+	if (thread.joinable()) {
+		thread.join();
+	}
+}
+
+bool AsioUDPIOThread::send(UDPEndpoint remote, OutboundNetworkPacket packet)
+{
+	if (!outbound.canWrite(1)) {
+		++droppedDatagrams;
+		return false;
+	}
+	outbound.writeOne(OutboundDatagram{ remote, std::move(packet) });
+	return true;
+}
+
+bool AsioUDPIOThread::receive(InboundDatagram& datagram)
+{
+	if (inbound.empty()) {
+		return false;
+	}
+	datagram = inbound.readOne();
+	return true;
+}
+
+AsioUDPIOThread::Stats AsioUDPIOThread::getStats() const
+{
+	Stats result;
+	result.receivedDatagrams = receivedDatagrams;
+	result.receiveCalls = receiveCalls;
+	result.sentDatagrams = sentDatagrams;
+	result.sendCalls = sendCalls;
+	result.droppedDatagrams = droppedDatagrams;
+	return result;
+}
+
+void AsioUDPIOThread::run()
+{
+	while (running) {
+		// Sends are picked up from the queue at least once per millisecond
+		const bool hasPendingSends = !sending.empty() || !outbound.empty();
+		waitForSocket(hasPendingSends && !sendBlocked ? 0 : 1);
+
+		while (receiveBatch() == batchSize) {}
+		while (sendBatch() > 0) {}
+	}
+}
+
+void AsioUDPIOThread::waitForSocket(int timeoutMs)
+{
+#ifdef _WIN32
+	WSAPOLLFD fd = {};
+	fd.fd = socket.native_handle();
+	fd.events = POLLRDNORM | (sendBlocked ? POLLWRNORM : 0);
+	WSAPoll(&fd, 1, timeoutMs);
+#else
+	pollfd fd = {};
+	fd.fd = socket.native_handle();
+	fd.events = POLLIN | (sendBlocked ? POLLOUT : 0);
+	::poll(&fd, 1, timeoutMs);
+#endif
+}
+
+size_t AsioUDPIOThread::receiveBatch()
+{
+	for (auto& buffer: receiveBuffers) {
+		if (!buffer.isValid()) {
+			buffer = NetworkPacketBufferPool::get().acquire();
+		}
+	}
+
+#ifdef __linux__
+	std::array<mmsghdr, batchSize> msgs;
+	std::array<iovec, batchSize> iovecs;
+	std::array<UDPEndpoint, batchSize> endpoints;
+	for (size_t i = 0; i < batchSize; ++i) {
+		const auto span = receiveBuffers[i].getSpan();
+		iovecs[i].iov_base = span.data();
+		iovecs[i].iov_len = span.size_bytes();
+
+		msgs[i] = {};
+		msgs[i].msg_hdr.msg_name = endpoints[i].data();
+		msgs[i].msg_hdr.msg_namelen = socklen_t(endpoints[i].capacity());
+		msgs[i].msg_hdr.msg_iov = &iovecs[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	++receiveCalls;
+	const int n = recvmmsg(socket.native_handle(), msgs.data(), static_cast<unsigned int>(batchSize), MSG_DONTWAIT, nullptr);
+	if (n < 0) {
+		if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+			// Errors on an unconnected socket can't be tied to a peer, their connections will time out instead
+			Logger::logWarning("Error receiving UDP packets: " + toString(errno));
+		}
+		return 0;
+	}
+
+	for (int i = 0; i < n; ++i) {
+		endpoints[i].resize(msgs[i].msg_hdr.msg_namelen);
+		onReceived(endpoints[i], std::move(receiveBuffers[i]), msgs[i].msg_len);
+	}
+	return size_t(n);
+#else
+	size_t n = 0;
+	for (auto& buffer: receiveBuffers) {
+		const auto span = buffer.getSpan();
+		UDPEndpoint remote;
+		boost::system::error_code ec;
+		++receiveCalls;
+		const size_t size = socket.receive_from(boost::asio::buffer(span.data(), span.size_bytes()), remote, 0, ec);
+		if (ec) {
+			if (ec != boost::asio::error::would_block) {
+				Logger::logWarning("Error receiving UDP packets: " + String(ec.message()));
+			}
+			break;
+		}
+		onReceived(remote, std::move(buffer), size);
+		++n;
+	}
+	return n;
+#endif
+}
+
+void AsioUDPIOThread::onReceived(UDPEndpoint remote, NetworkPacketBuffer buffer, size_t size)
+{
+	++receivedDatagrams;
+	if (inbound.canWrite(1)) {
+		inbound.writeOne(InboundDatagram{ remote, InboundNetworkPacket(std::move(buffer), 0, size) });
+	} else {
+		++droppedDatagrams;
+	}
+}
+
+size_t AsioUDPIOThread::sendBatch()
+{
+	// Anything the socket didn't take last time is still at the front
+	while (sending.size() < batchSize && !outbound.empty()) {
+		sending.push_back(outbound.readOne());
+	}
+	if (sending.empty()) {
+		return 0;
+	}
+
+#ifdef __linux__
+	std::array<mmsghdr, batchSize> msgs;
+	std::array<iovec, batchSize> iovecs;
+	for (size_t i = 0; i < sending.size(); ++i) {
+		const auto bytes = sending[i].packet.getBytes();
+		iovecs[i].iov_base = const_cast<gsl::byte*>(bytes.data());
+		iovecs[i].iov_len = bytes.size_bytes();
+
+		msgs[i] = {};
+		msgs[i].msg_hdr.msg_name = sending[i].remote.data();
+		msgs[i].msg_hdr.msg_namelen = socklen_t(sending[i].remote.size());
+		msgs[i].msg_hdr.msg_iov = &iovecs[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	++sendCalls;
+	int n = sendmmsg(socket.native_handle(), msgs.data(), static_cast<unsigned int>(sending.size()), MSG_DONTWAIT);
+	if (n < 0) {
+		if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+			sendBlocked = errno != EINTR;
+			return 0;
+		}
+		// Drop the datagram that failed, so it doesn't hold up the rest
+		Logger::logWarning("Error sending UDP packet: " + toString(errno));
+		n = 1;
+	} else {
+		sentDatagrams += size_t(n);
+	}
+#else
+	int n = 0;
+	for (auto& datagram: sending) {
+		const auto bytes = datagram.packet.getBytes();
+		boost::system::error_code ec;
+		++sendCalls;
+		socket.send_to(boost::asio::buffer(bytes.data(), bytes.size_bytes()), datagram.remote, 0, ec);
+		if (ec == boost::asio::error::would_block) {
+			break;
+		}
+		if (ec) {
+			Logger::logWarning("Error sending UDP packet: " + String(ec.message()));
+		} else {
+			++sentDatagrams;
+		}
+		++n;
+	}
+	if (n == 0) {
+		sendBlocked = true;
+		return 0;
+	}
+#endif
+
+	sendBlocked = false;
+	sending.erase(sending.begin(), sending.begin() + n);
+	return size_t(n);
+}
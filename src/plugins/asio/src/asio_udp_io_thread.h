@@ -0,0 +1,82 @@
+#pragma once
+
+#include "asio_udp_connection.h"
+#include "halley/data_structures/vector.h"
+#include "halley/data_structures/ring_buffer.h"
+#include "halley/text/halleystring.h"
+
+#include <atomic>
+#include <functional>
+#include <thread>
+
+namespace Halley
+{
+	// Runs all I/O for a UDP socket on a thread of its own. Datagrams are passed to and from the game thread through
+	// lock-free single producer/single consumer queues, so send() and receive() must only be called from one thread.
+	// On Linux, datagrams are received and sent in batches with recvmmsg/sendmmsg.
+	class AsioUDPIOThread
+	{
+	public:
+		using MakeThread = std::function<std::thread(String, std::function<void()>)>;
+
+		struct InboundDatagram
+		{
+			UDPEndpoint remote;
+			InboundNetworkPacket packet;
+		};
+
+		struct OutboundDatagram
+		{
+			UDPEndpoint remote;
+			OutboundNetworkPacket packet;
+		};
+
+		struct Stats
+		{
+			size_t receivedDatagrams = 0;
+			size_t receiveCalls = 0;
+			size_t sentDatagrams = 0;
+			size_t sendCalls = 0;
+			size_t droppedDatagrams = 0; // Queues were full
+		};
+
+		constexpr static size_t batchSize = 32;
+		constexpr static size_t queueSize = 4096;
+
+		AsioUDPIOThread(UDPSocket& socket, const MakeThread& makeThread);
+		~AsioUDPIOThread();
+
+		AsioUDPIOThread(const AsioUDPIOThread& other) = delete;
+		AsioUDPIOThread& operator=(const AsioUDPIOThread& other) = delete;
+
+		bool send(UDPEndpoint remote, OutboundNetworkPacket packet);
+		bool receive(InboundDatagram& datagram);
+
+		Stats getStats() const;
+
+	private:
+		UDPSocket& socket;
+		std::thread thread;
+		std::atomic<bool> running;
+
+		RingBuffer<InboundDatagram> inbound;
+		RingBuffer<OutboundDatagram> outbound;
+
+		// Only touched by the I/O thread
+		std::array<NetworkPacketBuffer, batchSize> receiveBuffers;
+		Vector<OutboundDatagram> sending;
+		bool sendBlocked = false;
+
+		std::atomic<size_t> receivedDatagrams;
+		std::atomic<size_t> receiveCalls;
+		std::atomic<size_t> sentDatagrams;
+		std::atomic<size_t> sendCalls;
+		std::atomic<size_t> droppedDatagrams;
+
+		void run();
+		void waitForSocket(int timeoutMs);
+		size_t receiveBatch();
+		size_t sendBatch();
+		void onReceived(UDPEndpoint remote, NetworkPacketBuffer buffer, size_t size);
+	};
+}
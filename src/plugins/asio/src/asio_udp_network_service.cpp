@@ -23,12 +23,16 @@ struct HandshakeOpen
 
 
 
-AsioUDPNetworkService::AsioUDPNetworkService(int port, IPVersion version)
+AsioUDPNetworkService::AsioUDPNetworkService(int port, IPVersion version, bool threadedIO, MakeThread makeThread)
 	: localEndpoint(version == IPVersion::IPv4 ? asio::ip::udp::v4() : asio::ip::udp::v6(), static_cast<unsigned short>(port))
 	, socket(service, localEndpoint)
 {
 	Expects(port == 0 || port > 1024);
 	Expects(port < 65536);
+
+	if (threadedIO) {
+		ioThread = std::make_unique<AsioUDPIOThread>(socket, makeThread);
+	}
 }
 
 
@@ -42,6 +46,7 @@ AsioUDPNetworkService::~AsioUDPNetworkService()
 		}
 	}
 	try {
+		ioThread.reset();
 		service.poll();
 		socket.shutdown(UDPSocket::shutdown_both);
 	} catch (...) {
@@ -68,6 +73,9 @@ void AsioUDPNetworkService::update(Time t)
 	}
 
 	// Update service
+	if (ioThread) {
+		receiveFromIOThread();
+	}
 	service.poll();
 }
 
@@ -81,7 +89,7 @@ std::shared_ptr<IConnection> AsioUDPNetworkService::connect(const String& addres
 	assert(port < 65536);
 	auto remoteAddr = asio::ip::address::from_string(addr.cppStr());
 	auto remote = UDPEndpoint(remoteAddr, static_cast<unsigned short>(port)); 
-	auto conn = std::make_shared<AsioUDPConnection>(socket, remote);
+	auto conn = std::make_shared<AsioUDPConnection>(socket, remote, ioThread.get());
 	activeConnections[0] = conn;
 
 	// Handshake
@@ -98,7 +106,9 @@ String AsioUDPNetworkService::startListening(AcceptCallback callback)
 	acceptCallback = std::move(callback);
 	if (!startedListening) {
 		startedListening = true;
-		receiveNext();
+		if (!ioThread) {
+			receiveNext();
+		}
 	}
 	return "";
 }
@@ -110,11 +120,13 @@ void AsioUDPNetworkService::stopListening()
 
 void AsioUDPNetworkService::receiveNext()
 {
-	auto buffer = asio::buffer(receiveBuffer);
-	socket.async_receive_from(buffer, remoteEndpoint, [this] (const boost::system::error_code& error, size_t size)
+	// Receive into a pooled buffer, which the packet then holds on to; if nobody keeps the packet, it goes back to the pool
+	receiveBuffer = NetworkPacketBufferPool::get().acquire();
+	const auto dst = receiveBuffer.getSpan();
+	socket.async_receive_from(asio::buffer(dst.data(), dst.size_bytes()), remoteEndpoint, [this] (const boost::system::error_code& error, size_t size)
 	{
 		try {
-			Expects(size <= receiveBuffer.size());
+			Expects(size <= receiveBuffer.getCapacity());
 
 			std::string errorMsg;
 			std::string* errorMsgPtr = nullptr;
@@ -123,7 +135,7 @@ void AsioUDPNetworkService::receiveNext()
 				errorMsgPtr = &errorMsg;
 			}
 
-			receivePacket(gsl::span<gsl::byte>(receiveBuffer.data(), size), errorMsgPtr);
+			receivePacket(InboundNetworkPacket(std::move(receiveBuffer), 0, size), errorMsgPtr);
 		} catch (...) {
 			std::cout << "Exception while receiving a packet." << std::endl;
 		}
@@ -132,7 +144,33 @@ void AsioUDPNetworkService::receiveNext()
 	});
 }
 
-void AsioUDPNetworkService::receivePacket(gsl::span<gsl::byte> received, std::string* error)
+void AsioUDPNetworkService::receiveFromIOThread()
+{
+	AsioUDPIOThread::InboundDatagram datagram;
+	while (ioThread->receive(datagram)) {
+		try {
+			remoteEndpoint = datagram.remote;
+			receivePacket(std::move(datagram.packet), nullptr);
+		} catch (...) {
+			std::cout << "Exception while receiving a packet." << std::endl;
+		}
+	}
+}
+
+std::optional<AsioUDPIOThread::Stats> AsioUDPNetworkService::getIOThreadStats() const
+{
+	if (ioThread) {
+		return ioThread->getStats();
+	}
+	return {};
+}
+
+int AsioUDPNetworkService::getLocalPort() const
+{
+	return socket.local_endpoint().port();
+}
+
+void AsioUDPNetworkService::receivePacket(InboundNetworkPacket packet, std::string* error)
 {
 	if (error) {
 		std::cout << "Error receiving packet: " << (*error) << std::endl;
@@ -146,31 +184,28 @@ void AsioUDPNetworkService::receivePacket(gsl::span<gsl::byte> received, std::st
 		return;
 	}
 
-	if (received.size_bytes() == 0) {
+	if (packet.getSize() == 0) {
 		return;
 	}
 
 	// Read connection id
 	short id = -1;
 	std::array<unsigned char, 2> bytes;
-	auto dst = gsl::as_writable_bytes(gsl::span<unsigned char, 2>(bytes));
-	dst[0] = received[0];
+	packet.extractHeader(bytes[0]);
 	if (bytes[0] & 0x80) {
-		if (received.size_bytes() < 2) {
+		if (packet.getSize() < 1) {
 			// Invalid header
 			std::cout << "Invalid header\n";
 			return;
 		}
-		dst[1] = received[1];
-		received = received.subspan(2);
+		packet.extractHeader(bytes[1]);
 		id = short(bytes[0] & 0x7F) | short(bytes[1]);
 	} else {
-		received = received.subspan(1);
 		id = short(bytes[0]);
 	}
 
 	// No connection id, check if it's a connection request
-	if (id == 0 && isValidConnectionRequest(received)) {
+	if (id == 0 && isValidConnectionRequest(packet.getBytes())) {
 		auto a = UDPAcceptor(*this, remoteEndpoint);
 		if (acceptCallback) {
 			acceptCallback(a);
@@ -200,7 +235,7 @@ void AsioUDPNetworkService::receivePacket(gsl::span<gsl::byte> received, std::st
 			connection->close();
 		} else {
 			try {
-				connection->onReceive(received);
+				connection->onReceive(std::move(packet));
 
 				if (conn->first == 0) {
 					// Hold on, we're still on 0, re-bind to the id
@@ -239,7 +274,7 @@ short AsioUDPNetworkService::getFreeId() const
 
 std::shared_ptr<AsioUDPConnection> AsioUDPNetworkService::acceptConnection(UDPEndpoint endPoint)
 {
-	auto conn = std::make_shared<AsioUDPConnection>(socket, endPoint);
+	auto conn = std::make_shared<AsioUDPConnection>(socket, endPoint, ioThread.get());
 	short id = getFreeId();
 	conn->open(id);
 
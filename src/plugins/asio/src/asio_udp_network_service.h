@@ -12,13 +12,17 @@
 namespace asio = boost::asio;
 
 #include "asio_udp_connection.h"
+#include "asio_udp_io_thread.h"
 
 namespace Halley
 {
 	class AsioUDPNetworkService : public NetworkServiceWithStats
 	{
 	public:
-		AsioUDPNetworkService(int port, IPVersion version = IPVersion::IPv4);
+		using MakeThread = AsioUDPIOThread::MakeThread;
+
+		// If threadedIO is set, the socket is serviced by a thread of its own (made with makeThread, if given), and update() only dispatches what it received
+		AsioUDPNetworkService(int port, IPVersion version = IPVersion::IPv4, bool threadedIO = false, MakeThread makeThread = {});
 		~AsioUDPNetworkService();
 
 		void update(Time t) override;
@@ -27,6 +31,11 @@ namespace Halley
 		void stopListening() override;
 		std::shared_ptr<IConnection> connect(const String& address) override;
 
+		std::optional<AsioUDPIOThread::Stats> getIOThreadStats() const;
+
+		// The port the socket is bound to, which is picked by the OS if the service was created with port 0
+		int getLocalPort() const;
+
 	private:
 		class UDPAcceptor : public Acceptor {
 		public:
@@ -47,11 +56,13 @@ namespace Halley
 		UDPEndpoint remoteEndpoint;
 		asio::ip::udp::socket socket;
 		HashMap<short, std::shared_ptr<AsioUDPConnection>> activeConnections;
+		std::unique_ptr<AsioUDPIOThread> ioThread;
 
-		std::array<gsl::byte, 2048> receiveBuffer;
+		NetworkPacketBuffer receiveBuffer;
 
 		void receiveNext();
-		void receivePacket(gsl::span<gsl::byte> data, std::string* error);
+		void receiveFromIOThread();
+		void receivePacket(InboundNetworkPacket packet, std::string* error);
 		bool isValidConnectionRequest(gsl::span<const gsl::byte> data);
 		short getFreeId() const;
 
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <halley.hpp>
+#include <thread>
+
+namespace Halley {
+	// Plain unnamed threads, for the executors that tests create
+	inline std::thread makeTestThread(String, std::function<void()> f)
+	{
+		return std::thread(std::move(f));
+	}
+}
@@ -0,0 +1,163 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+#include <halley/net/connection/message_queue_udp.h>
+#include "asio_udp_network_service.h"
+using namespace Halley;
+
+namespace {
+	struct LoopbackClient {
+		std::unique_ptr<AsioUDPNetworkService> service;
+		std::shared_ptr<IConnection> connection;
+		std::unique_ptr<MessageQueueUDP> queue;
+	};
+
+	std::unique_ptr<MessageQueueUDP> makeQueue(std::shared_ptr<IConnection> connection, float lag, float loss)
+	{
+		if (lag > 0 || loss > 0) {
+			connection = std::make_shared<InstabilitySimulator>(connection, lag, lag * 0.5f, loss, 0.0f);
+		}
+		auto queue = std::make_unique<MessageQueueUDP>(std::make_shared<AckUnreliableConnection>(connection));
+		queue->setChannel(0, ChannelSettings(true, true));
+		return queue;
+	}
+
+	// Connects nClients to a server on the loopback interface, each with a service of its own
+	bool connectClients(AsioUDPNetworkService& server, Vector<LoopbackClient>& clients, Vector<std::unique_ptr<MessageQueueUDP>>& serverQueues,
+		size_t nClients, float lag, float loss)
+	{
+		Vector<std::shared_ptr<IConnection>> accepted;
+		server.startListening([&] (NetworkService::Acceptor& acceptor)
+		{
+			accepted.push_back(acceptor.accept());
+		});
+
+		for (size_t i = 0; i < nClients; ++i) {
+			auto& client = clients.emplace_back();
+			client.service = std::make_unique<AsioUDPNetworkService>(0);
+			client.connection = client.service->connect("127.0.0.1:" + toString(server.getLocalPort()));
+		}
+
+		Stopwatch timer;
+		while (timer.elapsedNanoseconds() < 5'000'000'000ll) {
+			server.update(0);
+			bool allConnected = accepted.size() == nClients;
+			for (auto& client: clients) {
+				client.service->update(0);
+				allConnected = allConnected && client.connection->getStatus() == ConnectionStatus::Connected;
+			}
+			if (allConnected) {
+				break;
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+
+		// The callback refers to accepted, so it can't outlive this. Stopping also keeps retransmitted handshakes from being accepted again.
+		server.stopListening();
+		if (accepted.size() != nClients) {
+			return false;
+		}
+
+		for (auto& client: clients) {
+			client.queue = makeQueue(client.connection, lag, loss);
+		}
+		for (auto& connection: accepted) {
+			serverQueues.push_back(makeQueue(connection, lag, loss));
+		}
+		return true;
+	}
+
+	Bytes makePayload(size_t size, int seed)
+	{
+		Bytes result(size);
+		for (size_t i = 0; i < size; ++i) {
+			result[i] = Byte((i * 13 + seed) & 0xFF);
+		}
+		return result;
+	}
+}
+
+TEST(AsioUDP, ThreadedIORoundTrip)
+{
+	AsioUDPNetworkService server(0, IPVersion::IPv4, true);
+	Vector<LoopbackClient> clients;
+	Vector<std::unique_ptr<MessageQueueUDP>> serverQueues;
+	ASSERT_TRUE(connectClients(server, clients, serverQueues, 2, 0, 0));
+
+	const auto payload = makePayload(300, 5);
+	for (auto& client: clients) {
+		client.queue->enqueue(OutboundNetworkPacket(payload), 0);
+		client.queue->sendAll();
+	}
+
+	size_t received = 0;
+	Stopwatch timer;
+	while (received < clients.size() && timer.elapsedNanoseconds() < 2'000'000'000ll) {
+		for (auto& client: clients) {
+			client.service->update(0);
+		}
+		server.update(0);
+		for (auto& queue: serverQueues) {
+			for (auto& packet: queue->receivePackets()) {
+				EXPECT_EQ(size_t(packet.getSize()), payload.size());
+				EXPECT_EQ(memcmp(packet.getBytes().data(), payload.data(), payload.size()), 0);
+				++received;
+			}
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	EXPECT_EQ(received, clients.size());
+	EXPECT_GT(server.getIOThreadStats()->receivedDatagrams, 0);
+}
+
+TEST(AsioUDP, DISABLED_BenchmarkThreadedIO)
+{
+	// A server with many clients sending every "frame", over an unstable connection. Measures how long the server's
+	// main thread spends servicing the network each frame, with and without the I/O thread.
+	constexpr size_t nClients = 32;
+	constexpr int nFrames = 500;
+	const auto payload = makePayload(400, 7);
+
+	for (bool threaded : { false, true }) {
+		AsioUDPNetworkService server(0, IPVersion::IPv4, threaded);
+		Vector<LoopbackClient> clients;
+		Vector<std::unique_ptr<MessageQueueUDP>> serverQueues;
+		ASSERT_TRUE(connectClients(server, clients, serverQueues, nClients, 0.02f, 0.02f));
+
+		size_t received = 0;
+		int64_t serverNs = 0;
+		Stopwatch total;
+		for (int frame = 0; frame < nFrames; ++frame) {
+			for (auto& client: clients) {
+				for (int i = 0; i < 4; ++i) {
+					client.queue->enqueue(OutboundNetworkPacket(payload), 0);
+				}
+				client.queue->sendAll();
+				client.service->update(0);
+				client.queue->receivePackets();
+			}
+
+			Stopwatch serverTimer;
+			server.update(0);
+			for (auto& queue: serverQueues) {
+				received += queue->receivePackets().size();
+				queue->enqueue(OutboundNetworkPacket(payload), 0);
+				queue->sendAll();
+			}
+			serverTimer.pause();
+			serverNs += serverTimer.elapsedNanoseconds();
+
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		total.pause();
+
+		std::cout << (threaded ? "threaded I/O  " : "update loop I/O") << " | " << nClients << " clients | "
+			<< (serverNs / 1000.0 / nFrames) << " us/frame on server main thread | "
+			<< (received / (total.elapsedNanoseconds() / 1000000000.0)) << " msgs/s received";
+		if (const auto stats = server.getIOThreadStats()) {
+			std::cout << " | " << (double(stats->receivedDatagrams) / std::max(size_t(1), stats->receiveCalls)) << " datagrams/recv call"
+				<< " | " << (double(stats->sentDatagrams) / std::max(size_t(1), stats->sendCalls)) << " datagrams/send call"
+				<< " | " << stats->droppedDatagrams << " dropped";
+		}
+		std::cout << std::endl;
+	}
+}
@@ -0,0 +1,131 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+#include <halley/audio/audio_mixer.h>
+using namespace Halley;
+
+namespace {
+	class ScopedInstructionSet {
+	public:
+		ScopedInstructionSet(AudioMixerInstructionSet set)
+			: prev(AudioMixer::getInstructionSet())
+		{
+			AudioMixer::setInstructionSet(set);
+		}
+
+		~ScopedInstructionSet()
+		{
+			AudioMixer::setInstructionSet(prev);
+		}
+
+	private:
+		AudioMixerInstructionSet prev;
+	};
+
+	Vector<AudioMixerInstructionSet> getSupportedInstructionSets()
+	{
+		Vector<AudioMixerInstructionSet> result;
+		for (const auto set: { AudioMixerInstructionSet::Scalar, AudioMixerInstructionSet::SSE2, AudioMixerInstructionSet::AVX2, AudioMixerInstructionSet::NEON }) {
+			if (AudioMixer::isInstructionSetSupported(set)) {
+				result.push_back(set);
+			}
+		}
+		return result;
+	}
+
+	Vector<AudioSample> makeSamples(size_t n, uint32_t seed)
+	{
+		Random rng(seed);
+		Vector<AudioSample> result(n);
+		for (auto& s: result) {
+			s = rng.getFloat(-2.0f, 2.0f);
+		}
+		return result;
+	}
+
+	AudioBuffer makeBuffer(size_t n, uint32_t seed)
+	{
+		AudioBuffer result;
+		const auto samples = makeSamples(n, seed);
+		result.samples.assign(samples.begin(), samples.end());
+		return result;
+	}
+
+	struct Kernel {
+		const char* name;
+		std::function<void(AudioSamples dst, AudioBuffer& src, AudioBuffer& src2)> run;
+		size_t dstScale;
+	};
+
+	Vector<Kernel> getKernels()
+	{
+		Vector<Kernel> result;
+		result.push_back({ "mix", [] (AudioSamples dst, AudioBuffer& src, AudioBuffer&) { AudioMixer::mixAudio(src.samples, dst, 1.0f, 1.0f); }, 1 });
+		result.push_back({ "mix gain", [] (AudioSamples dst, AudioBuffer& src, AudioBuffer&) { AudioMixer::mixAudio(src.samples, dst, 0.7f, 0.7f); }, 1 });
+		result.push_back({ "mix ramp", [] (AudioSamples dst, AudioBuffer& src, AudioBuffer&) { AudioMixer::mixAudio(src.samples, dst, 0.1f, 0.9f); }, 1 });
+		result.push_back({ "copy gain", [] (AudioSamples dst, AudioBuffer& src, AudioBuffer&) { AudioMixer::copy(dst, src.samples, 0.7f, 0.7f); }, 1 });
+		result.push_back({ "copy ramp", [] (AudioSamples dst, AudioBuffer& src, AudioBuffer&) { AudioMixer::copy(dst, src.samples, 1.0f, 0.3f); }, 1 });
+		result.push_back({ "compress range", [] (AudioSamples dst, AudioBuffer&, AudioBuffer&) { AudioMixer::compressRange(dst); }, 1 });
+		result.push_back({ "interleave", [] (AudioSamples dst, AudioBuffer& src, AudioBuffer& src2) {
+			std::array<AudioBuffer*, 2> srcs = { &src, &src2 };
+			AudioMixer::interleaveChannels(dst, srcs);
+		}, 2 });
+		return result;
+	}
+}
+
+TEST(AudioMixer, KernelsAreBitExact)
+{
+	const auto sets = getSupportedInstructionSets();
+
+	for (const auto& kernel: getKernels()) {
+		for (size_t n : { size_t(1), size_t(3), size_t(4), size_t(7), size_t(8), size_t(9), size_t(16), size_t(17), size_t(255), size_t(1024), size_t(1031) }) {
+			auto src = makeBuffer(n, 1);
+			auto src2 = makeBuffer(n, 2);
+			const auto dstStart = makeSamples(n * kernel.dstScale, 3);
+
+			auto expected = dstStart;
+			{
+				ScopedInstructionSet scoped(AudioMixerInstructionSet::Scalar);
+				kernel.run(expected, src, src2);
+			}
+
+			for (const auto set: sets) {
+				auto dst = dstStart;
+				{
+					ScopedInstructionSet scoped(set);
+					kernel.run(dst, src, src2);
+				}
+				EXPECT_EQ(memcmp(dst.data(), expected.data(), dst.size() * sizeof(AudioSample)), 0) << kernel.name << " with " << toString(set) << " on " << n << " samples";
+			}
+		}
+	}
+}
+
+TEST(AudioMixer, DISABLED_BenchmarkKernels)
+{
+	constexpr size_t bufferSize = 1024;
+	constexpr size_t totalSamples = 50 * 1000 * 1000;
+
+	auto src = makeBuffer(bufferSize, 1);
+	auto src2 = makeBuffer(bufferSize, 2);
+
+	for (const auto& kernel: getKernels()) {
+		double scalarRate = 0;
+		for (const auto set: getSupportedInstructionSets()) {
+			ScopedInstructionSet scoped(set);
+			auto dst = makeSamples(bufferSize * kernel.dstScale, 3);
+
+			Stopwatch timer;
+			for (size_t done = 0; done < totalSamples; done += bufferSize) {
+				kernel.run(dst, src, src2);
+			}
+			timer.pause();
+
+			const double rate = double(totalSamples) / (timer.elapsedNanoseconds() / 1000000000.0);
+			if (set == AudioMixerInstructionSet::Scalar) {
+				scalarRate = rate;
+			}
+			std::cout << kernel.name << " | " << toString(set) << " | " << (rate / 1000000.0) << " Msamples/s | " << (rate / scalarRate) << "x scalar" << std::endl;
+		}
+	}
+}
@@ -0,0 +1,45 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+using namespace Halley;
+
+namespace {
+	Bytes makeTestData(size_t size, int alphabet)
+	{
+		Random rng(uint32_t(1234));
+		Bytes result(size);
+		for (auto& b: result) {
+			b = Byte(rng.getInt(0, alphabet - 1));
+		}
+		return result;
+	}
+
+	void testLZ4RoundTrip(const Bytes& data)
+	{
+		const auto compressed = Compression::lz4Compress(gsl::as_bytes(gsl::span<const Byte>(data)));
+		const auto decompressed = Compression::lz4Decompress(gsl::as_bytes(gsl::span<const Byte>(compressed)));
+		EXPECT_EQ(data, decompressed);
+	}
+}
+
+TEST(Compression, LZ4RoundTrip)
+{
+	for (size_t size : { size_t(0), size_t(1), size_t(12), size_t(13), size_t(100), size_t(70000), size_t(1000000) }) {
+		testLZ4RoundTrip(makeTestData(size, 256));
+		testLZ4RoundTrip(makeTestData(size, 4));
+		testLZ4RoundTrip(Bytes(size, 7));
+	}
+
+	String text;
+	for (int i = 0; i < 500; ++i) {
+		text += "Halley is a game engine, entry " + toString(i) + ".\n";
+	}
+	testLZ4RoundTrip(Bytes(text.c_str(), text.c_str() + text.size()));
+}
+
+TEST(Compression, LZ4RejectsCorruptData)
+{
+	const auto data = makeTestData(10000, 4);
+	auto compressed = Compression::lz4Compress(gsl::as_bytes(gsl::span<const Byte>(data)));
+	compressed.resize(compressed.size() / 2);
+	EXPECT_THROW(Compression::lz4Decompress(gsl::as_bytes(gsl::span<const Byte>(compressed))), Exception);
+}
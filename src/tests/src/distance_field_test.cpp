@@ -0,0 +1,157 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+#include <halley/tools/distance_field/distance_field_generator.h>
+#include <halley/tools/make_font/font_face.h>
+using namespace Halley;
+
+namespace {
+	class TestExecutors {
+	public:
+		TestExecutors()
+		{
+			Executors::setInstance(executors);
+			const auto nThreads = std::max(size_t(2), size_t(std::thread::hardware_concurrency()));
+			pool = std::make_unique<ThreadPool>("Test", Executors::getCPU(), nThreads, [] (String name, std::function<void()> f) { return std::thread(std::move(f)); });
+		}
+
+	private:
+		Executors executors;
+		std::unique_ptr<ThreadPool> pool;
+	};
+
+	// The brute force generator that DistanceFieldGenerator replaced, searching a (2r+1)^2 window around every sub-texel
+	float getReferenceDistanceAt(const int* src, int srcW, int srcH, int xCentre, int yCentre, float radius)
+	{
+		auto getAlpha = [&](int x, int y) { return (src[x + y * srcW] & 0xFF000000) >> 24; };
+		bool isInside = getAlpha(xCentre, yCentre) > 127;
+		if (radius < 0.001f) {
+			return isInside ? 1.0f : 0.0f;
+		}
+
+		int iRadius = int(ceil(radius));
+		int x0 = std::max(0, xCentre - iRadius);
+		int x1 = std::min(xCentre + iRadius, srcW - 1);
+		int y0 = std::max(0, yCentre - iRadius);
+		int y1 = std::min(yCentre + iRadius, srcH - 1);
+
+		int bestDistSqr = 2147483647;
+		for (int y = y0; y <= y1; y++) {
+			for (int x = x0; x <= x1; x++) {
+				bool thisInside = getAlpha(x, y) > 127;
+				if (isInside != thisInside) {
+					int distSqr = (x - xCentre) * (x - xCentre) + (y - yCentre) * (y - yCentre);
+					bestDistSqr = std::min(distSqr, bestDistSqr);
+				}
+			}
+		}
+
+		const float dist = float(sqrt(bestDistSqr));
+		const float normalDistance = (2 * dist - 1) / (2 * radius);
+		return 0.5f * (isInside ? 1.0f + normalDistance : 1.0f - normalDistance);
+	}
+
+	std::unique_ptr<Image> generateReference(Image& srcImg, Vector2i size, float radius)
+	{
+		const int srcW = srcImg.getWidth();
+		const int srcH = srcImg.getHeight();
+		const auto src = srcImg.getPixels4BPP();
+		auto dstImg = std::make_unique<Image>(Image::Format::SingleChannel, size);
+		const auto dst = dstImg->getPixelBytes();
+
+		const int texelW = srcW / size.x;
+		const int texelH = srcH / size.y;
+		for (int y = 0; y < size.y; y++) {
+			for (int x = 0; x < size.x; x++) {
+				float distAcc = 0;
+				for (int j = 0; j < texelH; j++) {
+					for (int i = 0; i < texelW; i++) {
+						distAcc += getReferenceDistanceAt(src.data(), srcW, srcH, x * srcW / size.x + i, y * srcH / size.y + j, radius * srcW / size.x);
+					}
+				}
+				dst[x + y * size.x] = static_cast<unsigned char>(clamp(int(distAcc * 255 / (texelW * texelH)), 0, 255));
+			}
+		}
+		return dstImg;
+	}
+
+	// Lays glyphs out in rows, as the font generator would, at superSample times the final size
+	std::unique_ptr<Image> renderGlyphs(const String& fontName, float fontSize, int superSample, float radius, Vector2i finalSize)
+	{
+		FontFace font((Path(HALLEY_TEST_ASSETS_DIR) / "font" / fontName).getString());
+		font.setSize(fontSize);
+
+		auto img = std::make_unique<Image>(Image::Format::RGBA, finalSize * superSample);
+		img->clear(0);
+
+		const int border = int(ceil(radius)) * superSample;
+		Vector2i pos;
+		int rowHeight = 0;
+		for (const int code: font.getCharCodes()) {
+			const auto size = font.getGlyphSize(code) + Vector2i(2 * border, 2 * border);
+			if (pos.x + size.x > img->getWidth()) {
+				pos = Vector2i(0, pos.y + rowHeight);
+				rowHeight = 0;
+			}
+			if (pos.y + size.y > img->getHeight()) {
+				break;
+			}
+			font.drawGlyph(*img, code, pos + Vector2i(border, border));
+			pos.x += size.x;
+			rowHeight = std::max(rowHeight, size.y);
+		}
+		return img;
+	}
+
+	void expectSameAsReference(const Image& result, const Image& reference)
+	{
+		const auto a = result.getPixelBytes();
+		const auto b = reference.getPixelBytes();
+		ASSERT_EQ(a.size(), b.size());
+		size_t nDifferent = 0;
+		for (size_t i = 0; i < a.size(); ++i) {
+			if (a[i] != b[i]) {
+				++nDifferent;
+			}
+		}
+		EXPECT_EQ(nDifferent, 0);
+	}
+}
+
+TEST(DistanceField, MatchesBruteForceOnFonts)
+{
+	TestExecutors executors;
+
+	for (const auto& fontName: { "Ubuntu-Regular.ttf", "Inconsolata.otf" }) {
+		constexpr int superSample = 4;
+		constexpr float radius = 4.0f;
+		const Vector2i size(128, 128);
+
+		auto src = renderGlyphs(fontName, 96.0f, superSample, radius, size);
+		const auto result = DistanceFieldGenerator::generate(*src, size, radius);
+		const auto reference = generateReference(*src, size, radius);
+		expectSameAsReference(*result, *reference);
+	}
+}
+
+TEST(DistanceField, DISABLED_BenchmarkAtlas)
+{
+	TestExecutors executors;
+
+	// A 1024x1024 atlas from a 4096x4096 render at 4x super sampling, like a large font import
+	constexpr int superSample = 4;
+	constexpr float radius = 8.0f;
+	const Vector2i size(1024, 1024);
+	auto src = renderGlyphs("Ubuntu-Regular.ttf", 256.0f, superSample, radius, size);
+
+	Stopwatch timer;
+	const auto result = DistanceFieldGenerator::generate(*src, size, radius);
+	timer.pause();
+
+	Stopwatch referenceTimer;
+	const auto reference = generateReference(*src, size, radius);
+	referenceTimer.pause();
+	expectSameAsReference(*result, *reference);
+
+	std::cout << src->getWidth() << "x" << src->getHeight() << " source | distance transform: " << (timer.elapsedNanoseconds() / 1000000.0)
+		<< " ms | brute force: " << (referenceTimer.elapsedNanoseconds() / 1000000.0) << " ms" << std::endl;
+}
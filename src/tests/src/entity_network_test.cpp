@@ -0,0 +1,179 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+#include <halley/net/entity/entity_network_remote_peer.h>
+#include <halley/net/connection/ack_unreliable_connection_stats.h>
+#include "asio_udp_network_service.h"
+#include <halley/net/entity/entity_network_session.h>
+#include <halley/entity/components/transform_2d_component.h>
+using namespace Halley;
+
+namespace {
+	using PendingSend = EntityNetworkRemotePeer::PendingSend;
+
+	PendingSend makeCreate(float relevance)
+	{
+		return PendingSend{ EntityRef(), true, relevance, 0 };
+	}
+
+	PendingSend makeUpdate(float relevance, Time timeSinceSend)
+	{
+		return PendingSend{ EntityRef(), false, relevance, timeSinceSend };
+	}
+
+	// Sends everything through sendByPriority, with each entry's size looked up by its relevance, and returns the relevances of what got sent, in order
+	Vector<float> sendAll(Vector<PendingSend> pending, size_t budget, const std::map<float, size_t>& sizes, size_t& totalSent)
+	{
+		Vector<float> sent;
+		totalSent = 0;
+		EntityNetworkRemotePeer::sendByPriority(pending, budget, [&] (const PendingSend& p, size_t maxSize) -> size_t
+		{
+			const auto size = sizes.at(p.relevance);
+			if (size > maxSize) {
+				return 0;
+			}
+			sent.push_back(p.relevance);
+			totalSent += size;
+			return size;
+		});
+		return sent;
+	}
+
+	class TestSessionListener final : public EntityNetworkSession::IEntityNetworkSessionListener {
+	public:
+		void onStartSession(NetworkSession::PeerId myPeerId) override {}
+		void setupInterpolators(DataInterpolatorSet& interpolatorSet, EntityRef entity, bool remote) override {}
+		bool isEntityInView(EntityRef entity, const EntityClientSharedData& clientData) override { return true; }
+	};
+
+	// A world with an entity session hosting on the loopback interface
+	class TestHost {
+	public:
+		TestHost()
+			: resources(std::unique_ptr<ResourceLocator>(), api, ResourceOptions())
+			, world(api, resources, WorldReflection())
+			, service(0, IPVersion::IPv4)
+			, session(std::make_shared<NetworkSession>(service, 1, "host"))
+			, entitySession(session, resources, {}, &listener)
+		{
+			session->host(4);
+			entitySession.setWorld(world, {});
+		}
+
+		HalleyAPI api{};
+		Resources resources;
+		World world;
+		AsioUDPNetworkService service;
+		std::shared_ptr<NetworkSession> session;
+		TestSessionListener listener;
+		EntityNetworkSession entitySession;
+
+		void sendUpdates(Time t)
+		{
+			entitySession.sendUpdates(t, Rect4i(0, 0, 100, 100), {});
+		}
+	};
+}
+
+TEST(EntityNetworkRemotePeer, SendsCreatesFirstThenByRelevanceTimesTimeSinceSend)
+{
+	// By relevance alone the updates would go 4, 1, 0.5, and by time alone 0.5, 1, 4
+	const Vector<PendingSend> pending = {
+		makeUpdate(4.0f, 0.1),
+		makeCreate(0.25f),
+		makeUpdate(1.0f, 0.3),
+		makeUpdate(0.5f, 1.0),
+		makeCreate(2.0f)
+	};
+	const std::map<float, size_t> sizes = { { 4.0f, 10 }, { 0.25f, 10 }, { 1.0f, 10 }, { 0.5f, 10 }, { 2.0f, 10 } };
+
+	size_t totalSent = 0;
+	EXPECT_EQ(sendAll(pending, 0, sizes, totalSent), Vector<float>({ 2.0f, 0.25f, 0.5f, 4.0f, 1.0f }));
+	EXPECT_EQ(totalSent, 50);
+}
+
+TEST(EntityNetworkRemotePeer, RespectsBandwidthBudget)
+{
+	const Vector<PendingSend> pending = {
+		makeCreate(1.0f),
+		makeUpdate(2.0f, 1.0),
+		makeUpdate(3.0f, 0.5),
+		makeUpdate(0.5f, 1.0)
+	};
+	const std::map<float, size_t> sizes = { { 1.0f, 10 }, { 2.0f, 10 }, { 3.0f, 10 }, { 0.5f, 5 } };
+
+	// The third one doesn't fit, but the smaller one after it still does
+	size_t totalSent = 0;
+	EXPECT_EQ(sendAll(pending, 25, sizes, totalSent), Vector<float>({ 1.0f, 2.0f, 0.5f }));
+	EXPECT_EQ(totalSent, 25);
+
+	// Something always goes through, even if it doesn't fit on its own, but nothing after it
+	EXPECT_EQ(sendAll(pending, 5, sizes, totalSent), Vector<float>({ 1.0f }));
+	EXPECT_EQ(totalSent, 10);
+}
+
+TEST(AckUnreliableConnectionStats, RolloverKeepsRemainder)
+{
+	AckUnreliableConnectionStats stats(64, 16);
+
+	stats.onPacketSent(0, 100);
+	stats.update(0.75);
+	stats.onPacketSent(1, 100);
+	stats.update(0.75);
+	EXPECT_EQ(stats.getSentDataPerSecond(), 200);
+
+	// Only 0.5s left of the second window, so this one rolls over again after another 0.5s, rather than a full second
+	stats.onPacketSent(2, 50);
+	stats.update(0.6);
+	EXPECT_EQ(stats.getSentDataPerSecond(), 50);
+}
+
+TEST(EntityNetworkSession, ReusesSnapshotsOfUnchangedEntities)
+{
+	TestHost host;
+	auto entity = host.world.createEntity().addComponent(Transform2DComponent(Vector2f(1, 2)));
+	host.world.spawnPending();
+
+	host.sendUpdates(0.1);
+	const auto first = host.entitySession.getOutboundSnapshot(entity).data;
+	ASSERT_TRUE(first);
+
+	// Nothing changed, so the entity isn't serialized again, and a peer that got this snapshot has nothing to be sent
+	host.sendUpdates(0.1);
+	EXPECT_EQ(host.entitySession.getOutboundSnapshot(entity).data, first);
+
+	entity.getComponent<Transform2DComponent>().setLocalPosition(Vector2f(3, 4));
+	entity.markComponentModified<Transform2DComponent>();
+	host.sendUpdates(0.1);
+	const auto second = host.entitySession.getOutboundSnapshot(entity).data;
+	EXPECT_NE(second, first);
+	EXPECT_EQ(second->getComponents().at(0).second["position"].asVector2f(), Vector2f(3, 4));
+
+	// Writes that nobody marked are still picked up once the snapshot gets old
+	entity.getComponent<Transform2DComponent>().getLocalPosition() = Vector2f(5, 6);
+	host.sendUpdates(0.1);
+	EXPECT_EQ(host.entitySession.getOutboundSnapshot(entity).data, second);
+	host.sendUpdates(1.0);
+	const auto third = host.entitySession.getOutboundSnapshot(entity).data;
+	EXPECT_NE(third, second);
+	EXPECT_EQ(third->getComponents().at(0).second["position"].asVector2f(), Vector2f(5, 6));
+}
+
+TEST(EntityNetworkSession, TracksChangesOnlyWithPeers)
+{
+	TestHost host;
+	host.sendUpdates(0.1);
+	EXPECT_FALSE(host.world.hasComponentChangeTracking());
+
+	AsioUDPNetworkService clientService(0, IPVersion::IPv4);
+	NetworkSession client(clientService, 1, "client");
+	client.join("127.0.0.1:" + toString(host.service.getLocalPort()));
+
+	// The client only has to join for the host to have someone to send entities to
+	Stopwatch timer;
+	while (!host.world.hasComponentChangeTracking() && timer.elapsedNanoseconds() < 5'000'000'000ll) {
+		host.sendUpdates(0.01);
+		client.update(0.01);
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	EXPECT_TRUE(host.world.hasComponentChangeTracking());
+}
@@ -0,0 +1,487 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+#include <halley/entity/components/transform_2d_component.h>
+#include "test_threads.h"
+using namespace Halley;
+
+namespace {
+	class StressAComponent final : public Component {
+	public:
+		static constexpr int componentIndex{ 200 };
+		static constexpr const char* componentName{ "StressA" };
+
+		int value = 0;
+
+		StressAComponent() = default;
+		explicit StressAComponent(int value) : value(value) {}
+	};
+
+	class StressBComponent final : public Component {
+	public:
+		static constexpr int componentIndex{ 201 };
+		static constexpr const char* componentName{ "StressB" };
+
+		int value = 0;
+
+		StressBComponent() = default;
+		explicit StressBComponent(int value) : value(value) {}
+	};
+
+	class StressAFamily : public FamilyBaseOf<StressAFamily> {
+	public:
+		StressAComponent& stressA;
+
+		using Type = FamilyType<StressAComponent>;
+
+	protected:
+		StressAFamily(StressAComponent& stressA) : stressA(stressA) {}
+	};
+
+	class StressABFamily : public FamilyBaseOf<StressABFamily> {
+	public:
+		StressAComponent& stressA;
+		const StressBComponent& stressB;
+
+		using Type = FamilyType<StressAComponent, StressBComponent>;
+
+	protected:
+		StressABFamily(StressAComponent& stressA, const StressBComponent& stressB) : stressA(stressA), stressB(stressB) {}
+	};
+
+	// Enough of an API and Resources for a World that has no systems
+	class TestWorld {
+	public:
+		TestWorld()
+			: resources(std::unique_ptr<ResourceLocator>(), api, ResourceOptions())
+			, world(api, resources, WorldReflection())
+		{}
+
+		World& get() { return world; }
+		Resources& getResources() { return resources; }
+
+	private:
+		HalleyAPI api{};
+		Resources resources;
+		World world;
+	};
+
+	// Lets the test drive a family directly, as World does
+	class TestFamily final : public FamilyImpl<StressAFamily> {
+	public:
+		using FamilyImpl::FamilyImpl;
+
+		void add(Entity& entity) { addEntity(entity); }
+		void remove(Entity& entity) { removeEntity(entity); }
+		void update() { updateEntities(); }
+	};
+
+	Vector<EntityId> getFamilyIds(const Family& family)
+	{
+		Vector<EntityId> result;
+		for (size_t i = 0; i < family.count(); ++i) {
+			result.push_back(static_cast<const FamilyBase*>(family.getElement(i))->entityId);
+		}
+		std::sort(result.begin(), result.end());
+		return result;
+	}
+
+	// Writes to every StressA, without telling anyone, like generated systems do
+	class StressAWriterSystem final : public System {
+	public:
+		StressAWriterSystem() : System({ &family }, {}) {}
+
+	protected:
+		void updateBase(Time) override
+		{
+			for (auto& e: family) {
+				++e.stressA.value;
+			}
+		}
+
+	private:
+		FamilyBinding<StressAFamily> family;
+	};
+
+	SystemAccessSignature makeSignature(Vector<int> read, Vector<int> written, Vector<String> services = {})
+	{
+		return SystemAccessSignature(std::move(read), std::move(written), std::move(services));
+	}
+
+	Vector<Vector<size_t>> makeStages(const Vector<SystemAccessSignature>& signatures)
+	{
+		Vector<const SystemAccessSignature*> ptrs;
+		for (auto& s: signatures) {
+			ptrs.push_back(&s);
+		}
+		return SystemAccessSignature::makeStages(ptrs);
+	}
+
+	// Records when it ran, and optionally waits for a partner system to be updating at the same time
+	class TestSystem final : public System {
+	public:
+		TestSystem(SystemAccessSignature signature, std::atomic<int>& clock, std::atomic<int>* rendezvous = nullptr)
+			: System({}, {})
+			, clock(clock)
+			, rendezvous(rendezvous)
+		{
+			setAccessSignature(std::move(signature));
+		}
+
+		int startedAt = -1;
+		int finishedAt = -1;
+		bool metPartner = false;
+
+	protected:
+		void updateBase(Time) override
+		{
+			startedAt = clock++;
+			if (rendezvous) {
+				++*rendezvous;
+				const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+				while (*rendezvous < 2 && std::chrono::steady_clock::now() < deadline) {
+					std::this_thread::yield();
+				}
+				metPartner = *rendezvous >= 2;
+			}
+			finishedAt = clock++;
+		}
+
+	private:
+		std::atomic<int>& clock;
+		std::atomic<int>* rendezvous;
+	};
+}
+
+TEST(Family, EntityReaddedWhileRemovalIsPending)
+{
+	TestWorld testWorld;
+	auto& world = testWorld.get();
+
+	Vector<Entity*> entities;
+	for (int i = 0; i < 5; ++i) {
+		const auto id = world.createEntity().addComponent(StressAComponent(i)).getEntityId();
+		world.spawnPending();
+		entities.push_back(world.tryGetRawEntity(id));
+	}
+
+	TestFamily family(world.getMaskStorage());
+	for (auto* e: entities) {
+		family.add(*e);
+	}
+	family.update();
+	ASSERT_EQ(family.count(), 5);
+
+	// Remove two and add one of them straight back, with the old entries in the middle of the family
+	family.remove(*entities[1]);
+	family.remove(*entities[3]);
+	family.add(*entities[1]);
+	family.update();
+
+	Vector<EntityId> expected = { entities[0]->getEntityId(), entities[1]->getEntityId(), entities[2]->getEntityId(), entities[4]->getEntityId() };
+	std::sort(expected.begin(), expected.end());
+	EXPECT_EQ(getFamilyIds(family), expected);
+
+	// The re-added entity can still be removed normally afterwards
+	family.remove(*entities[1]);
+	family.remove(*entities[4]);
+	family.update();
+	expected = { entities[0]->getEntityId(), entities[2]->getEntityId() };
+	std::sort(expected.begin(), expected.end());
+	EXPECT_EQ(getFamilyIds(family), expected);
+}
+
+TEST(Entity, ComponentRevisions)
+{
+	TestWorld testWorld;
+	auto& world = testWorld.get();
+	constexpr int idA = StressAComponent::componentIndex;
+	constexpr int idB = StressBComponent::componentIndex;
+
+	auto entity = world.createEntity().addComponent(StressAComponent(1));
+	world.spawnPending();
+	const auto added = entity.getComponentRevision(idA);
+	EXPECT_NE(added, 0);
+	EXPECT_EQ(entity.getComponentRevision(idB), 0);
+
+	// Reads aren't writes, even through a mutable reference
+	const auto revision = entity.getRevision();
+	std::as_const(entity).getComponent<StressAComponent>();
+	entity.getComponent<StressAComponent>();
+	entity.tryGetComponent<StressAComponent>();
+	EXPECT_EQ(entity.getRevision(), revision);
+	EXPECT_EQ(entity.getComponentRevision(idA), added);
+
+	entity.getComponent<StressAComponent>().value = 2;
+	entity.markComponentModified<StressAComponent>();
+	const auto written = entity.getComponentRevision(idA);
+	EXPECT_GT(written, added);
+	EXPECT_GT(entity.getRevision(), revision);
+
+	// Adding or removing another component leaves this one alone
+	entity.addComponent(StressBComponent(1));
+	EXPECT_GT(entity.getComponentRevision(idB), written);
+	EXPECT_EQ(entity.getComponentRevision(idA), written);
+
+	const auto beforeRemove = entity.getRevision();
+	entity.removeComponent<StressBComponent>();
+	world.spawnPending();
+	EXPECT_GT(entity.getRevision(), beforeRemove);
+	EXPECT_EQ(entity.getComponentRevision(idB), 0);
+	EXPECT_EQ(entity.getComponentRevision(idA), written);
+}
+
+TEST(Entity, SystemWritesAreTrackedWhenEnabled)
+{
+	TestWorld testWorld;
+	auto& world = testWorld.get();
+	constexpr int idA = StressAComponent::componentIndex;
+	constexpr int idB = StressBComponent::componentIndex;
+
+	world.addSystem(std::make_unique<StressAWriterSystem>(), TimeLine::FixedUpdate);
+	auto entity = world.createEntity().addComponent(StressAComponent(0)).addComponent(StressBComponent(0));
+	world.step(TimeLine::FixedUpdate, 1.0 / 60.0);
+	EXPECT_EQ(entity.getComponent<StressAComponent>().value, 1);
+
+	const auto revisionA = entity.getComponentRevision(idA);
+	const auto revisionB = entity.getComponentRevision(idB);
+	world.step(TimeLine::FixedUpdate, 1.0 / 60.0);
+	EXPECT_EQ(entity.getComponentRevision(idA), revisionA);
+
+	world.setComponentChangeTracking(true);
+	world.step(TimeLine::FixedUpdate, 1.0 / 60.0);
+	EXPECT_GT(entity.getComponentRevision(idA), revisionA);
+	EXPECT_EQ(entity.getComponentRevision(idB), revisionB);
+}
+
+TEST(EntitySerializationCache, ReusesComponentsUntilModified)
+{
+	TestWorld testWorld;
+	auto& world = testWorld.get();
+	EntityFactory factory(world, testWorld.getResources());
+
+	auto entity = world.createEntity().addComponent(Transform2DComponent(Vector2f(1, 2)));
+	world.spawnPending();
+
+	EntitySerializationCache cache;
+	EntityFactory::SerializationOptions options;
+	options.type = EntitySerialization::Type::Network;
+	options.cache = &cache;
+	const auto getPosition = [&] ()
+	{
+		const auto data = factory.serializeEntity(entity, options);
+		return data.getComponents().at(0).second["position"].asVector2f();
+	};
+
+	EXPECT_EQ(getPosition(), Vector2f(1, 2));
+
+	// An unmarked write doesn't show up, since every later serialization (e.g. one per peer) reuses the cached data
+	entity.getComponent<Transform2DComponent>().getLocalPosition() = Vector2f(3, 4);
+	EXPECT_EQ(getPosition(), Vector2f(1, 2));
+	EXPECT_EQ(getPosition(), Vector2f(1, 2));
+
+	entity.markComponentModified<Transform2DComponent>();
+	EXPECT_EQ(getPosition(), Vector2f(3, 4));
+
+	entity.getComponent<Transform2DComponent>().getLocalPosition() = Vector2f(5, 6);
+	cache.invalidate(entity);
+	EXPECT_EQ(getPosition(), Vector2f(5, 6));
+}
+
+TEST(SystemAccessSignature, Conflicts)
+{
+	const auto readA = makeSignature({ 1 }, {});
+	const auto readA2 = makeSignature({ 1 }, {});
+	const auto writeA = makeSignature({}, { 1 });
+	const auto writeA2 = makeSignature({}, { 1 });
+	const auto writeB = makeSignature({ 1 }, { 2 });
+
+	EXPECT_FALSE(readA.conflictsWith(readA2));
+	EXPECT_TRUE(readA.conflictsWith(writeA));
+	EXPECT_TRUE(writeA.conflictsWith(readA));
+	EXPECT_TRUE(writeA.conflictsWith(writeA2));
+	EXPECT_FALSE(readA.conflictsWith(writeB));
+	EXPECT_TRUE(writeA.conflictsWith(writeB));
+
+	// Sharing a service is treated as a write
+	EXPECT_FALSE(makeSignature({}, {}, { "a" }).conflictsWith(makeSignature({}, {}, { "b" })));
+	EXPECT_TRUE(makeSignature({}, {}, { "a" }).conflictsWith(makeSignature({}, {}, { "a" })));
+}
+
+TEST(SystemAccessSignature, ExclusiveConflictsWithEverything)
+{
+	const SystemAccessSignature exclusive;
+	EXPECT_TRUE(exclusive.isExclusive());
+	EXPECT_TRUE(exclusive.conflictsWith(SystemAccessSignature()));
+	EXPECT_TRUE(exclusive.conflictsWith(makeSignature({}, {})));
+	EXPECT_TRUE(makeSignature({}, {}).conflictsWith(exclusive));
+	EXPECT_TRUE(makeSignature({ 1 }, {}).conflictsWith(exclusive));
+
+	// An exclusive system is alone in its stage, and splits the ones around it
+	const auto stages = makeStages({ makeSignature({ 1 }, {}), SystemAccessSignature(), makeSignature({ 2 }, {}) });
+	EXPECT_EQ(stages, (Vector<Vector<size_t>>{ { 0 }, { 1 }, { 2 } }));
+}
+
+TEST(SystemAccessSignature, StagesKeepDeclaredOrder)
+{
+	// 0 and 1 don't conflict, 2 writes what 0 reads, 3 reads what 2 writes, 4 only conflicts with 1
+	const auto stages = makeStages({
+		makeSignature({ 1 }, {}),
+		makeSignature({}, { 5 }),
+		makeSignature({}, { 1 }),
+		makeSignature({ 1 }, {}),
+		makeSignature({ 5 }, {})
+	});
+	EXPECT_EQ(stages, (Vector<Vector<size_t>>{ { 0, 1 }, { 2, 4 }, { 3 } }));
+
+	// A later reader can't jump ahead of an earlier writer, even if nothing else is in its way
+	EXPECT_EQ(makeStages({ makeSignature({}, { 1 }), makeSignature({ 1 }, {}) }), (Vector<Vector<size_t>>{ { 0 }, { 1 } }));
+	EXPECT_EQ(makeStages({ makeSignature({ 1 }, {}), makeSignature({ 2 }, {}), makeSignature({ 3 }, {}) }), (Vector<Vector<size_t>>{ { 0, 1, 2 } }));
+}
+
+TEST(World, ParallelSystemUpdates)
+{
+	Executors executors;
+	Executors::setInstance(executors);
+	ThreadPool pool("Test", Executors::getCPU(), 2, makeTestThread);
+
+	TestWorld testWorld;
+	auto& world = testWorld.get();
+	world.setParallelSystemUpdates(true);
+
+	std::atomic<int> clock = 0;
+	std::atomic<int> rendezvous = 0;
+	auto& writer = static_cast<TestSystem&>(world.addSystem(std::make_unique<TestSystem>(makeSignature({}, { 1 }), clock, &rendezvous), TimeLine::FixedUpdate));
+	auto& other = static_cast<TestSystem&>(world.addSystem(std::make_unique<TestSystem>(makeSignature({ 2 }, {}), clock, &rendezvous), TimeLine::FixedUpdate));
+	auto& reader = static_cast<TestSystem&>(world.addSystem(std::make_unique<TestSystem>(makeSignature({ 1 }, {}), clock), TimeLine::FixedUpdate));
+
+	world.step(TimeLine::FixedUpdate, 1.0 / 60.0);
+
+	// The two non-conflicting systems were updating at the same time, and the reader only started once the writer was done
+	EXPECT_TRUE(writer.metPartner);
+	EXPECT_TRUE(other.metPartner);
+	EXPECT_GT(reader.startedAt, writer.finishedAt);
+	EXPECT_GT(reader.startedAt, other.finishedAt);
+}
+
+TEST(Family, DISABLED_BenchmarkChurn)
+{
+	// A large world where a slice of the entities gain or lose components, die or get created every frame
+	constexpr int nEntities = 50000;
+	constexpr int nFrames = 200;
+	constexpr int nChangesPerFrame = 2500;
+
+	TestWorld testWorld;
+	auto& world = testWorld.get();
+	auto& familyA = world.getFamily<StressAFamily>();
+	auto& familyAB = world.getFamily<StressABFamily>();
+
+	Vector<EntityId> ids;
+	for (int i = 0; i < nEntities; ++i) {
+		auto e = world.createEntity().addComponent(StressAComponent(i));
+		if (i % 2 == 0) {
+			e.addComponent(StressBComponent(i));
+		}
+		ids.push_back(e.getEntityId());
+	}
+	world.spawnPending();
+
+	Random rng(uint32_t(1234));
+	Stopwatch timer(false);
+	for (int frame = 0; frame < nFrames; ++frame) {
+		for (int i = 0; i < nChangesPerFrame; ++i) {
+			const auto idx = size_t(rng.getInt(0, int(ids.size()) - 1));
+			auto e = world.getEntity(ids[idx]);
+			switch (rng.getInt(0, 3)) {
+			case 0:
+				if (e.hasComponent<StressBComponent>()) {
+					e.removeComponent<StressBComponent>();
+				} else {
+					e.addComponent(StressBComponent(i));
+				}
+				break;
+			case 1:
+				world.destroyEntity(e);
+				ids[idx] = world.createEntity().addComponent(StressAComponent(i)).getEntityId();
+				break;
+			default:
+				e.setReloaded();
+				break;
+			}
+		}
+
+		timer.start();
+		world.spawnPending();
+		timer.pause();
+	}
+
+	EXPECT_EQ(familyA.count(), size_t(nEntities));
+	EXPECT_LE(familyAB.count(), size_t(nEntities));
+	std::cout << nEntities << " entities, " << nChangesPerFrame << " changes per frame | update: " << (timer.elapsedNanoseconds() / 1000.0 / nFrames) << " us/frame" << std::endl;
+}
+
+TEST(ComponentPools, NewAndDeleteUseSizePools)
+{
+	// Components outside of entities go back to the pool for their size, where the next one of that size comes from
+	auto* a = new StressAComponent(1);
+	EXPECT_EQ(a->value, 1);
+	delete a;
+
+	auto b = std::make_unique<StressBComponent>(2);
+	EXPECT_EQ(static_cast<void*>(b.get()), static_cast<void*>(a));
+	EXPECT_EQ(b->value, 2);
+
+	// Not mixed up with the per type pools that entity components use
+	TestWorld testWorld;
+	auto& world = testWorld.get();
+	auto entity = world.createEntity().addComponent(StressAComponent(3));
+	world.spawnPending();
+	EXPECT_NE(static_cast<void*>(&entity.getComponent<StressAComponent>()), static_cast<void*>(b.get()));
+}
+
+TEST(ComponentPools, DISABLED_BenchmarkLocality)
+{
+	// Entities with two components of the same size, created one after the other, and a family that only reads one of them
+	struct Payload {
+		int value;
+		std::array<char, 60> padding;
+	};
+	constexpr int nEntities = 200000;
+	constexpr int nPasses = 50;
+
+	auto run = [&] (auto alloc, auto free)
+	{
+		Vector<Payload*> a;
+		Vector<Payload*> b;
+		for (int i = 0; i < nEntities; ++i) {
+			a.push_back(static_cast<Payload*>(alloc(0)));
+			a.back()->value = i;
+			b.push_back(static_cast<Payload*>(alloc(1)));
+			b.back()->value = -i;
+		}
+
+		Stopwatch timer;
+		int64_t total = 0;
+		for (int pass = 0; pass < nPasses; ++pass) {
+			for (const auto* p: a) {
+				total += p->value;
+			}
+		}
+		timer.pause();
+		EXPECT_EQ(total, int64_t(nPasses) * nEntities * (nEntities - 1) / 2);
+
+		for (int i = 0; i < nEntities; ++i) {
+			free(0, a[i]);
+			free(1, b[i]);
+		}
+		return timer.elapsedNanoseconds() / double(nPasses * nEntities);
+	};
+
+	// Before: one pool for every component type of the same size
+	auto* sharedPool = PoolPool::getPool(sizeof(Payload));
+	const auto sharedTime = run([&] (int) { return sharedPool->alloc(); }, [&] (int, void* p) { sharedPool->free(p); });
+
+	// After: one pool per component type
+	const auto perTypeTime = run([&] (int type) { return ComponentPools::alloc(202 + type, sizeof(Payload)); }, [&] (int type, void* p) { ComponentPools::free(202 + type, p); });
+
+	std::cout << nEntities << " entities | shared size pool: " << sharedTime << " ns/component | per type pool: " << perTypeTime << " ns/component" << std::endl;
+}
@@ -0,0 +1,156 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+#include "test_threads.h"
+using namespace Halley;
+
+namespace {
+	size_t getNumTestThreads()
+	{
+		return std::max(size_t(2), size_t(std::thread::hardware_concurrency()));
+	}
+
+	void runFanOut(ExecutionQueue& queue, size_t nTasks, size_t nRoots)
+	{
+		std::atomic<size_t> done(0);
+		Vector<Future<void>> roots;
+		for (size_t i = 0; i < nRoots; ++i) {
+			const size_t count = nTasks * (i + 1) / nRoots - nTasks * i / nRoots;
+			roots.push_back(Concurrent::execute(queue, [&queue, &done, count] () {
+				for (size_t j = 0; j < count; ++j) {
+					queue.addToQueue([&done] () { done.fetch_add(1, std::memory_order_relaxed); });
+				}
+			}));
+		}
+		Concurrent::whenAll(roots.begin(), roots.end()).wait();
+
+		while (done.load() < nTasks) {
+			std::this_thread::yield();
+		}
+	}
+}
+
+TEST(Executor, RunsAllTasks)
+{
+	for (bool workStealing : { false, true }) {
+		ExecutionQueue queue(workStealing);
+		ThreadPool pool("Test", queue, getNumTestThreads(), makeTestThread);
+
+		runFanOut(queue, 10000, 4);
+		EXPECT_EQ(queue.getQueueDepth(), 0);
+	}
+}
+
+TEST(Executor, NestedWaitHelps)
+{
+	// Every worker blocks on subtasks it queued itself; without helping this relies on idle threads to make progress
+	ExecutionQueue queue(true);
+	ThreadPool pool("Test", queue, 2, makeTestThread);
+
+	std::atomic<int> total(0);
+	Vector<Future<void>> outer;
+	for (int i = 0; i < 8; ++i) {
+		outer.push_back(Concurrent::execute(queue, [&] () {
+			Vector<Future<void>> inner;
+			for (int j = 0; j < 16; ++j) {
+				inner.push_back(Concurrent::execute(queue, [&] () { ++total; }));
+			}
+			Concurrent::whenAll(inner.begin(), inner.end()).wait();
+		}));
+	}
+	Concurrent::whenAll(outer.begin(), outer.end()).wait();
+
+	EXPECT_EQ(total.load(), 8 * 16);
+}
+
+TEST(Executor, DISABLED_BenchmarkWorkStealing)
+{
+	const size_t nThreads = getNumTestThreads();
+
+	for (size_t nTasks : { size_t(10000), size_t(100000), size_t(1000000) }) {
+		for (bool workStealing : { false, true }) {
+			ExecutionQueue queue(workStealing);
+			ThreadPool pool("Bench", queue, nThreads, makeTestThread);
+
+			Stopwatch timer;
+			runFanOut(queue, nTasks, nThreads);
+			timer.pause();
+			const auto ns = timer.elapsedNanoseconds();
+
+			std::cout << (workStealing ? "work stealing" : "shared queue ") << " | " << nTasks << " tasks | "
+				<< (ns / 1000000.0) << " ms | " << (double(ns) / nTasks) << " ns/task | "
+				<< queue.getStealCount() << " steals" << std::endl;
+		}
+	}
+}
+
+TEST(Executor, ParallelForVisitsEachElementOnce)
+{
+	ExecutionQueue queue(true);
+	ThreadPool pool("Test", queue, getNumTestThreads(), makeTestThread);
+
+	for (size_t grainSize : { size_t(0), size_t(1), size_t(7), size_t(1000), size_t(100000) }) {
+		Vector<int> values(10000, 0);
+		Concurrent::parallelFor(queue, values.begin(), values.end(), [] (int& v) { ++v; }, grainSize);
+		EXPECT_TRUE(std::all_of(values.begin(), values.end(), [] (int v) { return v == 1; }));
+	}
+}
+
+TEST(Executor, ParallelForPropagatesExceptions)
+{
+	ExecutionQueue queue(true);
+	ThreadPool pool("Test", queue, getNumTestThreads(), makeTestThread);
+
+	Vector<int> values(1000);
+	for (size_t i = 0; i < values.size(); ++i) {
+		values[i] = int(i);
+	}
+
+	EXPECT_THROW(Concurrent::parallelFor(queue, values.begin(), values.end(), [] (int& v) {
+		if (v == 500) {
+			throw Exception("Test", HalleyExceptions::Utils);
+		}
+	}, 10), Exception);
+}
+
+TEST(Executor, DISABLED_BenchmarkParallelFor)
+{
+	const size_t nThreads = getNumTestThreads();
+	ExecutionQueue queue(true);
+	ThreadPool pool("Bench", queue, nThreads, makeTestThread);
+
+	const auto work = [] (int& v, int iterations)
+	{
+		uint32_t x = uint32_t(v) + 1;
+		for (int i = 0; i < iterations; ++i) {
+			x = x * 1664525u + 1013904223u;
+		}
+		v = int(x);
+	};
+
+	struct CostModel {
+		const char* name;
+		std::function<int(size_t)> iterations;
+	};
+	const CostModel costs[] = {
+		{ "cheap", [] (size_t) { return 10; } },
+		{ "expensive", [] (size_t) { return 1000; } },
+		{ "skewed", [] (size_t i) { return i % 64 == 0 ? 10000 : 10; } }
+	};
+
+	for (size_t familySize : { size_t(1000), size_t(10000), size_t(100000) }) {
+		for (const auto& cost : costs) {
+			Vector<int> values(familySize, 0);
+
+			// An even split into 8 pieces matches the old fixed Concurrent::foreach behaviour
+			const std::pair<const char*, size_t> grains[] = { { "8-way", (familySize + 7) / 8 }, { "auto", 0 }, { "64", 64 } };
+			for (const auto& [grainName, grainSize] : grains) {
+				Stopwatch timer;
+				Concurrent::parallelFor(queue, values.begin(), values.end(), [&] (int& v) { work(v, cost.iterations(size_t(&v - values.data()))); }, grainSize);
+				timer.pause();
+
+				std::cout << familySize << " entities | " << cost.name << " | grain " << grainName << " | "
+					<< (timer.elapsedNanoseconds() / 1000000.0) << " ms" << std::endl;
+			}
+		}
+	}
+}
@@ -0,0 +1,367 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+#include <filesystem>
+#include <fstream>
+using namespace Halley;
+
+namespace {
+	class TestSink final : public ILoggerSink {
+	public:
+		void log(LoggerLevel level, const String& msg) override
+		{
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				while (blocked) {
+					unblocked.wait(lock);
+				}
+				messages.emplace_back(level, msg);
+			}
+			if (onLog) {
+				onLog(msg);
+			}
+		}
+
+		void flush() override
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			++nFlushes;
+		}
+
+		void setBlocked(bool block)
+		{
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				blocked = block;
+			}
+			unblocked.notify_all();
+		}
+
+		Vector<std::pair<LoggerLevel, String>> getMessages()
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			return messages;
+		}
+
+		size_t getNumFlushes()
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			return nFlushes;
+		}
+
+		std::function<void(const String&)> onLog;
+
+	private:
+		std::mutex mutex;
+		std::condition_variable unblocked;
+		bool blocked = false;
+		Vector<std::pair<LoggerLevel, String>> messages;
+		size_t nFlushes = 0;
+	};
+
+	// Logger has no way to go back to not having an instance, so other tests log through this one afterwards
+	Logger& getDefaultLogger()
+	{
+		static Logger logger;
+		static StdOutSink sink(true);
+		static bool added = false;
+		Logger::setInstance(logger);
+		if (!added) {
+			Logger::addSink(sink);
+			added = true;
+		}
+		return logger;
+	}
+
+	class FileSink final : public ILoggerSink {
+	public:
+		explicit FileSink(const String& path)
+			: file(path.c_str(), std::ofstream::trunc)
+		{}
+
+		void log(LoggerLevel level, const String& msg) override
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			file << msg << '\n';
+		}
+
+		void flush() override
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			file.flush();
+		}
+
+	private:
+		std::mutex mutex;
+		std::ofstream file;
+	};
+
+	// Logs an exception from inside log() the first time it sees "trigger"
+	class ReentrantSink final : public ILoggerSink {
+	public:
+		void log(LoggerLevel level, const String& msg) override
+		{
+			messages.push_back(msg);
+			if (msg == "trigger" && !triggered) {
+				triggered = true;
+				Logger::logException(Exception("from sink", HalleyExceptions::Utils));
+			}
+		}
+
+		Vector<String> messages;
+
+	private:
+		bool triggered = false;
+	};
+
+	class TestLogger {
+	public:
+		TestLogger(size_t maxQueuedMessages, TestSink& sink)
+			: logger(maxQueuedMessages)
+			, sink(sink)
+		{
+			getDefaultLogger();
+			Logger::setInstance(logger);
+			Logger::addSink(sink);
+			Logger::setAsync(true);
+		}
+
+		~TestLogger()
+		{
+			Logger::setAsync(false);
+			Logger::removeSink(sink);
+			getDefaultLogger();
+		}
+
+	private:
+		Logger logger;
+		TestSink& sink;
+	};
+}
+
+TEST(Logger, AsyncKeepsEachThreadInOrder)
+{
+	TestSink sink;
+	constexpr int nThreads = 4;
+	constexpr int nMessages = 2000;
+	{
+		TestLogger logger(16384, sink);
+		Vector<std::thread> threads;
+		for (int i = 0; i < nThreads; ++i) {
+			threads.emplace_back([i] ()
+			{
+				for (int j = 0; j < nMessages; ++j) {
+					Logger::logInfo(toString(i) + ":" + toString(j));
+				}
+			});
+		}
+		for (auto& t: threads) {
+			t.join();
+		}
+		Logger::flush();
+		EXPECT_EQ(Logger::getNumDroppedMessages(), 0);
+	}
+
+	const auto messages = sink.getMessages();
+	ASSERT_EQ(messages.size(), size_t(nThreads * nMessages));
+	std::array<int, nThreads> next = {};
+	for (const auto& [level, msg]: messages) {
+		const auto parts = msg.split(':');
+		ASSERT_EQ(parts.size(), 2);
+		EXPECT_EQ(parts[1].toInteger(), next.at(parts[0].toInteger())++);
+	}
+
+	// Written in batches, rather than flushing every line
+	EXPECT_LT(sink.getNumFlushes(), messages.size());
+}
+
+TEST(Logger, AsyncDropsWhenFull)
+{
+	TestSink sink;
+	{
+		TestLogger logger(8, sink);
+
+		// Hold the writer up on its first message, so that the rest pile up in the queue
+		sink.setBlocked(true);
+		Logger::logInfo("first");
+		while (Logger::getNumDroppedMessages() == 0) {
+			Logger::logInfo("more");
+		}
+		const auto nDropped = Logger::getNumDroppedMessages();
+		sink.setBlocked(false);
+
+		// The writer reports how many got dropped once it catches up
+		Logger::flush();
+		EXPECT_EQ(Logger::getNumDroppedMessages(), nDropped);
+		const auto messages = sink.getMessages();
+		EXPECT_EQ(messages.front().second, "first");
+		EXPECT_EQ(messages.back().first, LoggerLevel::Warning);
+		EXPECT_TRUE(messages.back().second.contains("dropped " + toString(nDropped)));
+	}
+}
+
+TEST(Logger, AsyncKeepsWarningsWhenFull)
+{
+	TestSink sink;
+	{
+		TestLogger logger(8, sink);
+
+		sink.setBlocked(true);
+		Logger::logInfo("first");
+		while (Logger::getNumDroppedMessages() == 0) {
+			Logger::logInfo("more");
+		}
+		const auto nDropped = Logger::getNumDroppedMessages();
+
+		// The warning waits for the writer instead, so it has to come from another thread while this one unblocks it
+		std::thread thread([] () { Logger::logWarning("warning"); });
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		sink.setBlocked(false);
+		thread.join();
+
+		Logger::flush();
+		EXPECT_EQ(Logger::getNumDroppedMessages(), nDropped);
+		const auto messages = sink.getMessages();
+		EXPECT_TRUE(std::any_of(messages.begin(), messages.end(), [] (const auto& m) { return m.first == LoggerLevel::Warning && m.second == "warning"; }));
+	}
+}
+
+TEST(Logger, SyncOnlyFlushesErrors)
+{
+	TestSink sink;
+	Logger logger;
+	Logger::setInstance(logger);
+	Logger::addSink(sink);
+
+	for (int i = 0; i < 10; ++i) {
+		Logger::logInfo("info");
+		Logger::logWarning("warning");
+	}
+	EXPECT_EQ(sink.getNumFlushes(), 0);
+	Logger::logError("error");
+	EXPECT_EQ(sink.getNumFlushes(), 1);
+	EXPECT_EQ(sink.getMessages().size(), 21);
+
+	Logger::removeSink(sink);
+	getDefaultLogger();
+}
+
+TEST(Logger, DestructorWritesQueuedMessages)
+{
+	// The writer writes at most a queue's worth per batch, so what gets logged while it writes the last one waits for the next
+	TestSink sink;
+	sink.onLog = [] (const String& msg)
+	{
+		if (msg == "last") {
+			Logger::logInfo("late");
+		}
+	};
+
+	auto logger = std::make_unique<Logger>(8);
+	Logger::setInstance(*logger);
+	Logger::addSink(sink);
+	Logger::setAsync(true);
+
+	sink.setBlocked(true);
+	Logger::logInfo("first");
+	for (int i = 0; i < 6; ++i) {
+		Logger::logInfo("more");
+	}
+	Logger::logInfo("last");
+	ASSERT_EQ(Logger::getNumDroppedMessages(), 0);
+
+	// Stop the writer while it's held up on that batch, so that it doesn't get to the next one
+	std::thread thread([&] () { logger.reset(); });
+	std::this_thread::sleep_for(std::chrono::milliseconds(30));
+	sink.setBlocked(false);
+	thread.join();
+	getDefaultLogger();
+
+	const auto messages = sink.getMessages();
+	ASSERT_EQ(messages.size(), 9);
+	EXPECT_EQ(messages.back().second, "late");
+}
+
+TEST(Logger, SinksCanLogFromInsideLog)
+{
+	ReentrantSink sink;
+	{
+		Logger logger(1024);
+		getDefaultLogger();
+		Logger::setInstance(logger);
+		Logger::addSink(sink);
+		Logger::setAsync(true);
+
+		Logger::logInfo("trigger");
+		Logger::logInfo("after");
+		Logger::flush();
+
+		Logger::setAsync(false);
+		Logger::removeSink(sink);
+		getDefaultLogger();
+	}
+
+	ASSERT_EQ(sink.messages.size(), 3);
+	EXPECT_EQ(sink.messages[0], "trigger");
+	EXPECT_TRUE(sink.messages[1].contains("from sink"));
+	EXPECT_EQ(sink.messages[2], "after");
+}
+
+TEST(Logger, ExceptionsAreWrittenImmediately)
+{
+	TestSink sink;
+	TestLogger logger(1024, sink);
+
+	Logger::logInfo("before");
+	Logger::logException(Exception("oops", HalleyExceptions::Utils));
+
+	// Already written by the time logException returns, after what was queued before it
+	const auto messages = sink.getMessages();
+	ASSERT_EQ(messages.size(), 2);
+	EXPECT_EQ(messages[0].second, "before");
+	EXPECT_EQ(messages[1].first, LoggerLevel::Error);
+	EXPECT_TRUE(messages[1].second.contains("oops"));
+}
+
+TEST(Logger, DISABLED_BenchmarkLogging)
+{
+	// Worker threads logging heavily to a log file, as an asset import would
+	const auto path = (Path(std::filesystem::temp_directory_path().string()) / "halley_logger_benchmark.txt").getString();
+	constexpr int nThreads = 4;
+	constexpr int nMessages = 20000;
+
+	auto run = [&] (bool async)
+	{
+		FileSink sink(path);
+		Logger logger;
+		getDefaultLogger();
+		Logger::setInstance(logger);
+		Logger::addSink(sink);
+		Logger::setAsync(async);
+
+		Stopwatch timer;
+		Vector<std::thread> threads;
+		for (int i = 0; i < nThreads; ++i) {
+			threads.emplace_back([] ()
+			{
+				for (int j = 0; j < nMessages; ++j) {
+					Logger::logInfo("Imported asset " + toString(j));
+				}
+			});
+		}
+		for (auto& t: threads) {
+			t.join();
+		}
+		timer.pause();
+		const auto nDropped = Logger::getNumDroppedMessages();
+
+		Logger::setAsync(false);
+		Logger::removeSink(sink);
+		getDefaultLogger();
+		return std::make_pair(timer.elapsedNanoseconds() / double(nThreads * nMessages), nDropped);
+	};
+
+	const auto syncTime = run(false).first;
+	const auto [asyncTime, asyncDropped] = run(true);
+	std::filesystem::remove(path.cppStr());
+	std::cout << "sync: " << syncTime << " ns/message | async: " << asyncTime << " ns/message, " << asyncDropped << " dropped" << std::endl;
+}
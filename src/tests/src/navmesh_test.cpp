@@ -0,0 +1,473 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+#include "test_threads.h"
+#include <random>
+using namespace Halley;
+
+namespace {
+	// A square map of the given size, with a scattering of box obstacles
+	NavmeshSet makeMap(float size, size_t divisions, size_t nObstacles, uint32_t seed)
+	{
+		std::mt19937 rng(seed);
+		std::uniform_real_distribution<float> pos(0.0f, size);
+		std::uniform_real_distribution<float> side(size * 0.005f, size * 0.03f);
+
+		Vector<Polygon> obstacles;
+		for (size_t i = 0; i < nObstacles; ++i) {
+			obstacles.push_back(Polygon::makePolygon(Vector2f(pos(rng), pos(rng)), side(rng), side(rng)));
+		}
+
+		NavmeshGenerator::Params params{ NavmeshBounds(Vector2f(), Vector2f(size, 0), Vector2f(0, size), divisions, divisions, Vector2f(1, 1)) };
+		params.obstacles = obstacles;
+		params.agentSize = 4.0f;
+		return NavmeshGenerator::generate(params);
+	}
+
+	const Navmesh& getLargestNavmesh(const NavmeshSet& set)
+	{
+		return *std::max_element(set.getNavmeshes().begin(), set.getNavmeshes().end(), [] (const Navmesh& a, const Navmesh& b)
+		{
+			return a.getNumNodes() < b.getNumNodes();
+		});
+	}
+
+	Vector<NavigationQuery> makeQueries(const Navmesh& navmesh, size_t n, NavigationQuery::PostProcessingType postProcessing, uint32_t seed)
+	{
+		Random rng(seed);
+		Vector<NavigationQuery> result;
+		for (size_t i = 0; i < n; ++i) {
+			result.push_back(NavigationQuery(navmesh.getRandomPoint(rng), navmesh.getSubWorld(), navmesh.getRandomPoint(rng), navmesh.getSubWorld(), postProcessing));
+		}
+		return result;
+	}
+
+	// The search Navmesh::pathfind used before it had query contexts, allocating and clearing state for every node on each query
+	std::optional<Vector<Navmesh::NodeAndConn>> referencePathfind(const Navmesh& navmesh, const NavigationQuery& query)
+	{
+		struct State {
+			float gScore = std::numeric_limits<float>::infinity();
+			float fScore = std::numeric_limits<float>::infinity();
+			Navmesh::NodeAndConn cameFrom;
+			bool inOpenSet = false;
+			bool inClosedSet = false;
+		};
+
+		struct NodeComparator {
+			const Vector<State>& state;
+			bool operator()(Navmesh::NodeId a, Navmesh::NodeId b) const { return state[a].fScore > state[b].fScore; }
+		};
+
+		const auto fromId = navmesh.getNodeAt(query.from);
+		const auto toId = navmesh.getNodeAt(query.to);
+		if (!fromId || !toId) {
+			return {};
+		}
+
+		const auto& nodes = navmesh.getNodes();
+		Vector<State> state(nodes.size(), State{});
+		auto openSet = PriorityQueue<Navmesh::NodeId, NodeComparator>(NodeComparator{ state });
+		openSet.reserve(std::min(static_cast<size_t>(100), nodes.size()));
+
+		const Vector2f endPos = nodes[*toId].pos;
+		auto h = [&] (Vector2f pos) { return (pos - endPos).length() * 1.5f; };
+
+		state[*fromId].gScore = 0;
+		state[*fromId].fScore = h(nodes[*fromId].pos);
+		state[*fromId].inOpenSet = true;
+		openSet.push(*fromId);
+
+		while (!openSet.empty()) {
+			const auto curId = openSet.top();
+			if (curId == *toId) {
+				Vector<Navmesh::NodeAndConn> result;
+				for (Navmesh::NodeAndConn curNode(curId); true; curNode = state[curNode.node].cameFrom) {
+					result.push_back(curNode);
+					if (curNode.node == *fromId) {
+						break;
+					}
+				}
+				std::reverse(result.begin(), result.end());
+				return result;
+			}
+
+			state[curId].inOpenSet = false;
+			state[curId].inClosedSet = true;
+			openSet.pop();
+
+			const float gScore = state[curId].gScore;
+			const auto& curNode = nodes[curId];
+			for (size_t i = 0; i < curNode.nConnections; ++i) {
+				if (curNode.connections[i] && !state[curNode.connections[i].value()].inClosedSet) {
+					const auto nodeId = curNode.connections[i].value();
+					auto& neighState = state[nodeId];
+					const float neighScore = gScore + curNode.costs[i];
+					if (neighScore < neighState.gScore) {
+						neighState.cameFrom = Navmesh::NodeAndConn(curId, static_cast<uint16_t>(i));
+						neighState.gScore = neighScore;
+						neighState.fScore = neighScore + h(nodes[nodeId].pos);
+						if (!neighState.inOpenSet) {
+							neighState.inOpenSet = true;
+							openSet.push(nodeId);
+						} else {
+							openSet.update(nodeId);
+						}
+					}
+				}
+			}
+		}
+		return {};
+	}
+
+	// A chunk split into quadrant regions, with obstacles kept clear of its borders so it links up with its neighbours
+	NavmeshSet makeChunk(float chunkSize, std::mt19937& rng)
+	{
+		const float margin = chunkSize * 0.1f;
+		std::uniform_real_distribution<float> pos(margin, chunkSize - 2 * margin);
+		std::uniform_real_distribution<float> side(chunkSize * 0.02f, chunkSize * 0.08f);
+
+		Vector<Polygon> obstacles;
+		for (int i = 0; i < 8; ++i) {
+			obstacles.push_back(Polygon::makePolygon(Vector2f(pos(rng), pos(rng)), side(rng), side(rng)));
+		}
+
+		const float half = chunkSize / 2;
+		Vector<Polygon> regions;
+		regions.push_back(Polygon::makePolygon(Vector2f(0, 0), half, half));
+		regions.push_back(Polygon::makePolygon(Vector2f(half, 0), half, half));
+		regions.push_back(Polygon::makePolygon(Vector2f(0, half), half, half));
+		regions.push_back(Polygon::makePolygon(Vector2f(half, half), half, half));
+
+		NavmeshGenerator::Params params{ NavmeshBounds(Vector2f(), Vector2f(chunkSize, 0), Vector2f(0, chunkSize), 8, 8, Vector2f(1, 1)) };
+		params.obstacles = obstacles;
+		params.regions = regions;
+		params.agentSize = 4.0f;
+		return NavmeshGenerator::generate(params);
+	}
+
+	// A grid of chunks linked into one set, like a streamed world would be
+	NavmeshSet makeChunkedMap(int chunksX, int chunksY, float chunkSize, uint32_t seed)
+	{
+		std::mt19937 rng(seed);
+		NavmeshSet result;
+		for (int y = 0; y < chunksY; ++y) {
+			for (int x = 0; x < chunksX; ++x) {
+				result.addChunk(makeChunk(chunkSize, rng), Vector2f(float(x), float(y)) * chunkSize, Vector2i(x, y));
+			}
+		}
+		result.linkNavmeshes();
+		return result;
+	}
+
+	Vector2f getPortalPos(const NavmeshSet& set, uint16_t region, uint16_t edge)
+	{
+		// Both sides of a link sit where the lower numbered region has it
+		const auto [toRegion, toEdge] = set.getPortalDestination(region, edge);
+		return region < toRegion ? set.getNavmeshes()[region].getPortals()[edge].pos : set.getNavmeshes()[toRegion].getPortals()[toEdge].pos;
+	}
+
+	// Length of the straight lines from the start, through each portal on the route, to the end
+	float getRouteCost(const NavmeshSet& set, const NavigationQuery& query, const NavigationPath& path)
+	{
+		float cost = 0;
+		Vector2f pos = query.from;
+		for (size_t i = 0; i + 1 < path.regions.size(); ++i) {
+			const auto& region = path.regions[i];
+			EXPECT_EQ(set.getPortalDestination(region.regionNodeId, region.exitEdgeId).first, path.regions[i + 1].regionNodeId);
+			const auto portalPos = getPortalPos(set, region.regionNodeId, region.exitEdgeId);
+			cost += (portalPos - pos).length();
+			pos = portalPos;
+		}
+		return cost + (query.to - pos).length();
+	}
+
+	// The cheapest route cost between two regions, by Dijkstra over every portal in the set
+	std::optional<float> getBestRouteCost(const NavmeshSet& set, const NavigationQuery& query, uint16_t fromRegion, uint16_t toRegion)
+	{
+		using PortalId = std::pair<uint16_t, uint16_t>;
+		auto getConnectedPortals = [&] (uint16_t region)
+		{
+			Vector<PortalId> result;
+			const auto& portals = set.getNavmeshes()[region].getPortals();
+			for (size_t i = 0; i < portals.size(); ++i) {
+				if (portals[i].connected) {
+					result.emplace_back(region, static_cast<uint16_t>(i));
+				}
+			}
+			return result;
+		};
+
+		std::map<PortalId, float> distance;
+		std::set<std::pair<float, PortalId>> open;
+		auto visit = [&] (PortalId portal, float d)
+		{
+			const auto iter = distance.find(portal);
+			if (iter == distance.end() || d < iter->second) {
+				if (iter != distance.end()) {
+					open.erase({ iter->second, portal });
+				}
+				distance[portal] = d;
+				open.insert({ d, portal });
+			}
+		};
+
+		for (const auto& portal: getConnectedPortals(fromRegion)) {
+			visit(portal, (getPortalPos(set, portal.first, portal.second) - query.from).length());
+		}
+
+		std::optional<float> best;
+		while (!open.empty()) {
+			const auto [d, portal] = *open.begin();
+			open.erase(open.begin());
+
+			const auto pos = getPortalPos(set, portal.first, portal.second);
+			const auto dstRegion = set.getPortalDestination(portal.first, portal.second).first;
+			if (dstRegion == toRegion) {
+				const float total = d + (query.to - pos).length();
+				best = std::min(best.value_or(total), total);
+			}
+			for (const auto& next: getConnectedPortals(dstRegion)) {
+				visit(next, d + (getPortalPos(set, next.first, next.second) - pos).length());
+			}
+		}
+		return best;
+	}
+
+	// Queries between random points at least minDistance apart
+	Vector<NavigationQuery> makeLongQueries(const NavmeshSet& set, size_t n, float minDistance, uint32_t seed)
+	{
+		Random rng(seed);
+		const auto navmeshes = set.getNavmeshes();
+		auto randomPoint = [&] ()
+		{
+			return navmeshes[rng.getSizeT(0, navmeshes.size() - 1)].getRandomPoint(rng);
+		};
+
+		Vector<NavigationQuery> result;
+		while (result.size() < n) {
+			const auto from = randomPoint();
+			const auto to = randomPoint();
+			if ((to - from).length() >= minDistance) {
+				result.push_back(NavigationQuery(from, 0, to, 0, NavigationQuery::PostProcessingType::None));
+			}
+		}
+		return result;
+	}
+
+	float getPathCost(const Navmesh& navmesh, const Vector<Navmesh::NodeAndConn>& path)
+	{
+		float cost = 0;
+		for (size_t i = 0; i + 1 < path.size(); ++i) {
+			cost += navmesh.getNodes()[path[i].node].costs[path[i].connectionIdx];
+		}
+		return cost;
+	}
+}
+
+TEST(Navmesh, PathfindMatchesReference)
+{
+	const auto set = makeMap(2000.0f, 20, 150, 1);
+	const auto& navmesh = getLargestNavmesh(set);
+	const auto queries = makeQueries(navmesh, 500, NavigationQuery::PostProcessingType::None, 2);
+
+	// Reusing a context gives the same results as starting from scratch each time
+	Navmesh::QueryContext context;
+	for (const auto& query: queries) {
+		const auto reference = referencePathfind(navmesh, query);
+		const auto result = navmesh.pathfindNodes(query, context);
+		ASSERT_EQ(reference.has_value(), result.has_value()) << query.toString();
+		if (result) {
+			EXPECT_FLOAT_EQ(getPathCost(navmesh, *result), getPathCost(navmesh, *reference)) << query.toString();
+			EXPECT_EQ(result->front().node, reference->front().node);
+			EXPECT_EQ(result->back().node, reference->back().node);
+		}
+	}
+}
+
+TEST(Navmesh, PathfindBatchMatchesSingleQueries)
+{
+	const auto set = makeMap(2000.0f, 20, 150, 3);
+	const auto& navmesh = getLargestNavmesh(set);
+	const auto queries = makeQueries(navmesh, 300, NavigationQuery::PostProcessingType::Simple, 4);
+
+	ExecutionQueue queue(true);
+	ThreadPool pool("Test", queue, 4, makeTestThread);
+	const auto results = set.pathfindBatch(queries, queue);
+
+	ASSERT_EQ(results.size(), queries.size());
+	for (size_t i = 0; i < queries.size(); ++i) {
+		EXPECT_EQ(results[i], set.pathfind(queries[i])) << i;
+	}
+}
+
+TEST(Navmesh, RegionPathsAreShortest)
+{
+	const auto set = makeChunkedMap(5, 5, 1000.0f, 9);
+	const auto queries = makeLongQueries(set, 200, 2000.0f, 10);
+
+	Vector<std::optional<float>> best;
+	for (const auto& query: queries) {
+		const auto fromRegion = static_cast<uint16_t>(set.getNavMeshIdxAt(query.from, 0));
+		const auto toRegion = static_cast<uint16_t>(set.getNavMeshIdxAt(query.to, 0));
+		best.push_back(getBestRouteCost(set, query, fromRegion, toRegion));
+	}
+
+	// The first passes search the portal graph directly, the later ones run off the routes cached for each destination
+	for (int pass = 0; pass < 20; ++pass) {
+		for (size_t i = 0; i < queries.size(); ++i) {
+			const auto& query = queries[i];
+			const auto fromRegion = static_cast<uint16_t>(set.getNavMeshIdxAt(query.from, 0));
+			const auto toRegion = static_cast<uint16_t>(set.getNavMeshIdxAt(query.to, 0));
+			const auto path = set.pathfind(query);
+
+			ASSERT_EQ(best[i].has_value(), path.has_value()) << query.toString();
+			if (path) {
+				ASSERT_GE(path->regions.size(), 2);
+				EXPECT_EQ(path->regions.front().regionNodeId, fromRegion);
+				EXPECT_EQ(path->regions.back().regionNodeId, toRegion);
+				EXPECT_NEAR(getRouteCost(set, query, *path), *best[i], *best[i] * 0.0001f) << query.toString();
+			}
+		}
+	}
+	EXPECT_GT(set.getRouteCacheSize(), 0);
+}
+
+TEST(Navmesh, RouteCacheStaysWithinMaxSize)
+{
+	auto set = makeChunkedMap(5, 5, 1000.0f, 12);
+	const auto queries = makeLongQueries(set, 200, 2000.0f, 13);
+	const auto reference = set;
+
+	// Room for the routes into a handful of regions, so that they keep getting dropped and built again
+	constexpr size_t maxSize = 64 * 1024;
+	set.setRouteCacheMaxSize(maxSize);
+	for (int pass = 0; pass < 20; ++pass) {
+		for (const auto& query: queries) {
+			const auto path = set.pathfind(query);
+			ASSERT_EQ(path.has_value(), reference.pathfind(query).has_value());
+			if (path) {
+				EXPECT_NEAR(getRouteCost(set, query, *path), getRouteCost(reference, query, *reference.pathfind(query)), 0.1f) << query.toString();
+			}
+			ASSERT_LE(set.getRouteCacheSize(), maxSize);
+		}
+	}
+	EXPECT_GT(set.getRouteCacheSize(), 0);
+
+	// Shrinking it drops what no longer fits
+	set.setRouteCacheMaxSize(0);
+	EXPECT_EQ(set.getRouteCacheSize(), 0);
+	for (const auto& query: queries) {
+		EXPECT_EQ(set.pathfind(query).has_value(), reference.pathfind(query).has_value());
+	}
+	EXPECT_EQ(set.getRouteCacheSize(), 0);
+}
+
+TEST(Navmesh, RegionPathsUpdateWhenChunksAreAdded)
+{
+	constexpr float chunkSize = 1000.0f;
+	std::mt19937 rng(11);
+	const auto left = makeChunk(chunkSize, rng);
+	const auto middle = makeChunk(chunkSize, rng);
+	const auto right = makeChunk(chunkSize, rng);
+
+	// With a gap between them, there's no way across
+	NavmeshSet set;
+	set.addChunk(left, Vector2f(0, 0), Vector2i(0, 0));
+	set.addChunk(right, Vector2f(2 * chunkSize, 0), Vector2i(2, 0));
+	set.linkNavmeshes();
+
+	const auto query = NavigationQuery(Vector2f(50, 50), 0, Vector2f(3 * chunkSize - 50, 50), 0, NavigationQuery::PostProcessingType::None);
+	EXPECT_FALSE(set.pathfind(query));
+
+	set.addChunk(middle, Vector2f(chunkSize, 0), Vector2i(1, 0));
+	set.linkNavmeshes();
+	const auto path = set.pathfind(query);
+	ASSERT_TRUE(path);
+
+	const auto fromRegion = static_cast<uint16_t>(set.getNavMeshIdxAt(query.from, 0));
+	const auto toRegion = static_cast<uint16_t>(set.getNavMeshIdxAt(query.to, 0));
+	EXPECT_NEAR(getRouteCost(set, query, *path), getBestRouteCost(set, query, fromRegion, toRegion).value(), 0.1f);
+}
+
+TEST(Navmesh, DISABLED_BenchmarkPathfind)
+{
+	// Agents repathing across a large navmesh
+	const auto set = makeMap(10000.0f, 60, 2000, 5);
+	const auto& navmesh = getLargestNavmesh(set);
+	const auto queries = makeQueries(navmesh, 3000, NavigationQuery::PostProcessingType::None, 6);
+
+	auto report = [&] (const char* name, int64_t ns)
+	{
+		std::cout << name << " | " << navmesh.getNumNodes() << " nodes | " << (queries.size() / (ns / 1000000000.0)) << " queries/s" << std::endl;
+	};
+
+	size_t found = 0;
+	Stopwatch referenceTimer;
+	for (const auto& query: queries) {
+		found += referencePathfind(navmesh, query) ? 1 : 0;
+	}
+	referenceTimer.pause();
+	report("reference nodes    ", referenceTimer.elapsedNanoseconds());
+
+	size_t foundNew = 0;
+	Stopwatch nodesTimer;
+	for (const auto& query: queries) {
+		foundNew += navmesh.pathfindNodes(query) ? 1 : 0;
+	}
+	nodesTimer.pause();
+	report("pathfindNodes      ", nodesTimer.elapsedNanoseconds());
+	EXPECT_EQ(found, foundNew);
+
+	Stopwatch singleTimer;
+	for (const auto& query: queries) {
+		const auto path = set.pathfind(query);
+	}
+	singleTimer.pause();
+	report("pathfind           ", singleTimer.elapsedNanoseconds());
+
+	const size_t nThreads = std::max(size_t(2), size_t(std::thread::hardware_concurrency()));
+	ExecutionQueue queue(true);
+	ThreadPool pool("Bench", queue, nThreads, makeTestThread);
+	Stopwatch batchTimer;
+	const auto results = set.pathfindBatch(queries, queue);
+	batchTimer.pause();
+	report("pathfindBatch      ", batchTimer.elapsedNanoseconds());
+}
+
+TEST(Navmesh, DISABLED_BenchmarkRegionPaths)
+{
+	// Queries across most of a 12x12 chunk map
+	constexpr float chunkSize = 1000.0f;
+	const auto set = makeChunkedMap(12, 12, chunkSize, 7);
+	const auto queries = makeLongQueries(set, 1000, 8 * chunkSize, 8);
+
+	// Agents heading for a few shared destinations, from all over the map
+	Vector<NavigationQuery> busyQueries;
+	for (size_t i = 0; i < queries.size(); ++i) {
+		auto query = queries[i];
+		query.to = queries[i % 10].to;
+		busyQueries.push_back(query);
+	}
+
+	auto run = [&] (const char* name, gsl::span<const NavigationQuery> qs)
+	{
+		size_t found = 0;
+		size_t regions = 0;
+		Stopwatch timer;
+		for (const auto& query: qs) {
+			if (const auto path = set.pathfind(query)) {
+				++found;
+				regions += path->regions.size();
+			}
+		}
+		timer.pause();
+
+		std::cout << name << " | " << set.getNavmeshes().size() << " regions | " << found << "/" << qs.size() << " found, " << (double(regions) / std::max(found, size_t(1))) << " regions per path | "
+			<< (timer.elapsedNanoseconds() / 1000.0 / qs.size()) << " us/query | " << (set.getRouteCacheSize() / 1024) << " KB cached" << std::endl;
+	};
+
+	// Random destinations mostly miss the cache, busy ones get their routes built after a few queries
+	run("random, first pass     ", queries);
+	run("random, second pass    ", queries);
+	run("busy destinations      ", busyQueries);
+	run("busy, second pass      ", busyQueries);
+}
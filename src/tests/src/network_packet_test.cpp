@@ -0,0 +1,193 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+#include <halley/net/connection/message_queue_udp.h>
+#include <deque>
+using namespace Halley;
+
+namespace {
+	std::atomic<uint64_t> numHeapAllocations(0);
+}
+
+// Counts every heap allocation in the test executable, so the benchmarks below can report allocations per packet
+void* operator new(size_t size)
+{
+	numHeapAllocations.fetch_add(1, std::memory_order_relaxed);
+	if (void* p = std::malloc(size == 0 ? 1 : size)) {
+		return p;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+	std::free(p);
+}
+
+namespace {
+	class LoopbackConnection : public IConnection {
+	public:
+		void setRemote(LoopbackConnection& r)
+		{
+			remote = &r;
+		}
+
+		void close() override { status = ConnectionStatus::Closed; }
+		ConnectionStatus getStatus() const override { return status; }
+		bool isSupported(TransmissionType type) const override { return type == TransmissionType::Unreliable; }
+
+		void send(TransmissionType type, OutboundNetworkPacket packet) override
+		{
+			remote->inbox.push_back(InboundNetworkPacket(std::move(packet)));
+		}
+
+		bool receive(InboundNetworkPacket& packet) override
+		{
+			if (inbox.empty()) {
+				return false;
+			}
+			packet = std::move(inbox.front());
+			inbox.pop_front();
+			return true;
+		}
+
+	private:
+		LoopbackConnection* remote = nullptr;
+		ConnectionStatus status = ConnectionStatus::Connected;
+		std::deque<InboundNetworkPacket> inbox;
+	};
+
+	std::pair<std::shared_ptr<AckUnreliableConnection>, std::shared_ptr<AckUnreliableConnection>> makeLoopbackPair()
+	{
+		auto a = std::make_shared<LoopbackConnection>();
+		auto b = std::make_shared<LoopbackConnection>();
+		a->setRemote(*b);
+		b->setRemote(*a);
+		return { std::make_shared<AckUnreliableConnection>(a), std::make_shared<AckUnreliableConnection>(b) };
+	}
+
+	Bytes makePayload(size_t size, int seed)
+	{
+		Bytes result(size);
+		for (size_t i = 0; i < size; ++i) {
+			result[i] = Byte((i * 31 + seed) & 0xFF);
+		}
+		return result;
+	}
+
+	bool sameBytes(gsl::span<const gsl::byte> a, const Bytes& b)
+	{
+		return size_t(a.size()) == b.size() && memcmp(a.data(), b.data(), b.size()) == 0;
+	}
+}
+
+TEST(NetworkPacket, AddHeaderInPlace)
+{
+	auto packet = OutboundNetworkPacket(makePayload(100, 1));
+	const auto* start = packet.getBytes().data();
+
+	packet.addHeader(uint16_t(0x1234));
+	EXPECT_EQ(packet.getSize(), 102);
+	EXPECT_EQ(packet.getBytes().data(), start - 2);
+}
+
+TEST(NetworkPacket, CopiesShareUntilWritten)
+{
+	const auto payload = makePayload(100, 2);
+	auto a = OutboundNetworkPacket(payload);
+	auto b = a;
+	EXPECT_EQ(a.getBytes().data(), b.getBytes().data());
+
+	b.addHeader(uint8_t(7));
+	EXPECT_TRUE(sameBytes(a.getBytes(), payload));
+	EXPECT_EQ(b.getSize(), 101);
+	EXPECT_TRUE(sameBytes(b.getBytes().subspan(1), payload));
+
+	auto in = InboundNetworkPacket(std::move(b));
+	uint8_t header = 0;
+	in.extractHeader(header);
+	EXPECT_EQ(header, 7);
+	EXPECT_TRUE(sameBytes(in.getBytes(), payload));
+}
+
+TEST(NetworkPacket, MessageQueueRoundTrip)
+{
+	auto [connA, connB] = makeLoopbackPair();
+	MessageQueueUDP queueA(connA);
+	MessageQueueUDP queueB(connB);
+	queueA.setChannel(0, ChannelSettings(true, true));
+	queueB.setChannel(0, ChannelSettings(true, true));
+
+	Vector<Bytes> sent;
+	for (int i = 0; i < 50; ++i) {
+		sent.push_back(makePayload(size_t(i * 37 % 700), i));
+		queueA.enqueue(OutboundNetworkPacket(sent.back()), 0);
+	}
+	queueA.sendAll();
+
+	const auto received = queueB.receivePackets();
+	ASSERT_EQ(received.size(), sent.size());
+	for (size_t i = 0; i < sent.size(); ++i) {
+		EXPECT_TRUE(sameBytes(received[i].getBytes(), sent[i]));
+	}
+}
+
+TEST(NetworkPacket, DISABLED_BenchmarkLoopback)
+{
+	constexpr int nPackets = 200000;
+	const auto payload = makePayload(200, 3);
+
+	// Raw acked connection, one datagram per packet
+	{
+		auto [connA, connB] = makeLoopbackPair();
+		InboundNetworkPacket packet;
+
+		NetworkPacketBufferPool::get().resetStats();
+		const auto allocsBefore = numHeapAllocations.load();
+		Stopwatch timer;
+		for (int i = 0; i < nPackets; ++i) {
+			auto& from = i % 2 == 0 ? connA : connB;
+			auto& to = i % 2 == 0 ? connB : connA;
+			from->send(IConnection::TransmissionType::Unreliable, OutboundNetworkPacket(payload));
+			while (to->receive(packet)) {}
+		}
+		timer.pause();
+
+		const auto allocs = numHeapAllocations.load() - allocsBefore;
+		std::cout << "AckUnreliableConnection | " << (nPackets / (timer.elapsedNanoseconds() / 1000000000.0)) << " packets/s | "
+			<< (double(allocs) / nPackets) << " allocs/packet | "
+			<< (double(NetworkPacketBufferPool::get().getStats().allocated) / nPackets) << " buffer allocs/packet" << std::endl;
+	}
+
+	// Full message queue, replying to every message so each packet carries an ack
+	{
+		auto [connA, connB] = makeLoopbackPair();
+		MessageQueueUDP queueA(connA);
+		MessageQueueUDP queueB(connB);
+		for (auto* queue: { &queueA, &queueB }) {
+			queue->setChannel(0, ChannelSettings(true, true));
+		}
+
+		NetworkPacketBufferPool::get().resetStats();
+		const auto allocsBefore = numHeapAllocations.load();
+		Stopwatch timer;
+		for (int i = 0; i < nPackets; ++i) {
+			auto& from = i % 2 == 0 ? queueA : queueB;
+			auto& to = i % 2 == 0 ? queueB : queueA;
+			from.enqueue(OutboundNetworkPacket(payload), 0);
+			from.sendAll();
+			const auto received = to.receivePackets();
+			EXPECT_EQ(received.size(), 1);
+		}
+		timer.pause();
+
+		const auto allocs = numHeapAllocations.load() - allocsBefore;
+		std::cout << "MessageQueueUDP         | " << (nPackets / (timer.elapsedNanoseconds() / 1000000000.0)) << " packets/s | "
+			<< (double(allocs) / nPackets) << " allocs/packet | "
+			<< (double(NetworkPacketBufferPool::get().getStats().allocated) / nPackets) << " buffer allocs/packet" << std::endl;
+	}
+}
@@ -0,0 +1,209 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+#include <halley/file_formats/json/json.h>
+using namespace Halley;
+
+namespace {
+	void recordNested(ProfilerCapture& capture, int n)
+	{
+		const ProfilerName outerName("outer");
+		const ProfilerName innerName("inner");
+		for (int i = 0; i < n; ++i) {
+			const auto outer = capture.recordEventStart(ProfilerEventType::Game, outerName);
+			const auto inner = capture.recordEventStart(ProfilerEventType::DiskIO, innerName);
+			capture.recordEventEnd(inner);
+			capture.recordEventEnd(outer);
+		}
+	}
+}
+
+TEST(Profiler, NestsEventsOnEachThread)
+{
+	ProfilerCapture capture(1024);
+	capture.startFrame(true);
+
+	constexpr int nThreads = 4;
+	constexpr int nEvents = 100;
+	Vector<std::thread> threads;
+	for (int i = 0; i < nThreads; ++i) {
+		threads.emplace_back([&capture, i] ()
+		{
+			ProfilerCapture::setThreadName("Worker " + toString(i));
+			recordNested(capture, nEvents);
+		});
+	}
+	for (auto& t: threads) {
+		t.join();
+	}
+
+	capture.endFrame();
+	const auto data = capture.getCapture();
+	EXPECT_EQ(data.getEvents().size(), size_t(nThreads * nEvents * 2));
+	EXPECT_EQ(capture.getNumDroppedEvents(), 0);
+
+	ASSERT_EQ(data.getThreads().size(), size_t(nThreads));
+	for (const auto& thread: data.getThreads()) {
+		EXPECT_TRUE(thread.name.startsWith("Worker "));
+		EXPECT_EQ(thread.maxDepth, 1);
+
+		// Each inner event sits inside the outer event that precedes it on its thread
+		const ProfilerData::Event* outer = nullptr;
+		for (const auto& e: data.getEvents()) {
+			if (e.threadId != thread.id) {
+				continue;
+			}
+			if (e.name == "outer") {
+				EXPECT_EQ(e.depth, 0);
+				outer = &e;
+			} else {
+				EXPECT_EQ(e.name, "inner");
+				EXPECT_EQ(e.depth, 1);
+				ASSERT_NE(outer, nullptr);
+				EXPECT_GE(e.startTime, outer->startTime);
+				EXPECT_LE(e.endTime, outer->endTime);
+			}
+		}
+	}
+}
+
+TEST(Profiler, RecoversFromFullBuffers)
+{
+	ProfilerCapture capture(8);
+
+	// Only the first eight starts fit, and none of the ends
+	capture.startFrame(true);
+	Vector<ProfilerCapture::EventId> ids;
+	for (int i = 0; i < 20; ++i) {
+		ids.push_back(capture.recordEventStart(ProfilerEventType::Game, ProfilerName("nested")));
+	}
+	for (auto iter = ids.rbegin(); iter != ids.rend(); ++iter) {
+		capture.recordEventEnd(*iter);
+	}
+	capture.endFrame();
+	EXPECT_EQ(capture.getNumDroppedEvents(), 20);
+
+	const auto first = capture.getCapture();
+	ASSERT_EQ(first.getEvents().size(), 8);
+	EXPECT_EQ(first.getEvents().back().depth, 7);
+	EXPECT_EQ(first.getEvents().back().endTime, first.getEndTime());
+
+	// The next event back at the top closes everything that was left open
+	capture.startFrame(true);
+	capture.recordEventEnd(capture.recordEventStart(ProfilerEventType::Game, ProfilerName("after")));
+	capture.endFrame();
+
+	const auto second = capture.getCapture();
+	ASSERT_EQ(second.getEvents().size(), 9);
+	EXPECT_EQ(second.getEvents().back().name, "after");
+	const auto& after = second.getEvents().back();
+	EXPECT_EQ(after.depth, 0);
+	for (size_t i = 0; i + 1 < second.getEvents().size(); ++i) {
+		EXPECT_EQ(second.getEvents()[i].endTime, after.startTime);
+	}
+}
+
+TEST(Profiler, ContinuousCaptureExportsChromeTrace)
+{
+	ProfilerCapture capture;
+	ProfilerCapture::setThreadName("main");
+	capture.startContinuousCapture();
+
+	// Frames aren't asked to record, but the continuous capture records them anyway
+	constexpr int nFrames = 3;
+	for (int i = 0; i < nFrames; ++i) {
+		capture.startFrame(false);
+		EXPECT_TRUE(capture.isRecording());
+		capture.recordEventEnd(capture.recordEventStart(ProfilerEventType::WorldSystemUpdate, ProfilerName("Say \"hi\"")));
+		capture.recordEventEnd(capture.recordEventStart(ProfilerEventType::CoreRender, ProfilerName()));
+		capture.addCounter(ProfilerCounterType::ResourceHits, 2);
+		capture.endFrame();
+	}
+
+	const auto data = capture.stopContinuousCapture();
+	EXPECT_FALSE(capture.isCapturingContinuously());
+	EXPECT_EQ(data.getEvents().size(), size_t(nFrames * 2));
+	EXPECT_EQ(data.getCounter(ProfilerCounterType::ResourceHits), nFrames * 2);
+
+	const auto trace = data.toChromeTrace();
+	Json::Value root;
+	Json::Reader reader;
+	ASSERT_TRUE(reader.parse(trace.cppStr(), root)) << trace;
+
+	int nNamed = 0;
+	int nUnnamed = 0;
+	double lastTs = -1;
+	bool foundThreadName = false;
+	for (const auto& e: root["traceEvents"]) {
+		const auto ph = e["ph"].asString();
+		if (ph == "X") {
+			EXPECT_GE(e["ts"].asDouble(), lastTs);
+			EXPECT_GE(e["dur"].asDouble(), 0.0);
+			lastTs = e["ts"].asDouble();
+			if (e["name"].asString() == "Say \"hi\"") {
+				EXPECT_EQ(e["cat"].asString(), "worldSystemUpdate");
+				++nNamed;
+			} else {
+				EXPECT_EQ(e["name"].asString(), "coreRender");
+				++nUnnamed;
+			}
+		} else if (ph == "M" && e["name"].asString() == "thread_name") {
+			EXPECT_EQ(e["args"]["name"].asString(), "main");
+			foundThreadName = true;
+		} else if (ph == "C") {
+			EXPECT_EQ(e["args"]["resourceHits"].asInt(), nFrames * 2);
+		}
+	}
+	EXPECT_EQ(nNamed, nFrames);
+	EXPECT_EQ(nUnnamed, nFrames);
+	EXPECT_TRUE(foundThreadName);
+}
+
+TEST(Profiler, ContinuousCaptureIsCapped)
+{
+	ProfilerCapture capture(1024, 5);
+	capture.startContinuousCapture();
+	for (int i = 0; i < 3; ++i) {
+		capture.startFrame(false);
+		recordNested(capture, 1);
+		capture.endFrame();
+	}
+
+	// The first events to end are kept, and the rest are counted as dropped, which here is the last frame's outer event
+	const auto data = capture.stopContinuousCapture();
+	ASSERT_EQ(data.getEvents().size(), 5);
+	EXPECT_EQ(capture.getNumDroppedEvents(), 1);
+	EXPECT_EQ(data.getEvents().front().name, "outer");
+	EXPECT_EQ(data.getEvents().back().name, "inner");
+
+	// A new session starts with room for as many again
+	capture.startContinuousCapture();
+	capture.startFrame(false);
+	recordNested(capture, 1);
+	capture.endFrame();
+	EXPECT_EQ(capture.stopContinuousCapture().getEvents().size(), 2);
+	EXPECT_EQ(capture.getNumDroppedEvents(), 1);
+}
+
+TEST(Profiler, DISABLED_BenchmarkRecording)
+{
+	// Frames of a few thousand events, as a busy game would record with the profiler open
+	constexpr int nFrames = 1000;
+	constexpr int nPerFrame = 2500;
+	ProfilerCapture capture;
+
+	Stopwatch recordTimer(false);
+	Stopwatch frameTimer(false);
+	for (int i = 0; i < nFrames; ++i) {
+		capture.startFrame(true);
+		recordTimer.start();
+		recordNested(capture, nPerFrame / 2);
+		recordTimer.pause();
+		frameTimer.start();
+		capture.endFrame();
+		const auto data = capture.getCapture();
+		frameTimer.pause();
+	}
+
+	const auto nEvents = double(nFrames) * nPerFrame;
+	std::cout << "record: " << (recordTimer.elapsedNanoseconds() / nEvents) << " ns/event | read and capture: " << (frameTimer.elapsedNanoseconds() / nEvents) << " ns/event" << std::endl;
+}
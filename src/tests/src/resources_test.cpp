@@ -0,0 +1,225 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+using namespace Halley;
+
+namespace {
+	class TestResource final : public Resource {
+	public:
+		explicit TestResource(size_t bytes) : bytes(bytes) {}
+
+		static constexpr AssetType getAssetType() { return AssetType::BinaryFile; }
+		static std::shared_ptr<TestResource> loadResource(ResourceLoader& loader) { return {}; }
+
+		ResourceMemoryUsage getMemoryUsage() const override
+		{
+			ResourceMemoryUsage result;
+			result.ramUsage = bytes;
+			return result;
+		}
+
+	private:
+		size_t bytes;
+	};
+
+	// Resources without a locator, loading TestResources through a custom loader. The disk IO queue has no threads, so async loads only run when the test runs them.
+	class TestResources {
+	public:
+		TestResources()
+		{
+			Executors::setInstance(executors);
+			resources = std::make_unique<Resources>(std::unique_ptr<ResourceLocator>(), api, ResourceOptions());
+			resources->init<TestResource>();
+		}
+
+		Resources& get() { return *resources; }
+
+		void setLoader(ResourceCollectionBase::ResourceLoaderFunc loader)
+		{
+			resources->of<TestResource>().setResourceLoader(std::move(loader));
+		}
+
+		void destroy()
+		{
+			resources.reset();
+		}
+
+		static void runAsyncLoads()
+		{
+			for (auto& task: Executors::getDiskIO().getAll()) {
+				task();
+			}
+		}
+
+	private:
+		Executors executors;
+		HalleyAPI api{};
+		std::unique_ptr<Resources> resources;
+	};
+}
+
+TEST(Resources, DestructorWaitsForRunningAsyncLoads)
+{
+	TestResources resources;
+
+	std::mutex mutex;
+	std::condition_variable condition;
+	bool loadStarted = false;
+	bool loadReleased = false;
+	resources.setLoader([&] (const String& assetId, ResourceLoadPriority priority)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		loadStarted = true;
+		condition.notify_all();
+		condition.wait(lock, [&] () { return loadReleased; });
+		return std::make_shared<TestResource>(1);
+	});
+
+	auto future = resources.get().getAsync<TestResource>("a");
+	std::thread ioThread([] () { TestResources::runAsyncLoads(); });
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		condition.wait(lock, [&] () { return loadStarted; });
+	}
+
+	// Destroying Resources has to wait for the load that's running to finish with its collection
+	std::atomic<bool> destroyed = false;
+	std::thread destroyThread([&] ()
+	{
+		resources.destroy();
+		destroyed = true;
+	});
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	EXPECT_FALSE(destroyed);
+
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		loadReleased = true;
+	}
+	condition.notify_all();
+	ioThread.join();
+	destroyThread.join();
+
+	EXPECT_TRUE(destroyed);
+	ASSERT_TRUE(future.hasValue());
+	EXPECT_NE(future.get(), nullptr);
+}
+
+TEST(Resources, QueuedAsyncLoadsAreCancelledOnDestruction)
+{
+	TestResources resources;
+
+	int nLoads = 0;
+	resources.setLoader([&] (const String& assetId, ResourceLoadPriority priority)
+	{
+		++nLoads;
+		return std::make_shared<TestResource>(1);
+	});
+
+	// Loads that never got to run complete with nothing, so that waiting on them returns
+	auto future = resources.get().getAsync<TestResource>("a");
+	resources.destroy();
+	future.wait();
+	ASSERT_TRUE(future.hasValue());
+	EXPECT_EQ(future.get(), nullptr);
+
+	TestResources::runAsyncLoads();
+	EXPECT_EQ(nLoads, 0);
+}
+
+TEST(Resources, ReentrantLoadIsCached)
+{
+	TestResources resources;
+
+	// Loading "a" ends up asking for "a" again on the same thread, as a worker helping out while it waits would
+	int nLoads = 0;
+	std::shared_ptr<const TestResource> inner;
+	resources.setLoader([&] (const String& assetId, ResourceLoadPriority priority)
+	{
+		if (++nLoads == 1) {
+			inner = resources.get().get<TestResource>("a");
+		}
+		return std::make_shared<TestResource>(1);
+	});
+
+	// Whoever asked first gets what the inner load cached, rather than a second copy
+	const auto outer = resources.get().get<TestResource>("a");
+	EXPECT_EQ(nLoads, 2);
+	ASSERT_NE(inner, nullptr);
+	EXPECT_EQ(outer, inner);
+	EXPECT_EQ(resources.get().get<TestResource>("a"), inner);
+	EXPECT_EQ(nLoads, 2);
+}
+
+TEST(ResourcePrefetcher, HintsLoadInPriorityOrder)
+{
+	TestResources resources;
+
+	Vector<String> loadOrder;
+	resources.setLoader([&] (const String& assetId, ResourceLoadPriority priority)
+	{
+		loadOrder.push_back(assetId);
+		return std::make_shared<TestResource>(1);
+	});
+
+	ResourcePrefetcher prefetcher(resources.get(), 1024);
+	prefetcher.prefetch<TestResource>("low", ResourceLoadPriority::Low);
+	prefetcher.prefetch<TestResource>("normal", ResourceLoadPriority::Normal);
+	prefetcher.prefetch<TestResource>("high", ResourceLoadPriority::High);
+	prefetcher.prefetch<TestResource>("low", ResourceLoadPriority::Low);
+	EXPECT_TRUE(loadOrder.empty());
+
+	// Highest priority first, regardless of the order they were hinted in, and hinting twice doesn't load twice
+	TestResources::runAsyncLoads();
+	EXPECT_EQ(loadOrder, Vector<String>({ "high", "normal", "low" }));
+
+	prefetcher.update(0);
+	EXPECT_NE(prefetcher.get<TestResource>("normal"), nullptr);
+	EXPECT_NE(prefetcher.get<TestResource>("other"), nullptr);
+
+	const auto stats = prefetcher.getStats();
+	EXPECT_EQ(stats.prefetches, 3);
+	EXPECT_EQ(stats.hits, 1);
+	EXPECT_EQ(stats.misses, 1);
+	EXPECT_EQ(stats.stalls, 0);
+}
+
+TEST(ResourcePrefetcher, EvictsLeastRecentlyUsedOverBudget)
+{
+	TestResources resources;
+	resources.setLoader([&] (const String& assetId, ResourceLoadPriority priority)
+	{
+		return std::make_shared<TestResource>(100);
+	});
+	auto& collection = resources.get().of<TestResource>();
+
+	ResourcePrefetcher prefetcher(resources.get(), 250);
+
+	// Use "a", then "b", then "c", one frame apart, without holding on to any of them
+	for (const auto* id: { "a", "b", "c" }) {
+		EXPECT_NE(prefetcher.get<TestResource>(id), nullptr);
+		prefetcher.update(1);
+	}
+
+	// Over budget with the third one, so the one that's gone unused the longest goes
+	EXPECT_FALSE(collection.isLoaded("a"));
+	EXPECT_TRUE(collection.isLoaded("b"));
+	EXPECT_TRUE(collection.isLoaded("c"));
+	auto stats = prefetcher.getStats();
+	EXPECT_EQ(stats.evictions, 1);
+	EXPECT_EQ(stats.evictedBytes, 100);
+	EXPECT_EQ(stats.residentBytes, 200);
+
+	// Resources that are in use, or hinted and not requested yet, are never evicted
+	const auto c = prefetcher.get<TestResource>("c");
+	prefetcher.prefetch<TestResource>("d");
+	TestResources::runAsyncLoads();
+	prefetcher.setBudget(0);
+	prefetcher.update(1);
+
+	EXPECT_FALSE(collection.isLoaded("b"));
+	EXPECT_TRUE(collection.isLoaded("c"));
+	EXPECT_TRUE(collection.isLoaded("d"));
+	stats = prefetcher.getStats();
+	EXPECT_EQ(stats.evictions, 2);
+	EXPECT_EQ(stats.residentBytes, 200);
+}
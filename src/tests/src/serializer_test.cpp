@@ -26,4 +26,117 @@ TEST(Serializer, IntConversion)
 			EXPECT_EQ(value, convertBackAndForth(value));
 		}
 	}
-}
\ No newline at end of file
+}
+
+namespace {
+	// The dry run + write approach toBytes used before it went single pass, kept to compare against
+	template <typename F>
+	Bytes toBytesTwoPass(const F& f, SerializerOptions options)
+	{
+		auto dry = Serializer(options);
+		f(dry);
+		auto result = Bytes(dry.getSize());
+		auto s = Serializer(gsl::as_writable_bytes(gsl::span<Byte>(result)), options);
+		f(s);
+		return result;
+	}
+
+	ConfigNode makeConfigTree(Random& rng, int depth)
+	{
+		ConfigNode::MapType map;
+		map["name"] = "node" + toString(rng.getInt(0, 100000));
+		map["value"] = rng.getFloat(-1000.0f, 1000.0f);
+		map["count"] = rng.getInt(0, 100000);
+		map["enabled"] = rng.getInt(0, 1) == 1;
+		if (depth > 0) {
+			ConfigNode::SequenceType children;
+			for (int i = 0; i < 4; ++i) {
+				children.push_back(makeConfigTree(rng, depth - 1));
+			}
+			map["children"] = std::move(children);
+		}
+		return ConfigNode(std::move(map));
+	}
+
+	EntityData makeEntityTree(Random& rng, int depth)
+	{
+		EntityData data;
+		data.setName("entity" + toString(rng.getInt(0, 100000)));
+		data.setInstanceUUID(UUID::generate());
+
+		Vector<std::pair<String, ConfigNode>> components;
+		components.emplace_back("Transform2D", makeConfigTree(rng, 0));
+		components.emplace_back("Sprite", makeConfigTree(rng, 1));
+		data.setComponents(std::move(components));
+
+		if (depth > 0) {
+			Vector<EntityData> children;
+			for (int i = 0; i < 6; ++i) {
+				children.push_back(makeEntityTree(rng, depth - 1));
+			}
+			data.setChildren(std::move(children));
+		}
+		return data;
+	}
+}
+
+TEST(Serializer, SinglePassMatchesTwoPass)
+{
+	Random rng(uint32_t(42));
+	const auto config = makeConfigTree(rng, 4);
+	const auto entity = makeEntityTree(rng, 2);
+
+	for (int version = 0; version <= SerializerOptions::maxVersion; ++version) {
+		const auto options = SerializerOptions(version);
+		EXPECT_EQ(Serializer::toBytes(config, options), toBytesTwoPass([&] (Serializer& s) { s << config; }, options));
+		EXPECT_EQ(Serializer::toBytes(entity, options), toBytesTwoPass([&] (Serializer& s) { s << entity; }, options));
+	}
+}
+
+TEST(Serializer, NestedToBytes)
+{
+	const auto options = SerializerOptions(SerializerOptions::maxVersion);
+	const auto inner = Serializer::toBytes([] (Serializer& s) { s << String("inner") << 1234; }, options);
+	const auto outer = Serializer::toBytes([&] (Serializer& s)
+	{
+		s << String("outer");
+		s << Serializer::toBytes([] (Serializer& s2) { s2 << String("inner") << 1234; }, options);
+		s << 5678;
+	}, options);
+
+	auto ds = Deserializer(outer, options);
+	String outerName;
+	Bytes innerBytes;
+	int outerValue = 0;
+	ds >> outerName >> innerBytes >> outerValue;
+	EXPECT_EQ(outerName, "outer");
+	EXPECT_EQ(innerBytes, inner);
+	EXPECT_EQ(outerValue, 5678);
+}
+
+TEST(Serializer, DISABLED_BenchmarkToBytes)
+{
+	Random rng(uint32_t(42));
+	const auto config = makeConfigTree(rng, 6);
+	const auto entity = makeEntityTree(rng, 4);
+	const auto options = SerializerOptions(SerializerOptions::maxVersion);
+	constexpr int iterations = 5;
+
+	const auto run = [&] (const char* name, auto serialize)
+	{
+		for (bool singlePass : { false, true }) {
+			size_t size = 0;
+			Stopwatch timer;
+			for (int i = 0; i < iterations; ++i) {
+				size = singlePass ? Serializer::toBytes(serialize, options).size() : toBytesTwoPass(serialize, options).size();
+			}
+			timer.pause();
+
+			std::cout << name << " | " << (singlePass ? "single pass" : "two pass   ") << " | " << size << " bytes | "
+				<< (timer.elapsedNanoseconds() / 1000000.0 / iterations) << " ms" << std::endl;
+		}
+	};
+
+	run("ConfigNode", [&] (Serializer& s) { s << config; });
+	run("EntityData", [&] (Serializer& s) { s << entity; });
+}
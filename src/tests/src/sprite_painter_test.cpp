@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+using namespace Halley;
+
+namespace {
+	struct TestScene {
+		Vector<Sprite> sprites;
+		Vector<SpritePainterEntry> entries;
+	};
+
+	TestScene makeScene(size_t nSprites, int nLayers, Rect4f area)
+	{
+		Random rng(uint32_t(42));
+		TestScene scene;
+		scene.sprites.reserve(nSprites);
+		for (size_t i = 0; i < nSprites; ++i) {
+			Sprite sprite;
+			sprite.setPosition(Vector2f(rng.getFloat(area.getLeft(), area.getRight()), rng.getFloat(area.getTop(), area.getBottom())));
+			sprite.setSize(Vector2f(16, 16));
+			scene.sprites.push_back(std::move(sprite));
+		}
+		for (size_t i = 0; i < nSprites; ++i) {
+			const int layer = rng.getInt(0, nLayers - 1);
+			const int mask = rng.getInt(1, 3);
+			scene.entries.push_back(SpritePainterEntry(gsl::span<const Sprite>(&scene.sprites[i], 1), mask, layer, scene.sprites[i].getPosition().y, i, {}));
+		}
+		return scene;
+	}
+
+	void addToPainter(SpritePainter& painter, const TestScene& scene)
+	{
+		painter.start();
+		for (size_t i = 0; i < scene.entries.size(); ++i) {
+			const auto& e = scene.entries[i];
+			painter.add(scene.sprites[i], e.getMask(), e.getLayer(), e.getTieBreaker());
+		}
+	}
+}
+
+TEST(SpritePainter, DrawListMatchesFullSort)
+{
+	const auto scene = makeScene(5000, 20, Rect4f(-1000, -1000, 2000, 2000));
+	const auto view = Rect4f(0, 0, 640, 360);
+	SpritePainter painter;
+	addToPainter(painter, scene);
+
+	for (int mask : { 1, 2, 3 }) {
+		Vector<size_t> expected;
+		for (size_t i = 0; i < scene.entries.size(); ++i) {
+			if ((scene.entries[i].getMask() & mask) != 0 && scene.sprites[i].isInView(view)) {
+				expected.push_back(i);
+			}
+		}
+		std::sort(expected.begin(), expected.end(), [&] (size_t a, size_t b) { return scene.entries[a] < scene.entries[b]; });
+
+		const auto& drawList = painter.getDrawList(mask, view);
+		ASSERT_EQ(drawList.size(), expected.size());
+		for (size_t i = 0; i < expected.size(); ++i) {
+			EXPECT_EQ(drawList[i].entryIdx, expected[i]);
+		}
+	}
+}
+
+TEST(SpritePainter, EmptyFrameClearsDrawList)
+{
+	const auto scene = makeScene(100, 4, Rect4f(0, 0, 640, 360));
+	const auto view = Rect4f(0, 0, 640, 360);
+	SpritePainter painter;
+	addToPainter(painter, scene);
+	EXPECT_FALSE(painter.getDrawList(3, view).empty());
+
+	// Nothing submitted on the next frame, drawn with the same mask and view
+	painter.start();
+	EXPECT_TRUE(painter.getDrawList(3, view).empty());
+}
+
+TEST(SpritePainter, DISABLED_BenchmarkDrawList)
+{
+	constexpr size_t nSprites = 100000;
+	constexpr int nLayers = 20;
+	constexpr int nIterations = 20;
+	const auto view = Rect4f(0, 0, 1920, 1080);
+
+	for (const auto& [name, area] : { std::make_pair("all on screen", view), std::make_pair("1/4 on screen", Rect4f(-1920, -1080, 3840, 2160)) }) {
+		const auto scene = makeScene(nSprites, nLayers, area);
+
+		Stopwatch fullSort;
+		for (int i = 0; i < nIterations; ++i) {
+			fullSort.pause();
+			auto entries = scene.entries;
+			fullSort.start();
+			std::sort(entries.begin(), entries.end());
+		}
+		fullSort.pause();
+
+		SpritePainter painter;
+		Stopwatch bucketed;
+		for (int i = 0; i < nIterations; ++i) {
+			bucketed.pause();
+			addToPainter(painter, scene);
+			bucketed.start();
+			painter.getDrawList(3, view);
+		}
+		bucketed.pause();
+
+		std::cout << nSprites << " sprites, " << nLayers << " layers, " << name << " | std::sort: "
+			<< (fullSort.elapsedNanoseconds() / 1000000.0 / nIterations) << " ms | cull + bucket: "
+			<< (bucketed.elapsedNanoseconds() / 1000000.0 / nIterations) << " ms" << std::endl;
+	}
+}
@@ -0,0 +1,613 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+#include <random>
+using namespace Halley;
+
+namespace {
+	class NullInputAPI : public InputAPI {
+	public:
+		size_t getNumberOfKeyboards() const override { return 0; }
+		std::shared_ptr<InputKeyboard> getKeyboard(int id) const override { return {}; }
+		size_t getNumberOfJoysticks() const override { return 0; }
+		std::shared_ptr<InputJoystick> getJoystick(int id) const override { return {}; }
+		size_t getNumberOfMice() const override { return 0; }
+		std::shared_ptr<InputDevice> getMouse(int id) const override { return {}; }
+		Vector<std::shared_ptr<InputTouch>> getNewTouchEvents() override { return {}; }
+		Vector<std::shared_ptr<InputTouch>> getTouchEvents() override { return {}; }
+		void setMouseRemapping(std::function<Vector2f(Vector2i)> remapFunction) override {}
+	};
+
+	class TestMouse : public InputButtonBase {
+	public:
+		TestMouse() : InputButtonBase(3) {}
+
+		Vector2f getPosition() const override { return pos; }
+
+		Vector2f pos;
+	};
+
+	class TestUI {
+	public:
+		TestUI()
+		{
+			api.input = &input;
+			root = std::make_unique<UIRoot>(api, Rect4f(0, 0, 1280, 720));
+		}
+
+		~TestUI()
+		{
+			root.reset();
+		}
+
+		UIRoot& getRoot()
+		{
+			return *root;
+		}
+
+		UIStyle getListStyle()
+		{
+			if (!styleSheet) {
+				const auto border = ConfigNode(ConfigNode::SequenceType{ ConfigNode(0), ConfigNode(0), ConfigNode(0), ConfigNode(0) });
+				ConfigNode item = ConfigNode::MapType();
+				item["innerBorder"] = ConfigNode(border);
+				item["normal"] = "";
+				item["hover"] = "";
+				item["minSize"] = ConfigNode(ConfigNode::SequenceType{ ConfigNode(100), ConfigNode(20) });
+
+				ConfigNode list = ConfigNode::MapType();
+				list["gap"] = 0.0f;
+				list["innerBorder"] = ConfigNode(border);
+				list["extraMouseBorder"] = ConfigNode(border);
+				list["selectionChangedSound"] = "";
+				list["background"] = "";
+				list["item"] = std::move(item);
+
+				ConfigNode styles = ConfigNode::MapType();
+				styles["uiStyle"] = ConfigNode::MapType();
+				styles["uiStyle"]["list"] = std::move(list);
+
+				resources = std::make_unique<Resources>(nullptr, api, ResourceOptions());
+				styleFile = std::make_unique<ConfigFile>(std::move(styles));
+				styleSheet = std::make_shared<UIStyleSheet>(*resources, *styleFile);
+			}
+			return UIStyle("list", styleSheet);
+		}
+
+		void update()
+		{
+			root->update(1.0 / 60.0, UIInputType::Keyboard, {}, {});
+		}
+
+		void update(Vector2f mousePos)
+		{
+			mouse->pos = mousePos;
+			root->update(1.0 / 60.0, UIInputType::Mouse, mouse, {});
+		}
+
+	private:
+		NullInputAPI input;
+		std::shared_ptr<TestMouse> mouse = std::make_shared<TestMouse>();
+		HalleyAPI api{};
+		std::unique_ptr<UIRoot> root;
+		std::unique_ptr<Resources> resources;
+		std::unique_ptr<ConfigFile> styleFile;
+		std::shared_ptr<UIStyleSheet> styleSheet;
+	};
+
+	// Items are plain list items, as labels can't be measured without fonts
+	class TestVirtualList : public UIList {
+	public:
+		TestVirtualList(UIStyle style)
+			: UIList("list", std::move(style))
+		{}
+
+		int itemsMade = 0;
+		int itemsBound = 0;
+
+	protected:
+		std::shared_ptr<UIListItem> makeVirtualItem() override
+		{
+			++itemsMade;
+			return std::make_shared<UIListItem>("", *this, getStyle().getSubStyle("item"), 0, Vector4f());
+		}
+
+		void bindVirtualItem(int index, UIListItem& item) override
+		{
+			++itemsBound;
+			item.setId(getVirtualItemId(index));
+		}
+	};
+
+	class TestVirtualTree : public UITreeList {
+	public:
+		TestVirtualTree(UIStyle style)
+			: UITreeList("tree", std::move(style))
+		{}
+
+		HashMap<String, int> timesBound;
+
+	protected:
+		std::shared_ptr<UIListItem> makeVirtualItem() override
+		{
+			return std::make_shared<UIListItem>("", *this, getStyle().getSubStyle("item"), 0, Vector4f());
+		}
+
+		void bindVirtualItem(int index, UIListItem& item) override
+		{
+			item.setId(getVirtualItemId(index));
+			++timesBound[item.getId()];
+		}
+	};
+
+	std::shared_ptr<TestVirtualList> makeVirtualList(TestUI& ui, int count)
+	{
+		auto pane = std::make_shared<UIScrollPane>("pane", Vector2f(300, 200), UISizer(UISizerType::Vertical));
+		auto list = std::make_shared<TestVirtualList>(ui.getListStyle());
+		list->setVirtualItems(count, [] (int index) { return UIList::VirtualItem{ "item" + toString(index) }; });
+		pane->add(list, 1);
+		ui.getRoot().addChild(pane);
+		return list;
+	}
+
+	void expectItemsInPlace(const UIList& list, int count)
+	{
+		EXPECT_FLOAT_EQ(list.getSize().y, float(count) * 20.0f);
+		for (const auto& c: list.getChildren()) {
+			const auto& item = dynamic_cast<const UIListItem&>(*c);
+			EXPECT_EQ(item.getId(), "item" + toString(item.getIndex()));
+			EXPECT_FLOAT_EQ(item.getPosition().y, list.getPosition().y + float(item.getIndex()) * 20.0f);
+		}
+	}
+
+	std::shared_ptr<UIWidget> makeList(size_t nItems, Vector<std::shared_ptr<UIWidget>>& items)
+	{
+		auto list = std::make_shared<UIWidget>("list", Vector2f(), UISizer(UISizerType::Vertical, 2.0f));
+		for (size_t i = 0; i < nItems; ++i) {
+			auto row = std::make_shared<UIWidget>("", Vector2f(), UISizer(UISizerType::Horizontal));
+			auto item = std::make_shared<UIWidget>("", Vector2f(50, 10));
+			row->add(item);
+			list->add(row);
+			items.push_back(item);
+		}
+		return list;
+	}
+
+	// The depth-first walk UIRoot used before it had a hit test grid
+	std::pair<UIWidget*, int> referenceHitTest(UIWidget& widget, Vector2f pos, int layer)
+	{
+		if (!widget.isActive() || !widget.isEnabled()) {
+			return {};
+		}
+
+		const int childLayer = layer + widget.getChildLayerAdjustment();
+		std::pair<UIWidget*, int> best;
+		for (auto& c: widget.getChildren()) {
+			const auto result = referenceHitTest(*c, pos, childLayer);
+			if (result.first && (!best.first || result.second > best.second)) {
+				best = result;
+			}
+		}
+		if (best.first) {
+			return best;
+		}
+
+		if (widget.canInteractWithMouse() && widget.getMouseRect().contains(pos)) {
+			return { &widget, layer };
+		}
+		return {};
+	}
+
+	UIWidget* referenceHitTest(UIRoot& root, Vector2f pos)
+	{
+		const auto& cs = root.getChildren();
+		for (int i = static_cast<int>(cs.size()); --i >= 0; ) {
+			if (auto* result = referenceHitTest(*cs[i], pos, 0).first) {
+				return result;
+			}
+			if (cs[i]->isMouseBlocker() && cs[i]->isActiveInHierarchy()) {
+				return nullptr;
+			}
+		}
+		return nullptr;
+	}
+
+	// Overlapping free-floating widgets, with a mix of layer adjustments, disabled and inactive subtrees
+	void addRandomWidgets(UIWidget& parent, Rect4f area, int depth, std::mt19937& rng, Vector<std::shared_ptr<UIWidget>>& all)
+	{
+		auto rand = [&] (float a, float b) { return std::uniform_real_distribution<float>(a, b)(rng); };
+		const int n = depth == 0 ? 0 : 1 + int(rng() % 4);
+		for (int i = 0; i < n; ++i) {
+			const auto size = Vector2f(rand(10, area.getWidth()), rand(10, area.getHeight())).floor();
+			const auto pos = (area.getTopLeft() + Vector2f(rand(-10, area.getWidth() - size.x + 10), rand(-10, area.getHeight() - size.y + 10))).floor();
+			auto widget = std::make_shared<UIWidget>("", size);
+			widget->setPosition(pos);
+			widget->setInteractWithMouse(rng() % 3 != 0);
+			widget->setChildLayerAdjustment(int(rng() % 4) - 1);
+			widget->setEnabled(rng() % 8 != 0);
+			widget->setActive(rng() % 8 != 0);
+			parent.add(widget);
+			all.push_back(widget);
+			addRandomWidgets(*widget, Rect4f(pos, pos + size), depth - 1, rng, all);
+		}
+	}
+
+	void expectSameAsReference(TestUI& ui, std::mt19937& rng)
+	{
+		int nHits = 0;
+		for (int i = 0; i < 500; ++i) {
+			const auto pos = Vector2f(float(rng() % 1300) - 10, float(rng() % 740) - 10);
+			ui.update(pos);
+			const auto* expected = referenceHitTest(ui.getRoot(), pos);
+			ASSERT_EQ(ui.getRoot().getWidgetUnderMouse().get(), expected) << "at " << pos;
+			nHits += expected ? 1 : 0;
+		}
+		EXPECT_GT(nHits, 50);
+	}
+}
+
+TEST(UILayout, SkipsCleanTrees)
+{
+	TestUI ui;
+	Vector<std::shared_ptr<UIWidget>> items;
+	ui.getRoot().addChild(makeList(100, items));
+
+	ui.update();
+	EXPECT_EQ(ui.getRoot().getNumWidgetsLaidOut(), 201);
+
+	ui.update();
+	EXPECT_EQ(ui.getRoot().getNumWidgetsLaidOut(), 0);
+}
+
+TEST(UILayout, RelaysOnlyWhatMoved)
+{
+	TestUI ui;
+	Vector<std::shared_ptr<UIWidget>> items;
+	ui.getRoot().addChild(makeList(100, items));
+	ui.update();
+
+	// Everything after the grown item moves down, everything before it stays put
+	items[90]->setMinSize(Vector2f(50, 30));
+	ui.update();
+	EXPECT_EQ(ui.getRoot().getNumWidgetsLaidOut(), 21);
+	for (size_t i = 1; i < items.size(); ++i) {
+		EXPECT_FLOAT_EQ(items[i]->getPosition().y, items[i - 1]->getRect().getBottom() + 2.0f);
+	}
+
+	// Moving the list moves everything in it
+	ui.getRoot().getChildren().front()->setPosition(Vector2f(10, 10));
+	ui.update();
+	EXPECT_EQ(ui.getRoot().getNumWidgetsLaidOut(), 201);
+	EXPECT_FLOAT_EQ(items[0]->getPosition().x, 10.0f);
+	EXPECT_FLOAT_EQ(items[99]->getPosition().y, items[98]->getRect().getBottom() + 2.0f);
+}
+
+TEST(UILayout, RelaysAfterSizerChange)
+{
+	TestUI ui;
+	auto widget = std::make_shared<UIWidget>("", Vector2f(), UISizer(UISizerType::Vertical));
+	widget->getSizer().addSpacer(10);
+	ui.getRoot().addChild(widget);
+	ui.update();
+	EXPECT_FLOAT_EQ(widget->getSize().y, 10.0f);
+
+	// No children come or go, so only setSizer itself can tell the widget that its minimum size changed
+	UISizer sizer(UISizerType::Vertical);
+	sizer.addSpacer(50);
+	widget->setSizer(std::move(sizer));
+	ui.update();
+	EXPECT_FLOAT_EQ(widget->getSize().y, 50.0f);
+}
+
+TEST(UIHitTest, MatchesTreeWalk)
+{
+	std::mt19937 rng(1234);
+	TestUI ui;
+	Vector<std::shared_ptr<UIWidget>> all;
+	for (int i = 0; i < 3; ++i) {
+		auto window = std::make_shared<UIWidget>("", Vector2f(500, 400));
+		window->setPosition(Vector2f(float(i * 300), float(i * 100)));
+		window->setMouseBlocker(i == 1); // Roots block everything under them, whether the mouse is over them or not
+		window->setInteractWithMouse(i == 0);
+		ui.getRoot().addChild(window);
+		addRandomWidgets(*window, Rect4f(window->getPosition(), window->getPosition() + Vector2f(500, 400)), 4, rng, all);
+	}
+	ui.update();
+	expectSameAsReference(ui, rng);
+
+	// Changes to the tree after the grid was built
+	for (int i = 0; i < 20; ++i) {
+		auto& widget = all[rng() % all.size()];
+		switch (rng() % 9) {
+		case 0:
+			widget->setEnabled(!widget->isEnabled());
+			break;
+		case 1:
+			widget->setChildLayerAdjustment(int(rng() % 4) - 1);
+			break;
+		case 2:
+			widget->setPosition(widget->getPosition() + Vector2f(20, -15));
+			break;
+		case 3:
+			widget->destroy();
+			break;
+		case 4:
+			widget->setMinSize(widget->getSize() + Vector2f(30, 10));
+			break;
+		case 5:
+			widget->setMouseClip(Rect4f(widget->getPosition(), widget->getPosition() + widget->getSize() * 0.5f), false);
+			break;
+		default:
+			widget->setActive(!widget->isActive());
+			break;
+		}
+		ui.update();
+		expectSameAsReference(ui, rng);
+	}
+}
+
+TEST(UIHitTest, FollowsMouseBorderChanges)
+{
+	TestUI ui;
+	auto list = makeVirtualList(ui, 100);
+	ui.update();
+	ui.update();
+
+	auto item = std::dynamic_pointer_cast<UIListItem>(list->getChildren().front());
+	ASSERT_TRUE(item);
+	const auto pos = item->getPosition() + Vector2f(50, 5);
+	ui.update(pos);
+	EXPECT_EQ(ui.getRoot().getWidgetUnderMouse(), item);
+
+	// Neither of these moves the item, so the grid is updated in place
+	item->setClickableInnerBorder(Vector4f(0, 10, 0, 0));
+	ui.update(pos);
+	EXPECT_NE(ui.getRoot().getWidgetUnderMouse(), item);
+
+	item->setMouseExtraBorder(Vector4f(0, 10, 0, 0));
+	ui.update(pos);
+	EXPECT_EQ(ui.getRoot().getWidgetUnderMouse(), item);
+}
+
+TEST(UIHitTest, DISABLED_BenchmarkTreeList)
+{
+	// A long list of rows, each with an icon and a label, like an editor tree list
+	constexpr size_t nRows = 10000;
+	constexpr int nQueries = 2000;
+
+	TestUI ui;
+	auto list = std::make_shared<UIWidget>("list", Vector2f(), UISizer(UISizerType::Vertical));
+	for (size_t i = 0; i < nRows; ++i) {
+		auto row = std::make_shared<UIWidget>("", Vector2f(300, 20), UISizer(UISizerType::Horizontal));
+		row->setInteractWithMouse(true);
+		row->add(std::make_shared<UIWidget>("", Vector2f(16, 16)));
+		row->add(std::make_shared<UIWidget>("", Vector2f(200, 16)));
+		list->add(row);
+	}
+	ui.getRoot().addChild(list);
+	ui.update();
+
+	std::mt19937 rng(42);
+	Vector<Vector2f> positions;
+	for (int i = 0; i < nQueries; ++i) {
+		positions.push_back(Vector2f(float(rng() % 320), float(rng() % (nRows * 20))));
+	}
+
+	size_t found = 0;
+	Stopwatch walkTimer;
+	for (const auto& pos: positions) {
+		found += referenceHitTest(ui.getRoot(), pos) ? 1 : 0;
+	}
+	walkTimer.pause();
+
+	Stopwatch buildTimer;
+	UIHitTestGrid grid;
+	grid.rebuild(ui.getRoot());
+	buildTimer.pause();
+
+	size_t foundGrid = 0;
+	Stopwatch gridTimer;
+	for (const auto& pos: positions) {
+		foundGrid += grid.getWidgetAt(pos, false) ? 1 : 0;
+	}
+	gridTimer.pause();
+	EXPECT_EQ(found, foundGrid);
+
+	// Frames where one row changes size, moving the rows below it, and frames where the whole list scrolls, with and without the mouse over the UI
+	constexpr int nFrames = 50;
+	const auto mousePos = Vector2f(100, 300);
+	auto runFrames = [&] (bool withMouse, auto change)
+	{
+		Stopwatch timer;
+		for (int i = 0; i < nFrames; ++i) {
+			change(i);
+			if (withMouse) {
+				ui.update(mousePos);
+			} else {
+				ui.update();
+			}
+		}
+		timer.pause();
+		return timer.elapsedNanoseconds() / 1000.0 / nFrames;
+	};
+	auto resizeRow = [&] (int i) { list->getChildren()[nRows - 10]->setMinSize(Vector2f(300, float(20 + i % 2))); };
+	auto scroll = [&] (int i) { list->setPosition(Vector2f(0, -float(i % 2))); };
+	ui.update(mousePos);
+	const auto resizeLayoutTime = runFrames(false, resizeRow);
+	const auto resizeTime = runFrames(true, resizeRow);
+	const auto scrollLayoutTime = runFrames(false, scroll);
+	const auto scrollTime = runFrames(true, scroll);
+
+	std::cout << grid.getNumEntries() << " widgets | tree walk: " << (walkTimer.elapsedNanoseconds() / 1000.0 / nQueries) << " us/query | grid: "
+		<< (gridTimer.elapsedNanoseconds() / 1000.0 / nQueries) << " us/query, " << (buildTimer.elapsedNanoseconds() / 1000.0) << " us to build" << std::endl;
+	std::cout << "update with a row resized: " << resizeTime << " us/frame (" << resizeLayoutTime << " without the mouse) | update while scrolling: "
+		<< scrollTime << " us/frame (" << scrollLayoutTime << " without the mouse)" << std::endl;
+}
+
+TEST(UIVirtualList, OnlyMakesItemsInView)
+{
+	TestUI ui;
+	auto list = makeVirtualList(ui, 10000);
+	ui.update();
+
+	// 200px pane with 20px items, plus the margin after them
+	EXPECT_EQ(list->getChildren().size(), 10 + 8);
+	EXPECT_TRUE(list->getItem(0));
+	EXPECT_EQ(list->getCount(), 10000);
+	expectItemsInPlace(*list, 10000);
+
+	// Scrolling recycles the widgets it already has
+	auto& pane = dynamic_cast<UIScrollPane&>(*ui.getRoot().getChildren().front());
+	pane.scrollTo(Vector2f(0, 500));
+	ui.update();
+	const int made = list->itemsMade;
+	for (int i = 1; i <= 50; ++i) {
+		pane.scrollTo(Vector2f(0, float(i * 997)));
+		ui.update();
+		EXPECT_TRUE(list->tryGetItem(i * 997 / 20)) << i;
+		EXPECT_LE(list->getChildren().size(), 11 + 2 * 8);
+		expectItemsInPlace(*list, 10000);
+	}
+	EXPECT_EQ(list->itemsMade, made);
+	EXPECT_LE(list->itemsBound, made + 50 * 30);
+}
+
+TEST(UIVirtualList, NavigatesWholeRange)
+{
+	TestUI ui;
+	auto list = makeVirtualList(ui, 5000);
+	list->setMultiSelect(true);
+	ui.update();
+	EXPECT_EQ(list->getSelectedOptionId(), "item0");
+
+	// Moving past the end wraps around, and brings the selection into view
+	list->onManualControlCycleValue(-1);
+	ui.update();
+	ui.update();
+	EXPECT_EQ(list->getSelectedOption(), 4999);
+	EXPECT_EQ(list->getSelectedOptionId(), "item4999");
+	ASSERT_TRUE(list->tryGetItem(4999));
+	EXPECT_TRUE(list->tryGetItem(4999)->isSelected());
+	EXPECT_FALSE(list->tryGetItem(0));
+
+	list->setSelectedOption(10, UIList::SelectionMode::ShiftSelect);
+	EXPECT_EQ(list->getSelectedOptions().size(), 4990);
+	EXPECT_TRUE(list->isValidSelection("item2000"));
+
+	const String ids[] = { "item3", "item4000" };
+	list->setSelectedOptionIds(ids);
+	EXPECT_EQ(list->getSelectedOptionIds(), Vector<String>({ "item3", "item4000" }));
+	EXPECT_EQ(list->getSelectedOption(), 3);
+	ui.update();
+	ui.update();
+	ASSERT_TRUE(list->tryGetItem(3));
+	EXPECT_TRUE(list->tryGetItem(3)->isSelected());
+	EXPECT_FALSE(list->tryGetItem(4)->isSelected());
+
+	// Shrinking the list keeps the selection that's still in range
+	list->setVirtualItems(100, [] (int index) { return UIList::VirtualItem{ "item" + toString(index) }; });
+	ui.update();
+	EXPECT_EQ(list->getSelectedOptionIds(), Vector<String>({ "item3" }));
+	expectItemsInPlace(*list, 100);
+}
+
+TEST(UIVirtualList, FindsItemsById)
+{
+	TestUI ui;
+	auto list = makeVirtualList(ui, 5000);
+	int nCallbacks = 0;
+	list->setVirtualItems(5000, [&] (int index)
+	{
+		++nCallbacks;
+		return UIList::VirtualItem{ "item" + toString(index) };
+	});
+	ui.update();
+
+	// The callback goes through every item once, rather than once per lookup
+	nCallbacks = 0;
+	for (int i = 0; i < 100; ++i) {
+		const auto idx = (i * 397) % 5000;
+		EXPECT_TRUE(list->setSelectedOptionId("item" + toString(idx)));
+		EXPECT_EQ(list->getSelectedOption(), idx);
+	}
+	EXPECT_LT(nCallbacks, 5000 + 100 * 20);
+
+	// Changing the items changes the ids
+	list->setVirtualItems(10, [] (int index) { return UIList::VirtualItem{ "other" + toString(index) }; });
+	EXPECT_TRUE(list->setSelectedOptionId("other3"));
+	EXPECT_EQ(list->getSelectedOption(), 3);
+	EXPECT_FALSE(list->setSelectedOptionId("item3"));
+}
+
+TEST(UIVirtualList, TreeRebindsChangedRows)
+{
+	TestUI ui;
+	auto pane = std::make_shared<UIScrollPane>("pane", Vector2f(300, 200), UISizer(UISizerType::Vertical));
+	auto tree = std::make_shared<TestVirtualTree>(ui.getListStyle());
+	tree->setVirtual();
+	for (int i = 0; i < 100; ++i) {
+		tree->addTreeItem("item" + toString(i), "", std::numeric_limits<size_t>::max(), LocalisedString());
+	}
+	pane->add(tree, 1);
+	ui.getRoot().addChild(pane);
+	ui.update();
+	ui.update();
+
+	// Only the row showing the changed item is bound again, and only if it's in view
+	const auto before = tree->timesBound;
+	tree->tryGetTreeItem("item2")->setLabelColour(Colour4f(1, 0, 0));
+	tree->tryGetTreeItem("item3")->setIcon(Sprite());
+	tree->tryGetTreeItem("item90")->setLabelColour(Colour4f(1, 0, 0));
+	EXPECT_EQ(tree->timesBound["item2"], before.at("item2") + 1);
+	EXPECT_EQ(tree->timesBound["item3"], before.at("item3") + 1);
+	EXPECT_EQ(tree->timesBound["item4"], before.at("item4"));
+	EXPECT_EQ(tree->timesBound.find("item90"), tree->timesBound.end());
+	EXPECT_EQ(tree->tryGetTreeItem("item2")->getLabelColour(), Colour4f(1, 0, 0));
+}
+
+TEST(UIVirtualList, TreeKeepsSelectionById)
+{
+	TestUI ui;
+	auto pane = std::make_shared<UIScrollPane>("pane", Vector2f(300, 200), UISizer(UISizerType::Vertical));
+	auto tree = std::make_shared<TestVirtualTree>(ui.getListStyle());
+	tree->setVirtual();
+	tree->setMultiSelect(true);
+	for (int i = 0; i < 1000; ++i) {
+		const auto folder = "folder" + toString(i);
+		tree->addTreeItem(folder, "", std::numeric_limits<size_t>::max(), LocalisedString(), "label", Sprite(), false, false);
+		for (int j = 0; j < 10; ++j) {
+			tree->addTreeItem(folder + "_" + toString(j), folder, std::numeric_limits<size_t>::max(), LocalisedString());
+		}
+	}
+	pane->add(tree, 1);
+	ui.getRoot().addChild(pane);
+	ui.update();
+
+	// Only expanded items are rows
+	EXPECT_EQ(tree->getCount(), 1000);
+	EXPECT_EQ(tree->getSelectedOptionId(), "folder0");
+	EXPECT_LE(tree->getChildren().size(), 10 + 8);
+
+	// Selecting a hidden item expands its parent, and the rows after it move down
+	const String ids[] = { "folder500_3", "folder900" };
+	tree->setSelectedOptionIds(ids);
+	EXPECT_EQ(tree->getCount(), 1010);
+	EXPECT_EQ(tree->getSelectedOption(), 504);
+	EXPECT_EQ(tree->getSelectedOptions(), Vector<int>({ 504, 910 }));
+	ui.update();
+	ui.update();
+	ASSERT_TRUE(tree->tryGetItem(504));
+	EXPECT_TRUE(tree->tryGetItem(504)->isSelected());
+
+	tree->setAllExpanded(true);
+	ui.update();
+	EXPECT_EQ(tree->getCount(), 11000);
+	EXPECT_EQ(tree->getSelectedOptionIds(), Vector<String>({ "folder500_3", "folder900" }));
+	EXPECT_EQ(tree->getSelectedOptions(), Vector<int>({ 5504, 9900 }));
+
+	// Removing an item drops it from the selection
+	tree->removeItem("folder900");
+	ui.update();
+	EXPECT_EQ(tree->getCount(), 10989);
+	EXPECT_EQ(tree->getSelectedOptionIds(), Vector<String>({ "folder500_3" }));
+	EXPECT_FALSE(tree->tryGetTreeItem("folder900_1"));
+}
@@ -8,7 +8,10 @@ InfiniCanvas::InfiniCanvas(String id, UIStyle style, UISizer sizer, std::shared_
 
 void InfiniCanvas::setScrollPosition(Vector2f pos)
 {
-	scrollPos = pos;
+	if (scrollPos != pos) {
+		scrollPos = pos;
+		markLayoutDirty();
+	}
 }
 
 Vector2f InfiniCanvas::getScrollPosition() const
@@ -85,7 +85,9 @@ namespace Halley
 		SystemMethod method = SystemMethod::Update;
 		CodegenLanguage language = CodegenLanguage::CPlusPlus;
 		int smearing = 0;
+		int grainSize = 0;
 		bool generate = false;
+		bool concurrent = false;
 
 		HashSet<String> includeFiles;
 
@@ -25,6 +25,9 @@ namespace Halley {
 			uint64_t hash;
 			String key;
 			AssetDatabase::Entry entry;
+			String compression;
+			size_t uncompressedSize = 0;
+			double decodeSeconds = 0;
 
 			Entry(int assetType, uint64_t hash, String key, AssetDatabase::Entry entry);
 		};
@@ -34,6 +37,7 @@ namespace Halley {
 		void parseTable(Deserializer s, const Bytes& packBytes);
 	    void parseTypedDB(Deserializer& s, const Bytes& packBytes);
 		void computeHash();
+		static void measureDecompression(Entry& entry, gsl::span<const gsl::byte> data);
     };
 
 	class AssetPackInspectorTool : public CommandLineTool
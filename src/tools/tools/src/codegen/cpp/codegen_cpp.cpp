@@ -424,7 +424,8 @@ public:
 			stratImpl = "invokeIndividual([this, &" + methodArgName + "] (auto& e) { static_cast<T*>(this)->" + methodName + "(" + methodArgName + ", e); }, mainFamily);";
 		} else if (system.strategy == SystemStrategy::Parallel) {
 			familyArgs.push_back(VariableSchema(TypeSchema("MainFamily&"), "e"));
-			stratImpl = "invokeParallel([this, &" + methodArgName + "] (auto& e) { static_cast<T*>(this)->" + methodName + "(" + methodArgName + ", e); }, mainFamily);";
+			const String grainArg = system.grainSize > 0 ? ", " + toString(system.grainSize) : "";
+			stratImpl = "invokeParallel([this, &" + methodArgName + "] (auto& e) { static_cast<T*>(this)->" + methodName + "(" + methodArgName + ", e); }, mainFamily" + grainArg + ");";
 		} else {
 			throw Exception("Unsupported strategy in " + system.name + "System", HalleyExceptions::Tools);
 		}
@@ -734,11 +735,32 @@ Vector<String> CodegenCPP::generateSystemHeader(SystemSchema& system, const Hash
 			}, "canHandleSystemMessage", true, false, true, true), canReceiveBody);
 	}
 
+	Vector<String> constructorBody = { "static_assert(std::is_final_v<T>, \"System must be final.\");" };
+	if (system.concurrent) {
+		// Access signature used by the World to schedule this system alongside others
+		std::set<String> componentsRead;
+		std::set<String> componentsWritten;
+		for (auto& fam : system.families) {
+			for (auto& comp : fam.components) {
+				(comp.write ? componentsWritten : componentsRead).insert(comp.name + "Component::componentIndex");
+			}
+		}
+		for (auto& comp : componentsWritten) {
+			componentsRead.erase(comp);
+		}
+		auto services = convert<ServiceSchema, String>(system.services, [](auto& service) { return "\"" + service.name + "\""; });
+
+		constructorBody.push_back("setAccessSignature(Halley::SystemAccessSignature({ "
+			+ String::concatList(Vector<String>(componentsRead.begin(), componentsRead.end()), ", ") + " }, { "
+			+ String::concatList(Vector<String>(componentsWritten.begin(), componentsWritten.end()), ", ") + " }, { "
+			+ String::concatList(services, ", ") + " }));");
+	}
+
 	sysClassGen
 		.setAccessLevel(MemberAccess::Public)
 		.addCustomConstructor({}, {
 			VariableSchema(TypeSchema(""), "System", "{" + String::concatList(convert<FamilySchema, String>(system.families, [](auto& fam) { return "&" + fam.name + "Family"; }), ", ") + "}, {" + String::concatList(entityMsgsReceived, ", ") + "}")
-		}, { "static_assert(std::is_final_v<T>, \"System must be final.\");" })
+		}, constructorBody)
 		.finish()
 		.writeTo(contents);
 
@@ -1,41 +1,241 @@
 #include "halley/tools/distance_field/distance_field_generator.h"
 #include <cassert>
 #include <halley/file_formats/image.h>
+#include <halley/concurrency/concurrent.h>
 #include <gsl/gsl_assert>
 
 using namespace Halley;
 
-static float getDistanceAt(const int* src, int srcW, int srcH, int xCentre, int yCentre, float radius)
-{
-	auto getAlpha = [&](int x, int y) { return (src[x + y * srcW] & 0xFF000000) >> 24; };
-	bool isInside = getAlpha(xCentre, yCentre) > 127;
-	if (radius < 0.001f) {
-		return isInside ? 1.0f : 0.0f;
-	}
+namespace {
+	// Squared distance from every pixel to the nearest pixel on the other side of the alpha threshold, searching only the
+	// (2r+1)^2 window around it, like the brute force search this replaced.
+	// An exact Euclidean distance transform (Felzenszwalb & Huttenlocher, "Distance Transforms of Sampled Functions") does most of the
+	// work, down each column then along each row, in time linear in the number of pixels. Only pixels whose nearest neighbour falls
+	// in the window's corners, outside the inscribed circle, need the window itself searched, which takes O(r) per pixel.
+	class DistanceTransform {
+	public:
+		constexpr static int noDistance = std::numeric_limits<int>::max();
 
-	int iRadius = int(ceil(radius));
-	int x0 = std::max(0, xCentre - iRadius);
-	int x1 = std::min(xCentre + iRadius, srcW - 1);
-	int y0 = std::max(0, yCentre - iRadius);
-	int y1 = std::min(yCentre + iRadius, srcH - 1);
-
-	int bestDistSqr = 2147483647;
-	for (int y = y0; y <= y1; y++) {
-		for (int x = x0; x <= x1; x++) {
-			bool thisInside = getAlpha(x, y) > 127;
-			if (isInside != thisInside) {
-				// Candidate for best neighbour
-				int distSqr = (x - xCentre) * (x - xCentre) + (y - yCentre) * (y - yCentre);
-				bestDistSqr = std::min(distSqr, bestDistSqr);
+		DistanceTransform(gsl::span<const int> src, int w, int h, int searchRadius)
+			: w(w)
+			, h(h)
+			, searchRadius(searchRadius)
+			, inside(size_t(w) * size_t(h))
+			, distToInside(size_t(w) * size_t(h))
+			, distToOutside(size_t(w) * size_t(h))
+			, rowDistToInside(size_t(w) * size_t(h))
+			, rowDistToOutside(size_t(w) * size_t(h))
+		{
+			Expects(searchRadius < std::numeric_limits<uint16_t>::max());
+
+			for (size_t i = 0; i < inside.size(); ++i) {
+				inside[i] = ((src[i] & 0xFF000000) >> 24) > 127 ? 1 : 0;
 			}
+
+			auto& queue = ExecutionQueue::getDefault();
+			Concurrent::parallelForChunks(queue, size_t(w), [&] (size_t start, size_t end)
+			{
+				for (size_t x = start; x < end; ++x) {
+					transformColumn(int(x));
+				}
+			});
+			Concurrent::parallelForChunks(queue, size_t(h), [&] (size_t start, size_t end)
+			{
+				RowScratch scratch(w);
+				for (size_t y = start; y < end; ++y) {
+					transformRow(int(y), scratch);
+				}
+			});
+			Concurrent::parallelForChunks(queue, size_t(h), [&] (size_t start, size_t end)
+			{
+				for (size_t y = start; y < end; ++y) {
+					clipRowToWindow(int(y));
+				}
+			});
 		}
-	}
 
-	const float dist = float(sqrt(bestDistSqr));
-	const float normalDistance = (2 * dist - 1) / (2 * radius);
-	const float finalValue = 0.5f * (isInside ? 1.0f + normalDistance : 1.0f - normalDistance);
+		bool isInside(int x, int y) const
+		{
+			return inside[index(x, y)] != 0;
+		}
+
+		// Squared distance to the nearest pixel on the other side within the window, or noDistance if there's none
+		int getDistSqr(int x, int y) const
+		{
+			const auto idx = index(x, y);
+			return inside[idx] ? distToOutside[idx] : distToInside[idx];
+		}
+
+	private:
+		constexpr static int64_t infiniteDistSqr = std::numeric_limits<int64_t>::max() / 4;
+
+		struct RowScratch {
+			Vector<int64_t> f[2];
+			Vector<int> v;
+			Vector<double> z;
+
+			explicit RowScratch(int w)
+				: f{ Vector<int64_t>(size_t(w)), Vector<int64_t>(size_t(w)) }
+				, v(size_t(w))
+				, z(size_t(w) + 1)
+			{}
+		};
+
+		const int w;
+		const int h;
+		const int searchRadius;
+		Vector<uint8_t> inside;
+
+		// Distance along the column after the first pass, squared distance after the second
+		Vector<int> distToInside;
+		Vector<int> distToOutside;
+
+		// Distance along the row, up to searchRadius + 1
+		Vector<uint16_t> rowDistToInside;
+		Vector<uint16_t> rowDistToOutside;
+
+		size_t index(int x, int y) const
+		{
+			return size_t(x) + size_t(y) * size_t(w);
+		}
+
+		void transformColumn(int x)
+		{
+			// Positions out of range stand for "none", as they're further away than anything in the column
+			int lastPos[2] = { -h, -h };
+			for (int y = 0; y < h; ++y) {
+				const auto idx = index(x, y);
+				lastPos[inside[idx]] = y;
+				distToOutside[idx] = y - lastPos[0];
+				distToInside[idx] = y - lastPos[1];
+			}
+
+			lastPos[0] = lastPos[1] = 2 * h;
+			for (int y = h; --y >= 0; ) {
+				const auto idx = index(x, y);
+				lastPos[inside[idx]] = y;
+				distToOutside[idx] = std::min(distToOutside[idx], lastPos[0] - y);
+				distToInside[idx] = std::min(distToInside[idx], lastPos[1] - y);
+			}
+		}
+
+		void transformRow(int y, RowScratch& scratch)
+		{
+			const auto rowStart = index(0, y);
+			for (int x = 0; x < w; ++x) {
+				const int64_t dOut = distToOutside[rowStart + x];
+				const int64_t dIn = distToInside[rowStart + x];
+				scratch.f[0][x] = dOut >= h ? infiniteDistSqr : dOut * dOut;
+				scratch.f[1][x] = dIn >= h ? infiniteDistSqr : dIn * dIn;
+			}
+
+			// Pixels only need the distance to the other side, so each side's envelope is only evaluated there
+			transformRowSide(scratch.f[0], scratch, &distToOutside[rowStart], rowStart, 1);
+			transformRowSide(scratch.f[1], scratch, &distToInside[rowStart], rowStart, 0);
 
-	return finalValue;
+			const int maxRowDist = searchRadius + 1;
+			int lastPos[2] = { -maxRowDist, -maxRowDist };
+			for (int x = 0; x < w; ++x) {
+				lastPos[inside[rowStart + x]] = x;
+				rowDistToOutside[rowStart + x] = uint16_t(std::min(x - lastPos[0], maxRowDist));
+				rowDistToInside[rowStart + x] = uint16_t(std::min(x - lastPos[1], maxRowDist));
+			}
+			lastPos[0] = lastPos[1] = w + maxRowDist;
+			for (int x = w; --x >= 0; ) {
+				lastPos[inside[rowStart + x]] = x;
+				rowDistToOutside[rowStart + x] = uint16_t(std::min(int(rowDistToOutside[rowStart + x]), lastPos[0] - x));
+				rowDistToInside[rowStart + x] = uint16_t(std::min(int(rowDistToInside[rowStart + x]), lastPos[1] - x));
+			}
+		}
+
+		void transformRowSide(const Vector<int64_t>& f, RowScratch& scratch, int* dst, size_t rowStart, uint8_t evaluateOn)
+		{
+			auto& v = scratch.v;
+			auto& z = scratch.z;
+
+			// Lower envelope of the parabolas rooted at each column, skipping columns with nothing on this side
+			int k = -1;
+			for (int q = 0; q < w; ++q) {
+				if (f[q] >= infiniteDistSqr) {
+					continue;
+				}
+				double s = -std::numeric_limits<double>::infinity();
+				while (k >= 0) {
+					const int p = v[k];
+					s = double((f[q] + int64_t(q) * q) - (f[p] + int64_t(p) * p)) / double(2 * (q - p));
+					if (s > z[k]) {
+						break;
+					}
+					--k;
+				}
+				++k;
+				v[k] = q;
+				z[k] = k == 0 ? -std::numeric_limits<double>::infinity() : s;
+				z[k + 1] = std::numeric_limits<double>::infinity();
+			}
+			const bool empty = k < 0;
+
+			k = 0;
+			for (int q = 0; q < w; ++q) {
+				if (inside[rowStart + q] != evaluateOn) {
+					continue;
+				}
+				if (empty) {
+					dst[q] = noDistance;
+				} else {
+					while (z[k + 1] < q) {
+						++k;
+					}
+					const int64_t dx = q - v[k];
+					dst[q] = int(std::min(dx * dx + f[v[k]], int64_t(noDistance)));
+				}
+			}
+		}
+
+		void clipRowToWindow(int y)
+		{
+			const int64_t r = searchRadius;
+			for (int x = 0; x < w; ++x) {
+				const auto idx = index(x, y);
+				const bool isInside = inside[idx] != 0;
+				auto& distSqr = isInside ? distToOutside[idx] : distToInside[idx];
+
+				// Within the inscribed circle, the nearest pixel is in the window; past its corners, nothing is
+				if (distSqr <= r * r) {
+					continue;
+				}
+				if (distSqr > 2 * r * r) {
+					distSqr = noDistance;
+					continue;
+				}
+
+				const auto& rowDist = isInside ? rowDistToOutside : rowDistToInside;
+				int64_t best = noDistance;
+				for (int y1 = std::max(0, y - searchRadius); y1 <= std::min(y + searchRadius, h - 1); ++y1) {
+					const int64_t dx = rowDist[index(x, y1)];
+					if (dx <= r) {
+						const int64_t dy = y1 - y;
+						best = std::min(best, dx * dx + dy * dy);
+					}
+				}
+				distSqr = int(best);
+			}
+		}
+	};
+
+	float getDistanceAt(const DistanceTransform& transform, int x, int y, float radius)
+	{
+		const bool isInside = transform.isInside(x, y);
+		if (radius < 0.001f) {
+			return isInside ? 1.0f : 0.0f;
+		}
+
+		const float dist = float(sqrt(transform.getDistSqr(x, y)));
+		const float normalDistance = (2 * dist - 1) / (2 * radius);
+		const float finalValue = 0.5f * (isInside ? 1.0f + normalDistance : 1.0f - normalDistance);
+
+		return finalValue;
+	}
 }
 
 std::unique_ptr<Image> DistanceFieldGenerator::generate(Image& srcImg, Vector2i size, float radius)
@@ -44,7 +244,8 @@ std::unique_ptr<Image> DistanceFieldGenerator::generate(Image& srcImg, Vector2i
 	Expects(srcImg.getFormat() == Image::Format::RGBA);
 	const int srcW = srcImg.getWidth();
 	const int srcH = srcImg.getHeight();
-	const auto src = srcImg.getPixels4BPP();
+	const float srcRadius = radius * srcW / size.x;
+	const DistanceTransform transform(srcImg.getPixels4BPP(), srcW, srcH, int(ceil(srcRadius)));
 
 	auto dstImg = std::make_unique<Image>(Image::Format::SingleChannel, size);
 
@@ -55,21 +256,24 @@ std::unique_ptr<Image> DistanceFieldGenerator::generate(Image& srcImg, Vector2i
 	int texelW = srcW / w;
 	int texelH = srcH / h;
 
-	for (int y = 0; y < h; y++) {
-		for (int x = 0; x < w; x++) {
-			unsigned char* dst = &dstStart[x + y * w];
-			float distAcc = 0;
-			// For each sub-pixel, compute the distance to closest pixel of the opposite value
-			// Then average it all
-			for (int j = 0; j < texelH; j++) {
-				for (int i = 0; i < texelW; i++) {
-					distAcc += getDistanceAt(src.data(), srcW, srcH, x * srcW / w + i, y * srcH / h + j, radius * srcW / w);
+	Concurrent::parallelForChunks(ExecutionQueue::getDefault(), size_t(h), [&] (size_t start, size_t end)
+	{
+		for (int y = int(start); y < int(end); y++) {
+			for (int x = 0; x < w; x++) {
+				unsigned char* dst = &dstStart[x + y * w];
+				float distAcc = 0;
+				// For each sub-pixel, compute the distance to closest pixel of the opposite value
+				// Then average it all
+				for (int j = 0; j < texelH; j++) {
+					for (int i = 0; i < texelW; i++) {
+						distAcc += getDistanceAt(transform, x * srcW / w + i, y * srcH / h + j, srcRadius);
+					}
 				}
+				int distance = clamp(int(distAcc * 255 / (texelW * texelH)), 0, 255);
+				*dst = static_cast<unsigned char>(distance);
 			}
-			int distance = clamp(int(distAcc * 255 / (texelW * texelH)), 0, 255);
-			*dst = static_cast<unsigned char>(distance);
 		}
-	}
+	});
 
 	return dstImg;
 }
@@ -103,6 +103,14 @@ SystemSchema::SystemSchema(YAML::Node node, bool generate)
 
 	smearing = node["smearing"].as<int>(1);
 
+	grainSize = node["grainSize"].as<int>(0);
+	if (grainSize < 0) {
+		throw Exception("Invalid grain size in system " + name, HalleyExceptions::Resources);
+	}
+	if (grainSize > 0 && strategy != SystemStrategy::Parallel) {
+		throw Exception("Grain size is only supported by the parallel strategy, in system " + name, HalleyExceptions::Resources);
+	}
+
 	if (node["access"].IsDefined()) {
 		int accessValue = 0;
 		for(auto accessOpt : node["access"]) {
@@ -156,6 +164,20 @@ SystemSchema::SystemSchema(YAML::Node node, bool generate)
 			services.push_back(service);
 		}
 	}
+
+	concurrent = node["concurrent"].as<bool>(false);
+	if (concurrent) {
+		const int unsafeAccess = int(SystemAccess::API) | int(SystemAccess::World) | int(SystemAccess::MessageBridge);
+		if ((int(access) & unsafeAccess) != 0) {
+			throw Exception("Concurrent system " + name + " cannot have api, world or messageBridge access.", HalleyExceptions::Resources);
+		}
+		if (!messages.empty() || !systemMessages.empty()) {
+			throw Exception("Concurrent system " + name + " cannot send or receive messages.", HalleyExceptions::Resources);
+		}
+		if (method != SystemMethod::Update) {
+			throw Exception("Concurrent system " + name + " must use the update method.", HalleyExceptions::Resources);
+		}
+	}
 }
 
 bool SystemSchema::operator<(const SystemSchema& other) const
@@ -7,6 +7,7 @@
 #include "halley/support/console.h"
 #include "halley/core/resources/asset_database.h"
 #include "halley/utils/hash.h"
+#include "halley/time/stopwatch.h"
 
 using namespace Halley;
 
@@ -74,12 +75,34 @@ void AssetPackInspector::parseTypedDB(Deserializer& s, const Bytes& packBytes)
 		auto splitPath = entry.path.split(':');
 		size_t pos = splitPath.at(0).toInteger64();
 		size_t size = splitPath.at(1).toInteger64();
-		auto hash = Hash::hash(gsl::as_bytes(gsl::span<const Byte>(packBytes.data() + pos + dataStartPos, size)));
+		const auto data = gsl::as_bytes(gsl::span<const Byte>(packBytes.data() + pos + dataStartPos, size));
+		auto hash = Hash::hash(data);
 
 		entries.emplace_back(curAssetType, hash, std::move(key), std::move(entry));
+		measureDecompression(entries.back(), data);
 	}
 }
 
+void AssetPackInspector::measureDecompression(Entry& entry, gsl::span<const gsl::byte> data)
+{
+	entry.compression = entry.entry.meta.getString("asset_compression", "");
+	if (entry.compression.isEmpty()) {
+		entry.uncompressedSize = data.size();
+		return;
+	}
+
+	Stopwatch timer;
+	if (entry.compression == "deflate") {
+		entry.uncompressedSize = Compression::decompress(data).size();
+	} else if (entry.compression == "lz4") {
+		entry.uncompressedSize = Compression::lz4Decompress(data).size();
+	} else {
+		entry.uncompressedSize = data.size();
+	}
+	timer.pause();
+	entry.decodeSeconds = timer.elapsedNanoseconds() / 1'000'000'000.0;
+}
+
 void AssetPackInspector::computeHash()
 {
 	Hash::Hasher hasher;
@@ -112,6 +135,12 @@ void AssetPackInspector::printData() const
 
 		auto splitPath = entry.entry.path.split(':');
 		std::cout << "    [" << i << "] " << strCol << entry.key << stdCol << " [" << infoCol << toString(entry.hash, 16) << stdCol << "]: at " << infoCol << splitPath.at(0) << stdCol << ", " << infoCol << splitPath.at(1) << stdCol << " bytes, " << strCol << toString(entry.entry.meta) <<  stdCol << "\n";
+		if (!entry.compression.isEmpty()) {
+			const auto compressedSize = splitPath.at(1).toInteger64();
+			const auto ratio = entry.uncompressedSize > 0 ? 100.0 * double(compressedSize) / double(entry.uncompressedSize) : 100.0;
+			const auto throughput = entry.decodeSeconds > 0 ? double(entry.uncompressedSize) / entry.decodeSeconds : 0.0;
+			std::cout << "        " << entry.compression << ": " << infoCol << entry.uncompressedSize << stdCol << " bytes uncompressed, " << infoCol << toString(ratio, 1) << "%" << stdCol << " ratio, decodes at " << infoCol << String::prettySize(size_t(throughput)) << "/s" << stdCol << "\n";
+		}
 
 		++i;
 	}
@@ -8,8 +8,37 @@
 #include "halley/core/resources/asset_pack.h"
 #include "halley/tools/project/project.h"
 #include "halley/tools/assets/import_assets_database.h"
+#include "halley/bytes/compression.h"
 using namespace Halley;
 
+namespace {
+	bool shouldCompressLZ4(AssetType type, const Metadata& meta)
+	{
+		if (!meta.getString("asset_compression", "").isEmpty() || meta.getBool("streaming", false)) {
+			// Already compressed by its importer, or read through a stream
+			return false;
+		}
+
+		// Images, textures and audio clips are already stored in compressed formats
+		switch (type) {
+		case AssetType::BinaryFile:
+		case AssetType::TextFile:
+		case AssetType::Shader:
+		case AssetType::MaterialDefinition:
+		case AssetType::Animation:
+		case AssetType::Font:
+		case AssetType::AudioObject:
+		case AssetType::AudioEvent:
+		case AssetType::Mesh:
+		case AssetType::MeshAnimation:
+		case AssetType::NavmeshSet:
+			return true;
+		default:
+			return false;
+		}
+	}
+}
+
 
 bool AssetPackListing::Entry::operator<(const Entry& other) const
 {
@@ -197,18 +226,29 @@ void AssetPacker::generatePack(const String& packId, const AssetPackListing& pac
 
 		// Read original file
 		auto fileData = FileSystem::readFile(src / entry.path);
-		const size_t pos = data.size();
-		const size_t size = fileData.size();
-		if (size == 0) {
+		if (fileData.empty()) {
 			throw Exception("Unable to pack: \"" + (src / entry.path) + "\". File not found or empty.", HalleyExceptions::Tools);
 		}
+
+		// Compress with LZ4 if it's worth it; assets that were already deflated by their importer keep zlib
+		auto metadata = entry.metadata;
+		if (shouldCompressLZ4(entry.type, metadata)) {
+			auto compressed = Compression::lz4Compress(gsl::as_bytes(gsl::span<const Byte>(fileData)));
+			if (compressed.size() < fileData.size() * 9 / 10) {
+				fileData = std::move(compressed);
+				metadata.set("asset_compression", "lz4");
+			}
+		}
+
+		const size_t pos = data.size();
+		const size_t size = fileData.size();
 		
 		// Read data into pack data
 		data.reserve(nextPowerOf2(pos + size));
 		data.resize(pos + size);
 		memcpy(data.data() + pos, fileData.data(), size);
 
-		db.addAsset(entry.name, entry.type, AssetDatabase::Entry(toString(pos) + ":" + toString(size), entry.metadata));
+		db.addAsset(entry.name, entry.type, AssetDatabase::Entry(toString(pos) + ":" + toString(size), metadata));
 
 		progress(float(i) / float(n), packId);
 		i++;